@@ -251,7 +251,9 @@ typedef enum VkuBufferUsage
 {
     VKU_BUFFER_USAGE_CPU_TO_GPU = (1 << 0),
     VKU_BUFFER_USAGE_GPU_ONLY = (1 << 1),
-    VKU_BUFFER_USAGE_COMPUTE = (1 << 2)
+    VKU_BUFFER_USAGE_COMPUTE = (1 << 2),
+    VKU_BUFFER_USAGE_GPU_TO_CPU = (1 << 3),
+    VKU_BUFFER_USAGE_TEXEL = (1 << 4)
 } VkuBufferUsage;
 
 typedef struct VkuBuffer_T
@@ -273,6 +275,15 @@ void * vkuMapBuffer(VkuMemoryManager manager, VkuBuffer buffer);
 void vkuUnmapBuffer(VkuMemoryManager manager, VkuBuffer buffer);
 void vkuEnqueueBufferDestruction(VkuMemoryManager manager, VkuBuffer buffer);
 
+/**
+ * @brief Creates a formatted view over a whole VkuBuffer for uniform / storage texel buffer descriptors.
+ *
+ * The buffer has to be created with VKU_BUFFER_USAGE_TEXEL.
+ */
+
+VkBufferView vkuCreateBufferView(VkuMemoryManager manager, VkuBuffer buffer, VkFormat format);
+void vkuDestroyBufferView(VkuMemoryManager manager, VkBufferView bufferView);
+
 typedef enum vkuContextUsageFlags
 {
     VKU_CONTEXT_USAGE_OFFSCREEN = (1 << 0),
@@ -285,8 +296,20 @@ typedef struct VkuContextCreateInfo
     const char *applicationName;
     uint32_t applicationVersion;
     vkuContextUsageFlags usage;
+    uint32_t bindlessTextureCount;
+    const char *pipelineCachePath;
+    VkBool32 enableShaderHotReload;
 } VkuContextCreateInfo;
 
+typedef struct VkuUploadBatch_T *VkuUploadBatch;
+typedef struct VkuLayoutCache_T *VkuLayoutCache;
+typedef struct VkuPipelineVariantCache_T *VkuPipelineVariantCache;
+typedef struct VkuDescriptorAllocator_T *VkuDescriptorAllocator;
+typedef struct VkuBindlessTable_T *VkuBindlessTable;
+typedef struct VkuShaderWatcher_T *VkuShaderWatcher;
+
+#define VKU_BINDLESS_INVALID_INDEX UINT32_MAX
+
 typedef struct VkuContext_T
 {
     VkBool32 validation;
@@ -306,15 +329,84 @@ typedef struct VkuContext_T
     VkCommandPool computeCmdPool;
 
     VkuMemoryManager memoryManager;
+    VkuUploadBatch uploadBatch;
+    VkuLayoutCache layoutCache;
+    VkuPipelineVariantCache pipelineVariantCache;
+    VkuDescriptorAllocator descriptorAllocator;
+
+    uint32_t bindlessTextureCount;
+    VkuBindlessTable bindlessTable;
+
+    PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR;
+    VkBool32 inlineShaderModules;
+    VkBool32 extendedDynamicState;
+    VkBool32 dynamicPolygonMode;
+    PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT;
+    VkBool32 dynamicRendering;
+    VkBool32 graphicsPipelineLibrary;
+
+    char *pipelineCachePath;
+    VkPipelineCache pipelineCache;
+    // Read-locked by everything that compiles into or reads pipelineCache, write-locked by merges and its destruction.
+    pthread_rwlock_t pipelineCacheLock;
+
+    pthread_mutex_t pipelineBatchLock;
+    pthread_cond_t pipelineBatchCond;
+    uint32_t pipelineBatchesInFlight;
+    struct VkuPipelineBatch_T **pipelineBatches;
+    uint32_t pipelineBatchCount, pipelineBatchCapacity;
+
+    VkuShaderWatcher shaderWatcher;
 } VkuContext_T;
 
 typedef VkuContext_T *VkuContext;
 
+/**
+ * @brief Creates a VkuContext.
+ *
+ * A bindlessTextureCount > 0 enables bindless mode (requires descriptor indexing). The context then owns one
+ * UPDATE_AFTER_BIND / PARTIALLY_BOUND array of bindlessTextureCount combined image samplers at set 0, binding 0 of every
+ * VkuPipeline, bound once per frame in vkuPresenterBeginFrame. Every VkuTexture2D and VkuTexture2DArray gets a stable
+ * bindlessIndex into it on creation, which shaders receive e.g. through push constants. A pipeline's own
+ * VkuDescriptorSet moves to set 1. Indices of destroyed textures are handed out again only after framesInFlight frames.
+ *
+ * With a pipelineCachePath, the VkPipelineCache used for every pipeline is seeded from that file if its header matches
+ * the vendor, device and pipelineCacheUUID of the selected GPU, and written back in vkuDestroyContext.
+ *
+ * enableShaderHotReload watches the shader paths given at pipeline creation. It relies on inotify and is Linux only,
+ * on other platforms context creation fails with it enabled. Changed SPIR-V is recompiled on a background thread and
+ * swapped in at the next vkuPresenterBeginFrame of the render stage's presenter (graphics) or
+ * vkuComputeExecutorStartRun (compute). If the render stage changed in between, the pipeline is first rebuilt on the
+ * background thread. The replaced pipeline is destroyed once the frames in flight of every presenter and compute
+ * executor have completed.
+ */
+
 VkuContext vkuCreateContext(VkuContextCreateInfo *createInfo);
 void vkuDestroyContext(VkuContext context);
+
+/**
+ * @brief Writes the pipeline cache to VkuContextCreateInfo::pipelineCachePath.
+ *
+ * The data goes to a temporary file that is renamed over the old one, so a crash never leaves a truncated cache behind.
+ *
+ * @return true on success, false if no path is set or writing failed.
+ */
+
+bool vkuContextSavePipelineCache(VkuContext context);
 VkSampleCountFlagBits vkuContextGetMaxSampleCount(VkuContext context);
 VkuMemoryManager vkuContextGetMemoryManager(VkuContext context);
 
+/**
+ * @brief Submits all pending texture region uploads and waits for them.
+ *
+ * With a VkuPresenter, pending uploads are recorded automatically into the next frame. Offscreen contexts have to call
+ * this before the updated textures are used.
+ *
+ * @param context A VkuContext.
+ */
+
+void vkuContextFlushUploads(VkuContext context);
+
 typedef struct VkuPresenter_T *VkuPresenter;
 typedef struct VkuColorResource_T *VkuColorResource;
 typedef struct VkuDepthResource_T *VkuDepthResource;
@@ -385,12 +477,17 @@ typedef enum VkuRenderOptions
     VKU_RENDER_OPTION_PRESENTER = (1 << 2)
 } VkuRenderOptions;
 
+#define VKU_MAX_COLOR_ATTACHMENTS 8
+
 typedef struct VkuRenderStageCreateInfo
 {
     VkSampleCountFlagBits msaaSamples;
     VkuPresenter presenter;
     int options;
     VkBool32 enableDepthTesting;
+    VkBool32 dynamicRendering;
+    uint32_t colorAttachmentCount;
+    VkFormat *colorAttachmentFormats;
 } VkuRenderStageCreateInfo;
 
 typedef struct VkuRenderStage_T
@@ -405,8 +502,14 @@ typedef struct VkuRenderStage_T
 
     VkBool32 staticRenderStage;
     VkExtent2D extend;
+    VkBool32 dynamicRendering;
+
+    uint32_t colorAttachmentCount;
+    VkFormat colorAttachmentFormats[VKU_MAX_COLOR_ATTACHMENTS];
 
     VkRenderPass renderPass;
+    VkFormat renderPassFormat;
+    VkSampleCountFlagBits renderPassSampleCount;
     VkFramebuffer *framebuffers;
     VkuColorResource colorResource;
     VkuDepthResource depthResource;
@@ -424,6 +527,18 @@ typedef struct VkuRenderStage_T
 
 typedef VkuRenderStage_T *VkuRenderStage;
 
+/**
+ * @brief Creates a render stage drawing into the swapchain or its own color / depth outputs.
+ *
+ * With dynamicRendering (requires context->dynamicRendering, Vulkan 1.3) the stage records vkCmdBeginRendering and
+ * binds its attachments per frame instead of owning a VkRenderPass and VkFramebuffers, so resizes only reallocate the
+ * attachment images. Also available for static render stages.
+ *
+ * With VKU_RENDER_OPTION_COLOR_IMAGE the stage writes colorAttachmentCount (up to VKU_MAX_COLOR_ATTACHMENTS) color
+ * outputs in one pass, e.g. a G-buffer. colorAttachmentFormats gives their formats, outputs default to
+ * VK_FORMAT_B8G8R8A8_SRGB. Several outputs require msaaSamples = VK_SAMPLE_COUNT_1_BIT.
+ */
+
 VkuRenderStage vkuCreateRenderStage(VkuRenderStageCreateInfo *createInfo);
 void vkuDestroyRenderStage(VkuRenderStage renderStage);
 void vkuRenderStageSetMSAA(VkuRenderStage renderStage, VkSampleCountFlagBits msaaFlags);
@@ -435,11 +550,17 @@ typedef struct VkuStaticRenderStageCreateInfo {
     VkBool32 enableDepthTesting;
     VkSampleCountFlagBits msaaSamples;
     int depthLayers;
+    VkBool32 dynamicRendering;
+    uint32_t colorAttachmentCount;
+    VkFormat *colorAttachmentFormats;
 } VkuStaticRenderStageCreateInfo;
 
 VkuRenderStage vkuCreateStaticRenderStage(VkuStaticRenderStageCreateInfo * createInfo);
 void vkuDestroyStaticRenderStage(VkuRenderStage renderStage);
 
+#define VKU_MAX_DESCRIPTOR_SETS 8
+#define VKU_MAX_PUSH_CONSTANT_RANGES 8
+
 typedef struct VkuFrame_T
 {
     VkuPresenter presenter;
@@ -447,6 +568,10 @@ typedef struct VkuFrame_T
     VkCommandBuffer cmdBuffer;
 
     bool activeRenderStage;
+
+    VkDescriptorSetLayout boundSetLayouts[VKU_MAX_DESCRIPTOR_SETS];
+    VkDescriptorSet boundSets[VKU_MAX_DESCRIPTOR_SETS];
+    uint64_t boundPushConstantHash;
 } VkuFrame_T;
 
 typedef struct VkuFrame_T *VkuFrame;
@@ -475,10 +600,13 @@ typedef struct VkuTexture2D_T
     VmaAllocation textureImageAllocation;
     VkImageView textureImageView;
     VkExtent2D imageExtend;
+    uint32_t mipLevels;
+    uint32_t bindlessIndex;
 
     VkBool32 renderStageColorImage;
     VkBool32 renderStageDepthImage;
     VkuRenderStage renderStage;
+    uint32_t renderStageOutputIndex;
 } VkuTexture2D_T;
 
 typedef VkuTexture2D_T *VkuTexture2D;
@@ -498,6 +626,10 @@ typedef struct VkuTexture2DArray_T
     VkImage textureImage;
     VmaAllocation textureImageAllocation;
     VkImageView textureImageView;
+    VkExtent2D imageExtend;
+    uint32_t layerCount;
+    uint32_t mipLevels;
+    uint32_t bindlessIndex;
 } VkuTexture2DArray_T;
 
 typedef VkuTexture2DArray_T *VkuTexture2DArray;
@@ -510,6 +642,280 @@ void vkuDestroyTexture2D(VkuContext context, VkuTexture2D texture);
 VkuTexture2D vkuRenderStageGetDepthOutput(VkuRenderStage renderStage);
 VkuTexture2D vkuRenderStageGetColorOutput(VkuRenderStage renderStage);
 
+/**
+ * @brief Retrieves the color output at index of a render stage. vkuRenderStageGetColorOutput() returns output 0.
+ */
+
+VkuTexture2D vkuRenderStageGetColorOutputAt(VkuRenderStage renderStage, uint32_t index);
+
+/**
+ * @brief Overwrites a rectangle of one mip level of a texture.
+ *
+ * pixelData holds width * height tightly packed RGBA8 texels. The data is copied into the context staging ring and the
+ * copy is recorded, including layout barriers, into the frame's upload batch before the next VkuRenderStage begins.
+ * If the ring is exhausted the upload is submitted immediately.
+ *
+ * WARNING: RenderStage output textures can't be updated.
+ */
+
+void vkuTexture2DUpdateRegion(VkuContext context, VkuTexture2D texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mipLevel, uint32_t layer, const uint8_t *pixelData);
+void vkuTexture2DArrayUpdateRegion(VkuContext context, VkuTexture2DArray texArray, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mipLevel, uint32_t layer, const uint8_t *pixelData);
+
+typedef struct VkuStorageImageCreateInfo
+{
+    uint32_t width;
+    uint32_t height;
+    VkFormat format;
+} VkuStorageImageCreateInfo;
+
+typedef struct VkuStorageImage_T
+{
+    VkImage image;
+    VmaAllocation imageAllocation;
+    VkImageView imageView;
+    VkExtent2D imageExtend;
+    VkFormat format;
+} VkuStorageImage_T;
+
+typedef VkuStorageImage_T *VkuStorageImage;
+
+/**
+ * @brief Creates an image that compute kernels can write directly (VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_IMAGE).
+ *
+ * The image stays in VK_IMAGE_LAYOUT_GENERAL for its whole lifetime, so it can be bound as storage image, sampled image
+ * or combined image sampler without layout transitions. The format needs storage image support, e.g.
+ * VK_FORMAT_R8G8B8A8_UNORM or VK_FORMAT_R32G32B32A32_SFLOAT (sRGB formats usually don't qualify).
+ */
+
+VkuStorageImage vkuCreateStorageImage(VkuContext context, VkuStorageImageCreateInfo *createInfo);
+void vkuDestroyStorageImage(VkuContext context, VkuStorageImage storageImage);
+
+typedef bool (*VkuVirtualTexturePageLoader)(uint32_t mipLevel, uint32_t pageX, uint32_t pageY, uint8_t *pixelData, void *userData);
+
+typedef struct VkuVirtualTextureCreateInfo
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t pageSize;
+    uint32_t physicalPageCount;
+    uint32_t maxUploadsPerFrame;
+    uint32_t framesInFlight;
+    VkuVirtualTexturePageLoader pageLoader;
+    void *userData;
+} VkuVirtualTextureCreateInfo;
+
+typedef struct VkuVirtualTexture_T
+{
+    VkuContext context;
+    uint32_t pageSize;
+    uint32_t pagesX, pagesY;
+    uint32_t mipLevels;
+    uint32_t *mipPageOffsets;
+    uint32_t pageCount;
+    uint32_t physicalPageCount;
+    uint32_t maxUploadsPerFrame;
+    uint32_t framesInFlight;
+    uint32_t updateIndex;
+
+    VkuVirtualTexturePageLoader pageLoader;
+    void *userData;
+
+    VkuTexture2DArray physicalPages;
+    VkuTexture2D indirectionTexture;
+    VkuBuffer feedbackBuffer;
+    uint32_t *feedback;
+    VkuBuffer *stagingBuffers;
+    uint8_t **stagingMemory;
+
+    int32_t *pageTable;
+    uint32_t *slotPages;
+    uint32_t *slotLastUsed;
+    uint32_t *lruPrev;
+    uint32_t *lruNext;
+    uint32_t lruHead, lruTail;
+    uint32_t *freeSlots;
+    uint32_t freeSlotCount;
+    uint32_t *requests;
+    VkBufferImageCopy *pageRegions;
+    VkBufferImageCopy *indirectionRegions;
+    uint32_t *indirectionData;
+    VkBool32 indirectionDirty;
+} VkuVirtualTexture_T;
+
+typedef VkuVirtualTexture_T *VkuVirtualTexture;
+
+/**
+ * @brief Creates a paged virtual texture.
+ *
+ * The logical texture (width x height, multiples of pageSize) is split into pageSize x pageSize pages per mip level.
+ * Resident pages live in physicalPages (a VkuTexture2DArray with one layer per page slot). indirectionTexture has one
+ * RGBA8 texel per virtual page and mip: RG = physical layer (R low byte), B = mip level of the resident page, A = 255 if
+ * any page is resident. Missing pages fall back to their nearest resident ancestor.
+ *
+ * The fragment shader writes a non-zero value to feedbackBuffer (uint32 per page) at index
+ * mipPageOffsets[mip] + pageY * max(1, pagesX >> mip) + pageX for every page it needs. The coarsest mip is always resident.
+ *
+ * @param context A VkuContext.
+ * @param createInfo PTR to a VkuVirtualTextureCreateInfo struct.
+ * @return A VkuVirtualTexture.
+ */
+
+VkuVirtualTexture vkuCreateVirtualTexture(VkuContext context, VkuVirtualTextureCreateInfo *createInfo);
+void vkuDestroyVirtualTexture(VkuContext context, VkuVirtualTexture virtualTexture);
+
+/**
+ * @brief Consumes the feedback buffer and streams missing pages.
+ *
+ * Least recently used pages are evicted first. Page uploads and the indirection update are recorded into the frame's
+ * command buffer, so this has to be called before vkuFrameBeginRenderStage.
+ *
+ * @param frame The active VkuFrame.
+ * @param virtualTexture A VkuVirtualTexture.
+ */
+
+void vkuFrameUpdateVirtualTexture(VkuFrame frame, VkuVirtualTexture virtualTexture);
+
+typedef struct VkuTextureCachePath
+{
+    uint64_t pathHash;
+    char *path;
+    struct VkuTextureCacheEntry_T *entry;
+    struct VkuTextureCachePath *nextInBucket;
+    struct VkuTextureCachePath *nextOfEntry;
+} VkuTextureCachePath;
+
+typedef struct VkuTextureCacheEntry_T
+{
+    uint64_t contentHash;
+    uint64_t contentCheck; // Second, differently seeded hash of the pixels, together a 128-bit content key.
+    uint32_t mipLevels;
+    uint32_t refCount;
+    uint64_t retireFrame;
+    VkuTexture2D texture;
+    VkuTextureCachePath *paths;
+    struct VkuTextureCacheEntry_T *nextByContent;
+    struct VkuTextureCacheEntry_T *nextByTexture;
+} VkuTextureCacheEntry_T;
+
+typedef VkuTextureCacheEntry_T *VkuTextureCacheEntry;
+
+typedef struct VkuTextureCache_T
+{
+    VkuContext context;
+    uint32_t framesInFlight;
+    uint64_t frameIndex;
+
+    VkuTextureCacheEntry *entries;
+    uint32_t entryCount, entryCapacity;
+    VkuTextureCacheEntry *contentBuckets;
+    VkuTextureCacheEntry *textureBuckets;
+    uint32_t entryBucketCount;
+    VkuTextureCachePath **pathBuckets;
+    uint32_t pathCount, pathBucketCount;
+} VkuTextureCache_T;
+
+typedef VkuTextureCache_T *VkuTextureCache;
+
+/**
+ * @brief Creates a content-addressed cache of shared VkuTexture2Ds.
+ *
+ * Textures are looked up by a hash of their path first and by a hash of their decoded pixels second, so the same asset
+ * is decoded and uploaded once no matter how often or under which path it is requested. Contents are matched by a
+ * 128-bit hash and their extent, the decoded pixels are freed right after the upload.
+ *
+ * @param context A VkuContext.
+ * @param framesInFlight Number of frames a released texture may still be in use by the GPU.
+ * @return A VkuTextureCache.
+ */
+
+VkuTextureCache vkuCreateTextureCache(VkuContext context, uint32_t framesInFlight);
+void vkuDestroyTextureCache(VkuTextureCache cache);
+
+/**
+ * @brief Returns a shared texture for path and takes a reference on it. Returns NULL if the image can't be loaded.
+ */
+
+VkuTexture2D vkuTextureCacheAcquire(VkuTextureCache cache, const char *path, int mipLevels);
+
+/**
+ * @brief Drops a reference taken by vkuTextureCacheAcquire().
+ *
+ * The texture is destroyed by vkuTextureCacheCollect() once framesInFlight frames have passed without it being acquired
+ * again.
+ */
+
+void vkuTextureCacheRelease(VkuTextureCache cache, VkuTexture2D texture);
+
+/**
+ * @brief Advances the cache by one frame and destroys unreferenced textures whose last frame has retired.
+ *
+ * Call once per frame, after vkuPresenterBeginFrame().
+ */
+
+void vkuTextureCacheCollect(VkuTextureCache cache);
+
+#define VKU_ASSET_PACK_MAGIC 0x4B415056u
+#define VKU_ASSET_PACK_VERSION 1
+#define VKU_ASSET_PACK_ALIGNMENT 256
+#define VKU_ASSET_PACK_MAX_MIP_LEVELS 16
+#define VKU_ASSET_PACK_MAX_NAME_LENGTH 128
+
+typedef struct VkuAssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t textureCount;
+    uint32_t reserved;
+    uint64_t tableOffset;
+} VkuAssetPackHeader;
+
+typedef struct VkuAssetPackTexture
+{
+    char name[VKU_ASSET_PACK_MAX_NAME_LENGTH];
+    uint64_t nameHash;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint64_t mipOffsets[VKU_ASSET_PACK_MAX_MIP_LEVELS];
+    uint64_t mipSizes[VKU_ASSET_PACK_MAX_MIP_LEVELS];
+} VkuAssetPackTexture;
+
+typedef struct VkuAssetPack_T
+{
+    uint8_t *mapping;
+    size_t mappingSize;
+    const VkuAssetPackHeader *header;
+    const VkuAssetPackTexture *textures;
+} VkuAssetPack_T;
+
+typedef VkuAssetPack_T *VkuAssetPack;
+
+/**
+ * @brief Bakes images into a pack that can be uploaded without decoding.
+ *
+ * Every image is decoded once and stored as VK_FORMAT_R8G8B8A8_SRGB with its full mip chain (downsampled in linear
+ * space). Each mip level starts at a VKU_ASSET_PACK_ALIGNMENT aligned offset, so regions can be copied straight into a
+ * staging buffer and used with vkCmdCopyBufferToImage. Textures are named after their path.
+ *
+ * @return true on success.
+ */
+
+bool vkuBuildAssetPack(const char *outputPath, const char **imagePaths, uint32_t imageCount);
+
+/**
+ * @brief Memory-maps a pack written by vkuBuildAssetPack(). Returns NULL if the file is missing or invalid.
+ */
+
+VkuAssetPack vkuOpenAssetPack(const char *path);
+void vkuCloseAssetPack(VkuAssetPack pack);
+
+/**
+ * @brief Creates a VkuTexture2D from a pack entry. Returns NULL if the pack has no texture with that name.
+ */
+
+VkuTexture2D vkuAssetPackLoadTexture2D(VkuContext context, VkuAssetPack pack, const char *name);
+
 typedef struct VkuTextureSamplerCreateInfo
 {
     VkFilter minFilter;
@@ -551,9 +957,25 @@ typedef enum descriptorAttributeOptions
 {
     VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER,
     VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER,
-    VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER
+    VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER,
+    VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER_STATIC,
+    VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_IMAGE,
+    VKU_DESCRIPTOR_SET_ATTRIB_SAMPLED_IMAGE,
+    VKU_DESCRIPTOR_SET_ATTRIB_SEPARATE_SAMPLER,
+    VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_TEXEL_BUFFER,
+    VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_TEXEL_BUFFER
 } descriptorAttributeOptions;
 
+/**
+ * @brief Resources used by each descriptorAttributeOptions value:
+ *
+ * SAMPLER: sampler + tex2D / tex2DArray / storageImage. SAMPLED_IMAGE: tex2D / tex2DArray / storageImage.
+ * SEPARATE_SAMPLER: sampler. STORAGE_IMAGE: storageImage. UNIFORM_BUFFER: uniformBuffer.
+ * STORAGE_BUFFER (dynamic offset, bound with offset 0) and STORAGE_BUFFER_STATIC: storageBuffer + storageBufferRange.
+ * UNIFORM_TEXEL_BUFFER / STORAGE_TEXEL_BUFFER: texelBufferView (see vkuCreateBufferView).
+ */
+
+
 typedef struct VkuDescriptorSetAttribute
 {
     descriptorAttributeOptions type;
@@ -564,6 +986,8 @@ typedef struct VkuDescriptorSetAttribute
     VkShaderStageFlagBits shaderStage;
     VkuBuffer storageBuffer;
     VkDeviceSize storageBufferRange;
+    VkuStorageImage storageImage;
+    VkBufferView texelBufferView;
 } VkuDescriptorSetAttribute;
 
 typedef struct VkuDescriptorSetCreateInfo
@@ -575,6 +999,8 @@ typedef struct VkuDescriptorSetCreateInfo
     VkuContext context;
 } VkuDescriptorSetCreateInfo;
 
+// attributes holds attributeCount entries per set, so vkuDescriptorSetWrite can point each frame at its own resources.
+// The set is registered with every non-static render stage whose outputs it samples and refreshed when they resize.
 typedef struct VkuDescriptorSet_T
 {
     VkuRenderStage renderStage;
@@ -582,10 +1008,14 @@ typedef struct VkuDescriptorSet_T
     VkuDescriptorSetAttribute *attributes;
     uint32_t attributeCount;
     uint32_t setCount;
+    VkuRenderStage *linkedRenderStages;
+    uint32_t linkedRenderStageCount;
 
     VkDescriptorSetLayout setLayout;
+    VkDescriptorUpdateTemplate updateTemplate;
     VkDescriptorPool pool;
     VkDescriptorSet *sets;
+    void *templateData;
 } VkuDescriptorSet_T;
 
 typedef VkuDescriptorSet_T *VkuDescriptorSet;
@@ -593,6 +1023,34 @@ typedef VkuDescriptorSet_T *VkuDescriptorSet;
 VkuDescriptorSet vkuCreateDescriptorSet(VkuDescriptorSetCreateInfo *createInfo);
 void vkuDestroyDescriptorSet(VkuDescriptorSet set);
 
+/**
+ * @brief Rebinds a single attribute of one per-frame set through the set's cached descriptor update template.
+ *
+ * Only the resource handles of the given attribute are taken over, its type has to match the one the set was created
+ * with. Set frameIndex must not be in use by the GPU, e.g. use frame->presenter->currentFrame after vkuPresenterBeginFrame.
+ * The other sets keep their resources, also when render stage outputs are re-pointed after a resize.
+ *
+ * @param set The VkuDescriptorSet to write.
+ * @param frameIndex Index of the per-frame set (0 .. descriptorCount - 1).
+ * @param attribIndex Index of the attribute / binding to rewrite.
+ * @param resource Attribute holding the new sampler, texture or buffer.
+ */
+
+void vkuDescriptorSetWrite(VkuDescriptorSet set, uint32_t frameIndex, uint32_t attribIndex, VkuDescriptorSetAttribute *resource);
+
+/**
+ * @brief Allocates a transient VkDescriptorSet that is valid until this frame slot comes around again.
+ *
+ * Transient sets come from per-frame pools that are reset in bulk in vkuPresenterBeginFrame, so they never have to be
+ * freed. The set still has to be written with vkUpdateDescriptorSets before use.
+ *
+ * @param frame The active VkuFrame.
+ * @param setLayout Layout of the set, e.g. VkuDescriptorSet::setLayout.
+ * @return A VkDescriptorSet.
+ */
+
+VkDescriptorSet vkuFrameAllocateDescriptorSet(VkuFrame frame, VkDescriptorSetLayout setLayout);
+
 typedef struct VkuVertexAttribute
 {
     VkFormat format;
@@ -624,8 +1082,24 @@ typedef struct VkuPipelineCreateInfo
     float depthBiasConstantFactor;
     float depthBiasSlopeFactor;
     VkPrimitiveTopology topology;
+    VkuDescriptorSetAttribute *pushDescriptorAttributes;
+    uint32_t pushDescriptorAttributeCount;
+    VkuDescriptorSet *descriptorSets;
+    uint32_t descriptorSetCount;
+    VkPushConstantRange *pushConstantRanges;
+    uint32_t pushConstantRangeCount;
+    VkSpecializationMapEntry *specializationEntries;
+    uint32_t specializationEntryCount;
+    void *specializationData;
+    size_t specializationDataSize;
+    const char *vertexShaderPath;
+    const char *fragmentShaderPath;
+    VkPipelineColorBlendAttachmentState *blendAttachments;
+    uint32_t blendAttachmentCount;
 } VkuPipelineCreateInfo;
 
+typedef struct VkuPipelineVariant_T *VkuPipelineVariant;
+
 typedef struct VkuPipeline_T
 {
     VkuPipelineCreateInfo recreateInfo;
@@ -633,9 +1107,24 @@ typedef struct VkuPipeline_T
     VkuVertexLayout vertexLayout;
 
     VkPipelineLayout pipelineLayout;
+    VkuPipelineVariant variant;
     VkPipeline graphicsPipeline;
     VkuDescriptorSet descriptorSet;
+    uint32_t descriptorSetIndex;
+    VkuDescriptorSet descriptorSets[VKU_MAX_DESCRIPTOR_SETS];
+    uint32_t descriptorSetCount;
+    VkDescriptorSetLayout setLayouts[VKU_MAX_DESCRIPTOR_SETS];
+    uint32_t setLayoutCount;
+    VkPushConstantRange pushConstantRanges[VKU_MAX_PUSH_CONSTANT_RANGES];
+    uint32_t pushConstantRangeCount;
+    uint64_t pushConstantHash;
+    VkSpecializationInfo specializationInfo;
+    VkDescriptorSetLayout pushDescriptorSetLayout;
+    uint32_t pushDescriptorSetIndex;
+    VkuDescriptorSetAttribute *pushDescriptorAttributes;
+    uint32_t pushDescriptorAttributeCount;
     VkuRenderStage renderStage;
+    VkPipelineColorBlendAttachmentState blendAttachments[VKU_MAX_COLOR_ATTACHMENTS];
 
     char *internalVertexSpirv;
     char *internalFragmentSpirv;
@@ -644,10 +1133,125 @@ typedef struct VkuPipeline_T
 typedef VkuPipeline_T *VkuPipeline;
 
 char *vkuReadFile(const char *filename, uint32_t *length);
+
+typedef struct VkuShaderBinding
+{
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType type;
+    uint32_t count; // 0 for runtime-sized arrays.
+} VkuShaderBinding;
+
+typedef struct VkuShaderReflection_T
+{
+    VkShaderStageFlagBits stage;
+    VkuShaderBinding *bindings;
+    uint32_t bindingCount;
+    uint32_t pushConstantOffset; // Lowest member offset of the push constant block.
+    uint32_t pushConstantSize;   // End of the push constant block.
+    uint32_t *inputLocations; // Every location a vertex input occupies, matrices and 64 bit vectors take several.
+    uint32_t inputLocationCount;
+    uint32_t localSize[3];        // Defaults of the module, before specialization.
+    uint32_t localSizeSpecIds[3]; // SpecId behind each dimension, UINT32_MAX if it isn't specialized.
+} VkuShaderReflection_T;
+
+typedef VkuShaderReflection_T *VkuShaderReflection;
+
+/**
+ * @brief Reflects the interface of a SPIR-V module without external dependencies.
+ *
+ * Extracts the descriptor bindings (uniform / storage buffers, images, samplers and texel buffers), the byte span of the
+ * push constant block, the vertex input locations of vertex shaders and the workgroup size of compute shaders. Buffer
+ * bindings are reported as their non-dynamic type.
+ */
+
+VkuShaderReflection vkuCreateShaderReflection(const char *spirv, uint32_t length);
+void vkuDestroyShaderReflection(VkuShaderReflection reflection);
+
+/**
+ * @brief Workgroup size of a reflected compute shader with the given specialization constants applied.
+ *
+ * Dimensions set through a specialization constant (LocalSizeId or the WorkgroupSize built-in) take the value of the
+ * matching map entry, all others keep the module's default. specializationInfo may be NULL.
+ */
+
+void vkuResolveShaderLocalSize(VkuShaderReflection reflection, const VkSpecializationInfo *specializationInfo, uint32_t localSize[3]);
+
+/**
+ * @brief Creates a graphics pipeline.
+ *
+ * descriptorSets is an ordered array of descriptorSetCount sets, from least to most frequently changing (e.g. per-frame,
+ * per-pass, per-material, per-object), bound at consecutive set numbers. descriptorSet is the single-set shorthand and is
+ * ignored if descriptorSetCount > 0. Pipelines sharing a prefix of set layouts are compatible up to that prefix, so
+ * vkuFrameBindPipeline only rebinds the sets from the first one that actually changed.
+ *
+ * Pipelines with identical state (SPIR-V, vertex layout, raster / depth state, pipeline layout and render pass
+ * compatibility) share one refcounted VkPipeline and one copy of their SPIR-V, so only the first one is compiled.
+ *
+ * With VK_EXT_graphics_pipeline_library (context->graphicsPipelineLibrary) a new combination is fast-linked from cached
+ * vertex input, pre-rasterization, fragment shader and fragment output parts. The link-time optimized pipeline is
+ * built in the background and replaces the fast link at the next vkuFrameBindPipeline. Devices without
+ * graphicsPipelineLibraryFastLinking compile monolithic pipelines instead.
+ *
+ * pushConstantRanges declares up to VKU_MAX_PUSH_CONSTANT_RANGES ranges (one per shader stage) within the device's
+ * maxPushConstantsSize. Without them the pipeline gets a single 128 byte vertex stage range.
+ *
+ * specializationEntries / specializationData specialize both shader stages at pipeline creation (stages ignore constant
+ * IDs they don't declare). They are copied, and pipelines only share a variant if their specialization is identical.
+ *
+ * With context validation enabled both shaders are reflected and checked against the descriptor sets, push constant
+ * ranges and vertex layout of the pipeline.
+ *
+ * vertexShaderPath / fragmentShaderPath name the files the SPIR-V was read from. With shader hot reload enabled on the
+ * context, the pipeline is rebuilt whenever they change. Its layout, descriptor sets and vertex layout stay as created.
+ *
+ * blendAttachments sets the blend state of the render stage's color outputs: one state per output, or a single state
+ * applied to all of them. Without them blending is disabled and all channels are written. Blending can't be enabled
+ * for outputs in formats without blend support, such as integer formats.
+ */
+
 VkuPipeline vkuCreatePipeline(VkuContext context, VkuPipelineCreateInfo *createInfo);
 void vkuDestroyPipeline(VkuContext context, VkuPipeline pipeline);
 void vkuFrameBindPipeline(VkuFrame frame, VkuPipeline pipeline);
+
+/**
+ * @brief Writes push constants of the bound pipeline, starting at offset 0 or at offset.
+ *
+ * The data is pushed to every stage whose range it overlaps, so with per-stage ranges at different offsets each
+ * stage's block has to be written through its own offset.
+ */
+
 void vkuFramePipelinePushConstant(VkuFrame frame, VkuPipeline pipeline, void *data, size_t size);
+void vkuFramePipelinePushConstantRange(VkuFrame frame, VkuPipeline pipeline, uint32_t offset, void *data, size_t size);
+
+/**
+ * @brief Pushes the per-draw resources of a pipeline's push-descriptor set (VK_KHR_push_descriptor).
+ *
+ * The pipeline has to be created with pushDescriptorAttributes, which only define binding types and shader stages.
+ * writes holds one attribute per binding (pushDescriptorAttributeCount) with the resources for the next draws. Nothing
+ * is allocated from a descriptor pool, the descriptors are recorded straight into the command buffer.
+ *
+ * @param frame The active VkuFrame, the pipeline must already be bound.
+ * @param pipeline The VkuPipeline owning the push-descriptor set.
+ * @param writes Array of pushDescriptorAttributeCount attributes holding the resources.
+ */
+
+void vkuFramePushDescriptors(VkuFrame frame, VkuPipeline pipeline, VkuDescriptorSetAttribute *writes);
+
+/**
+ * @brief Overrides the bound pipeline's cull mode, depth state, depth bias, topology or polygon mode.
+ *
+ * Requires context->extendedDynamicState (Vulkan 1.3), vkuFrameSetPolygonMode requires context->dynamicPolygonMode
+ * (VK_EXT_extended_dynamic_state3). On such devices these states no longer create separate pipelines; the values
+ * from VkuPipelineCreateInfo are applied by vkuFrameBindPipeline, so call these after binding. Topologies can only be
+ * changed within their class (points, lines, triangles, patches).
+ */
+
+void vkuFrameSetCullMode(VkuFrame frame, VkCullModeFlags cullMode);
+void vkuFrameSetDepthState(VkuFrame frame, VkBool32 depthTestEnable, VkBool32 depthTestWrite, VkCompareOp depthCompareMode);
+void vkuFrameSetDepthBias(VkuFrame frame, VkBool32 enableDepthBias, float depthBiasConstantFactor, float depthBiasSlopeFactor);
+void vkuFrameSetTopology(VkuFrame frame, VkPrimitiveTopology topology);
+void vkuFrameSetPolygonMode(VkuFrame frame, VkPolygonMode polygonMode);
 
 typedef struct VkuComputeExecutor_T
 {
@@ -679,6 +1283,15 @@ typedef struct VkuComputePipelineCreateInfo
     char * computeShaderSpirV;
     uint32_t computeShaderLength;
     VkuDescriptorSet descriptorSet;
+    VkuDescriptorSet *descriptorSets;
+    uint32_t descriptorSetCount;
+    VkPushConstantRange *pushConstantRanges;
+    uint32_t pushConstantRangeCount;
+    VkSpecializationMapEntry *specializationEntries;
+    uint32_t specializationEntryCount;
+    void *specializationData;
+    size_t specializationDataSize;
+    const char *computeShaderPath;
 } VkuComputePipelineCreateInfo;
 
 typedef struct VkuComputePipeline_T
@@ -688,13 +1301,65 @@ typedef struct VkuComputePipeline_T
     VkPipelineLayout pipelineLayout;
     VkPipeline computePipeline;
     VkuDescriptorSet descriptorSet;
+    VkuDescriptorSet descriptorSets[VKU_MAX_DESCRIPTOR_SETS];
+    uint32_t descriptorSetCount;
+    VkPushConstantRange pushConstantRanges[VKU_MAX_PUSH_CONSTANT_RANGES];
+    uint32_t pushConstantRangeCount;
+    VkSpecializationInfo specializationInfo;
+    uint32_t localSize[3];
 } VkuComputePipeline_T;
 
 typedef VkuComputePipeline_T *VkuComputePipeline;
 
+/**
+ * @brief Creates a compute pipeline.
+ *
+ * specializationEntries / specializationData fix values such as workgroup sizes or loop counts at pipeline creation,
+ * so the driver can constant-fold them instead of reading them from a uniform buffer. The kernel is reflected: its
+ * workgroup size, with the specialization constants applied, ends up in localSize, and without pushConstantRanges
+ * the layout gets exactly the push constant block the kernel declares. With context validation enabled its bindings
+ * are checked against the descriptor sets.
+ * computeShaderPath enables hot reload of the kernel, see VkuPipelineCreateInfo::vertexShaderPath.
+ */
+
 VkuComputePipeline vkuCreateComputePipeline(VkuContext context, VkuComputePipelineCreateInfo *createInfo);
 void vkuDestroyComputePipeline(VkuContext context, VkuComputePipeline computePipeline);
 void vkuComputeRunBindComputePipeline(VkuComputeRun computeRun, VkuComputePipeline pipeline, uint32_t dynamicOffsetCount, uint32_t * dynamicOffsets);
+
+/**
+ * @brief Writes push constants of the bound compute pipeline for the following dispatches.
+ *
+ * Unless VkuComputePipelineCreateInfo declares ranges, the range is the push constant block reflected from the kernel.
+ */
+
+void vkuComputeRunPushConstant(VkuComputeRun computeRun, VkuComputePipeline pipeline, void *data, size_t size);
 void vkuComputeRunDispatch(VkuComputeRun computeRun, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
+typedef struct VkuPipelineBatch_T *VkuPipelineBatch;
+
+/**
+ * @brief Creates many graphics / compute pipelines, compiling them concurrently on one worker thread per CPU core.
+ *
+ * Each worker compiles into its own VkPipelineCache seeded from the context cache; the worker caches are merged back
+ * into the context cache afterwards. Results are identical to calling vkuCreatePipeline / vkuCreateComputePipeline
+ * for every entry.
+ */
+
+void vkuCreatePipelines(VkuContext context, VkuPipelineCreateInfo *infos, uint32_t count, VkuPipeline *outPipelines);
+void vkuCreateComputePipelines(VkuContext context, VkuComputePipelineCreateInfo *infos, uint32_t count, VkuComputePipeline *outPipelines);
+
+/**
+ * @brief Asynchronous variant of vkuCreatePipelines for graphics and compute pipelines at once.
+ *
+ * The returned VkuPipeline / VkuComputePipeline handles are written immediately, but must not be bound or destroyed
+ * before vkuPipelineBatchIsComplete returns true (or vkuPipelineBatchWait returned). A swapchain resize waits for
+ * running batches. Always release the batch with vkuDestroyPipelineBatch, which also merges the worker caches.
+ * vkuDestroyContext joins batches that were not waited on yet; only vkuDestroyPipelineBatch may follow it.
+ */
+
+VkuPipelineBatch vkuCreatePipelinesAsync(VkuContext context, VkuPipelineCreateInfo *infos, uint32_t count, VkuPipeline *outPipelines, VkuComputePipelineCreateInfo *computeInfos, uint32_t computeCount, VkuComputePipeline *outComputePipelines);
+bool vkuPipelineBatchIsComplete(VkuPipelineBatch batch);
+void vkuPipelineBatchWait(VkuPipelineBatch batch);
+void vkuDestroyPipelineBatch(VkuPipelineBatch batch);
+
 #endif
\ No newline at end of file
@@ -34,6 +34,15 @@
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stb/stb_image.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -100,7 +109,12 @@ typedef struct VkuVkDeviceCreateInfo
     VkSurfaceKHR surface;
     VkPhysicalDevice physical_device;
     VkBool32 enable_validation;
+    VkBool32 enable_bindless;
     VkQueue *pGraphicsQueue, *pPresentQueue, *pTransferQueue, *pComputeQueue;
+    VkBool32 *pInlineShaderModules;
+    VkBool32 *pExtendedDynamicState, *pDynamicPolygonMode;
+    VkBool32 *pDynamicRendering;
+    VkBool32 *pGraphicsPipelineLibrary;
 } VkuVkDeviceCreateInfo;
 
 char **vkuGetDeviceExtensions(uint32_t *pDeviceExtensionCount);
@@ -210,6 +224,7 @@ VkFormat vkuFindDepthFormat(VkPhysicalDevice physicalDevice);
 VkuDepthResource vkuCreateDepthResources(VkuDepthResourcesCreateInfo *createInfo);
 void vkuDestroyDepthResources(VmaAllocator allocator, VkDevice device, VkuDepthResource depthResource);
 void vkuTransitionDepthImageLayout(VkDevice device, VkCommandBuffer commandBuffer, VkImage depthImage, uint32_t layerCount);
+void vkuCmdAttachmentBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
 
 typedef struct VkuVkSwapchainKHRCreateInfo
 {
@@ -247,13 +262,13 @@ void vkuDestroySyncObjects(VkDevice device, uint32_t framesInFlight, VkSemaphore
 
 typedef struct VkuVkRenderPassCreateInfo
 {
-    VkFormat format;
+    uint32_t colorAttachmentCount;
+    const VkFormat *colorFormats;
     VkSampleCountFlagBits msaaSamples;
     VkPhysicalDevice physicalDevice;
     VkDevice device;
 
     VkBool32 enableDepthTest;
-    VkBool32 enableTargetColorImage;
     VkBool32 enableTargetDepthImage;
     VkBool32 presentationLayout;
 } VkuVkRenderPassCreateInfo;
@@ -274,7 +289,7 @@ typedef struct VkuVkFramebufferCreateInfo
     VkExtent2D extend;
     VkDevice device;
 
-    VkBool32 enableTargetColorImage;
+    uint32_t colorAttachmentCount; // renderTargetColorImageViews holds colorAttachmentCount views per image.
     VkBool32 enableTargetDepthImage;
     VkBool32 enableDepthTest;
 } VkuVkFramebufferCreateInfo;
@@ -323,6 +338,40 @@ VkImageView vkuCreateTextureImageView(VkDevice device, VkImage image, uint32_t m
 void vkuDestroyTextureImageView(VkDevice device, VkImageView image_view);
 void vkuCreateTextureImageArray(VkuTextureImageArrayCreateInfo *create_info);
 VkImageView vkuCreateTextureImageArrayView(VkDevice device, VkImage image, uint32_t mipLevels, uint32_t layerCount);
+void vkuCmdUploadImageRegions(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage image, VkBufferImageCopy *regions, uint32_t regionCount, uint32_t mipLevels, uint32_t layerCount);
+
+// Every shader stage that may sample an uploaded image.
+#define VKU_SHADER_READ_STAGES (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+
+#define VKU_UPLOAD_BATCH_RING_SIZE (8 * 1024 * 1024)
+#define VKU_UPLOAD_BATCH_ALIGNMENT 16
+#define VKU_UPLOAD_BATCH_NO_FRAME UINT64_MAX
+
+typedef struct VkuUploadBatch_T
+{
+    VkuBuffer stagingRing;
+    uint8_t *stagingMemory;
+    VkDeviceSize head;
+    VkDeviceSize tail;
+
+    VkImage *images;
+    VkBufferImageCopy *regions;
+    uint32_t uploadCount;
+    uint32_t uploadCapacity;
+
+    VkDeviceSize *frameEnds;
+    uint32_t frameCount;
+    uint32_t lastFrame; // Frame that most recently recorded uploads, its ring space is released last.
+} VkuUploadBatch_T;
+
+VkuUploadBatch vkuCreateUploadBatch(VkuContext context);
+void vkuDestroyUploadBatch(VkuContext context, VkuUploadBatch batch);
+VkBool32 vkuUploadBatchAllocate(VkuUploadBatch batch, VkDeviceSize size, VkDeviceSize *offset);
+void vkuUploadBatchRecord(VkuUploadBatch batch, VkCommandBuffer commandBuffer);
+void vkuUploadBatchRetireFrame(VkuUploadBatch batch, uint32_t frameIndex);
+void vkuContextEnqueueImageUpload(VkuContext context, VkImage image, VkBufferImageCopy region, const uint8_t *data, VkDeviceSize size);
+
+uint64_t vkuHash64(const void *data, size_t size, uint64_t seed);
 
 typedef struct VkuUniformBuffersCreateInfo
 {
@@ -341,27 +390,106 @@ typedef struct VkuDescriptorSetsCreateInfo
 {
     uint32_t setCount;
     VkDescriptorSetLayout setLayout;
-    VkDescriptorPool pool;
+    VkuDescriptorAllocator allocator;
+    VkDescriptorPool *pPool;
     VkDevice device;
-    VkuDescriptorSetAttribute *attributes;
-    uint32_t attribCount;
+    const VkDescriptorPoolSize *pPoolSizes;
+    uint32_t poolSizeCount;
 } VkuDescriptorSetsCreateInfo;
 
-VkDescriptorSetLayout vkuCreateDescriptorSetLayout(VkDevice device, VkuDescriptorSetAttribute *attribs, uint32_t attribCount);
+typedef union VkuDescriptorTemplateData
+{
+    VkDescriptorImageInfo image;
+    VkDescriptorBufferInfo buffer;
+    VkBufferView texelBufferView;
+} VkuDescriptorTemplateData;
+
+VkDescriptorType vkuGetDescriptorType(descriptorAttributeOptions type);
+VkDescriptorType vkuGetPushDescriptorType(descriptorAttributeOptions type);
+VkDescriptorSetLayout vkuCreateDescriptorSetLayout(VkDevice device, VkuDescriptorSetAttribute *attribs, uint32_t attribCount, VkDescriptorSetLayoutCreateFlags flags);
 void vkuDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout set_layout);
-VkDescriptorPool vkuCreateDescriptorPool(VkDevice device, VkuDescriptorSetAttribute *attributes, uint32_t attribCount, uint32_t setCount);
+VkDescriptorPool vkuCreateDescriptorPool(VkDevice device, VkDescriptorPoolCreateFlags flags, const VkDescriptorPoolSize *requiredSizes, uint32_t requiredSizeCount, uint32_t requiredSetCount);
 void vkuDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool);
 VkDescriptorSet *vkuCreateDescriptorSets(VkuDescriptorSetsCreateInfo *createInfo);
+VkImageView vkuGetDescriptorImageView(VkuDescriptorSetAttribute *attribute, VkImageLayout *layout);
+void vkuFillDescriptorTemplateData(VkuDescriptorTemplateData *data, VkuDescriptorSetAttribute *attribute, uint32_t frameIndex);
 void vkuDestroyDescriptorSets(VkDescriptorSet *sets);
 
+#define VKU_DESCRIPTOR_POOL_MAX_SETS 256
+#define VKU_DESCRIPTOR_TYPE_COUNT (VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1)
+
+typedef struct VkuDescriptorPoolChain
+{
+    VkDescriptorPool *pools;
+    uint32_t poolCount;
+    uint32_t poolCapacity;
+    uint32_t currentPool;
+} VkuDescriptorPoolChain;
+
+typedef struct VkuDescriptorAllocator_T
+{
+    pthread_mutex_t lock;
+    VkuDescriptorPoolChain shared;
+    VkuDescriptorPoolChain *frames;
+    uint32_t frameCount;
+} VkuDescriptorAllocator_T;
+
+#define VKU_BINDLESS_MAX_MIP_LEVELS 16
+
+typedef struct VkuBindlessRetiredIndex
+{
+    uint32_t index;
+    uint32_t framesSeen;
+} VkuBindlessRetiredIndex;
+
+typedef struct VkuBindlessTable_T
+{
+    pthread_mutex_t lock;
+    VkDescriptorSetLayout setLayout;
+    VkPipelineLayout pipelineLayout;
+    uint64_t pushConstantHash;
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+    VkSampler sampler;
+    uint32_t capacity;
+    uint32_t nextIndex;
+    uint32_t *freeIndices;
+    uint32_t freeIndexCount;
+    VkuBindlessRetiredIndex *retiredIndices;
+    uint32_t retiredIndexCount;
+} VkuBindlessTable_T;
+
+VkuBindlessTable vkuCreateBindlessTable(VkuContext context, uint32_t capacity);
+void vkuDestroyBindlessTable(VkuContext context, VkuBindlessTable table);
+uint32_t vkuContextRegisterBindlessTexture(VkuContext context, VkImageView imageView);
+void vkuContextUnregisterBindlessTexture(VkuContext context, uint32_t index);
+void vkuBindlessTableFrameBoundary(VkuBindlessTable table, uint32_t framesInFlight);
+
+VkuDescriptorAllocator vkuCreateDescriptorAllocator();
+void vkuDescriptorAllocatorClear(VkuDescriptorAllocator allocator, VkDevice device);
+void vkuDestroyDescriptorAllocator(VkuDescriptorAllocator allocator, VkDevice device);
+VkDescriptorPool vkuDescriptorAllocatorAllocate(VkuDescriptorAllocator allocator, VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setCount, VkDescriptorSet *sets, const VkDescriptorPoolSize *requiredSizes, uint32_t requiredSizeCount);
+void vkuDescriptorAllocatorFree(VkuDescriptorAllocator allocator, VkDevice device, VkDescriptorPool pool, VkDescriptorSet *sets, uint32_t setCount);
+void vkuDescriptorAllocatorResetFrame(VkuDescriptorAllocator allocator, VkDevice device, uint32_t frameIndex);
+
 typedef struct VkuGraphicsPipelineCreateInfo
 {
     VkDevice device;
+    VkPipelineCache pipelineCache;
     char *vertexShaderSpirv;
     uint32_t vertexShaderLength;
+    VkShaderModule vertexShaderModule;
     char *fragmentShaderSpirv;
     uint32_t fragmentShaderLength;
+    VkShaderModule fragmentShaderModule;
+    VkSpecializationInfo *specializationInfo;
     VkuVertexLayout vertexInputLayout;
+    uint32_t colorAttachmentCount;
+    const VkFormat *colorAttachmentFormats;
+    const VkPipelineColorBlendAttachmentState *blendAttachments;
+    VkFormat depthAttachmentFormat;
+    VkBool32 extendedDynamicState;
+    VkBool32 dynamicPolygonMode;
     VkExtent2D swapchainExtend;
     VkPolygonMode polygonMode;
     VkPipelineLayout pipelineLayout;
@@ -375,26 +503,359 @@ typedef struct VkuGraphicsPipelineCreateInfo
     float depthBiasConstantFactor;
     float depthBiasSlopeFactor;
     VkPrimitiveTopology topology;
+    VkResult *pResult; // Set to get failures reported here instead of exiting.
 } VkuGraphicsPipelineCreateInfo;
 
-VkPipelineLayout vkuCreatePipelineLayout(VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount);
+VkPipelineLayout vkuCreatePipelineLayout(VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount);
+uint32_t vkuResolvePushConstantRanges(VkuContext context, VkPushConstantRange *ranges, VkPushConstantRange *requestedRanges, uint32_t requestedRangeCount, VkShaderStageFlags defaultStage);
+VkShaderStageFlags vkuGetPushConstantStages(VkPushConstantRange *ranges, uint32_t rangeCount, uint32_t offset, size_t size);
 void vkuDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout);
+
+typedef struct VkuDescriptorBindingKey
+{
+    VkDescriptorType type;
+    VkShaderStageFlags stageFlags;
+    uint32_t count;
+} VkuDescriptorBindingKey;
+
+typedef struct VkuLayoutCacheEntry
+{
+    uint64_t hash;
+    void *key;
+    size_t keySize;
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorUpdateTemplate updateTemplate;
+    VkPipelineLayout pipelineLayout;
+    uint32_t setLayoutCount;
+    uint32_t refCount;
+} VkuLayoutCacheEntry;
+
+typedef struct VkuLayoutCache_T
+{
+    pthread_mutex_t lock;
+    VkuLayoutCacheEntry *setLayouts;
+    uint32_t setLayoutCount, setLayoutCapacity;
+    VkuLayoutCacheEntry *pipelineLayouts;
+    uint32_t pipelineLayoutCount, pipelineLayoutCapacity;
+} VkuLayoutCache_T;
+
+VkuLayoutCache vkuCreateLayoutCache();
+void vkuLayoutCacheClear(VkuLayoutCache cache, VkDevice device);
+void vkuDestroyLayoutCache(VkuLayoutCache cache, VkDevice device);
+uint32_t vkuLayoutCacheGetPoolSizes(VkuLayoutCache cache, VkDescriptorSetLayout setLayout, uint32_t setCount, VkDescriptorPoolSize *sizes);
+
+typedef struct VkuShaderCodeEntry
+{
+    uint64_t hash;
+    char *code;
+    uint32_t length;
+    uint32_t refCount;
+    VkShaderModule module;
+} VkuShaderCodeEntry;
+
+#define VKU_PIPELINE_LIBRARY_PART_COUNT 4
+
+// Also used for the graphics pipeline library parts, which are cached in their own list.
+typedef struct VkuPipelineVariant_T
+{
+    uint64_t hash;
+    void *key;
+    size_t keySize;
+    VkPipeline pipeline;
+    uint32_t refCount;
+    // Set under the cache lock by the one thread compiling pipeline, others wait on the cache's compileCond.
+    bool compiling;
+
+    // With graphics pipeline libraries, pipeline is the fast link of these parts. optimizedPipeline replaces it at
+    // the next bind once the link-time optimized link has finished in the background.
+    VkuPipelineVariant libraries[VKU_PIPELINE_LIBRARY_PART_COUNT];
+    _Atomic(VkPipeline) optimizedPipeline;
+} VkuPipelineVariant_T;
+
+// Everything that decides the compiled VkPipeline. SPIR-V is keyed by the identity of the shared code blob, render
+// passes by their compatibility-relevant parameters, so compatible render stages share variants too.
+typedef struct VkuPipelineVariantKey
+{
+    const char *vertexSpirv;
+    const char *fragmentSpirv;
+    VkPipelineLayout pipelineLayout;
+    VkFormat renderPassFormat;
+    VkSampleCountFlagBits sampleCount;
+    int options;
+    VkBool32 enableDepthTesting;
+    VkBool32 staticRenderStage;
+    VkBool32 dynamicRendering;
+    uint32_t colorAttachmentCount;
+    VkFormat colorAttachmentFormats[VKU_MAX_COLOR_ATTACHMENTS];
+    VkPipelineColorBlendAttachmentState blendAttachments[VKU_MAX_COLOR_ATTACHMENTS];
+    VkPolygonMode polygonMode;
+    VkBool32 depthTestWrite;
+    VkBool32 depthTestEnable;
+    VkCompareOp depthCompareMode;
+    VkCullModeFlags cullMode;
+    VkBool32 enableDepthBias;
+    float depthBiasConstantFactor;
+    float depthBiasSlopeFactor;
+    VkPrimitiveTopology topology;
+    uint32_t vertexSize;
+    uint32_t attributeCount;
+    VkGraphicsPipelineLibraryFlagsEXT libraryPart; // Only set for library keys.
+    VkBool32 fragmentOutput;
+    uint32_t specializationEntryCount;
+    uint32_t specializationDataSize;
+    VkuVertexAttribute attributes[]; // Followed by the specialization map entries and data.
+} VkuPipelineVariantKey;
+
+typedef struct VkuPipelineVariantCache_T
+{
+    pthread_mutex_t lock;
+    VkuPipelineVariant *variants;
+    uint32_t variantCount, variantCapacity;
+    VkuShaderCodeEntry *shaderCodes;
+    uint32_t shaderCodeCount, shaderCodeCapacity;
+    VkuPipelineVariant *libraries;
+    uint32_t libraryCount, libraryCapacity;
+    pthread_cond_t compileCond;
+
+    // Background thread producing the link-time optimized pipelines.
+    pthread_cond_t optimizeCond;
+    VkuPipelineVariant *optimizeQueue;
+    uint32_t optimizeCount, optimizeCapacity;
+    pthread_t optimizeThread;
+    bool optimizerRunning, stopOptimizer;
+} VkuPipelineVariantCache_T;
+
+typedef struct VkuSpirvId
+{
+    uint32_t opcode;
+    const uint32_t *instruction;
+    uint32_t set, binding, location, arrayStride, specId;
+    bool hasSet, hasBinding, hasLocation, hasSpecId, builtIn, bufferBlock;
+} VkuSpirvId;
+
+typedef struct VkuSpirvParser
+{
+    const uint32_t *words;
+    uint32_t wordCount;
+    uint32_t bound;
+    VkuSpirvId *ids; // bound + 1 entries, the last one stands in for out of bounds ids.
+    const char *error;
+} VkuSpirvParser;
+
+void vkuSpirvFail(VkuSpirvParser *parser, const char *error);
+VkuSpirvId *vkuSpirvGetId(VkuSpirvParser *parser, uint32_t id);
+uint32_t vkuSpirvConstantValue(VkuSpirvParser *parser, uint32_t id);
+bool vkuSpirvMemberDecoration(VkuSpirvParser *parser, uint32_t structId, uint32_t member, uint32_t decoration, uint32_t *value);
+uint32_t vkuSpirvTypeSize(VkuSpirvParser *parser, uint32_t typeId, uint32_t depth);
+uint32_t vkuSpirvTypeOffset(VkuSpirvParser *parser, uint32_t typeId);
+uint32_t vkuSpirvLocationCount(VkuSpirvParser *parser, uint32_t typeId, uint32_t depth);
+uint32_t vkuSpirvMinInstructionLength(uint32_t opcode);
+VkuShaderReflection vkuTryCreateShaderReflection(const char *spirv, uint32_t length, const char **error);
+VkDescriptorType vkuGetDescriptorTypeClass(VkDescriptorType type);
+const char *vkuCheckShaderReflection(VkuShaderReflection reflection, VkuDescriptorSet *descriptorSets, uint32_t firstSet, uint32_t descriptorSetCount, VkuDescriptorSetAttribute *pushAttributes, uint32_t pushAttributeCount, VkPushConstantRange *ranges, uint32_t rangeCount);
+void vkuValidateShaderReflection(VkuShaderReflection reflection, VkuDescriptorSet *descriptorSets, uint32_t firstSet, uint32_t descriptorSetCount, VkuDescriptorSetAttribute *pushAttributes, uint32_t pushAttributeCount, VkPushConstantRange *ranges, uint32_t rangeCount);
+
+VkuPipelineVariantCache vkuCreatePipelineVariantCache();
+void vkuPipelineVariantCacheClear(VkuPipelineVariantCache cache, VkDevice device);
+void vkuDestroyPipelineVariantCache(VkuPipelineVariantCache cache, VkDevice device);
+char *vkuContextAcquireShaderCode(VkuContext context, const char *code, uint32_t length);
+void vkuContextReleaseShaderCode(VkuContext context, char *code);
+VkShaderModule vkuContextGetShaderModule(VkuContext context, const char *code);
+VkuPipelineVariant vkuFindPipelineVariant(VkuPipelineVariant *variants, uint32_t variantCount, uint64_t hash, void *key, size_t keySize);
+VkuPipelineVariant vkuContextAcquirePipelineVariant(VkuContext context, VkuPipeline pipeline);
+VkPrimitiveTopology vkuGetTopologyClass(VkPrimitiveTopology topology);
+void vkuContextReleasePipelineVariant(VkuContext context, VkuPipelineVariant variant);
+bool vkuPipelineVariantBeginCompile(VkuContext context, VkuPipelineVariant variant);
+void vkuPipelineVariantEndCompile(VkuContext context, VkuPipelineVariant variant, VkPipeline pipeline);
+VkPipeline vkuPipelineVariantWait(VkuContext context, VkuPipelineVariant variant);
+VkPipeline vkuPipelineVariantPeek(VkuContext context, VkuPipelineVariant variant);
+void vkuPipelineVariantCacheReleaseLibrary(VkuPipelineVariantCache cache, VkDevice device, VkuPipelineVariant library);
+void vkuPipelineVariantCacheStopOptimizer(VkuPipelineVariantCache cache);
+void vkuContextQueuePipelineOptimization(VkuContext context, VkuPipelineVariant variant);
+void *vkuPipelineOptimizerRun(void *arg);
+VkDescriptorUpdateTemplate vkuCreateDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout setLayout, VkuDescriptorBindingKey *bindings, uint32_t bindingCount);
+void vkuDestroyDescriptorUpdateTemplate(VkDevice device, VkDescriptorUpdateTemplate updateTemplate);
+VkDescriptorSetLayout vkuContextAcquireDescriptorSetLayout(VkuContext context, VkuDescriptorSetAttribute *attributes, uint32_t attributeCount, VkDescriptorSetLayoutCreateFlags flags, VkDescriptorUpdateTemplate *pUpdateTemplate);
+void vkuContextReleaseDescriptorSetLayout(VkuContext context, VkDescriptorSetLayout setLayout);
+VkPipelineLayout vkuContextAcquirePipelineLayout(VkuContext context, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount);
+void vkuContextReleasePipelineLayout(VkuContext context, VkPipelineLayout pipelineLayout);
 VkShaderModule vkuCreateShaderModule(const char *shaderCode, uint32_t codeLength, VkDevice device);
+void vkuInitShaderStage(VkPipelineShaderStageCreateInfo *stageInfo, VkShaderModuleCreateInfo *inlineModuleInfo, VkShaderStageFlagBits stage, VkShaderModule module, const char *spirv, uint32_t length);
+void vkuCopySpecializationInfo(VkSpecializationInfo *info, VkSpecializationMapEntry *entries, uint32_t entryCount, const void *data, size_t dataSize);
+void vkuFreeSpecializationInfo(VkSpecializationInfo *info);
+size_t vkuGetSpecializationKeySize(const VkSpecializationInfo *info);
+void vkuWriteSpecializationKey(uint8_t *dst, const VkSpecializationInfo *info);
 VkVertexInputBindingDescription vkuGetVertexInputBindingDescription(VkuVertexLayout *layout);
 VkVertexInputAttributeDescription *vkuGetVertexAttributeDescriptions(VkuVertexLayout *layout);
+
+// Fixed-function and shader state of a graphics pipeline, shared by full pipelines and pipeline library parts.
+typedef struct VkuGraphicsPipelineState
+{
+    VkPipelineShaderStageCreateInfo shaderStages[2];
+    VkShaderModuleCreateInfo inlineModules[2];
+    VkDynamicState dynamicStates[11];
+    VkPipelineDynamicStateCreateInfo dynamicState;
+    VkVertexInputBindingDescription bindingDescription;
+    VkVertexInputAttributeDescription *attributeDescriptions;
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo;
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+    VkViewport viewport;
+    VkRect2D scissor;
+    VkPipelineViewportStateCreateInfo viewportState;
+    VkPipelineRasterizationStateCreateInfo rasterizer;
+    VkPipelineMultisampleStateCreateInfo multisampling;
+    VkPipelineDepthStencilStateCreateInfo depthStencil;
+    VkPipelineColorBlendAttachmentState colorBlendAttachments[VKU_MAX_COLOR_ATTACHMENTS];
+    VkPipelineColorBlendStateCreateInfo colorBlending;
+    VkPipelineRenderingCreateInfo renderingInfo;
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo;
+} VkuGraphicsPipelineState;
+
+void vkuInitGraphicsPipelineState(VkuGraphicsPipelineState *state, VkuGraphicsPipelineCreateInfo *createInfo);
 VkPipeline vkuCreateGraphicsPipeline(VkuGraphicsPipelineCreateInfo *createInfo);
+VkPipeline vkuCreateGraphicsPipelineLibrary(VkuGraphicsPipelineCreateInfo *createInfo, VkGraphicsPipelineLibraryFlagsEXT part);
+VkPipeline vkuLinkGraphicsPipeline(VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkPipeline *libraries, VkBool32 optimize, VkResult *pResult);
+void vkuCheckPipelineResult(VkResult result, VkResult *pResult);
 void vkuDestroyVkPipeline(VkDevice device, VkPipeline pipeline);
 
 typedef struct VkuComputeVkPipelineCreateInfo
 {
     VkDevice device;
+    VkPipelineCache pipelineCache;
     char *computeShaderSpirv;
     uint32_t computeShaderLength;
+    VkShaderModule computeShaderModule;
+    VkSpecializationInfo *specializationInfo;
     VkPipelineLayout pipelineLayout;
+    VkResult *pResult; // Set to get failures reported here instead of exiting.
 } VkuComputeVkPipelineCreateInfo;
 
 VkPipeline vkuCreateComputeVkPipeline(VkuComputeVkPipelineCreateInfo *createInfo);
 
+VkPipelineCache vkuCreatePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char *path);
+bool vkuSavePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path);
+void vkuDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache);
+
+VkuPipeline vkuPreparePipeline(VkuContext context, VkuPipelineCreateInfo *createInfo);
+void vkuContextWaitPipelineBatches(VkuContext context);
+VkBool32 vkuRenderStageHasColorTarget(VkuRenderStage renderStage);
+void vkuRenderStageInitColorOutputs(VkuRenderStage renderStage, uint32_t colorAttachmentCount, VkFormat *colorAttachmentFormats);
+VkBool32 vkuRenderStageSupportsMSAA(VkuRenderStage renderStage);
+void vkuRenderStageCreateColorOutputs(VkuRenderStage renderStage, VkExtent2D extent);
+void vkuRenderStageDestroyColorOutputs(VkuRenderStage renderStage);
+VkPipeline vkuPipelineCompile(VkuPipeline pipeline, VkPipelineCache pipelineCache, VkResult *pResult);
+VkuPipelineVariant vkuPipelineAcquireLibrary(VkuPipeline pipeline, VkuGraphicsPipelineCreateInfo *createInfo, VkGraphicsPipelineLibraryFlagsEXT part);
+const char *vkuCheckPipelineShader(VkuPipeline pipeline, const char *spirv, uint32_t length);
+void vkuPipelineAcquireVariant(VkuPipeline pipeline);
+void vkuPipelineCompileVariant(VkuPipeline pipeline);
+VkuComputePipeline vkuPrepareComputePipeline(VkuContext context, VkuComputePipelineCreateInfo *createInfo);
+VkPipeline vkuComputePipelineCompile(VkuContext context, VkuComputePipeline pipeline, VkPipelineCache pipelineCache, VkResult *pResult);
+
+typedef struct VkuPipelineBatchWorker
+{
+    VkuPipelineBatch batch;
+    VkPipelineCache pipelineCache;
+    pthread_t thread;
+} VkuPipelineBatchWorker;
+
+typedef struct VkuPipelineBatch_T
+{
+    VkuContext context;
+    VkuPipeline *pipelines;
+    uint32_t pipelineCount;
+    VkuPipeline *compilePipelines;
+    uint32_t compilePipelineCount;
+    VkuComputePipeline *computePipelines;
+    uint32_t computePipelineCount;
+
+    VkuPipelineBatchWorker *workers;
+    uint32_t workerCount;
+    atomic_uint nextIndex;
+    atomic_uint runningWorkers;
+    atomic_bool complete;
+    bool joined;
+} VkuPipelineBatch_T;
+
+// Watched shader file of a pipeline. The directory is watched rather than the file, so editors that save by renaming a
+// new file over the old one are noticed as well.
+typedef struct VkuShaderWatch
+{
+    char *path;
+    const char *name;
+    int watchDescriptor;
+    VkuPipeline pipeline;
+    VkuComputePipeline computePipeline;
+    uint32_t stageIndex; // 0 = vertex / compute, 1 = fragment
+} VkuShaderWatch;
+
+// A presenter or compute executor passing frame boundaries. In a retired reload, boundary is the boundary count the
+// owner has to reach before none of its frames can reference the replaced objects anymore.
+typedef struct VkuShaderReloadOwner
+{
+    void *owner;
+    uint64_t boundary;
+    uint32_t framesInFlight;
+} VkuShaderReloadOwner;
+
+// A recompiled pipeline waiting for the next frame boundary. After the swap it holds the replaced objects until every
+// frame that could still reference them has completed.
+typedef struct VkuShaderReload
+{
+    VkuPipeline pipeline;
+    VkuComputePipeline computePipeline;
+    char *spirv[2];
+    uint32_t spirvLength[2];
+    VkuPipelineVariant variant;
+    VkPipeline computeVkPipeline;
+    uint32_t localSize[3];
+    VkuShaderReloadOwner *waitFor;
+    uint32_t waitForCount;
+} VkuShaderReload;
+
+typedef struct VkuShaderWatcher_T
+{
+    VkuContext context;
+    int inotifyFd;
+    pthread_t thread;
+    atomic_bool stop;
+
+    pthread_mutex_t compileLock;
+    pthread_mutex_t lock;
+    VkuShaderWatch *watches;
+    uint32_t watchCount;
+    uint32_t watchCapacity;
+    VkuShaderReload *pending;
+    uint32_t pendingCount;
+    uint32_t pendingCapacity;
+    VkuShaderReload *retired;
+    uint32_t retiredCount;
+    uint32_t retiredCapacity;
+    VkuShaderReloadOwner *owners;
+    uint32_t ownerCount;
+    uint32_t ownerCapacity;
+    VkuPipeline *retries;
+    uint32_t retryCount;
+    uint32_t retryCapacity;
+} VkuShaderWatcher_T;
+
+VkuShaderWatcher vkuCreateShaderWatcher(VkuContext context);
+void vkuDestroyShaderWatcher(VkuShaderWatcher watcher);
+void vkuShaderWatcherAdd(VkuShaderWatcher watcher, const char *path, VkuPipeline pipeline, VkuComputePipeline computePipeline, uint32_t stageIndex);
+void vkuShaderWatcherRemove(VkuShaderWatcher watcher, void *pipeline);
+void vkuShaderWatcherPushReload(VkuShaderReload **reloads, uint32_t *count, uint32_t *capacity, VkuShaderReload *reload);
+void vkuShaderWatcherReleaseReload(VkuContext context, VkuShaderReload *reload);
+char *vkuShaderWatcherReadSpirv(const char *path, uint32_t *length);
+bool vkuShaderWatcherReloadPipeline(VkuShaderWatcher watcher, VkuPipeline pipeline, VkuShaderReload *reload);
+bool vkuShaderWatcherReloadComputePipeline(VkuShaderWatcher watcher, VkuComputePipeline pipeline, VkuShaderReload *reload);
+#ifdef __linux__
+void *vkuShaderWatcherRun(void *arg);
+#endif
+void vkuShaderWatcherReleaseRetired(VkuShaderWatcher watcher);
+void vkuShaderWatcherFrameBoundary(VkuShaderWatcher watcher, void *owner, uint32_t framesInFlight, bool compute);
+void vkuShaderWatcherRemoveOwner(VkuShaderWatcher watcher, void *owner);
+void vkuContextPauseShaderReload(VkuContext context);
+void vkuContextResumeShaderReload(VkuContext context);
+
 // ===== BASIC HELPER C FUNCTIONS =====
 
 VkuObjectManager vkuCreateObjectManager(size_t elementSize)
@@ -918,8 +1379,151 @@ VkDevice vkuCreateVkDevice(VkuVkDeviceCreateInfo *create_info)
     if (bufferDeviceAddressFeatures.bufferDeviceAddress)
         createInfo.pNext = &bufferDeviceAddressFeatures;
 
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    if (create_info->enable_bindless)
+    {
+        VkPhysicalDeviceFeatures2 indexingQuery = {};
+        indexingQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        indexingQuery.pNext = &descriptorIndexingFeatures;
+        vkGetPhysicalDeviceFeatures2(create_info->physical_device, &indexingQuery);
+
+        if (!descriptorIndexingFeatures.runtimeDescriptorArray || !descriptorIndexingFeatures.descriptorBindingPartiallyBound ||
+            !descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind || !descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending ||
+            !descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing)
+            EXIT("VkuError: Bindless textures require descriptor indexing support!\n");
+
+        memset(&descriptorIndexingFeatures, 0, sizeof(descriptorIndexingFeatures));
+        descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        descriptorIndexingFeatures.pNext = (void *)createInfo.pNext;
+        createInfo.pNext = &descriptorIndexingFeatures;
+    }
+
     uint32_t device_extension_count = 0;
     char **device_extensions = vkuGetDeviceExtensions(&device_extension_count);
+
+    char *optional_extensions[] = {VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME};
+    for (uint32_t i = 0; i < sizeof(optional_extensions) / sizeof(optional_extensions[0]); i++)
+        if (vkuCheckPhysicalDeviceExtensionSupport(create_info->physical_device, &optional_extensions[i], 1))
+            vkuAddStringToArray(&device_extensions, &device_extension_count, optional_extensions[i]);
+
+    // maintenance5 lets pipelines take SPIR-V inline instead of through VkShaderModule objects.
+    VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features = {};
+    maintenance5Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+
+    char *maintenance5Extension = VK_KHR_MAINTENANCE_5_EXTENSION_NAME;
+    if (vkuCheckPhysicalDeviceExtensionSupport(create_info->physical_device, &maintenance5Extension, 1))
+    {
+        VkPhysicalDeviceFeatures2 maintenance5Query = {};
+        maintenance5Query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        maintenance5Query.pNext = &maintenance5Features;
+        vkGetPhysicalDeviceFeatures2(create_info->physical_device, &maintenance5Query);
+
+        if (maintenance5Features.maintenance5)
+        {
+            maintenance5Features.pNext = (void *)createInfo.pNext;
+            createInfo.pNext = &maintenance5Features;
+            vkuAddStringToArray(&device_extensions, &device_extension_count, maintenance5Extension);
+        }
+    }
+
+    if (create_info->pInlineShaderModules != NULL)
+        *create_info->pInlineShaderModules = maintenance5Features.maintenance5;
+
+    // Extended dynamic state 1 / 2 is core since Vulkan 1.3, polygon mode needs extended dynamic state 3.
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(create_info->physical_device, &deviceProperties);
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features = {};
+    dynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    VkBool32 dynamicPolygonMode = VK_FALSE;
+
+    char *dynamicState3Extension = VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_3 && vkuCheckPhysicalDeviceExtensionSupport(create_info->physical_device, &dynamicState3Extension, 1))
+    {
+        VkPhysicalDeviceFeatures2 dynamicState3Query = {};
+        dynamicState3Query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        dynamicState3Query.pNext = &dynamicState3Features;
+        vkGetPhysicalDeviceFeatures2(create_info->physical_device, &dynamicState3Query);
+
+        dynamicPolygonMode = dynamicState3Features.extendedDynamicState3PolygonMode;
+        if (dynamicPolygonMode)
+        {
+            memset(&dynamicState3Features, 0, sizeof(dynamicState3Features));
+            dynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+            dynamicState3Features.extendedDynamicState3PolygonMode = VK_TRUE;
+            dynamicState3Features.pNext = (void *)createInfo.pNext;
+            createInfo.pNext = &dynamicState3Features;
+            vkuAddStringToArray(&device_extensions, &device_extension_count, dynamicState3Extension);
+        }
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = {};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_3)
+    {
+        VkPhysicalDeviceFeatures2 dynamicRenderingQuery = {};
+        dynamicRenderingQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        dynamicRenderingQuery.pNext = &dynamicRenderingFeatures;
+        vkGetPhysicalDeviceFeatures2(create_info->physical_device, &dynamicRenderingQuery);
+
+        if (dynamicRenderingFeatures.dynamicRendering)
+        {
+            dynamicRenderingFeatures.pNext = (void *)createInfo.pNext;
+            createInfo.pNext = &dynamicRenderingFeatures;
+        }
+    }
+
+    // Graphics pipeline libraries let pipelines be linked from separately compiled and cached parts. Without fast
+    // linking the link is a full compile on the calling thread, monolithic pipelines are cheaper then.
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures = {};
+    pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    VkBool32 graphicsPipelineLibrary = VK_FALSE;
+
+    char *pipelineLibraryExtensions[] = {VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME};
+    if (vkuCheckPhysicalDeviceExtensionSupport(create_info->physical_device, pipelineLibraryExtensions, 2))
+    {
+        VkPhysicalDeviceFeatures2 pipelineLibraryQuery = {};
+        pipelineLibraryQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        pipelineLibraryQuery.pNext = &pipelineLibraryFeatures;
+        vkGetPhysicalDeviceFeatures2(create_info->physical_device, &pipelineLibraryQuery);
+
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT pipelineLibraryProperties = {};
+        pipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 pipelineLibraryPropertiesQuery = {};
+        pipelineLibraryPropertiesQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        pipelineLibraryPropertiesQuery.pNext = &pipelineLibraryProperties;
+        vkGetPhysicalDeviceProperties2(create_info->physical_device, &pipelineLibraryPropertiesQuery);
+
+        graphicsPipelineLibrary = pipelineLibraryFeatures.graphicsPipelineLibrary && pipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+        if (graphicsPipelineLibrary)
+        {
+            memset(&pipelineLibraryFeatures, 0, sizeof(pipelineLibraryFeatures));
+            pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            pipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+            pipelineLibraryFeatures.pNext = (void *)createInfo.pNext;
+            createInfo.pNext = &pipelineLibraryFeatures;
+            vkuAddStringToArray(&device_extensions, &device_extension_count, pipelineLibraryExtensions[0]);
+            vkuAddStringToArray(&device_extensions, &device_extension_count, pipelineLibraryExtensions[1]);
+        }
+    }
+
+    if (create_info->pGraphicsPipelineLibrary != NULL)
+        *create_info->pGraphicsPipelineLibrary = graphicsPipelineLibrary;
+    if (create_info->pDynamicRendering != NULL)
+        *create_info->pDynamicRendering = dynamicRenderingFeatures.dynamicRendering;
+    if (create_info->pExtendedDynamicState != NULL)
+        *create_info->pExtendedDynamicState = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+    if (create_info->pDynamicPolygonMode != NULL)
+        *create_info->pDynamicPolygonMode = dynamicPolygonMode;
+
     createInfo.enabledExtensionCount = device_extension_count;
     createInfo.ppEnabledExtensionNames = (const char **)device_extensions;
 
@@ -1448,6 +2052,26 @@ void vkuDestroyDepthResources(VmaAllocator allocator, VkDevice device, VkuDepthR
     free(depthResource);
 }
 
+void vkuCmdAttachmentBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = aspectMask;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
 void vkuTransitionDepthImageLayout(VkDevice device, VkCommandBuffer commandBuffer, VkImage depthImage, uint32_t layerCount)
 {
     VkImageMemoryBarrier barrier = {};
@@ -1670,20 +2294,23 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
 
     VkImageLayout finalLayout = createInfo->presentationLayout ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    VkAttachmentDescription2 attachments[4];
+    VkAttachmentDescription2 attachments[VKU_MAX_COLOR_ATTACHMENTS * 2 + 2];
     uint32_t attachmentCount = 0;
 
-    VkAttachmentReference2 colorAttachmentRef = {};
+    VkAttachmentReference2 colorAttachmentRefs[VKU_MAX_COLOR_ATTACHMENTS] = {};
     VkAttachmentReference2 depthAttachmentRef = {};
-    VkAttachmentReference2 colorAttachmentResolveRef = {};
+    VkAttachmentReference2 colorAttachmentResolveRefs[VKU_MAX_COLOR_ATTACHMENTS] = {};
     VkAttachmentReference2 depthAttachmentResolveRef = {};
 
-    // Color attachment
-    if (createInfo->enableTargetColorImage)
+    if (createInfo->colorAttachmentCount > VKU_MAX_COLOR_ATTACHMENTS)
+        EXIT("VkuError: Render pass creation: Too many color attachments!\n");
+
+    // Color attachments
+    for (uint32_t i = 0; i < createInfo->colorAttachmentCount; i++)
     {
         VkAttachmentDescription2 colorAttachment = {};
         colorAttachment.sType = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
-        colorAttachment.format = createInfo->format;
+        colorAttachment.format = createInfo->colorFormats[i];
         colorAttachment.samples = createInfo->msaaSamples;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -1697,9 +2324,9 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
             colorAttachment.finalLayout = finalLayout;
 
         attachments[attachmentCount] = colorAttachment;
-        colorAttachmentRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
-        colorAttachmentRef.attachment = attachmentCount++;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachmentRefs[i].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+        colorAttachmentRefs[i].attachment = attachmentCount++;
+        colorAttachmentRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     }
 
     // Depth attachment
@@ -1722,12 +2349,12 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
         depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     }
 
-    // Color resolve attachment
-    if (createInfo->enableTargetColorImage && createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT)
+    // Color resolve attachments
+    for (uint32_t i = 0; i < createInfo->colorAttachmentCount && createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT; i++)
     {
         VkAttachmentDescription2 colorAttachmentResolve = {};
         colorAttachmentResolve.sType = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
-        colorAttachmentResolve.format = createInfo->format;
+        colorAttachmentResolve.format = createInfo->colorFormats[i];
         colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
         colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -1737,9 +2364,9 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
         colorAttachmentResolve.finalLayout = finalLayout;
 
         attachments[attachmentCount] = colorAttachmentResolve;
-        colorAttachmentResolveRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
-        colorAttachmentResolveRef.attachment = attachmentCount++;
-        colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachmentResolveRefs[i].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+        colorAttachmentResolveRefs[i].attachment = attachmentCount++;
+        colorAttachmentResolveRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     }
 
     // Depth resolve attachment
@@ -1767,9 +2394,9 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
     subpass.sType = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2;
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
-    if (createInfo->enableTargetColorImage) {
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
+    if (createInfo->colorAttachmentCount > 0) {
+        subpass.colorAttachmentCount = createInfo->colorAttachmentCount;
+        subpass.pColorAttachments = colorAttachmentRefs;
     } else {
         subpass.colorAttachmentCount = 0;
         subpass.pColorAttachments = NULL; // Explicitly no color attachments
@@ -1788,9 +2415,9 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
 
     if (createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT)
     {
-        if (createInfo->enableTargetColorImage)
+        if (createInfo->colorAttachmentCount > 0)
         {
-            subpass.pResolveAttachments = &colorAttachmentResolveRef;
+            subpass.pResolveAttachments = colorAttachmentResolveRefs;
         }
 
         if (createInfo->enableTargetDepthImage)
@@ -1809,7 +2436,7 @@ VkRenderPass vkuCreateVkRenderPass(VkuVkRenderPassCreateInfo *createInfo)
     dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-    if (createInfo->enableTargetColorImage)
+    if (createInfo->colorAttachmentCount > 0)
     {
         dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -1840,14 +2467,18 @@ void vkuDestroyVkRenderPass(VkDevice device, VkRenderPass renderPass)
 
 VkFramebuffer *vkuCreateVkFramebuffer(VkuVkFramebufferCreateInfo *createInfo)
 {
+    if (createInfo->colorAttachmentCount > VKU_MAX_COLOR_ATTACHMENTS)
+        EXIT("VkuError: Framebuffer is created with more than VKU_MAX_COLOR_ATTACHMENTS color attachments!\n");
+
     VkFramebuffer *framebuffers = (VkFramebuffer *)malloc(sizeof(VkFramebuffer) * createInfo->imageCount);
 
     for (uint32_t i = 0; i < createInfo->imageCount; i++)
     {
         uint32_t attachmentCount = 0;
-        VkImageView attachments[4] = {};
+        VkImageView attachments[VKU_MAX_COLOR_ATTACHMENTS * 2 + 2] = {};
+        VkImageView *colorViews = createInfo->renderTargetColorImageViews + i * createInfo->colorAttachmentCount;
 
-        if (createInfo->enableTargetColorImage)
+        for (uint32_t j = 0; j < createInfo->colorAttachmentCount; j++)
         {
             if (createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT)
             {
@@ -1855,7 +2486,7 @@ VkFramebuffer *vkuCreateVkFramebuffer(VkuVkFramebufferCreateInfo *createInfo)
             }
             else
             {
-                attachments[attachmentCount++] = createInfo->renderTargetColorImageViews[i];
+                attachments[attachmentCount++] = colorViews[j];
             }
         }
 
@@ -1871,9 +2502,9 @@ VkFramebuffer *vkuCreateVkFramebuffer(VkuVkFramebufferCreateInfo *createInfo)
             }
         }
 
-        if (createInfo->enableTargetColorImage && createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT)
+        for (uint32_t j = 0; j < createInfo->colorAttachmentCount && createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT; j++)
         {
-            attachments[attachmentCount++] = createInfo->renderTargetColorImageViews[i];
+            attachments[attachmentCount++] = colorViews[j];
         }
 
         if (createInfo->enableTargetDepthImage && createInfo->msaaSamples != VK_SAMPLE_COUNT_1_BIT)
@@ -1881,14 +2512,6 @@ VkFramebuffer *vkuCreateVkFramebuffer(VkuVkFramebufferCreateInfo *createInfo)
             attachments[attachmentCount++] = createInfo->renderTargetDepthImageViews[0];
         }
 
-        // Ensure attachment count doesn't exceed array bounds
-        if (attachmentCount > 4)
-        {
-            fprintf(stderr, "Error: Too many attachments for framebuffer!\n");
-            free(framebuffers);
-            return NULL;
-        }
-
         // Framebuffer creation info
         VkFramebufferCreateInfo framebufferInfo = {};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -1914,6 +2537,9 @@ VkFramebuffer *vkuCreateVkFramebuffer(VkuVkFramebufferCreateInfo *createInfo)
 
 void vkuDestroyFramebuffer(VkDevice device, VkFramebuffer *framebuffer, uint32_t framebuffer_count)
 {
+    if (framebuffer == NULL)
+        return;
+
     for (uint32_t i = 0; i < framebuffer_count; i++)
         vkDestroyFramebuffer(device, framebuffer[i], NULL);
 
@@ -1993,6 +2619,14 @@ void vkuTransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldL
         sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
         destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     }
+    else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_GENERAL)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
     else
         EXIT("Unsupported Image Layout Transition!\n");
 
@@ -2247,6 +2881,34 @@ VkImageView vkuCreateTextureImageArrayView(VkDevice device, VkImage image, uint3
     return view;
 }
 
+void vkuCmdUploadImageRegions(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage image, VkBufferImageCopy *regions, uint32_t regionCount, uint32_t mipLevels, uint32_t layerCount)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layerCount;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VKU_SHADER_READ_STAGES, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+    vkCmdCopyBufferToImage(commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VKU_SHADER_READ_STAGES, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
 // VkSampler
 
 typedef struct VkuSamplerCreateInfo
@@ -2343,7 +3005,47 @@ void vkuDestroyUniformBuffers(VmaAllocator allocator, VkBuffer *uniBuffer, VmaAl
 
 // DescriptorSet & Pool
 
-VkDescriptorSetLayout vkuCreateDescriptorSetLayout(VkDevice device, VkuDescriptorSetAttribute *attribs, uint32_t attribCount)
+VkDescriptorType vkuGetDescriptorType(descriptorAttributeOptions type)
+{
+    switch (type)
+    {
+    case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER:
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER_STATIC:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_IMAGE:
+        return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLED_IMAGE:
+        return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    case VKU_DESCRIPTOR_SET_ATTRIB_SEPARATE_SAMPLER:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+    case VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_TEXEL_BUFFER:
+        return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_TEXEL_BUFFER:
+        return VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+    default:
+        EXIT("VkuError: Unknown descriptor attribute type!\n");
+    }
+
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+VkDescriptorType vkuGetPushDescriptorType(descriptorAttributeOptions type)
+{
+    // Dynamic buffers are not allowed in push-descriptor sets, offsets go into the buffer info instead.
+    VkDescriptorType descriptorType = vkuGetDescriptorType(type);
+    if (descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    if (descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    return descriptorType;
+}
+
+VkDescriptorSetLayout vkuCreateDescriptorSetLayout(VkDevice device, VkuDescriptorSetAttribute *attribs, uint32_t attribCount, VkDescriptorSetLayoutCreateFlags flags)
 {
     VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
     VkDescriptorSetLayoutBinding *bindings = (VkDescriptorSetLayoutBinding *)malloc(sizeof(VkDescriptorSetLayoutBinding) * attribCount);
@@ -2354,25 +3056,12 @@ VkDescriptorSetLayout vkuCreateDescriptorSetLayout(VkDevice device, VkuDescripto
         bindings[i].descriptorCount = 1;
         bindings[i].pImmutableSamplers = NULL;
         bindings[i].stageFlags = attribs[i].shaderStage;
-
-        if (attribs[i].type == VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER)
-        {
-            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        }
-
-        if (attribs[i].type == VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER)
-        {
-            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        }
-
-        if (attribs[i].type == VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER)
-        {
-            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-        }
+        bindings[i].descriptorType = (flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) ? vkuGetPushDescriptorType(attribs[i].type) : vkuGetDescriptorType(attribs[i].type);
     }
 
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.flags = flags;
     layoutInfo.bindingCount = attribCount;
     layoutInfo.pBindings = bindings;
 
@@ -2390,28 +3079,46 @@ void vkuDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout set_la
     vkDestroyDescriptorSetLayout(device, set_layout, NULL);
 }
 
-VkDescriptorPool vkuCreateDescriptorPool(VkDevice device, VkuDescriptorSetAttribute *attributes, uint32_t attribCount, uint32_t setCount)
+VkDescriptorPool vkuCreateDescriptorPool(VkDevice device, VkDescriptorPoolCreateFlags flags, const VkDescriptorPoolSize *requiredSizes, uint32_t requiredSizeCount, uint32_t requiredSetCount)
 {
     VkDescriptorPool pool = VK_NULL_HANDLE;
 
-    VkDescriptorPoolSize poolSizes[attribCount];
+    VkDescriptorPoolSize defaultSizes[] = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VKU_DESCRIPTOR_POOL_MAX_SETS * 4},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VKU_DESCRIPTOR_POOL_MAX_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VKU_DESCRIPTOR_POOL_MAX_SETS},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VKU_DESCRIPTOR_POOL_MAX_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VKU_DESCRIPTOR_POOL_MAX_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VKU_DESCRIPTOR_POOL_MAX_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, VKU_DESCRIPTOR_POOL_MAX_SETS},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, VKU_DESCRIPTOR_POOL_MAX_SETS},
+        {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, VKU_DESCRIPTOR_POOL_MAX_SETS},
+    };
+
+    uint32_t defaultSizeCount = sizeof(defaultSizes) / sizeof(defaultSizes[0]);
+    VkDescriptorPoolSize poolSizes[defaultSizeCount + requiredSizeCount];
+    memcpy(poolSizes, defaultSizes, sizeof(defaultSizes));
+    uint32_t poolSizeCount = defaultSizeCount;
 
-    for (uint32_t i = 0; i < attribCount; i++)
+    // A pool has to fit at least the allocation that triggered it, larger layouts would fail again otherwise.
+    for (uint32_t i = 0; i < requiredSizeCount; i++)
     {
-        if (attributes[i].type == VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER)
-            poolSizes[i].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        if (attributes[i].type == VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER)
-            poolSizes[i].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        if (attributes[i].type == VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER)
-            poolSizes[i].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-        poolSizes[i].descriptorCount = setCount;
+        uint32_t j = 0;
+        while (j < poolSizeCount && poolSizes[j].type != requiredSizes[i].type)
+            j++;
+
+        if (j == poolSizeCount)
+            poolSizes[poolSizeCount++] = requiredSizes[i];
+        else if (poolSizes[j].descriptorCount < requiredSizes[i].descriptorCount)
+            poolSizes[j].descriptorCount = requiredSizes[i].descriptorCount;
     }
 
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = attribCount;
+    poolInfo.flags = flags;
+    poolInfo.poolSizeCount = poolSizeCount;
     poolInfo.pPoolSizes = poolSizes;
-    poolInfo.maxSets = setCount;
+    poolInfo.maxSets = (requiredSetCount > VKU_DESCRIPTOR_POOL_MAX_SETS) ? requiredSetCount : VKU_DESCRIPTOR_POOL_MAX_SETS;
 
     VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, NULL, &pool));
     return pool;
@@ -2429,89 +3136,70 @@ VkDescriptorSet *vkuCreateDescriptorSets(VkuDescriptorSetsCreateInfo *createInfo
     for (uint32_t i = 0; i < createInfo->setCount; i++)
         layouts[i] = createInfo->setLayout;
 
-    VkDescriptorSetAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = createInfo->pool;
-    allocInfo.descriptorSetCount = createInfo->setCount;
-    allocInfo.pSetLayouts = layouts;
-
     VkDescriptorSet *descriptor_sets = (VkDescriptorSet *)malloc(sizeof(VkDescriptorSet) * createInfo->setCount);
     if (descriptor_sets == NULL)
     {
         return NULL;
     }
 
-    VK_CHECK(vkAllocateDescriptorSets(createInfo->device, &allocInfo, descriptor_sets));
+    *createInfo->pPool = vkuDescriptorAllocatorAllocate(createInfo->allocator, createInfo->device, layouts, createInfo->setCount, descriptor_sets, createInfo->pPoolSizes, createInfo->poolSizeCount);
 
-    for (uint32_t i = 0; i < createInfo->setCount; i++)
-    {
-        VkWriteDescriptorSet descriptorWrites[createInfo->attribCount];
-        memset(descriptorWrites, 0, sizeof(descriptorWrites));
+    return descriptor_sets;
+}
 
-        VkDescriptorImageInfo imageInfos[createInfo->attribCount];
-        VkDescriptorBufferInfo bufferInfos[createInfo->attribCount];
+VkImageView vkuGetDescriptorImageView(VkuDescriptorSetAttribute *attribute, VkImageLayout *layout)
+{
+    *layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-        for (uint32_t j = 0; j < createInfo->attribCount; j++)
-        {
-            if (createInfo->attributes[j].type == VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER)
-            {
-                imageInfos[j].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                imageInfos[j].sampler = createInfo->attributes[j].sampler->sampler;
-                if (createInfo->attributes[j].tex2D != NULL)
-                    imageInfos[j].imageView = createInfo->attributes[j].tex2D->textureImageView;
-                else if (createInfo->attributes[j].tex2DArray != NULL)
-                    imageInfos[j].imageView = createInfo->attributes[j].tex2DArray->textureImageView;
-                else
-                    imageInfos[j].imageView = VK_NULL_HANDLE;
-
-                descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[j].dstSet = descriptor_sets[i];
-                descriptorWrites[j].dstBinding = j;
-                descriptorWrites[j].dstArrayElement = 0;
-                descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptorWrites[j].descriptorCount = 1;
-                descriptorWrites[j].pImageInfo = &imageInfos[j];
-                descriptorWrites[j].pBufferInfo = NULL;
-                descriptorWrites[j].pTexelBufferView = NULL;
-            }
+    if (attribute->tex2D != NULL)
+        return attribute->tex2D->textureImageView;
+    if (attribute->tex2DArray != NULL)
+        return attribute->tex2DArray->textureImageView;
+    if (attribute->storageImage != NULL)
+    {
+        *layout = VK_IMAGE_LAYOUT_GENERAL;
+        return attribute->storageImage->imageView;
+    }
 
-            if (createInfo->attributes[j].type == VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER)
-            {
-                bufferInfos[j].buffer = createInfo->attributes[j].uniformBuffer->uniformBuffer[i];
-                bufferInfos[j].offset = 0;
-                bufferInfos[j].range = createInfo->attributes[j].uniformBuffer->bufferSize;
-
-                descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[j].dstSet = descriptor_sets[i];
-                descriptorWrites[j].dstBinding = j;
-                descriptorWrites[j].dstArrayElement = 0;
-                descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                descriptorWrites[j].descriptorCount = 1;
-                descriptorWrites[j].pBufferInfo = &bufferInfos[j];
-            }
+    return VK_NULL_HANDLE;
+}
 
-            if (createInfo->attributes[j].type == VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER)
-            {
-                bufferInfos[j].buffer = createInfo->attributes[j].storageBuffer->buffer;
-                bufferInfos[j].offset = 0; 
-                bufferInfos[j].range = createInfo->attributes[j].storageBufferRange;
-
-                descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[j].dstSet = descriptor_sets[i];
-                descriptorWrites[j].dstBinding = j;
-                descriptorWrites[j].dstArrayElement = 0;
-                descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-                descriptorWrites[j].descriptorCount = 1;
-                descriptorWrites[j].pBufferInfo = &bufferInfos[j];
-                descriptorWrites[j].pImageInfo = NULL;
-                descriptorWrites[j].pTexelBufferView = NULL;
-            }
-        }
+void vkuFillDescriptorTemplateData(VkuDescriptorTemplateData *data, VkuDescriptorSetAttribute *attribute, uint32_t frameIndex)
+{
+    memset(data, 0, sizeof(VkuDescriptorTemplateData));
 
-        vkUpdateDescriptorSets(createInfo->device, createInfo->attribCount, descriptorWrites, 0, NULL);
+    switch (attribute->type)
+    {
+    case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER:
+        data->image.sampler = attribute->sampler->sampler;
+        data->image.imageView = vkuGetDescriptorImageView(attribute, &data->image.imageLayout);
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLED_IMAGE:
+        data->image.imageView = vkuGetDescriptorImageView(attribute, &data->image.imageLayout);
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_SEPARATE_SAMPLER:
+        data->image.sampler = attribute->sampler->sampler;
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_IMAGE:
+        data->image.imageView = attribute->storageImage->imageView;
+        data->image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_BUFFER:
+        data->buffer.buffer = attribute->uniformBuffer->uniformBuffer[frameIndex];
+        data->buffer.offset = 0;
+        data->buffer.range = attribute->uniformBuffer->bufferSize;
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER:
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER_STATIC:
+        data->buffer.buffer = attribute->storageBuffer->buffer;
+        data->buffer.offset = 0;
+        data->buffer.range = attribute->storageBufferRange;
+        break;
+    case VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_TEXEL_BUFFER:
+    case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_TEXEL_BUFFER:
+        data->texelBufferView = attribute->texelBufferView;
+        break;
     }
-
-    return descriptor_sets;
 }
 
 void vkuDestroyDescriptorSets(VkDescriptorSet *sets)
@@ -2519,2413 +3207,7537 @@ void vkuDestroyDescriptorSets(VkDescriptorSet *sets)
     free(sets);
 }
 
-// VkPipeline & layout
+// Descriptor Allocator
 
-VkPipelineLayout vkuCreatePipelineLayout(VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount)
+VkuDescriptorAllocator vkuCreateDescriptorAllocator()
 {
-    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkuDescriptorAllocator_T *allocator = (VkuDescriptorAllocator_T *)calloc(1, sizeof(VkuDescriptorAllocator_T));
+    pthread_mutex_init(&allocator->lock, NULL);
+    return allocator;
+}
 
-    VkPushConstantRange pushConstantRange = {};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = 128;
+void vkuDescriptorPoolChainClear(VkuDescriptorPoolChain *chain, VkDevice device)
+{
+    for (uint32_t i = 0; i < chain->poolCount; i++)
+        vkuDestroyDescriptorPool(device, chain->pools[i]);
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = setLayoutCount;
-    pipelineLayoutInfo.pSetLayouts = setLayouts;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    free(chain->pools);
+    memset(chain, 0, sizeof(VkuDescriptorPoolChain));
+}
 
-    VK_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutInfo, NULL, &layout));
-    return layout;
+void vkuDescriptorAllocatorClear(VkuDescriptorAllocator allocator, VkDevice device)
+{
+    vkuDescriptorPoolChainClear(&allocator->shared, device);
+
+    for (uint32_t i = 0; i < allocator->frameCount; i++)
+        vkuDescriptorPoolChainClear(&allocator->frames[i], device);
+
+    free(allocator->frames);
+    allocator->frames = NULL;
+    allocator->frameCount = 0;
 }
 
-void vkuDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout)
+void vkuDestroyDescriptorAllocator(VkuDescriptorAllocator allocator, VkDevice device)
 {
-    vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+    vkuDescriptorAllocatorClear(allocator, device);
+    pthread_mutex_destroy(&allocator->lock);
+    free(allocator);
 }
 
-VkShaderModule vkuCreateShaderModule(const char *shaderCode, uint32_t codeLength, VkDevice device)
+VkDescriptorPool vkuDescriptorPoolChainAllocate(VkuDescriptorPoolChain *chain, VkDevice device, VkDescriptorPoolCreateFlags flags, VkDescriptorSetLayout *setLayouts, uint32_t setCount, VkDescriptorSet *sets, const VkDescriptorPoolSize *requiredSizes, uint32_t requiredSizeCount)
 {
-    VkShaderModuleCreateInfo createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = codeLength;
-    createInfo.pCode = (const uint32_t *)shaderCode;
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts = setLayouts;
 
-    VkShaderModule shaderModule = VK_NULL_HANDLE;
-    VK_CHECK(vkCreateShaderModule(device, &createInfo, NULL, &shaderModule));
+    // Pools are filled in order; earlier pools only regain space when sets are freed back to them.
+    for (uint32_t i = chain->currentPool; i < chain->poolCount; i++)
+    {
+        allocInfo.descriptorPool = chain->pools[i];
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, sets);
 
-    return shaderModule;
+        if (result == VK_SUCCESS)
+        {
+            chain->currentPool = i;
+            return chain->pools[i];
+        }
+
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+            VK_CHECK(result);
+    }
+
+    if (chain->poolCount == chain->poolCapacity)
+    {
+        chain->poolCapacity = (chain->poolCapacity == 0) ? 4 : chain->poolCapacity * 2;
+        chain->pools = (VkDescriptorPool *)realloc(chain->pools, sizeof(VkDescriptorPool) * chain->poolCapacity);
+    }
+
+    chain->pools[chain->poolCount] = vkuCreateDescriptorPool(device, flags, requiredSizes, requiredSizeCount, setCount);
+    chain->currentPool = chain->poolCount++;
+
+    allocInfo.descriptorPool = chain->pools[chain->currentPool];
+    VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, sets));
+
+    return chain->pools[chain->currentPool];
 }
 
-VkVertexInputBindingDescription vkuGetVertexInputBindingDescription(VkuVertexLayout *layout)
+VkDescriptorPool vkuDescriptorAllocatorAllocate(VkuDescriptorAllocator allocator, VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setCount, VkDescriptorSet *sets, const VkDescriptorPoolSize *requiredSizes, uint32_t requiredSizeCount)
 {
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = (*layout).vertexSize;
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    return bindingDescription;
+    pthread_mutex_lock(&allocator->lock);
+    VkDescriptorPool pool = vkuDescriptorPoolChainAllocate(&allocator->shared, device, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, setLayouts, setCount, sets, requiredSizes, requiredSizeCount);
+    pthread_mutex_unlock(&allocator->lock);
+
+    return pool;
 }
 
-VkVertexInputAttributeDescription *vkuGetVertexAttributeDescriptions(VkuVertexLayout *layout)
+void vkuDescriptorAllocatorFree(VkuDescriptorAllocator allocator, VkDevice device, VkDescriptorPool pool, VkDescriptorSet *sets, uint32_t setCount)
 {
-    if ((*layout).attributeCount == 0)
-        return VK_NULL_HANDLE;
+    pthread_mutex_lock(&allocator->lock);
 
-    VkVertexInputAttributeDescription *attributeDescriptions = (VkVertexInputAttributeDescription *)malloc(sizeof(VkVertexInputAttributeDescription) * (*layout).attributeCount);
+    VK_CHECK(vkFreeDescriptorSets(device, pool, setCount, sets));
 
-    for (uint32_t i = 0; i < (*layout).attributeCount; i++)
+    for (uint32_t i = 0; i < allocator->shared.poolCount; i++)
     {
-        attributeDescriptions[i].binding = 0;
-        attributeDescriptions[i].location = i;
-        attributeDescriptions[i].format = (*layout).attributes[i].format;
-        attributeDescriptions[i].offset = (*layout).attributes[i].offset;
+        if (allocator->shared.pools[i] == pool && i < allocator->shared.currentPool)
+        {
+            allocator->shared.currentPool = i;
+            break;
+        }
     }
 
-    return attributeDescriptions;
+    pthread_mutex_unlock(&allocator->lock);
 }
 
-VkPipeline vkuCreateGraphicsPipeline(VkuGraphicsPipelineCreateInfo *createInfo)
+void vkuDescriptorAllocatorResetFrame(VkuDescriptorAllocator allocator, VkDevice device, uint32_t frameIndex)
 {
-    VkShaderModule vertexShaderModule = vkuCreateShaderModule(createInfo->vertexShaderSpirv, createInfo->vertexShaderLength, createInfo->device);
-    
-    VkShaderModule fragmentShaderModule = NULL;
-    if (createInfo->fragmentShaderSpirv != NULL && createInfo->fragmentShaderLength > 0) {
-        fragmentShaderModule = vkuCreateShaderModule(createInfo->fragmentShaderSpirv, createInfo->fragmentShaderLength, createInfo->device);
+    pthread_mutex_lock(&allocator->lock);
+
+    if (frameIndex < allocator->frameCount)
+    {
+        VkuDescriptorPoolChain *chain = &allocator->frames[frameIndex];
+        for (uint32_t i = 0; i < chain->poolCount; i++)
+            VK_CHECK(vkResetDescriptorPool(device, chain->pools[i], 0));
+        chain->currentPool = 0;
     }
 
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertexShaderModule;
-    vertShaderStageInfo.pName = "main";
+    pthread_mutex_unlock(&allocator->lock);
+}
 
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-    uint32_t stageCount = 1;
-    VkPipelineShaderStageCreateInfo shaderStages[2] = {vertShaderStageInfo};
-    if (fragmentShaderModule != NULL) {
-        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragShaderStageInfo.module = fragmentShaderModule;
-        fragShaderStageInfo.pName = "main";
-        shaderStages[1] = fragShaderStageInfo;
-        stageCount = 2;
-    }
+// VkPipeline & layout
 
-    VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    uint32_t dynamicStatesCount = sizeof(dynamicStates) / sizeof(dynamicStates[0]);
+VkPipelineLayout vkuCreatePipelineLayout(VkDevice device, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount)
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
 
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = (uint32_t)dynamicStatesCount;
-    dynamicState.pDynamicStates = dynamicStates;
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = setLayoutCount;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = pushConstantRangeCount;
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges;
 
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    VK_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutInfo, NULL, &layout));
+    return layout;
+}
 
-    VkVertexInputBindingDescription bindingDescription = vkuGetVertexInputBindingDescription(&createInfo->vertexInputLayout);
-    VkVertexInputAttributeDescription *AttributeDescriptions = vkuGetVertexAttributeDescriptions(&createInfo->vertexInputLayout);
+// Without requested ranges a pipeline gets one 128 byte range (the guaranteed minimum) for defaultStage.
+uint32_t vkuResolvePushConstantRanges(VkuContext context, VkPushConstantRange *ranges, VkPushConstantRange *requestedRanges, uint32_t requestedRangeCount, VkShaderStageFlags defaultStage)
+{
+    if (requestedRangeCount == 0)
+    {
+        ranges[0].stageFlags = defaultStage;
+        ranges[0].offset = 0;
+        ranges[0].size = 128;
+        return 1;
+    }
 
-    vertexInputInfo.vertexBindingDescriptionCount = (createInfo->vertexInputLayout.attributeCount == 0) ? 0 : 1;
-    vertexInputInfo.pVertexBindingDescriptions = (createInfo->vertexInputLayout.attributeCount == 0) ? NULL : &bindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = createInfo->vertexInputLayout.attributeCount;
-    vertexInputInfo.pVertexAttributeDescriptions = (createInfo->vertexInputLayout.attributeCount == 0) ? NULL : AttributeDescriptions;
+    if (requestedRangeCount > VKU_MAX_PUSH_CONSTANT_RANGES)
+        EXIT("VkuError: Pipeline Creation: Too many push constant ranges!\n");
 
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = createInfo->topology;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &properties);
 
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)createInfo->swapchainExtend.width;
-    viewport.height = (float)createInfo->swapchainExtend.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent = createInfo->swapchainExtend;
-
-    VkPipelineViewportStateCreateInfo viewportState = {};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = createInfo->polygonMode;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = createInfo->cullMode;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = createInfo->enableDepthBias;
-    rasterizer.depthBiasConstantFactor = createInfo->depthBiasConstantFactor;
-    rasterizer.depthBiasSlopeFactor = createInfo->depthBiasSlopeFactor;
-
-    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_TRUE;
-    multisampling.rasterizationSamples = createInfo->msaaSamples;
-    multisampling.minSampleShading = 0.2f;
-
-    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = createInfo->depth_test_enable;
-    depthStencil.depthWriteEnable = createInfo->depth_test_write;
-    depthStencil.depthCompareOp = createInfo->depth_compare_mode;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f;
-    depthStencil.maxDepthBounds = 1.0f;
-    depthStencil.stencilTestEnable = VK_FALSE;
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-
-    if (fragmentShaderModule == NULL) colorBlendAttachment.colorWriteMask = 0;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY;
-
-    if (fragmentShaderModule != NULL) {
-        colorBlending.attachmentCount = 1;
-        colorBlending.pAttachments = &colorBlendAttachment;
-    }
-
-    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .stageCount = stageCount, // Updated dynamically
-        .pStages = shaderStages, // Updated dynamically
-        .pVertexInputState = &vertexInputInfo,
-        .pInputAssemblyState = &inputAssembly,
-        .pViewportState = &viewportState,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState = &multisampling,
-        .pDepthStencilState = &depthStencil,
-        .pColorBlendState = &colorBlending,
-        .pDynamicState = &dynamicState,
-        .layout = createInfo->pipelineLayout,
-        .renderPass = createInfo->renderPass,
-        .subpass = 0,
-        .basePipelineHandle = VK_NULL_HANDLE,
-        .basePipelineIndex = -1
-    };
+    for (uint32_t i = 0; i < requestedRangeCount; i++)
+    {
+        VkPushConstantRange *range = &requestedRanges[i];
+        if (range->stageFlags == 0)
+            EXIT("VkuError: Pipeline Creation: Push constant ranges need at least one shader stage!\n");
+        if (range->size == 0 || range->offset % 4 != 0 || range->size % 4 != 0)
+            EXIT("VkuError: Pipeline Creation: Push constant ranges need a non-zero size and 4 byte aligned offset and size!\n");
+        if (range->offset + range->size > properties.limits.maxPushConstantsSize)
+            EXIT("VkuError: Pipeline Creation: Push constant range exceeds the device's maxPushConstantsSize!\n");
 
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
-    VK_CHECK(vkCreateGraphicsPipelines(createInfo->device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, NULL, &graphicsPipeline));
+        for (uint32_t j = 0; j < i; j++)
+            if (requestedRanges[j].stageFlags & range->stageFlags)
+                EXIT("VkuError: Pipeline Creation: A shader stage may only appear in one push constant range!\n");
 
-    // Clean up shader modules
-    vkDestroyShaderModule(createInfo->device, vertexShaderModule, NULL);
-    if (fragmentShaderModule != NULL) {
-        vkDestroyShaderModule(createInfo->device, fragmentShaderModule, NULL);
+        ranges[i] = *range;
     }
-    free(AttributeDescriptions);
 
-    return graphicsPipeline;
+    return requestedRangeCount;
 }
 
-void vkuDestroyVkPipeline(VkDevice device, VkPipeline pipeline)
+// vkCmdPushConstants needs exactly the stages of every range the written bytes overlap, and each of those ranges has to
+// contain all written bytes. Writes spanning ranges of different stages have to be split by the caller.
+VkShaderStageFlags vkuGetPushConstantStages(VkPushConstantRange *ranges, uint32_t rangeCount, uint32_t offset, size_t size)
 {
-    vkDestroyPipeline(device, pipeline, NULL);
-}
+    VkShaderStageFlags stageFlags = 0;
+    uint64_t end = (uint64_t)offset + size;
 
-VkPipeline vkuCreateComputeVkPipeline(VkuComputeVkPipelineCreateInfo *createInfo) {
-    VkShaderModule computeShaderModule = vkuCreateShaderModule(createInfo->computeShaderSpirv, createInfo->computeShaderLength, createInfo->device);
-
-    VkPipelineShaderStageCreateInfo shaderStageInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
-        .module = computeShaderModule,
-        .pName = "main"
-    };
-
-    VkComputePipelineCreateInfo pipelineInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-        .stage = shaderStageInfo,
-        .layout = createInfo->pipelineLayout
-    };
+    for (uint32_t i = 0; i < rangeCount; i++)
+    {
+        if (ranges[i].offset < end && offset < ranges[i].offset + ranges[i].size)
+            stageFlags |= ranges[i].stageFlags;
+    }
 
-    VkPipeline pipeline;
-    VK_CHECK(vkCreateComputePipelines(createInfo->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &pipeline));
+    if (stageFlags == 0)
+        EXIT("VkuError: PushConstant data exceeds the pipeline's push constant ranges!\n");
 
-    vkDestroyShaderModule(createInfo->device, computeShaderModule, NULL);
+    for (uint32_t i = 0; i < rangeCount; i++)
+    {
+        if ((ranges[i].stageFlags & stageFlags) != 0 && (ranges[i].offset > offset || ranges[i].offset + ranges[i].size < end))
+            EXIT("VkuError: PushConstant data has to lie inside one push constant range of every stage it reaches!\n");
+    }
 
-    return pipeline;
+    return stageFlags;
 }
 
-/** ######################################
- *  #                                    #
- *  #        VkUtils External            #
- *  #                                    #
- *  ######################################
- */
+void vkuDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout)
+{
+    vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+}
 
-// External Function Predefines
+// Layout Cache
 
-// VkuQueue
+VkuLayoutCache vkuCreateLayoutCache()
+{
+    VkuLayoutCache_T *cache = (VkuLayoutCache_T *)calloc(1, sizeof(VkuLayoutCache_T));
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
 
-VkuThreadSafeQueue vkuQueueCreate(size_t initial_capacity) {
-    if (initial_capacity == 0) {
-        initial_capacity = 1;
+void vkuLayoutCacheClear(VkuLayoutCache cache, VkDevice device)
+{
+    for (uint32_t i = 0; i < cache->pipelineLayoutCount; i++)
+    {
+        vkuDestroyPipelineLayout(device, cache->pipelineLayouts[i].pipelineLayout);
+        free(cache->pipelineLayouts[i].key);
     }
 
-    VkuThreadSafeQueue queue = (VkuThreadSafeQueue) malloc(sizeof(VkuThreadSafeQueue_T));
-    if (!queue) return NULL;
-
-    queue->data = (void **) malloc(initial_capacity * sizeof(void *));
-    if (!queue->data) {
-        free(queue);
-        return NULL;
+    for (uint32_t i = 0; i < cache->setLayoutCount; i++)
+    {
+        vkuDestroyDescriptorUpdateTemplate(device, cache->setLayouts[i].updateTemplate);
+        vkuDestroyDescriptorSetLayout(device, cache->setLayouts[i].setLayout);
+        free(cache->setLayouts[i].key);
     }
 
-    queue->capacity = initial_capacity;
-    queue->front = 0;
-    queue->rear = 0;
-    queue->size = 0;
-
-    pthread_mutex_init(&queue->lock, NULL);
+    cache->pipelineLayoutCount = 0;
+    cache->setLayoutCount = 0;
+}
 
-    return queue;
+void vkuDestroyLayoutCache(VkuLayoutCache cache, VkDevice device)
+{
+    vkuLayoutCacheClear(cache, device);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->setLayouts);
+    free(cache->pipelineLayouts);
+    free(cache);
 }
 
-void vkuQueueDestroy(VkuThreadSafeQueue queue) {
-    if (!queue) return;
+VkuLayoutCacheEntry *vkuLayoutCacheFind(VkuLayoutCacheEntry *entries, uint32_t entryCount, uint64_t hash, const void *key, size_t keySize)
+{
+    for (uint32_t i = 0; i < entryCount; i++)
+        if (entries[i].hash == hash && entries[i].keySize == keySize && memcmp(entries[i].key, key, keySize) == 0)
+            return &entries[i];
 
-    pthread_mutex_destroy(&queue->lock);
-    free(queue->data);
-    free(queue);
+    return NULL;
 }
 
-static int vkuQueueResize(VkuThreadSafeQueue queue) {
-    size_t new_capacity = queue->capacity * 2;
-    void **new_data = (void **) malloc(new_capacity * sizeof(void *));
-    if (!new_data) return -1;
-
-    if (queue->front < queue->rear) {
-        // Elements are in a contiguous block
-        memcpy(new_data, &queue->data[queue->front], queue->size * sizeof(void *));
-    } else {
-        // Elements wrap around the end of the buffer
-        size_t first_part_size = queue->capacity - queue->front;
-        memcpy(new_data, &queue->data[queue->front], first_part_size * sizeof(void *));
-        memcpy(&new_data[first_part_size], queue->data, queue->rear * sizeof(void *));
+VkuLayoutCacheEntry *vkuLayoutCacheInsert(VkuLayoutCacheEntry **entries, uint32_t *entryCount, uint32_t *entryCapacity, uint64_t hash, const void *key, size_t keySize)
+{
+    if (*entryCount == *entryCapacity)
+    {
+        *entryCapacity = (*entryCapacity == 0) ? 16 : *entryCapacity * 2;
+        *entries = (VkuLayoutCacheEntry *)realloc(*entries, sizeof(VkuLayoutCacheEntry) * *entryCapacity);
     }
 
-    queue->front = 0;
-    queue->rear = queue->size;
-    queue->capacity = new_capacity;
-
-    free(queue->data);
-    queue->data = new_data;
+    VkuLayoutCacheEntry *entry = &(*entries)[(*entryCount)++];
+    memset(entry, 0, sizeof(VkuLayoutCacheEntry));
+    entry->hash = hash;
+    entry->keySize = keySize;
+    entry->key = malloc(keySize > 0 ? keySize : 1);
+    memcpy(entry->key, key, keySize);
 
-    return 0;
+    return entry;
 }
 
-int vkuQueueEnqueue(VkuThreadSafeQueue queue, void *item) {
-    pthread_mutex_lock(&queue->lock);
+VkDescriptorUpdateTemplate vkuCreateDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout setLayout, VkuDescriptorBindingKey *bindings, uint32_t bindingCount)
+{
+    if (bindingCount == 0)
+        return VK_NULL_HANDLE;
 
-    if (queue->size == queue->capacity) {
-        if (vkuQueueResize(queue) != 0) {
-            pthread_mutex_unlock(&queue->lock);
-            return -1;
-        }
+    // One VkuDescriptorTemplateData slot per binding, so a whole set is written from a packed array in one call.
+    VkDescriptorUpdateTemplateEntry entries[bindingCount];
+    for (uint32_t i = 0; i < bindingCount; i++)
+    {
+        entries[i].dstBinding = i;
+        entries[i].dstArrayElement = 0;
+        entries[i].descriptorCount = bindings[i].count;
+        entries[i].descriptorType = bindings[i].type;
+        entries[i].offset = sizeof(VkuDescriptorTemplateData) * i;
+        entries[i].stride = sizeof(VkuDescriptorTemplateData);
     }
 
-    queue->data[queue->rear] = item;
-    queue->rear = (queue->rear + 1) % queue->capacity;
-    queue->size++;
+    VkDescriptorUpdateTemplateCreateInfo templateInfo = {};
+    templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    templateInfo.descriptorUpdateEntryCount = bindingCount;
+    templateInfo.pDescriptorUpdateEntries = entries;
+    templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    templateInfo.descriptorSetLayout = setLayout;
 
-    pthread_mutex_unlock(&queue->lock);
-    return 0;
+    VkDescriptorUpdateTemplate updateTemplate;
+    VK_CHECK(vkCreateDescriptorUpdateTemplate(device, &templateInfo, NULL, &updateTemplate));
+    return updateTemplate;
 }
 
-void *vkuQueueDequeue(VkuThreadSafeQueue queue) {
-    pthread_mutex_lock(&queue->lock);
+void vkuDestroyDescriptorUpdateTemplate(VkDevice device, VkDescriptorUpdateTemplate updateTemplate)
+{
+    if (updateTemplate != VK_NULL_HANDLE)
+        vkDestroyDescriptorUpdateTemplate(device, updateTemplate, NULL);
+}
 
-    if (queue->size == 0) {
-        pthread_mutex_unlock(&queue->lock);
-        return NULL;
+VkDescriptorSetLayout vkuContextAcquireDescriptorSetLayout(VkuContext context, VkuDescriptorSetAttribute *attributes, uint32_t attributeCount, VkDescriptorSetLayoutCreateFlags flags, VkDescriptorUpdateTemplate *pUpdateTemplate)
+{
+    VkuLayoutCache cache = context->layoutCache;
+    VkuDescriptorBindingKey key[attributeCount + 1];
+    memset(key, 0, sizeof(key));
+
+    VkBool32 pushDescriptor = (flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) != 0;
+    for (uint32_t i = 0; i < attributeCount; i++)
+    {
+        key[i].type = pushDescriptor ? vkuGetPushDescriptorType(attributes[i].type) : vkuGetDescriptorType(attributes[i].type);
+        key[i].stageFlags = attributes[i].shaderStage;
+        key[i].count = 1;
     }
 
-    void *item = queue->data[queue->front];
-    queue->front = (queue->front + 1) % queue->capacity;
-    queue->size--;
+    // The trailing entry keys the layout create flags.
+    key[attributeCount].stageFlags = flags;
 
-    pthread_mutex_unlock(&queue->lock);
-    return item;
-}
+    size_t keySize = sizeof(VkuDescriptorBindingKey) * (attributeCount + 1);
+    uint64_t hash = vkuHash64(key, keySize, 0);
 
-// VkuWindow
+    pthread_mutex_lock(&cache->lock);
 
-uint8_t *vkuLoadImage(const char *path, int *width, int *height, int *channels)
-{
-    stbi_set_flip_vertically_on_load(0);
-    uint8_t *data = stbi_load(path, width, height, channels, STBI_rgb_alpha);
-    if (data == NULL)
+    VkuLayoutCacheEntry *entry = vkuLayoutCacheFind(cache->setLayouts, cache->setLayoutCount, hash, key, keySize);
+    if (entry == NULL)
     {
-        fprintf(stderr, "Failed to load image from path: %s\n", path);
-        return NULL;
+        entry = vkuLayoutCacheInsert(&cache->setLayouts, &cache->setLayoutCount, &cache->setLayoutCapacity, hash, key, keySize);
+        entry->setLayout = vkuCreateDescriptorSetLayout(context->device, attributes, attributeCount, flags);
+        entry->updateTemplate = pushDescriptor ? VK_NULL_HANDLE : vkuCreateDescriptorUpdateTemplate(context->device, entry->setLayout, key, attributeCount);
     }
 
-    return data;
-}
+    entry->refCount++;
+    VkDescriptorSetLayout setLayout = entry->setLayout;
+    if (pUpdateTemplate != NULL)
+        *pUpdateTemplate = entry->updateTemplate;
 
-void framebuffer_size_callback(void *userdata, SDL_Event *event) {
-    if (event->type == SDL_EVENT_WINDOW_RESIZED) {
-        VkuWindow_T *vku_window = (VkuWindow_T *)userdata;
-        if (vku_window)
-            vku_window->window_resized = true;
-    }
+    pthread_mutex_unlock(&cache->lock);
+    return setLayout;
 }
 
-static bool SDLCALL WindowEventFilter(void* userdata, SDL_Event* event) {
-    VkuWindow vkuWindow = (VkuWindow) userdata;
+void vkuLayoutCacheAddSetLayoutRef(VkuLayoutCache cache, VkDescriptorSetLayout setLayout, VkDevice device, int32_t delta)
+{
+    for (uint32_t i = 0; i < cache->setLayoutCount; i++)
+    {
+        VkuLayoutCacheEntry *entry = &cache->setLayouts[i];
+        if (entry->setLayout != setLayout)
+            continue;
 
-    if (event->type == SDL_EVENT_WINDOW_MINIMIZED) {
-        vkuWindow->minimized = true;
-    } else if (event->type == SDL_EVENT_WINDOW_RESIZED) {
-        vkuWindow->window_resized = true;
+        entry->refCount += delta;
+        if (entry->refCount == 0)
+        {
+            vkuDestroyDescriptorUpdateTemplate(device, entry->updateTemplate);
+            vkuDestroyDescriptorSetLayout(device, entry->setLayout);
+            free(entry->key);
+            *entry = cache->setLayouts[--cache->setLayoutCount];
+        }
+        return;
     }
-
-    return true;
 }
 
-VkuWindow vkuCreateWindow(VkuWindowCreateInfo *createInfo) {
-    VkuWindow_T *window = (VkuWindow_T *)calloc(1, sizeof(VkuWindow_T));
-
-    window->sdlWindow = SDL_CreateWindow(createInfo->title, createInfo->width, createInfo->height, SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+uint32_t vkuLayoutCacheGetPoolSizes(VkuLayoutCache cache, VkDescriptorSetLayout setLayout, uint32_t setCount, VkDescriptorPoolSize *sizes)
+{
+    uint32_t counts[VKU_DESCRIPTOR_TYPE_COUNT] = {0};
 
-    if (!window->sdlWindow) {
-        free(window);
-        return NULL;
-    }
+    pthread_mutex_lock(&cache->lock);
 
-    SDL_GetWindowSizeInPixels(window->sdlWindow, &window->windowedWidth, &window->windowedHeight);
-    SDL_GetWindowPosition(window->sdlWindow, &window->windowedX, &window->windowedY);
+    for (uint32_t i = 0; i < cache->setLayoutCount; i++)
+    {
+        VkuLayoutCacheEntry *entry = &cache->setLayouts[i];
+        if (entry->setLayout != setLayout)
+            continue;
 
-    if (createInfo->window_icon_path != NULL) {
-        int w, h, channels;
-        void *pixels = vkuLoadImage(createInfo->window_icon_path, &w, &h, &channels); // Your custom loader
-        if (pixels) {
-            SDL_Surface *icon = SDL_CreateSurfaceFrom(w, h, SDL_PIXELFORMAT_RGBA32, pixels, 4*w);
-            SDL_SetWindowIcon(window->sdlWindow, icon);
-            SDL_DestroySurface(icon);
-            stbi_image_free(pixels);
+        // The trailing key entry holds the layout flags, not a binding.
+        const VkuDescriptorBindingKey *bindings = (const VkuDescriptorBindingKey *)entry->key;
+        uint32_t bindingCount = (uint32_t)(entry->keySize / sizeof(VkuDescriptorBindingKey)) - 1;
+        for (uint32_t j = 0; j < bindingCount; j++)
+        {
+            if ((uint32_t)bindings[j].type < VKU_DESCRIPTOR_TYPE_COUNT)
+                counts[bindings[j].type] += bindings[j].count * setCount;
         }
+        break;
     }
 
-    SDL_AddEventWatch(WindowEventFilter, window);
-
-    return window;
-}
+    pthread_mutex_unlock(&cache->lock);
 
-void vkuWindowToggleFullscreen(VkuWindow window) {
-    if (!window->fullscreen) {
-        SDL_GetWindowPosition(window->sdlWindow, &window->windowedX, &window->windowedY);
-        SDL_GetWindowSizeInPixels(window->sdlWindow, &window->windowedWidth, &window->windowedHeight);
-        SDL_SetWindowFullscreen(window->sdlWindow, SDL_WINDOW_FULLSCREEN);
-        window->fullscreen = true;
-    } else {
-        SDL_SetWindowFullscreen(window->sdlWindow, 0);
-        SDL_SetWindowPosition(window->sdlWindow, window->windowedX, window->windowedY);
-        SDL_SetWindowSize(window->sdlWindow, window->windowedWidth, window->windowedHeight);
-        window->fullscreen = false;
+    uint32_t sizeCount = 0;
+    for (uint32_t type = 0; type < VKU_DESCRIPTOR_TYPE_COUNT; type++)
+    {
+        if (counts[type] > 0)
+            sizes[sizeCount++] = (VkDescriptorPoolSize){(VkDescriptorType)type, counts[type]};
     }
-}
 
-void vkuWindowToggleInputMode(VkuWindow window) {
-    SDL_Window *win = window->sdlWindow;
-    int isRelative = SDL_GetWindowRelativeMouseMode(window->sdlWindow);
-    SDL_SetWindowRelativeMouseMode(window->sdlWindow, !isRelative);
+    return sizeCount;
 }
 
-float vkuWindowGetAspect(VkuWindow window) {
-    int width, height;
-    SDL_GetWindowSize(window->sdlWindow, &width, &height);
-    return (float)width / (float)height;
+void vkuContextReleaseDescriptorSetLayout(VkuContext context, VkDescriptorSetLayout setLayout)
+{
+    VkuLayoutCache cache = context->layoutCache;
+    pthread_mutex_lock(&cache->lock);
+    vkuLayoutCacheAddSetLayoutRef(cache, setLayout, context->device, -1);
+    pthread_mutex_unlock(&cache->lock);
 }
 
-void vkuDestroyWindow(VkuWindow window) {
-    if (window) {
-        SDL_DestroyWindow(window->sdlWindow);
-        free(window);
+VkPipelineLayout vkuContextAcquirePipelineLayout(VkuContext context, VkDescriptorSetLayout *setLayouts, uint32_t setLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount)
+{
+    VkuLayoutCache cache = context->layoutCache;
+
+    // Keyed by the set layout handles followed by the push constant ranges.
+    size_t setLayoutsSize = sizeof(VkDescriptorSetLayout) * setLayoutCount;
+    size_t keySize = setLayoutsSize + sizeof(VkPushConstantRange) * pushConstantRangeCount;
+    uint8_t key[keySize > 0 ? keySize : 1];
+    memcpy(key, setLayouts, setLayoutsSize);
+    memcpy(key + setLayoutsSize, pushConstantRanges, keySize - setLayoutsSize);
+    uint64_t hash = vkuHash64(key, keySize, 0);
+
+    pthread_mutex_lock(&cache->lock);
+
+    VkuLayoutCacheEntry *entry = vkuLayoutCacheFind(cache->pipelineLayouts, cache->pipelineLayoutCount, hash, key, keySize);
+    if (entry == NULL)
+    {
+        entry = vkuLayoutCacheInsert(&cache->pipelineLayouts, &cache->pipelineLayoutCount, &cache->pipelineLayoutCapacity, hash, key, keySize);
+        entry->pipelineLayout = vkuCreatePipelineLayout(context->device, setLayouts, setLayoutCount, pushConstantRanges, pushConstantRangeCount);
+        entry->setLayoutCount = setLayoutCount;
+
+        // Cached set layouts stay alive while a pipeline layout keyed by their handles exists, so a recycled handle can't alias a stale key.
+        for (uint32_t i = 0; i < setLayoutCount; i++)
+            vkuLayoutCacheAddSetLayoutRef(cache, setLayouts[i], context->device, 1);
     }
-}
 
-// VkuMemoryManager
+    entry->refCount++;
+    VkPipelineLayout pipelineLayout = entry->pipelineLayout;
 
-VkuMemoryManager vkuCreateMemoryManager(VkuMemoryManagerCreateInfo *createInfo)
+    pthread_mutex_unlock(&cache->lock);
+    return pipelineLayout;
+}
+
+void vkuContextReleasePipelineLayout(VkuContext context, VkPipelineLayout pipelineLayout)
 {
-    VkuMemoryManager_T *manager = (VkuMemoryManager_T *)calloc(1, sizeof(VkuMemoryManager_T));
-    manager->device = createInfo->device;
-    manager->transferQueue = createInfo->transferQueue;
-    manager->allocator = vkuCreateVmaAllocator(createInfo->instance, createInfo->physicalDevice, createInfo->device);
-    manager->transferCmdPool = vkuCreateCmdPool(createInfo->physicalDevice, createInfo->device, (createInfo->transferQueue != VK_NULL_HANDLE) ? VKU_CMD_POOL_TYPE_TRANSFER : VKU_CMD_POOL_TYPE_GRAPHICS);
-    manager->fences = NULL;
-    manager->fenceCount = 0;
-    manager->destructionQueue = vkuQueueCreate(128);
+    VkuLayoutCache cache = context->layoutCache;
+    pthread_mutex_lock(&cache->lock);
 
-    return manager;
-}
+    for (uint32_t i = 0; i < cache->pipelineLayoutCount; i++)
+    {
+        VkuLayoutCacheEntry *entry = &cache->pipelineLayouts[i];
+        if (entry->pipelineLayout != pipelineLayout)
+            continue;
 
-void vkuDestroyMemoryManager(VkuMemoryManager memoryManager)
+        if (--entry->refCount == 0)
+        {
+            VkDescriptorSetLayout *setLayouts = (VkDescriptorSetLayout *)entry->key;
+            uint32_t setLayoutCount = entry->setLayoutCount;
+
+            vkuDestroyPipelineLayout(context->device, entry->pipelineLayout);
+            *entry = cache->pipelineLayouts[--cache->pipelineLayoutCount];
+
+            for (uint32_t j = 0; j < setLayoutCount; j++)
+                vkuLayoutCacheAddSetLayoutRef(cache, setLayouts[j], context->device, -1);
+            free(setLayouts);
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// SPIR-V Reflection
+
+#define VKU_SPIRV_MAGIC 0x07230203
+#define VKU_SPIRV_MAX_INPUT_LOCATIONS 256
+
+// The few opcodes, decorations and storage classes the reflection needs, as numbered by the SPIR-V specification.
+enum
+{
+    VKU_SPIRV_OP_ENTRY_POINT = 15,
+    VKU_SPIRV_OP_EXECUTION_MODE = 16,
+    VKU_SPIRV_OP_TYPE_BOOL = 20,
+    VKU_SPIRV_OP_TYPE_INT = 21,
+    VKU_SPIRV_OP_TYPE_FLOAT = 22,
+    VKU_SPIRV_OP_TYPE_VECTOR = 23,
+    VKU_SPIRV_OP_TYPE_MATRIX = 24,
+    VKU_SPIRV_OP_TYPE_IMAGE = 25,
+    VKU_SPIRV_OP_TYPE_SAMPLER = 26,
+    VKU_SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+    VKU_SPIRV_OP_TYPE_ARRAY = 28,
+    VKU_SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+    VKU_SPIRV_OP_TYPE_STRUCT = 30,
+    VKU_SPIRV_OP_TYPE_POINTER = 32,
+    VKU_SPIRV_OP_CONSTANT = 43,
+    VKU_SPIRV_OP_CONSTANT_COMPOSITE = 44,
+    VKU_SPIRV_OP_SPEC_CONSTANT = 50,
+    VKU_SPIRV_OP_SPEC_CONSTANT_COMPOSITE = 51,
+    VKU_SPIRV_OP_VARIABLE = 59,
+    VKU_SPIRV_OP_DECORATE = 71,
+    VKU_SPIRV_OP_MEMBER_DECORATE = 72,
+    VKU_SPIRV_OP_EXECUTION_MODE_ID = 331,
+
+    VKU_SPIRV_DECORATION_SPEC_ID = 1,
+    VKU_SPIRV_DECORATION_BUFFER_BLOCK = 3,
+    VKU_SPIRV_DECORATION_ARRAY_STRIDE = 6,
+    VKU_SPIRV_DECORATION_MATRIX_STRIDE = 7,
+    VKU_SPIRV_DECORATION_BUILT_IN = 11,
+    VKU_SPIRV_DECORATION_LOCATION = 30,
+    VKU_SPIRV_DECORATION_BINDING = 33,
+    VKU_SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+    VKU_SPIRV_DECORATION_OFFSET = 35,
+
+    VKU_SPIRV_STORAGE_UNIFORM_CONSTANT = 0,
+    VKU_SPIRV_STORAGE_INPUT = 1,
+    VKU_SPIRV_STORAGE_UNIFORM = 2,
+    VKU_SPIRV_STORAGE_PUSH_CONSTANT = 9,
+    VKU_SPIRV_STORAGE_STORAGE_BUFFER = 12,
+
+    VKU_SPIRV_EXECUTION_MODE_LOCAL_SIZE = 17,
+    VKU_SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID = 38,
+    VKU_SPIRV_BUILT_IN_WORKGROUP_SIZE = 25,
+    VKU_SPIRV_DIM_BUFFER = 5,
+    VKU_SPIRV_DIM_SUBPASS_DATA = 6,
+};
+
+// Keeps the first error, the passes stop at the next instruction and the partial reflection is discarded.
+void vkuSpirvFail(VkuSpirvParser *parser, const char *error)
 {
-    vkuQueueDestroy(memoryManager->destructionQueue);
-    vkuDestroyVmaAllocator(memoryManager->allocator);
-    vkuDestroyCommandPool(memoryManager->device, memoryManager->transferCmdPool);
-    free(memoryManager);
+    if (parser->error == NULL)
+        parser->error = error;
 }
 
-VkDeviceSize vkuMemoryMamgerGetAllocatedMemorySize(VkuMemoryManager manager)
+VkuSpirvId *vkuSpirvGetId(VkuSpirvParser *parser, uint32_t id)
 {
-    if (!manager)
+    if (id >= parser->bound)
     {
-        return 0;
+        vkuSpirvFail(parser, "Shader Reflection: SPIR-V id out of bounds!");
+        return &parser->ids[parser->bound];
     }
 
-    VmaTotalStatistics stats;
-    vmaCalculateStatistics(manager->allocator, &stats);
+    return &parser->ids[id];
+}
 
-    return stats.total.statistics.blockBytes;
-}
-
-VkuBuffer vkuCreateBuffer(VkuMemoryManager manager, VkDeviceSize size, VkuBufferUsage usage)
+// Specialization constants count with their default value.
+uint32_t vkuSpirvConstantValue(VkuSpirvParser *parser, uint32_t id)
 {
-    VkuBuffer_T *buffer = (VkuBuffer_T *)calloc(1, sizeof(VkuBuffer_T));
-    buffer->size = size;
-    atomic_init(&buffer->queuedForDestruction, false);
+    VkuSpirvId *constant = vkuSpirvGetId(parser, id);
+    if (constant->opcode != VKU_SPIRV_OP_CONSTANT && constant->opcode != VKU_SPIRV_OP_SPEC_CONSTANT)
+        return 1;
 
-    VkBufferCreateInfo bufferInfo = {};
-    VmaAllocationCreateInfo allocInfo = {};
+    return constant->instruction[3];
+}
 
-    if ((usage & VKU_BUFFER_USAGE_CPU_TO_GPU) == VKU_BUFFER_USAGE_CPU_TO_GPU)
+bool vkuSpirvMemberDecoration(VkuSpirvParser *parser, uint32_t structId, uint32_t member, uint32_t decoration, uint32_t *value)
+{
+    for (uint32_t i = 5; i < parser->wordCount; i += parser->words[i] >> 16)
     {
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = size;
-        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        const uint32_t *instruction = &parser->words[i];
+        if ((instruction[0] & 0xFFFF) == VKU_SPIRV_OP_MEMBER_DECORATE && (instruction[0] >> 16) >= 5 && instruction[1] == structId && instruction[2] == member && instruction[3] == decoration)
+        {
+            *value = instruction[4];
+            return true;
+        }
     }
-    else if ((usage & VKU_BUFFER_USAGE_GPU_ONLY) == VKU_BUFFER_USAGE_GPU_ONLY)
-    {
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = size;
-        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 
-        if ((usage & VKU_BUFFER_USAGE_COMPUTE) == VKU_BUFFER_USAGE_COMPUTE)
-            bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    return false;
+}
 
-        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+// Byte size of a type laid out with explicit offsets / strides, as used by push constant blocks.
+uint32_t vkuSpirvTypeSize(VkuSpirvParser *parser, uint32_t typeId, uint32_t depth)
+{
+    if (depth > 32)
+    {
+        vkuSpirvFail(parser, "Shader Reflection: SPIR-V types nest too deeply!");
+        return 0;
     }
 
-    VK_CHECK(vmaCreateBuffer(manager->allocator, &bufferInfo, &allocInfo, &buffer->buffer, &buffer->allocation, NULL));
-    return buffer;
-};
-
-void vkuDestroyBuffer(VkuBuffer buffer, VkuMemoryManager manager, VkBool32 syncronize)
-{
-    if (buffer == NULL)
-        return;
+    VkuSpirvId *type = vkuSpirvGetId(parser, typeId);
+    const uint32_t *instruction = type->instruction;
 
-    if (syncronize)
+    switch (type->opcode)
     {
-        if (manager->fenceCount >= 0)
-        {
-            vkWaitForFences(manager->device, manager->fenceCount, manager->fences, VK_TRUE, UINT64_MAX);
-        }
-        else
+    case VKU_SPIRV_OP_TYPE_BOOL:
+        return 4;
+    case VKU_SPIRV_OP_TYPE_INT:
+    case VKU_SPIRV_OP_TYPE_FLOAT:
+        return instruction[2] / 8;
+    case VKU_SPIRV_OP_TYPE_VECTOR:
+    case VKU_SPIRV_OP_TYPE_MATRIX:
+        return instruction[3] * vkuSpirvTypeSize(parser, instruction[2], depth + 1);
+    case VKU_SPIRV_OP_TYPE_ARRAY:
+    {
+        uint32_t stride = type->arrayStride ? type->arrayStride : vkuSpirvTypeSize(parser, instruction[2], depth + 1);
+        return vkuSpirvConstantValue(parser, instruction[3]) * stride;
+    }
+    case VKU_SPIRV_OP_TYPE_STRUCT:
+    {
+        uint32_t size = 0;
+        uint32_t memberCount = (instruction[0] >> 16) - 2;
+        for (uint32_t i = 0; i < memberCount; i++)
         {
-            vkDeviceWaitIdle(manager->device);
+            uint32_t offset = 0, matrixStride = 0;
+            vkuSpirvMemberDecoration(parser, typeId, i, VKU_SPIRV_DECORATION_OFFSET, &offset);
+
+            uint32_t memberSize = vkuSpirvTypeSize(parser, instruction[2 + i], depth + 1);
+            VkuSpirvId *memberType = vkuSpirvGetId(parser, instruction[2 + i]);
+            if (memberType->opcode == VKU_SPIRV_OP_TYPE_MATRIX && vkuSpirvMemberDecoration(parser, typeId, i, VKU_SPIRV_DECORATION_MATRIX_STRIDE, &matrixStride))
+                memberSize = memberType->instruction[3] * matrixStride;
+
+            if (offset + memberSize > size)
+                size = offset + memberSize;
         }
+        return size;
+    }
+    default:
+        return 0;
     }
-    
-    vmaDestroyBuffer(manager->allocator, buffer->buffer, buffer->allocation);
-    free(buffer);
 }
 
-void vkuEnqueueBufferDestruction(VkuMemoryManager manager, VkuBuffer buffer)
+// Lowest member offset of a block, push constants of a later stage usually start behind those of an earlier one.
+uint32_t vkuSpirvTypeOffset(VkuSpirvParser *parser, uint32_t typeId)
 {
-    if (!vku_atomic_load(buffer->queuedForDestruction)) {
-        vku_atomic_store(buffer->queuedForDestruction, true);
-        vkuQueueEnqueue(manager->destructionQueue, (void*) buffer);
+    VkuSpirvId *type = vkuSpirvGetId(parser, typeId);
+    if (type->opcode != VKU_SPIRV_OP_TYPE_STRUCT)
+        return 0;
+
+    uint32_t minOffset = UINT32_MAX;
+    uint32_t memberCount = (type->instruction[0] >> 16) - 2;
+    for (uint32_t i = 0; i < memberCount; i++)
+    {
+        uint32_t offset = 0;
+        vkuSpirvMemberDecoration(parser, typeId, i, VKU_SPIRV_DECORATION_OFFSET, &offset);
+        if (offset < minOffset)
+            minOffset = offset;
     }
+
+    return (memberCount > 0) ? minOffset : 0;
 }
 
-void vkuDestroyBuffersInDestructionQueue(VkuMemoryManager manager, VkuPresenter syncPresenter) 
+// Number of consecutive interface locations a type occupies. 64 bit vectors with three or four components take two.
+uint32_t vkuSpirvLocationCount(VkuSpirvParser *parser, uint32_t typeId, uint32_t depth)
 {
-    if (syncPresenter != VK_NULL_HANDLE)
-        vkWaitForFences(manager->device, manager->fenceCount, manager->fences, VK_TRUE, UINT64_MAX);
-    else
-        vkDeviceWaitIdle(manager->device);
+    if (depth > 32)
+    {
+        vkuSpirvFail(parser, "Shader Reflection: SPIR-V types nest too deeply!");
+        return 0;
+    }
 
-    VkuBuffer buffer;
-    while((buffer = (VkuBuffer) vkuQueueDequeue(manager->destructionQueue)) != NULL)
+    VkuSpirvId *type = vkuSpirvGetId(parser, typeId);
+    const uint32_t *instruction = type->instruction;
+
+    switch (type->opcode)
     {
-        vmaDestroyBuffer(manager->allocator, buffer->buffer, buffer->allocation);
-        free(buffer);
+    case VKU_SPIRV_OP_TYPE_VECTOR:
+        return (instruction[3] > 2 && vkuSpirvTypeSize(parser, instruction[2], depth + 1) == 8) ? 2 : 1;
+    case VKU_SPIRV_OP_TYPE_MATRIX:
+        return instruction[3] * vkuSpirvLocationCount(parser, instruction[2], depth + 1);
+    case VKU_SPIRV_OP_TYPE_ARRAY:
+        return vkuSpirvConstantValue(parser, instruction[3]) * vkuSpirvLocationCount(parser, instruction[2], depth + 1);
+    case VKU_SPIRV_OP_TYPE_STRUCT:
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < (instruction[0] >> 16) - 2; i++)
+            count += vkuSpirvLocationCount(parser, instruction[2 + i], depth + 1);
+        return count;
+    }
+    default:
+        return 1;
     }
 }
 
-void vkuSetBufferData(VkuMemoryManager manager, VkuBuffer buffer, void *data, size_t size)
+// Word count up to the last operand the reflection reads, shorter instructions would be read past their end.
+uint32_t vkuSpirvMinInstructionLength(uint32_t opcode)
 {
-    void *mapped_data = NULL;
-    vmaMapMemory(manager->allocator, buffer->allocation, &mapped_data);
-    memcpy(mapped_data, data, size);
-    vmaUnmapMemory(manager->allocator, buffer->allocation);
-}
+    switch (opcode)
+    {
+    case VKU_SPIRV_OP_TYPE_BOOL:
+    case VKU_SPIRV_OP_TYPE_SAMPLER:
+    case VKU_SPIRV_OP_TYPE_STRUCT:
+        return 2;
+    case VKU_SPIRV_OP_ENTRY_POINT:
+    case VKU_SPIRV_OP_EXECUTION_MODE:
+    case VKU_SPIRV_OP_EXECUTION_MODE_ID:
+    case VKU_SPIRV_OP_DECORATE:
+    case VKU_SPIRV_OP_TYPE_INT:
+    case VKU_SPIRV_OP_TYPE_FLOAT:
+    case VKU_SPIRV_OP_TYPE_SAMPLED_IMAGE:
+    case VKU_SPIRV_OP_TYPE_RUNTIME_ARRAY:
+    case VKU_SPIRV_OP_CONSTANT_COMPOSITE:
+    case VKU_SPIRV_OP_SPEC_CONSTANT_COMPOSITE:
+        return 3;
+    case VKU_SPIRV_OP_MEMBER_DECORATE:
+    case VKU_SPIRV_OP_TYPE_VECTOR:
+    case VKU_SPIRV_OP_TYPE_MATRIX:
+    case VKU_SPIRV_OP_TYPE_ARRAY:
+    case VKU_SPIRV_OP_TYPE_POINTER:
+    case VKU_SPIRV_OP_CONSTANT:
+    case VKU_SPIRV_OP_SPEC_CONSTANT:
+    case VKU_SPIRV_OP_VARIABLE:
+        return 4;
+    case VKU_SPIRV_OP_TYPE_IMAGE:
+        return 9;
+    default:
+        return 1;
+    }
+}
+
+VkuShaderReflection vkuCreateShaderReflection(const char *spirv, uint32_t length)
+{
+    const char *error = NULL;
+    VkuShaderReflection reflection = vkuTryCreateShaderReflection(spirv, length, &error);
+    if (reflection == NULL)
+    {
+        fprintf(stderr, "VkuError: %s\n", error);
+        exit(EXIT_FAILURE);
+    }
 
-void * vkuMapBuffer(VkuMemoryManager manager, VkuBuffer buffer)
-{
-    void *mapped_data = NULL;
-    vmaMapMemory(manager->allocator, buffer->allocation, &mapped_data);
-    return mapped_data;
+    return reflection;
 }
 
-void vkuUnmapBuffer(VkuMemoryManager manager, VkuBuffer buffer)
+// Returns NULL and the reason in error for malformed modules, so a hot reload can keep the old shader.
+VkuShaderReflection vkuTryCreateShaderReflection(const char *spirv, uint32_t length, const char **error)
 {
-    vmaUnmapMemory(manager->allocator, buffer->allocation);
-}
+    const uint32_t *words = (const uint32_t *)spirv;
+    if (spirv == NULL || length < 20 || length % 4 != 0 || words[0] != VKU_SPIRV_MAGIC || words[3] == UINT32_MAX)
+    {
+        *error = "Shader Reflection: Invalid SPIR-V module!";
+        return NULL;
+    }
 
-void vkuCopyBuffer(VkuMemoryManager manager, VkuBuffer *srcBuffer, VkuBuffer *dstBuffer, VkDeviceSize *size, uint32_t count)
-{
-    uint32_t greater_than_null = 0;
-    for (uint32_t i = 0; i < count; i++)
-        if (size[i] > 0)
-            greater_than_null++;
+    VkuSpirvParser parser = {
+        .words = words,
+        .wordCount = length / 4,
+        .bound = words[3],
+    };
+    parser.ids = (VkuSpirvId *)calloc((size_t)parser.bound + 1, sizeof(VkuSpirvId));
+    if (parser.ids == NULL)
+    {
+        *error = "Shader Reflection: SPIR-V id bound is too large!";
+        return NULL;
+    }
 
-    if (greater_than_null <= 0)
-        return;
+    VkuShaderReflection_T *reflection = (VkuShaderReflection_T *)calloc(1, sizeof(VkuShaderReflection_T));
+    uint32_t localSizeIds[3] = {0, 0, 0};
+    uint32_t workgroupSizeId = 0;
 
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = manager->transferCmdPool;
-    allocInfo.commandBufferCount = 1;
+    // First pass: remember where every result id is defined and collect its decorations.
+    for (uint32_t i = 5; i < parser.wordCount && parser.error == NULL;)
+    {
+        const uint32_t *instruction = &words[i];
+        uint32_t opcode = instruction[0] & 0xFFFF;
+        uint32_t instructionLength = instruction[0] >> 16;
+        if (instructionLength == 0 || i + instructionLength > parser.wordCount)
+        {
+            vkuSpirvFail(&parser, "Shader Reflection: Truncated SPIR-V instruction!");
+            break;
+        }
+        if (instructionLength < vkuSpirvMinInstructionLength(opcode))
+        {
+            vkuSpirvFail(&parser, "Shader Reflection: SPIR-V instruction is too short for its opcode!");
+            break;
+        }
+        i += instructionLength;
 
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(manager->device, &allocInfo, &commandBuffer);
+        switch (opcode)
+        {
+        case VKU_SPIRV_OP_ENTRY_POINT:
+            if (reflection->stage == 0)
+            {
+                static const VkShaderStageFlagBits stages[] = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, VK_SHADER_STAGE_GEOMETRY_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT};
+                reflection->stage = (instruction[1] < 6) ? stages[instruction[1]] : VK_SHADER_STAGE_ALL;
+            }
+            break;
+        case VKU_SPIRV_OP_EXECUTION_MODE:
+            if (instruction[2] == VKU_SPIRV_EXECUTION_MODE_LOCAL_SIZE && instructionLength >= 6)
+                memcpy(reflection->localSize, &instruction[3], sizeof(reflection->localSize));
+            break;
+        case VKU_SPIRV_OP_EXECUTION_MODE_ID:
+            if (instruction[2] == VKU_SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID && instructionLength >= 6)
+                memcpy(localSizeIds, &instruction[3], sizeof(localSizeIds));
+            break;
+        case VKU_SPIRV_OP_DECORATE:
+        {
+            VkuSpirvId *target = vkuSpirvGetId(&parser, instruction[1]);
+            uint32_t value = (instructionLength > 3) ? instruction[3] : 0;
+            switch (instruction[2])
+            {
+            case VKU_SPIRV_DECORATION_DESCRIPTOR_SET: target->set = value; target->hasSet = true; break;
+            case VKU_SPIRV_DECORATION_BINDING: target->binding = value; target->hasBinding = true; break;
+            case VKU_SPIRV_DECORATION_LOCATION: target->location = value; target->hasLocation = true; break;
+            case VKU_SPIRV_DECORATION_SPEC_ID: target->specId = value; target->hasSpecId = true; break;
+            case VKU_SPIRV_DECORATION_BUILT_IN:
+                target->builtIn = true;
+                if (value == VKU_SPIRV_BUILT_IN_WORKGROUP_SIZE)
+                    workgroupSizeId = instruction[1];
+                break;
+            case VKU_SPIRV_DECORATION_BUFFER_BLOCK: target->bufferBlock = true; break;
+            case VKU_SPIRV_DECORATION_ARRAY_STRIDE: target->arrayStride = value; break;
+            }
+            break;
+        }
+        case VKU_SPIRV_OP_TYPE_BOOL:
+        case VKU_SPIRV_OP_TYPE_INT:
+        case VKU_SPIRV_OP_TYPE_FLOAT:
+        case VKU_SPIRV_OP_TYPE_VECTOR:
+        case VKU_SPIRV_OP_TYPE_MATRIX:
+        case VKU_SPIRV_OP_TYPE_IMAGE:
+        case VKU_SPIRV_OP_TYPE_SAMPLER:
+        case VKU_SPIRV_OP_TYPE_SAMPLED_IMAGE:
+        case VKU_SPIRV_OP_TYPE_ARRAY:
+        case VKU_SPIRV_OP_TYPE_RUNTIME_ARRAY:
+        case VKU_SPIRV_OP_TYPE_STRUCT:
+        case VKU_SPIRV_OP_TYPE_POINTER:
+            vkuSpirvGetId(&parser, instruction[1])->opcode = opcode;
+            vkuSpirvGetId(&parser, instruction[1])->instruction = instruction;
+            break;
+        case VKU_SPIRV_OP_CONSTANT:
+        case VKU_SPIRV_OP_CONSTANT_COMPOSITE:
+        case VKU_SPIRV_OP_SPEC_CONSTANT:
+        case VKU_SPIRV_OP_SPEC_CONSTANT_COMPOSITE:
+        case VKU_SPIRV_OP_VARIABLE:
+            vkuSpirvGetId(&parser, instruction[2])->opcode = opcode;
+            vkuSpirvGetId(&parser, instruction[2])->instruction = instruction;
+            break;
+        }
+    }
 
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    // A WorkgroupSize built-in overrides the execution mode. Dimensions backed by a specialization constant keep its
+    // SpecId, see vkuResolveShaderLocalSize.
+    if (workgroupSizeId != 0 && parser.error == NULL)
+    {
+        VkuSpirvId *composite = vkuSpirvGetId(&parser, workgroupSizeId);
+        if ((composite->opcode == VKU_SPIRV_OP_CONSTANT_COMPOSITE || composite->opcode == VKU_SPIRV_OP_SPEC_CONSTANT_COMPOSITE) && (composite->instruction[0] >> 16) >= 6)
+            memcpy(localSizeIds, &composite->instruction[3], sizeof(localSizeIds));
+    }
 
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    for (uint32_t i = 0; i < 3; i++)
+        reflection->localSizeSpecIds[i] = UINT32_MAX;
 
-    for (uint32_t i = 0; i < count; i++)
+    if (localSizeIds[0] != 0 && parser.error == NULL)
     {
-        if (size[i] <= 0)
-            continue;
-
-        VkBufferCopy copyRegion = {};
-        copyRegion.size = size[i];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            reflection->localSize[i] = vkuSpirvConstantValue(&parser, localSizeIds[i]);
 
-        vkCmdCopyBuffer(commandBuffer, srcBuffer[i]->buffer, dstBuffer[i]->buffer, 1, &copyRegion);
+            VkuSpirvId *constant = vkuSpirvGetId(&parser, localSizeIds[i]);
+            if (constant->opcode == VKU_SPIRV_OP_SPEC_CONSTANT && constant->hasSpecId)
+                reflection->localSizeSpecIds[i] = constant->specId;
+        }
     }
 
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(manager->transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(manager->transferQueue);
+    // Second pass over the global variables.
+    uint32_t bindingCapacity = 0, inputCapacity = 0;
+    reflection->pushConstantOffset = UINT32_MAX;
+    for (uint32_t id = 0; id < parser.bound && parser.error == NULL; id++)
+    {
+        VkuSpirvId *variable = &parser.ids[id];
+        if (variable->opcode != VKU_SPIRV_OP_VARIABLE)
+            continue;
 
-    vkFreeCommandBuffers(manager->device, manager->transferCmdPool, 1, &commandBuffer);
-}
+        uint32_t storageClass = variable->instruction[3];
+        VkuSpirvId *pointer = vkuSpirvGetId(&parser, variable->instruction[1]);
+        if (pointer->opcode != VKU_SPIRV_OP_TYPE_POINTER)
+            continue;
+        uint32_t typeId = pointer->instruction[3];
 
-// VkuContext
+        if (storageClass == VKU_SPIRV_STORAGE_PUSH_CONSTANT)
+        {
+            uint32_t size = vkuSpirvTypeSize(&parser, typeId, 0);
+            uint32_t offset = vkuSpirvTypeOffset(&parser, typeId);
+            if (size > reflection->pushConstantSize)
+                reflection->pushConstantSize = size;
+            if (offset < reflection->pushConstantOffset)
+                reflection->pushConstantOffset = offset;
+        }
+        else if (storageClass == VKU_SPIRV_STORAGE_INPUT && reflection->stage == VK_SHADER_STAGE_VERTEX_BIT && variable->hasLocation && !variable->builtIn)
+        {
+            // Every location the input occupies is reported, e.g. a mat4 takes four consecutive ones.
+            uint32_t locationCount = vkuSpirvLocationCount(&parser, typeId, 0);
+            if (locationCount > VKU_SPIRV_MAX_INPUT_LOCATIONS || variable->location > VKU_SPIRV_MAX_INPUT_LOCATIONS - locationCount)
+            {
+                vkuSpirvFail(&parser, "Shader Reflection: Vertex shader input uses too many locations!");
+                break;
+            }
 
-VkuContext vkuCreateContext(VkuContextCreateInfo *createInfo)
-{
+            for (uint32_t i = 0; i < locationCount; i++)
+            {
+                if (reflection->inputLocationCount == inputCapacity)
+                {
+                    inputCapacity = (inputCapacity == 0) ? 8 : inputCapacity * 2;
+                    reflection->inputLocations = (uint32_t *)realloc(reflection->inputLocations, sizeof(uint32_t) * inputCapacity);
+                }
+                reflection->inputLocations[reflection->inputLocationCount++] = variable->location + i;
+            }
+        }
+        else if ((storageClass == VKU_SPIRV_STORAGE_UNIFORM_CONSTANT || storageClass == VKU_SPIRV_STORAGE_UNIFORM || storageClass == VKU_SPIRV_STORAGE_STORAGE_BUFFER) && variable->hasBinding)
+        {
+            // Arrays of descriptors multiply into the descriptor count, runtime arrays are unbounded (count 0).
+            uint32_t count = 1;
+            VkuSpirvId *type = vkuSpirvGetId(&parser, typeId);
+            while (type->opcode == VKU_SPIRV_OP_TYPE_ARRAY || type->opcode == VKU_SPIRV_OP_TYPE_RUNTIME_ARRAY)
+            {
+                count = (type->opcode == VKU_SPIRV_OP_TYPE_ARRAY) ? count * vkuSpirvConstantValue(&parser, type->instruction[3]) : 0;
+                typeId = type->instruction[2];
+                type = vkuSpirvGetId(&parser, typeId);
+            }
 
-    VkuContext_T *context = (VkuContext_T *)calloc(1, sizeof(VkuContext_T));
-    context->validation = createInfo->enableValidation;
-    context->usageFlags = createInfo->usage;
+            VkDescriptorType descriptorType;
+            switch (type->opcode)
+            {
+            case VKU_SPIRV_OP_TYPE_SAMPLED_IMAGE:
+                descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                break;
+            case VKU_SPIRV_OP_TYPE_SAMPLER:
+                descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                break;
+            case VKU_SPIRV_OP_TYPE_IMAGE:
+                if (type->instruction[3] == VKU_SPIRV_DIM_BUFFER)
+                    descriptorType = (type->instruction[7] == 2) ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                else if (type->instruction[3] == VKU_SPIRV_DIM_SUBPASS_DATA)
+                    descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                else
+                    descriptorType = (type->instruction[7] == 2) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                break;
+            case VKU_SPIRV_OP_TYPE_STRUCT:
+                descriptorType = (storageClass == VKU_SPIRV_STORAGE_STORAGE_BUFFER || type->bufferBlock) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                break;
+            default:
+                continue; // Acceleration structures and other descriptor kinds vkutils doesn't create.
+            }
 
-    VkuVkInstanceCreateInfo instanceCreateInfo = {
-        .enableValidation = createInfo->enableValidation,
-        .applicationName = createInfo->applicationName,
-        .applicationVersion = createInfo->applicationVersion,
-    };
+            if (reflection->bindingCount == bindingCapacity)
+            {
+                bindingCapacity = (bindingCapacity == 0) ? 8 : bindingCapacity * 2;
+                reflection->bindings = (VkuShaderBinding *)realloc(reflection->bindings, sizeof(VkuShaderBinding) * bindingCapacity);
+            }
 
-    context->instance = vkuCreateVkInstance(&instanceCreateInfo);
+            VkuShaderBinding *binding = &reflection->bindings[reflection->bindingCount++];
+            binding->set = variable->hasSet ? variable->set : 0;
+            binding->binding = variable->binding;
+            binding->type = descriptorType;
+            binding->count = count;
+        }
+    }
 
-    context->debugMessenger = vkuCreateVkDebugMessenger(context->instance, createInfo->enableValidation);
+    if (reflection->pushConstantOffset > reflection->pushConstantSize)
+        reflection->pushConstantOffset = 0;
 
-    if ((createInfo->usage & VKU_CONTEXT_USAGE_PRESENTATION) != VKU_CONTEXT_USAGE_PRESENTATION)
+    free(parser.ids);
+    if (parser.error != NULL)
     {
-        context->physicalDevice = vkuGetOptimalPhysicalDevice(context->instance, VK_NULL_HANDLE);
-
-        VkuVkDeviceCreateInfo deviceCreateInfo = {
-            .instance = context->instance,
-            .surface = VK_NULL_HANDLE,
-            .physical_device = context->physicalDevice,
-            .enable_validation = createInfo->enableValidation,
-            .pGraphicsQueue = &context->graphicsQueue,
-            .pPresentQueue = &context->presentQueue,
-            .pTransferQueue = &context->transferQueue,
-            .pComputeQueue = &context->computeQueue,
-        };
+        *error = parser.error;
+        vkuDestroyShaderReflection(reflection);
+        return NULL;
+    }
 
-        context->device = vkuCreateVkDevice(&deviceCreateInfo);
+    return reflection;
+}
 
-        VkuMemoryManagerCreateInfo memoryManagerCreateInfo = {
-            .device = context->device,
-            .transferQueue = context->transferQueue,
-            .physicalDevice = context->physicalDevice,
-            .instance = context->instance,
-        };
+void vkuDestroyShaderReflection(VkuShaderReflection reflection)
+{
+    free(reflection->bindings);
+    free(reflection->inputLocations);
+    free(reflection);
+}
 
-        context->memoryManager = vkuCreateMemoryManager(&memoryManagerCreateInfo);
+void vkuResolveShaderLocalSize(VkuShaderReflection reflection, const VkSpecializationInfo *specializationInfo, uint32_t localSize[3])
+{
+    memcpy(localSize, reflection->localSize, sizeof(reflection->localSize));
+    if (specializationInfo == NULL)
+        return;
 
-        context->graphicsCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_GRAPHICS);
-        context->computeCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_COMPUTE);
-    }
-    else
+    for (uint32_t i = 0; i < 3; i++)
     {
-        context->physicalDevice = VK_NULL_HANDLE;
-        context->device = VK_NULL_HANDLE;
-        context->memoryManager = NULL;
+        for (uint32_t j = 0; j < specializationInfo->mapEntryCount && reflection->localSizeSpecIds[i] != UINT32_MAX; j++)
+        {
+            const VkSpecializationMapEntry *entry = &specializationInfo->pMapEntries[j];
+            if (entry->constantID != reflection->localSizeSpecIds[i])
+                continue;
+
+            // Workgroup sizes are 32 bit integers, the entry may be narrower than that.
+            uint32_t value = 0;
+            memcpy(&value, (const uint8_t *)specializationInfo->pData + entry->offset, (entry->size < sizeof(value)) ? entry->size : sizeof(value));
+            localSize[i] = value;
+            break;
+        }
     }
+}
 
-    return context;
+// Dynamic and static buffer descriptors are interchangeable as far as the shader is concerned.
+VkDescriptorType vkuGetDescriptorTypeClass(VkDescriptorType type)
+{
+    if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    return type;
 }
 
-void vkuDestroyContext(VkuContext context)
+void vkuValidateShaderReflection(VkuShaderReflection reflection, VkuDescriptorSet *descriptorSets, uint32_t firstSet, uint32_t descriptorSetCount, VkuDescriptorSetAttribute *pushAttributes, uint32_t pushAttributeCount, VkPushConstantRange *ranges, uint32_t rangeCount)
 {
-    if (context->device != VK_NULL_HANDLE)
+    const char *error = vkuCheckShaderReflection(reflection, descriptorSets, firstSet, descriptorSetCount, pushAttributes, pushAttributeCount, ranges, rangeCount);
+    if (error != NULL)
     {
-        vkDeviceWaitIdle(context->device);
-        vkuDestroyCommandPool(context->device, context->computeCmdPool);
-        vkuDestroyCommandPool(context->device, context->graphicsCmdPool);
-        vkuDestroyMemoryManager(context->memoryManager);
-        vkuDestroyVkDevice(context->device);
-        vkuDestroyVkDebugMessenger(context->instance, context->debugMessenger);
-        vkuDestroyVkInstance(context->instance);
+        fprintf(stderr, "VkuError: %s\n", error);
+        exit(EXIT_FAILURE);
     }
-
-    free(context);
 }
 
-VkSampleCountFlagBits vkuContextGetMaxSampleCount(VkuContext context)
+// Returns the first mismatch or NULL. Set numbers below firstSet belong to the bindless table, the push-descriptor set
+// follows the descriptor sets.
+const char *vkuCheckShaderReflection(VkuShaderReflection reflection, VkuDescriptorSet *descriptorSets, uint32_t firstSet, uint32_t descriptorSetCount, VkuDescriptorSetAttribute *pushAttributes, uint32_t pushAttributeCount, VkPushConstantRange *ranges, uint32_t rangeCount)
 {
-    return vkuGetMaxUsableSampleCount(context->physicalDevice);
-}
+    for (uint32_t i = 0; i < reflection->bindingCount; i++)
+    {
+        VkuShaderBinding *binding = &reflection->bindings[i];
+        if (binding->set < firstSet)
+            continue;
 
-void vkuContextPhysicalDeviceWithSurfaceSupport(VkuContext context, VkSurfaceKHR surface)
-{
-    if ((context->usageFlags & VKU_CONTEXT_USAGE_PRESENTATION) != VKU_CONTEXT_USAGE_PRESENTATION)
-        EXIT("VkuError: Please set VKU_CONTEXT_USAGE_PRESENTATION flag during vkuContextCreation when using a vkuPresenter!\n");
+        VkuDescriptorSetAttribute *attributes = NULL;
+        uint32_t attributeCount = 0;
+        uint32_t setIndex = binding->set - firstSet;
 
-    if ((context->usageFlags & VKU_CONTEXT_USAGE_OFFSCREEN) == VKU_CONTEXT_USAGE_OFFSCREEN)
-        printf("VkuPerformanceWarning: When VKU_CONTEXT_USAGE_PRESENTATION | VKU_CONTEXT_USAGE_BASIC is set, Objects have to be recreated internally during vkuPresenter creation!\n");
+        if (setIndex < descriptorSetCount)
+        {
+            attributes = descriptorSets[setIndex]->attributes;
+            attributeCount = descriptorSets[setIndex]->attributeCount;
+        }
+        else if (setIndex == descriptorSetCount && pushAttributeCount > 0)
+        {
+            attributes = pushAttributes;
+            attributeCount = pushAttributeCount;
+        }
+        else
+        {
+            return "Shader Reflection: Shader uses a descriptor set the pipeline doesn't provide!";
+        }
 
-    VkPhysicalDevice supportedPhysicalDevice = vkuGetOptimalPhysicalDevice(context->instance, surface);
+        if (binding->binding >= attributeCount)
+            return "Shader Reflection: Shader uses a binding its descriptor set doesn't provide!";
+        if (vkuGetDescriptorTypeClass(vkuGetDescriptorType(attributes[binding->binding].type)) != binding->type)
+            return "Shader Reflection: Descriptor type of a binding doesn't match the shader!";
+        if ((attributes[binding->binding].shaderStage & reflection->stage) == 0)
+            return "Shader Reflection: A binding used by the shader isn't visible to its stage!";
+    }
 
-    if (context->memoryManager != NULL)
+    if (reflection->pushConstantSize == 0)
+        return NULL;
+
+    // Every byte of the block has to lie in the range of the shader's stage, a stage has at most one range.
+    bool covered = false;
+    for (uint32_t i = 0; i < rangeCount; i++)
     {
-        vkuDestroyMemoryManager(context->memoryManager);
+        if ((ranges[i].stageFlags & reflection->stage) == 0)
+            continue;
+
+        covered = ranges[i].offset <= reflection->pushConstantOffset && ranges[i].offset + ranges[i].size >= reflection->pushConstantSize;
+        break;
     }
 
-    if (context->graphicsCmdPool != VK_NULL_HANDLE)
+    if (!covered)
+        return "Shader Reflection: Shader push constants aren't covered by the pipeline's push constant ranges!";
+
+    return NULL;
+}
+
+// Pipeline Variant Cache
+
+VkuPipelineVariantCache vkuCreatePipelineVariantCache()
+{
+    VkuPipelineVariantCache_T *cache = (VkuPipelineVariantCache_T *)calloc(1, sizeof(VkuPipelineVariantCache_T));
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->compileCond, NULL);
+    pthread_cond_init(&cache->optimizeCond, NULL);
+    return cache;
+}
+
+void vkuPipelineVariantCacheClear(VkuPipelineVariantCache cache, VkDevice device)
+{
+    vkuPipelineVariantCacheStopOptimizer(cache);
+
+    for (uint32_t i = 0; i < cache->variantCount; i++)
     {
-        vkuDestroyCommandPool(context->device, context->graphicsCmdPool);
+        if (cache->variants[i]->pipeline != VK_NULL_HANDLE)
+            vkuDestroyVkPipeline(device, cache->variants[i]->pipeline);
+        VkPipeline optimizedPipeline = atomic_load(&cache->variants[i]->optimizedPipeline);
+        if (optimizedPipeline != VK_NULL_HANDLE)
+            vkuDestroyVkPipeline(device, optimizedPipeline);
+        free(cache->variants[i]->key);
+        free(cache->variants[i]);
     }
 
-    if (context->computeCmdPool != VK_NULL_HANDLE)
+    for (uint32_t i = 0; i < cache->libraryCount; i++)
     {
-        vkuDestroyCommandPool(context->device, context->computeCmdPool);
+        vkuDestroyVkPipeline(device, cache->libraries[i]->pipeline);
+        free(cache->libraries[i]->key);
+        free(cache->libraries[i]);
     }
 
-    if (context->device != VK_NULL_HANDLE)
+    // Shader code outlives the device, its modules don't.
+    for (uint32_t i = 0; i < cache->shaderCodeCount; i++)
     {
-        vkuDestroyVkDevice(context->device);
+        if (cache->shaderCodes[i].module != VK_NULL_HANDLE)
+            vkDestroyShaderModule(device, cache->shaderCodes[i].module, NULL);
+        cache->shaderCodes[i].module = VK_NULL_HANDLE;
     }
 
-    context->physicalDevice = supportedPhysicalDevice;
-
-    VkuVkDeviceCreateInfo deviceCreateInfo = {
-        .instance = context->instance,
-        .surface = surface,
-        .physical_device = context->physicalDevice,
-        .enable_validation = context->validation,
-        .pGraphicsQueue = &context->graphicsQueue,
-        .pPresentQueue = &context->presentQueue,
-        .pTransferQueue = &context->transferQueue,
-        .pComputeQueue = &context->computeQueue,
-    };
-
-    context->device = vkuCreateVkDevice(&deviceCreateInfo);
+    cache->variantCount = 0;
+    cache->libraryCount = 0;
+}
 
-    VkuMemoryManagerCreateInfo memoryManagerCreateInfo = {
-        .device = context->device,
-        .transferQueue = context->transferQueue,
-        .physicalDevice = context->physicalDevice,
-        .instance = context->instance,
-    };
+void vkuDestroyPipelineVariantCache(VkuPipelineVariantCache cache, VkDevice device)
+{
+    vkuPipelineVariantCacheClear(cache, device);
 
-    context->memoryManager = vkuCreateMemoryManager(&memoryManagerCreateInfo);
+    for (uint32_t i = 0; i < cache->shaderCodeCount; i++)
+        free(cache->shaderCodes[i].code);
 
-    context->graphicsCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_GRAPHICS);
-    context->computeCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_COMPUTE);
+    pthread_cond_destroy(&cache->optimizeCond);
+    pthread_cond_destroy(&cache->compileCond);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->variants);
+    free(cache->shaderCodes);
+    free(cache->libraries);
+    free(cache->optimizeQueue);
+    free(cache);
 }
 
-VkuMemoryManager vkuContextGetMemoryManager(VkuContext context)
+char *vkuContextAcquireShaderCode(VkuContext context, const char *code, uint32_t length)
 {
-    return context->memoryManager;
-}
+    if (code == NULL || length == 0)
+        return NULL;
 
-// VkuRenderResourceManager
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    uint64_t hash = vkuHash64(code, length, 0);
 
-VkuRenderResourceManager vkuCreateRenderResourceManager(VkuPresenter presenter)
-{
-    VkuRenderResourceManager_T *mgr = (VkuRenderResourceManager_T *)calloc(1, sizeof(VkuRenderResourceManager_T));
-    mgr->presenter = presenter;
-    mgr->maxSamplesUint32 = find_bit_position(vkuGetMaxUsableSampleCount(presenter->context->physicalDevice)) + 1;
+    pthread_mutex_lock(&cache->lock);
 
-    mgr->colorResources = (VkuColorResource *)calloc(1, sizeof(VkuColorResource) * mgr->maxSamplesUint32);
-    mgr->depthResources = (VkuDepthResource *)calloc(1, sizeof(VkuDepthResource) * mgr->maxSamplesUint32);
-    mgr->sampleFlags = (VkSampleCountFlagBits *)calloc(1, sizeof(VkSampleCountFlagBits) * mgr->maxSamplesUint32);
+    VkuShaderCodeEntry *entry = NULL;
+    for (uint32_t i = 0; i < cache->shaderCodeCount && entry == NULL; i++)
+        if (cache->shaderCodes[i].hash == hash && cache->shaderCodes[i].length == length && memcmp(cache->shaderCodes[i].code, code, length) == 0)
+            entry = &cache->shaderCodes[i];
 
-    return mgr;
+    if (entry == NULL)
+    {
+        if (cache->shaderCodeCount == cache->shaderCodeCapacity)
+        {
+            cache->shaderCodeCapacity = (cache->shaderCodeCapacity == 0) ? 16 : cache->shaderCodeCapacity * 2;
+            cache->shaderCodes = (VkuShaderCodeEntry *)realloc(cache->shaderCodes, sizeof(VkuShaderCodeEntry) * cache->shaderCodeCapacity);
+        }
+
+        entry = &cache->shaderCodes[cache->shaderCodeCount++];
+        entry->hash = hash;
+        entry->length = length;
+        entry->refCount = 0;
+        entry->module = VK_NULL_HANDLE;
+        entry->code = (char *)malloc(length);
+        memcpy(entry->code, code, length);
+    }
+
+    entry->refCount++;
+    char *sharedCode = entry->code;
+
+    pthread_mutex_unlock(&cache->lock);
+    return sharedCode;
 }
 
-VkuColorResource vkuRenderResourceManagerGetColorResource(VkuRenderResourceManager resourceManager, VkSampleCountFlagBits sampleCount)
+void vkuContextReleaseShaderCode(VkuContext context, char *code)
 {
-    uint32_t index = find_bit_position(sampleCount);
+    if (code == NULL)
+        return;
 
-    if (resourceManager->colorResources[index] == NULL)
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
+
+    for (uint32_t i = 0; i < cache->shaderCodeCount; i++)
     {
-        VkuColorResourcesCreateInfo colorResourcesCreateInfo = {
-            .format = resourceManager->presenter->swapchainFormat,
-            .allocator = resourceManager->presenter->context->memoryManager->allocator,
-            .extend = resourceManager->presenter->swapchainExtend,
-            .msaa_samples = sampleCount,
-            .device = resourceManager->presenter->context->device,
-        };
+        if (cache->shaderCodes[i].code != code)
+            continue;
 
-        resourceManager->colorResources[index] = vkuCreateColorResources(&colorResourcesCreateInfo);
-        resourceManager->sampleFlags[index] = sampleCount;
+        if (--cache->shaderCodes[i].refCount == 0)
+        {
+            if (cache->shaderCodes[i].module != VK_NULL_HANDLE)
+                vkDestroyShaderModule(context->device, cache->shaderCodes[i].module, NULL);
+            free(cache->shaderCodes[i].code);
+            cache->shaderCodes[i] = cache->shaderCodes[--cache->shaderCodeCount];
+        }
+        break;
     }
 
-    return resourceManager->colorResources[index];
+    pthread_mutex_unlock(&cache->lock);
 }
 
-VkuDepthResource vkuRenderResourceManagerGetDepthResource(VkuRenderResourceManager resourceManager, VkSampleCountFlagBits sampleCount)
+VkShaderModule vkuContextGetShaderModule(VkuContext context, const char *code)
 {
-    uint32_t index = find_bit_position(sampleCount);
+    if (code == NULL || context->inlineShaderModules)
+        return VK_NULL_HANDLE;
 
-    if (resourceManager->depthResources[index] == NULL)
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    VkShaderModule module = VK_NULL_HANDLE;
+
+    pthread_mutex_lock(&cache->lock);
+
+    // One module per distinct SPIR-V, created on first use and reused by every later (re)build.
+    for (uint32_t i = 0; i < cache->shaderCodeCount; i++)
     {
-        VkuDepthResourcesCreateInfo depthResourcesCreateInfo = {
-            .physical_device = resourceManager->presenter->context->physicalDevice,
-            .device = resourceManager->presenter->context->device,
-            .allocator = resourceManager->presenter->context->memoryManager->allocator,
-            .extend = resourceManager->presenter->swapchainExtend,
-            .msaa_samples = sampleCount,
-            .layerCount = 1
-        };
+        VkuShaderCodeEntry *entry = &cache->shaderCodes[i];
+        if (entry->code != code)
+            continue;
 
-        resourceManager->depthResources[index] = vkuCreateDepthResources(&depthResourcesCreateInfo);
-        resourceManager->sampleFlags[index] = sampleCount;
+        if (entry->module == VK_NULL_HANDLE)
+            entry->module = vkuCreateShaderModule(entry->code, entry->length, context->device);
+        module = entry->module;
+        break;
     }
 
-    return resourceManager->depthResources[index];
+    pthread_mutex_unlock(&cache->lock);
+    return module;
 }
 
-void vkuRenderResourceManagerUpdate(VkuRenderResourceManager resourceManager)
+VkPrimitiveTopology vkuGetTopologyClass(VkPrimitiveTopology topology)
 {
-    for (uint32_t i = 0; i < resourceManager->maxSamplesUint32; i++)
+    switch (topology)
     {
-        if (resourceManager->colorResources[i] != NULL)
-        {
-            vkuDestroyColorResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->colorResources[i]);
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY:
+        return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    default:
+        return topology;
+    }
+}
+
+VkuPipelineVariant vkuFindPipelineVariant(VkuPipelineVariant *variants, uint32_t variantCount, uint64_t hash, void *key, size_t keySize)
+{
+    for (uint32_t i = 0; i < variantCount; i++)
+        if (variants[i]->hash == hash && variants[i]->keySize == keySize && memcmp(variants[i]->key, key, keySize) == 0)
+            return variants[i];
+
+    return NULL;
+}
+
+VkuPipelineVariant vkuContextAcquirePipelineVariant(VkuContext context, VkuPipeline pipeline)
+{
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    VkuRenderStage renderStage = pipeline->renderStage;
+    VkuPipelineCreateInfo *info = &pipeline->recreateInfo;
+
+    size_t attributesSize = sizeof(VkuVertexAttribute) * pipeline->vertexLayout.attributeCount;
+    size_t keySize = sizeof(VkuPipelineVariantKey) + attributesSize + vkuGetSpecializationKeySize(&pipeline->specializationInfo);
+    VkuPipelineVariantKey *key = (VkuPipelineVariantKey *)calloc(1, keySize);
+    key->vertexSpirv = pipeline->internalVertexSpirv;
+    key->fragmentSpirv = pipeline->internalFragmentSpirv;
+    key->pipelineLayout = pipeline->pipelineLayout;
+    key->renderPassFormat = renderStage->renderPassFormat;
+    key->sampleCount = renderStage->sampleCount;
+    key->options = renderStage->options;
+    key->enableDepthTesting = renderStage->enableDepthTesting;
+    key->staticRenderStage = renderStage->staticRenderStage;
+    key->dynamicRendering = renderStage->dynamicRendering;
+    key->colorAttachmentCount = renderStage->colorAttachmentCount;
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+    {
+        key->colorAttachmentFormats[i] = renderStage->colorAttachmentFormats[i];
+        key->blendAttachments[i] = pipeline->blendAttachments[i];
+    }
+    key->polygonMode = info->polygonMode;
+    key->depthTestWrite = info->depthTestWrite;
+    key->depthTestEnable = info->depthTestEnable;
+    key->depthCompareMode = info->depthCompareMode;
+    key->cullMode = info->cullMode;
+    key->enableDepthBias = info->enableDepthBias;
+    key->depthBiasConstantFactor = info->depthBiasConstantFactor;
+    key->depthBiasSlopeFactor = info->depthBiasSlopeFactor;
+    key->topology = info->topology;
+    key->vertexSize = pipeline->vertexLayout.vertexSize;
+    key->attributeCount = pipeline->vertexLayout.attributeCount;
+
+    // State that is set per bind doesn't split variants, topologies only have to agree on their class.
+    if (context->extendedDynamicState)
+    {
+        key->depthTestWrite = VK_FALSE;
+        key->depthTestEnable = VK_FALSE;
+        key->depthCompareMode = 0;
+        key->cullMode = 0;
+        key->enableDepthBias = VK_FALSE;
+        key->depthBiasConstantFactor = 0.0f;
+        key->depthBiasSlopeFactor = 0.0f;
+        key->topology = vkuGetTopologyClass(info->topology);
+    }
 
-            VkuColorResourcesCreateInfo colorResourcesCreateInfo = {
-                .format = resourceManager->presenter->swapchainFormat,
-                .allocator = resourceManager->presenter->context->memoryManager->allocator,
-                .extend = resourceManager->presenter->swapchainExtend,
-                .msaa_samples = resourceManager->sampleFlags[i],
-                .device = resourceManager->presenter->context->device,
-            };
+    if (context->dynamicPolygonMode)
+        key->polygonMode = 0;
+    for (uint32_t i = 0; i < key->attributeCount; i++)
+        key->attributes[i] = pipeline->vertexLayout.attributes[i];
 
-            resourceManager->colorResources[i] = vkuCreateColorResources(&colorResourcesCreateInfo);
-        }
+    key->specializationEntryCount = pipeline->specializationInfo.mapEntryCount;
+    key->specializationDataSize = (uint32_t)pipeline->specializationInfo.dataSize;
+    vkuWriteSpecializationKey((uint8_t *)key->attributes + attributesSize, &pipeline->specializationInfo);
 
-        if (resourceManager->depthResources[i] != NULL)
-        {
-            vkuDestroyDepthResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->depthResources[i]);
+    uint64_t hash = vkuHash64(key, keySize, 0);
 
-            VkuDepthResourcesCreateInfo depthResourcesCreateInfo = {
-                .physical_device = resourceManager->presenter->context->physicalDevice,
-                .device = resourceManager->presenter->context->device,
-                .allocator = resourceManager->presenter->context->memoryManager->allocator,
-                .extend = resourceManager->presenter->swapchainExtend,
-                .msaa_samples = resourceManager->sampleFlags[i],
-                .layerCount = 1
-            };
+    pthread_mutex_lock(&cache->lock);
 
-            resourceManager->depthResources[i] = vkuCreateDepthResources(&depthResourcesCreateInfo);
+    VkuPipelineVariant variant = vkuFindPipelineVariant(cache->variants, cache->variantCount, hash, key, keySize);
+
+    if (variant == NULL)
+    {
+        if (cache->variantCount == cache->variantCapacity)
+        {
+            cache->variantCapacity = (cache->variantCapacity == 0) ? 16 : cache->variantCapacity * 2;
+            cache->variants = (VkuPipelineVariant *)realloc(cache->variants, sizeof(VkuPipelineVariant) * cache->variantCapacity);
         }
+
+        // The VkPipeline is compiled by the caller that inserted the variant.
+        variant = (VkuPipelineVariant_T *)calloc(1, sizeof(VkuPipelineVariant_T));
+        variant->hash = hash;
+        variant->key = key;
+        variant->keySize = keySize;
+        cache->variants[cache->variantCount++] = variant;
+        key = NULL;
     }
+
+    variant->refCount++;
+
+    pthread_mutex_unlock(&cache->lock);
+    free(key);
+    return variant;
 }
 
-void vkuDestroyRenderResourceManager(VkuRenderResourceManager resourceManager)
+void vkuContextReleasePipelineVariant(VkuContext context, VkuPipelineVariant variant)
 {
-    for (uint32_t i = 0; i < resourceManager->maxSamplesUint32; i++)
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
+
+    if (--variant->refCount == 0)
     {
-        if (resourceManager->colorResources[i] != NULL)
-            vkuDestroyColorResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->colorResources[i]);
+        for (uint32_t i = 0; i < cache->variantCount; i++)
+        {
+            if (cache->variants[i] == variant)
+            {
+                cache->variants[i] = cache->variants[--cache->variantCount];
+                break;
+            }
+        }
 
-        if (resourceManager->depthResources[i] != NULL)
-            vkuDestroyDepthResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->depthResources[i]);
+        if (variant->pipeline != VK_NULL_HANDLE)
+            vkuDestroyVkPipeline(context->device, variant->pipeline);
+        VkPipeline optimizedPipeline = atomic_load(&variant->optimizedPipeline);
+        if (optimizedPipeline != VK_NULL_HANDLE)
+            vkuDestroyVkPipeline(context->device, optimizedPipeline);
+        for (uint32_t i = 0; i < VKU_PIPELINE_LIBRARY_PART_COUNT; i++)
+            if (variant->libraries[i] != NULL)
+                vkuPipelineVariantCacheReleaseLibrary(cache, context->device, variant->libraries[i]);
+        free(variant->key);
+        free(variant);
     }
 
-    free(resourceManager->colorResources);
-    free(resourceManager->depthResources);
-    free(resourceManager->sampleFlags);
-    free(resourceManager);
+    pthread_mutex_unlock(&cache->lock);
 }
 
-// VkuPresenter
-
-VkuPresenter vkuCreatePresenter(VkuPresenterCreateInfo *createInfo)
+// Returns true if the caller has to compile the variant and hand the result to vkuPipelineVariantEndCompile. Returns
+// false once another thread has published it, waiting while that compile is still running.
+bool vkuPipelineVariantBeginCompile(VkuContext context, VkuPipelineVariant variant)
 {
-    VkuPresenter_T *presenter = (VkuPresenter_T *)calloc(1, sizeof(VkuPresenter_T));
-    presenter->context = createInfo->context;
-    presenter->framesInFlight = createInfo->framesInFlight;
-
-    VkuWindowCreateInfo windowCreateInfo = {
-        .width = createInfo->width,
-        .height = createInfo->height,
-        .centered = true,
-        .title = createInfo->windowTitle,
-        .window_icon_path = createInfo->windowIconPath};
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
 
-    presenter->window = vkuCreateWindow(&windowCreateInfo);
+    while (variant->compiling)
+        pthread_cond_wait(&cache->compileCond, &cache->lock);
 
-    presenter->surface = vkuCreateSurface(createInfo->context->instance, presenter->window->sdlWindow);
-    vkuContextPhysicalDeviceWithSurfaceSupport(createInfo->context, presenter->surface);
+    bool claimed = variant->pipeline == VK_NULL_HANDLE;
+    variant->compiling = claimed;
 
-    presenter->presentMode = createInfo->presentMode;
+    pthread_mutex_unlock(&cache->lock);
+    return claimed;
+}
 
-    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
-        .physicalDevice = createInfo->context->physicalDevice,
-        .device = createInfo->context->device,
-        .surface = presenter->surface,
-        .sdlWindow = presenter->window->sdlWindow,
-        .presentMode = presenter->presentMode,
-        .pSwapchainImageCount = &presenter->swapchainImageCount,
-        .ppSwapchainImages = &presenter->swapchainImages,
-        .pSwapchainFormat = &presenter->swapchainFormat,
-        .pSwapchainExtent = &presenter->swapchainExtend,
-    };
+void vkuPipelineVariantEndCompile(VkuContext context, VkuPipelineVariant variant, VkPipeline pipeline)
+{
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
 
-    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
+    variant->pipeline = pipeline;
+    variant->compiling = false;
+    pthread_cond_broadcast(&cache->compileCond);
 
-    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, createInfo->context->device);
+    pthread_mutex_unlock(&cache->lock);
+}
 
-    presenter->cmdBuffer = vkuCreateCommandBuffer(presenter->context->device, presenter->framesInFlight, presenter->context->graphicsCmdPool);
+VkPipeline vkuPipelineVariantWait(VkuContext context, VkuPipelineVariant variant)
+{
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
 
-    VkuSyncObjectsCreateInfo syncCreateInfo = {
-        .ppImageAvailableSemaphores = &presenter->imageAvailableSemaphores,
-        .ppRenderFinishedSemaphores = &presenter->renderFinishedSemaphores,
-        .ppInFlightFences = &presenter->inFlightFences,
-        .framesInFlight = presenter->framesInFlight,
-        .device = presenter->context->device,
-    };
+    while (variant->compiling)
+        pthread_cond_wait(&cache->compileCond, &cache->lock);
+    VkPipeline pipeline = variant->pipeline;
 
-    vkuCreateSyncObjects(&syncCreateInfo);
+    pthread_mutex_unlock(&cache->lock);
+    return pipeline;
+}
 
-    presenter->resourceManager = vkuCreateRenderResourceManager(presenter);
-    presenter->renderStageManager = vkuCreateObjectManager(sizeof(VkuRenderStage));
+// Like vkuPipelineVariantWait, but returns VK_NULL_HANDLE instead of blocking while the variant is still compiling.
+VkPipeline vkuPipelineVariantPeek(VkuContext context, VkuPipelineVariant variant)
+{
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
 
-    presenter->context->memoryManager->fences = presenter->inFlightFences;
-    presenter->context->memoryManager->fenceCount = presenter->framesInFlight;
+    VkPipeline pipeline = variant->compiling ? VK_NULL_HANDLE : variant->pipeline;
 
-    return presenter;
+    pthread_mutex_unlock(&cache->lock);
+    return pipeline;
 }
 
-void vkuRenderStageUpdate(VkuRenderStage renderStage);
-
-void vkuPresenterRecreate(VkuPresenter presenter)
+// Expects the cache lock to be held.
+void vkuPipelineVariantCacheReleaseLibrary(VkuPipelineVariantCache cache, VkDevice device, VkuPipelineVariant library)
 {
-    int width = 0, height = 0;
-    SDL_GetWindowSizeInPixels(presenter->window->sdlWindow, &width, &height);
+    if (--library->refCount > 0)
+        return;
 
-    SDL_Event event;
-    while (presenter->window->minimized || width == 0 || height == 0) {
-        if (SDL_WaitEvent(&event)) {
-            if (event.type == SDL_EVENT_WINDOW_RESTORED) {
-                presenter->window->minimized = false;
-            } else if (event.type == SDL_EVENT_WINDOW_RESIZED) {
-                SDL_GetWindowSizeInPixels(presenter->window->sdlWindow, &width, &height);
-            }
+    for (uint32_t i = 0; i < cache->libraryCount; i++)
+    {
+        if (cache->libraries[i] == library)
+        {
+            cache->libraries[i] = cache->libraries[--cache->libraryCount];
+            break;
         }
     }
 
-    // Cleanup
-    vkDeviceWaitIdle(presenter->context->device);
+    vkuDestroyVkPipeline(device, library->pipeline);
+    free(library->key);
+    free(library);
+}
 
-    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
-    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
+void vkuContextQueuePipelineOptimization(VkuContext context, VkuPipelineVariant variant)
+{
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    pthread_mutex_lock(&cache->lock);
 
-    // Creation
-    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
-        .physicalDevice = presenter->context->physicalDevice,
-        .device = presenter->context->device,
-        .surface = presenter->surface,
-        .sdlWindow = presenter->window->sdlWindow,
-        .presentMode = presenter->presentMode,
-        .pSwapchainImageCount = &presenter->swapchainImageCount,
-        .ppSwapchainImages = &presenter->swapchainImages,
-        .pSwapchainFormat = &presenter->swapchainFormat,
-        .pSwapchainExtent = &presenter->swapchainExtend,
-    };
+    if (cache->optimizeCount == cache->optimizeCapacity)
+    {
+        cache->optimizeCapacity = (cache->optimizeCapacity == 0) ? 16 : cache->optimizeCapacity * 2;
+        cache->optimizeQueue = (VkuPipelineVariant *)realloc(cache->optimizeQueue, sizeof(VkuPipelineVariant) * cache->optimizeCapacity);
+    }
 
-    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
-    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, presenter->context->device);
+    // The queue keeps the variant alive until its optimized pipeline is linked.
+    variant->refCount++;
+    cache->optimizeQueue[cache->optimizeCount++] = variant;
 
-    vkuRenderResourceManagerUpdate(presenter->resourceManager);
+    if (!cache->optimizerRunning)
+    {
+        cache->optimizerRunning = true;
+        if (pthread_create(&cache->optimizeThread, NULL, vkuPipelineOptimizerRun, context) != 0)
+            EXIT("VkuError: Failed to start pipeline optimizer thread!\n");
+    }
 
-    for (uint32_t i = 0; i < presenter->renderStageManager->elemCnt; i++)
+    pthread_cond_signal(&cache->optimizeCond);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void *vkuPipelineOptimizerRun(void *arg)
+{
+    VkuContext context = (VkuContext)arg;
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+
+    pthread_mutex_lock(&cache->lock);
+
+    while (true)
     {
-        vkuRenderStageUpdate((VkuRenderStage)presenter->renderStageManager->elements[i]);
+        while (cache->optimizeCount == 0 && !cache->stopOptimizer)
+            pthread_cond_wait(&cache->optimizeCond, &cache->lock);
+
+        if (cache->stopOptimizer)
+            break;
+
+        VkuPipelineVariant variant = cache->optimizeQueue[--cache->optimizeCount];
+        pthread_mutex_unlock(&cache->lock);
+
+        VkPipeline libraries[VKU_PIPELINE_LIBRARY_PART_COUNT];
+        for (uint32_t i = 0; i < VKU_PIPELINE_LIBRARY_PART_COUNT; i++)
+            libraries[i] = variant->libraries[i]->pipeline;
+
+        VkuPipelineVariantKey *key = (VkuPipelineVariantKey *)variant->key;
+        pthread_rwlock_rdlock(&context->pipelineCacheLock);
+        VkPipeline optimizedPipeline = vkuLinkGraphicsPipeline(context->device, context->pipelineCache, key->pipelineLayout, libraries, VK_TRUE, NULL);
+        pthread_rwlock_unlock(&context->pipelineCacheLock);
+        atomic_store(&variant->optimizedPipeline, optimizedPipeline);
+
+        vkuContextReleasePipelineVariant(context, variant);
+        pthread_mutex_lock(&cache->lock);
     }
+
+    pthread_mutex_unlock(&cache->lock);
+    return NULL;
 }
 
-void vkuPresenterSetPresentMode(VkuPresenter presenter, VkPresentModeKHR presentMode)
+void vkuPipelineVariantCacheStopOptimizer(VkuPipelineVariantCache cache)
 {
-    vkDeviceWaitIdle(presenter->context->device);
+    pthread_mutex_lock(&cache->lock);
+    bool running = cache->optimizerRunning;
+    cache->stopOptimizer = true;
+    pthread_cond_broadcast(&cache->optimizeCond);
+    pthread_mutex_unlock(&cache->lock);
 
-    presenter->presentMode = presentMode;
+    if (running)
+        pthread_join(cache->optimizeThread, NULL);
 
-    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
-    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
+    // Variants still queued are torn down by the caller.
+    cache->optimizerRunning = false;
+    cache->stopOptimizer = false;
+    cache->optimizeCount = 0;
+}
 
-    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
-        .physicalDevice = presenter->context->physicalDevice,
-        .device = presenter->context->device,
-        .surface = presenter->surface,
-        .sdlWindow = presenter->window->sdlWindow,
-        .presentMode = presenter->presentMode,
-        .pSwapchainImageCount = &presenter->swapchainImageCount,
-        .ppSwapchainImages = &presenter->swapchainImages,
-        .pSwapchainFormat = &presenter->swapchainFormat,
-        .pSwapchainExtent = &presenter->swapchainExtend,
-    };
+VkShaderModule vkuCreateShaderModule(const char *shaderCode, uint32_t codeLength, VkDevice device)
+{
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = codeLength;
+    createInfo.pCode = (const uint32_t *)shaderCode;
 
-    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
-    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, presenter->context->device);
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateShaderModule(device, &createInfo, NULL, &shaderModule));
 
-    for (uint32_t i = 0; i < presenter->renderStageManager->elemCnt; i++)
+    return shaderModule;
+}
+
+// A VK_NULL_HANDLE module passes the SPIR-V inline through the stage pNext chain, which requires maintenance5.
+void vkuInitShaderStage(VkPipelineShaderStageCreateInfo *stageInfo, VkShaderModuleCreateInfo *inlineModuleInfo, VkShaderStageFlagBits stage, VkShaderModule module, const char *spirv, uint32_t length)
+{
+    memset(stageInfo, 0, sizeof(VkPipelineShaderStageCreateInfo));
+    stageInfo->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageInfo->stage = stage;
+    stageInfo->module = module;
+    stageInfo->pName = "main";
+
+    if (module == VK_NULL_HANDLE)
     {
-        vkuRenderStageUpdate((VkuRenderStage)presenter->renderStageManager->elements[i]);
+        memset(inlineModuleInfo, 0, sizeof(VkShaderModuleCreateInfo));
+        inlineModuleInfo->sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        inlineModuleInfo->codeSize = length;
+        inlineModuleInfo->pCode = (const uint32_t *)spirv;
+        stageInfo->pNext = inlineModuleInfo;
     }
 }
 
-VkuWindow vkuPresenterGetWindow(VkuPresenter presenter)
+void vkuCopySpecializationInfo(VkSpecializationInfo *info, VkSpecializationMapEntry *entries, uint32_t entryCount, const void *data, size_t dataSize)
 {
-    return presenter->window;
+    memset(info, 0, sizeof(VkSpecializationInfo));
+    if (entryCount == 0)
+        return;
+
+    if (entries == NULL)
+        EXIT("VkuError: Pipeline Creation: specializationEntryCount is set, but specializationEntries is NULL!\n");
+    if (dataSize > 0 && data == NULL)
+        EXIT("VkuError: Pipeline Creation: specializationDataSize is set, but specializationData is NULL!\n");
+
+    for (uint32_t i = 0; i < entryCount; i++)
+        if (entries[i].size > dataSize || entries[i].offset > dataSize - entries[i].size)
+            EXIT("VkuError: Pipeline Creation: Specialization map entry exceeds the specialization data!\n");
+
+    VkSpecializationMapEntry *mapEntries = (VkSpecializationMapEntry *)malloc(sizeof(VkSpecializationMapEntry) * entryCount);
+    memcpy(mapEntries, entries, sizeof(VkSpecializationMapEntry) * entryCount);
+
+    void *mapData = malloc(dataSize > 0 ? dataSize : 1);
+    memcpy(mapData, data, dataSize);
+
+    info->mapEntryCount = entryCount;
+    info->pMapEntries = mapEntries;
+    info->dataSize = dataSize;
+    info->pData = mapData;
 }
 
-uint32_t vkuPresenterGetFramesInFlight(VkuPresenter presenter)
+void vkuFreeSpecializationInfo(VkSpecializationInfo *info)
 {
-    return presenter->framesInFlight;
+    free((void *)info->pMapEntries);
+    free((void *)info->pData);
+    memset(info, 0, sizeof(VkSpecializationInfo));
 }
 
-void vkuDestroyPresenter(VkuPresenter presenter)
+size_t vkuGetSpecializationKeySize(const VkSpecializationInfo *info)
 {
-    vkDeviceWaitIdle(presenter->context->device);
-
-    vkuDestroyObjectManager(presenter->renderStageManager);
-    vkuDestroyRenderResourceManager(presenter->resourceManager);
-    vkuDestroySyncObjects(presenter->context->device, presenter->framesInFlight, presenter->imageAvailableSemaphores, presenter->renderFinishedSemaphores, presenter->inFlightFences);
-    vkuDestroyCmdBuffer(presenter->cmdBuffer);
-    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
-    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
-    vkuDestroySurface(presenter->surface, presenter->context->instance);
-    vkuDestroyWindow(presenter->window);
-    free(presenter);
+    return sizeof(VkSpecializationMapEntry) * info->mapEntryCount + info->dataSize;
 }
 
-uint8_t *vkuPresenterRetrieveSwapchainImage(VkuPresenter presenter, uint32_t *outWidth, uint32_t *outHeight) {
-    if (presenter->swapchainExtend.width == 0 || presenter->swapchainExtend.height == 0) {
-        EXIT("vkuPresenterRetrieveSwapchainImage: Invalid swapchain extent!\n");
-        return NULL;
-    }
+void vkuWriteSpecializationKey(uint8_t *dst, const VkSpecializationInfo *info)
+{
+    if (info->mapEntryCount == 0)
+        return;
 
-    vkQueueWaitIdle(presenter->context->graphicsQueue);
+    memcpy(dst, info->pMapEntries, sizeof(VkSpecializationMapEntry) * info->mapEntryCount);
+    memcpy(dst + sizeof(VkSpecializationMapEntry) * info->mapEntryCount, info->pData, info->dataSize);
+}
 
-    VkImage dstImage;
-    VmaAllocation dstAlloc;
-    VmaAllocationInfo allocInfo;
+VkVertexInputBindingDescription vkuGetVertexInputBindingDescription(VkuVertexLayout *layout)
+{
+    VkVertexInputBindingDescription bindingDescription = {};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = (*layout).vertexSize;
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return bindingDescription;
+}
 
-    VkImageCreateInfo imageInfo = {
-        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        .imageType = VK_IMAGE_TYPE_2D,
-        .format = VK_FORMAT_B8G8R8A8_SRGB,
-        .extent = {presenter->swapchainExtend.width, presenter->swapchainExtend.height, 1},
-        .mipLevels = 1, .arrayLayers = 1, .samples = VK_SAMPLE_COUNT_1_BIT,
-        .tiling = VK_IMAGE_TILING_LINEAR,
-        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
-    };
+VkVertexInputAttributeDescription *vkuGetVertexAttributeDescriptions(VkuVertexLayout *layout)
+{
+    if ((*layout).attributeCount == 0)
+        return VK_NULL_HANDLE;
 
-    VmaAllocationCreateInfo allocCreateInfo = {
-        .usage = VMA_MEMORY_USAGE_AUTO,
-        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
-    };
+    VkVertexInputAttributeDescription *attributeDescriptions = (VkVertexInputAttributeDescription *)malloc(sizeof(VkVertexInputAttributeDescription) * (*layout).attributeCount);
 
-    if (vmaCreateImage(presenter->context->memoryManager->allocator, &imageInfo, &allocCreateInfo, &dstImage, &dstAlloc, &allocInfo) != VK_SUCCESS) {
-        EXIT("Failed to create destination image\n");
-        return NULL;
+    for (uint32_t i = 0; i < (*layout).attributeCount; i++)
+    {
+        attributeDescriptions[i].binding = 0;
+        attributeDescriptions[i].location = i;
+        attributeDescriptions[i].format = (*layout).attributes[i].format;
+        attributeDescriptions[i].offset = (*layout).attributes[i].offset;
     }
 
-    VkCommandBuffer cmdBuffer;
-    VkCommandBufferAllocateInfo cmdAllocInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandPool = presenter->context->graphicsCmdPool,
-        .commandBufferCount = 1
-    };
+    return attributeDescriptions;
+}
 
-    if (vkAllocateCommandBuffers(presenter->context->device, &cmdAllocInfo, &cmdBuffer) != VK_SUCCESS) {
-        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
-        EXIT("Failed to allocate command buffer!\n");
-        return NULL;
-    }
+void vkuInitGraphicsPipelineState(VkuGraphicsPipelineState *state, VkuGraphicsPipelineCreateInfo *createInfo)
+{
+    memset(state, 0, sizeof(VkuGraphicsPipelineState));
 
-    VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-    };
+    // Modules are owned by the context shader cache, or VK_NULL_HANDLE to pass the SPIR-V inline.
+    uint32_t stageCount = 1;
+    vkuInitShaderStage(&state->shaderStages[0], &state->inlineModules[0], VK_SHADER_STAGE_VERTEX_BIT, createInfo->vertexShaderModule, createInfo->vertexShaderSpirv, createInfo->vertexShaderLength);
 
-    if (vkBeginCommandBuffer(cmdBuffer, &beginInfo) != VK_SUCCESS) {
-        vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
-        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
-        EXIT("Failed to begin command buffer\n");
-        return NULL;
+    if (createInfo->fragmentShaderSpirv != NULL && createInfo->fragmentShaderLength > 0) {
+        vkuInitShaderStage(&state->shaderStages[1], &state->inlineModules[1], VK_SHADER_STAGE_FRAGMENT_BIT, createInfo->fragmentShaderModule, createInfo->fragmentShaderSpirv, createInfo->fragmentShaderLength);
+        stageCount = 2;
     }
 
-    VkImageMemoryBarrier barriers[2] = {
+    // Constant IDs a stage doesn't declare are ignored, so both stages share one specialization map.
+    for (uint32_t i = 0; i < stageCount; i++)
+        state->shaderStages[i].pSpecializationInfo = createInfo->specializationInfo;
+
+    VkDynamicState *dynamicStates = state->dynamicStates;
+    dynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+    dynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+    uint32_t dynamicStatesCount = 2;
+
+    // The baked values below only act as defaults, vkuFrameBindPipeline sets them again for every bind.
+    if (createInfo->extendedDynamicState)
+    {
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_CULL_MODE;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_DEPTH_COMPARE_OP;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE;
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS;
+    }
+
+    if (createInfo->dynamicPolygonMode)
+        dynamicStates[dynamicStatesCount++] = VK_DYNAMIC_STATE_POLYGON_MODE_EXT;
+
+    state->dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    state->dynamicState.dynamicStateCount = (uint32_t)dynamicStatesCount;
+    state->dynamicState.pDynamicStates = dynamicStates;
+
+    state->bindingDescription = vkuGetVertexInputBindingDescription(&createInfo->vertexInputLayout);
+    state->attributeDescriptions = vkuGetVertexAttributeDescriptions(&createInfo->vertexInputLayout);
+
+    state->vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    state->vertexInputInfo.vertexBindingDescriptionCount = (createInfo->vertexInputLayout.attributeCount == 0) ? 0 : 1;
+    state->vertexInputInfo.pVertexBindingDescriptions = (createInfo->vertexInputLayout.attributeCount == 0) ? NULL : &state->bindingDescription;
+    state->vertexInputInfo.vertexAttributeDescriptionCount = createInfo->vertexInputLayout.attributeCount;
+    state->vertexInputInfo.pVertexAttributeDescriptions = (createInfo->vertexInputLayout.attributeCount == 0) ? NULL : state->attributeDescriptions;
+
+    state->inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    state->inputAssembly.topology = createInfo->topology;
+    state->inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    state->viewport.x = 0.0f;
+    state->viewport.y = 0.0f;
+    state->viewport.width = (float)createInfo->swapchainExtend.width;
+    state->viewport.height = (float)createInfo->swapchainExtend.height;
+    state->viewport.minDepth = 0.0f;
+    state->viewport.maxDepth = 1.0f;
+
+    state->scissor.offset.x = 0;
+    state->scissor.offset.y = 0;
+    state->scissor.extent = createInfo->swapchainExtend;
+
+    state->viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    state->viewportState.viewportCount = 1;
+    state->viewportState.pViewports = &state->viewport;
+    state->viewportState.scissorCount = 1;
+    state->viewportState.pScissors = &state->scissor;
+
+    state->rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    state->rasterizer.depthClampEnable = VK_FALSE;
+    state->rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    state->rasterizer.polygonMode = createInfo->polygonMode;
+    state->rasterizer.lineWidth = 1.0f;
+    state->rasterizer.cullMode = createInfo->cullMode;
+    state->rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    state->rasterizer.depthBiasEnable = createInfo->enableDepthBias;
+    state->rasterizer.depthBiasConstantFactor = createInfo->depthBiasConstantFactor;
+    state->rasterizer.depthBiasSlopeFactor = createInfo->depthBiasSlopeFactor;
+
+    state->multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    state->multisampling.sampleShadingEnable = VK_TRUE;
+    state->multisampling.rasterizationSamples = createInfo->msaaSamples;
+    state->multisampling.minSampleShading = 0.2f;
+
+    state->depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    state->depthStencil.depthTestEnable = createInfo->depth_test_enable;
+    state->depthStencil.depthWriteEnable = createInfo->depth_test_write;
+    state->depthStencil.depthCompareOp = createInfo->depth_compare_mode;
+    state->depthStencil.depthBoundsTestEnable = VK_FALSE;
+    state->depthStencil.minDepthBounds = 0.0f;
+    state->depthStencil.maxDepthBounds = 1.0f;
+    state->depthStencil.stencilTestEnable = VK_FALSE;
+
+    // One blend state per color output. Vertex-only pipelines (depth passes) keep the outputs but write nothing.
+    for (uint32_t i = 0; i < createInfo->colorAttachmentCount; i++)
+    {
+        if (createInfo->blendAttachments != NULL)
         {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-            .srcAccessMask = 0, .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
-            .image = presenter->swapchainImages[presenter->activeFrame],
-            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
-        },
+            state->colorBlendAttachments[i] = createInfo->blendAttachments[i];
+        }
+        else
         {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            .srcAccessMask = 0, .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-            .image = dstImage,
-            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+            state->colorBlendAttachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            state->colorBlendAttachments[i].blendEnable = VK_FALSE;
         }
-    };
 
-    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2, barriers);
+        if (stageCount == 1)
+        {
+            state->colorBlendAttachments[i].colorWriteMask = 0;
+            state->colorBlendAttachments[i].blendEnable = VK_FALSE;
+        }
+    }
 
-    VkImageCopy region = {
-        .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
-        .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
-        .extent = {presenter->swapchainExtend.width, presenter->swapchainExtend.height, 1}
-    };
+    state->colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    state->colorBlending.logicOpEnable = VK_FALSE;
+    state->colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    state->colorBlending.attachmentCount = createInfo->colorAttachmentCount;
+    state->colorBlending.pAttachments = state->colorBlendAttachments;
 
-    vkCmdCopyImage(cmdBuffer, presenter->swapchainImages[presenter->activeFrame], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    // Without a render pass the attachment formats are declared on the pipeline (dynamic rendering).
+    state->renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    state->renderingInfo.colorAttachmentCount = createInfo->colorAttachmentCount;
+    state->renderingInfo.pColorAttachmentFormats = createInfo->colorAttachmentFormats;
+    state->renderingInfo.depthAttachmentFormat = createInfo->depthAttachmentFormat;
 
-    VkImageMemoryBarrier presentBarrier = {
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT, .dstAccessMask = 0,
-        .image = presenter->swapchainImages[presenter->activeFrame],
-        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    state->pipelineCreateInfo = (VkGraphicsPipelineCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = (createInfo->renderPass == VK_NULL_HANDLE) ? &state->renderingInfo : NULL,
+        .stageCount = stageCount, // Updated dynamically
+        .pStages = state->shaderStages, // Updated dynamically
+        .pVertexInputState = &state->vertexInputInfo,
+        .pInputAssemblyState = &state->inputAssembly,
+        .pViewportState = &state->viewportState,
+        .pRasterizationState = &state->rasterizer,
+        .pMultisampleState = &state->multisampling,
+        .pDepthStencilState = &state->depthStencil,
+        .pColorBlendState = &state->colorBlending,
+        .pDynamicState = &state->dynamicState,
+        .layout = createInfo->pipelineLayout,
+        .renderPass = createInfo->renderPass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
     };
+}
 
-    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &presentBarrier);
-    vkEndCommandBuffer(cmdBuffer);
+VkPipeline vkuCreateGraphicsPipeline(VkuGraphicsPipelineCreateInfo *createInfo)
+{
+    VkuGraphicsPipelineState state;
+    vkuInitGraphicsPipelineState(&state, createInfo);
 
-    VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .commandBufferCount = 1, .pCommandBuffers = &cmdBuffer};
-    if (vkQueueSubmit(presenter->context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-        vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
-        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
-        EXIT("Failed to submit command buffer\n");
-        return NULL;
-    }
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    vkuCheckPipelineResult(vkCreateGraphicsPipelines(createInfo->device, createInfo->pipelineCache, 1, &state.pipelineCreateInfo, NULL, &graphicsPipeline), createInfo->pResult);
 
-    vkQueueWaitIdle(presenter->context->graphicsQueue);
-    vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
+    free(state.attributeDescriptions);
 
-    *outWidth = presenter->swapchainExtend.width;
-    *outHeight = presenter->swapchainExtend.height;
+    return graphicsPipeline;
+}
 
-    size_t imageSize = *outWidth * *outHeight * 4;
-    uint8_t *imageData = malloc(imageSize);
-    if (!imageData) {
-        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
-        EXIT("Failed to allocate image data\n");
-        return NULL;
-    }
+VkPipeline vkuCreateGraphicsPipelineLibrary(VkuGraphicsPipelineCreateInfo *createInfo, VkGraphicsPipelineLibraryFlagsEXT part)
+{
+    VkuGraphicsPipelineState state;
+    vkuInitGraphicsPipelineState(&state, createInfo);
 
-    VkImageSubresource subresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .arrayLayer = 0};
-    VkSubresourceLayout layout;
-    vkGetImageSubresourceLayout(presenter->context->device, dstImage, &subresource, &layout);
+    // Each part only keeps the state it owns from the full pipeline description.
+    VkGraphicsPipelineCreateInfo *info = &state.pipelineCreateInfo;
 
-    uint8_t *src = allocInfo.pMappedData;
-    for (uint32_t y = 0; y < *outHeight; ++y)
-        memcpy(imageData + y * *outWidth * 4, src + y * layout.rowPitch, *outWidth * 4);
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    libraryInfo.pNext = info->pNext;
+    libraryInfo.flags = part;
 
-    vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
-    return imageData;
-}
+    info->pNext = &libraryInfo;
+    info->flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
 
-bool vkuWriteImage(const uint8_t *pixelData, uint32_t width, uint32_t height, uint32_t channels, const char *filename, bool forceOpaque) {
-    if (!pixelData || width == 0 || height == 0 || channels != 4 || !filename) {
-        fprintf(stderr, "vkuWriteImage: Invalid parameters (requires 4 channels)\n");
-        return false;
+    if (part != VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+    {
+        info->pVertexInputState = NULL;
+        info->pInputAssemblyState = NULL;
     }
 
-    size_t imageSize = width * height * 4;
-    uint8_t *convertedData = (uint8_t *)malloc(imageSize);
-    if (!convertedData) {
-        fprintf(stderr, "vkuWriteImage: Failed to allocate memory\n");
-        return false;
+    if (part != VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+    {
+        info->pViewportState = NULL;
+        info->pRasterizationState = NULL;
     }
 
-    for (size_t i = 0; i < width * height; ++i) {
-        size_t idx = i * 4;
-        convertedData[idx + 0] = pixelData[idx + 2]; // R
-        convertedData[idx + 1] = pixelData[idx + 1]; // G
-        convertedData[idx + 2] = pixelData[idx + 0]; // B
-        convertedData[idx + 3] = forceOpaque ? 255 : pixelData[idx + 3]; // A
-    }
-
-    int stride = width * 4;
-    int success = stbi_write_png(filename, width, height, 4, convertedData, stride);
-
-    free(convertedData);
-
-    if (!success) {
-        EXIT("vkuWriteImage: Failed to write image.\n");
-        return false;
-    }
-
-    return true;
-}
-
-// VkuRenderStage
-
-VkuRenderStage vkuCreateRenderStage(VkuRenderStageCreateInfo *createInfo)
-{
-    VkuRenderStage_T *renderStage = (VkuRenderStage_T *)calloc(1, sizeof(VkuRenderStage_T));
-    renderStage->options = createInfo->options;
-    renderStage->presenter = createInfo->presenter;
-    renderStage->context = createInfo->presenter->context;
-    renderStage->sampleCount = createInfo->msaaSamples;
-    renderStage->enableDepthTesting = createInfo->enableDepthTesting;
-    renderStage->outputCount = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? renderStage->presenter->swapchainImageCount : 1;
-    renderStage->staticRenderStage = VK_FALSE;
-    renderStage->staticDepthArrayCount = 1;
-
-    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
-    {
-        if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
-            EXIT("VkuError: A RenderStage cant have VKU_RENDER_OPTION_DEPTH_IMAGE and / or VKU_RENDER_OPTION_COLOR_IMAGE enabled along with VKU_RENDER_OPTION_PRESENTER!\n");
+    if (part != VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+        info->pDepthStencilState = NULL;
+    if (part != VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+        info->pColorBlendState = NULL;
+    if (part != VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT && part != VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+        info->pMultisampleState = NULL;
 
-        renderStage->pTargetColorImgViews = renderStage->presenter->swapchainImageViews;
-    }
-    else
+    if (part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
     {
-        if (!renderStage->enableDepthTesting && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
-            EXIT("VkuError: RenderStage is created with VKU_RENDER_OPTION_DEPTH_IMAGE option enabled, but enableDepthTesting is disabled!\n");
-
-        renderStage->pTargetColorImages = (VkImage *)calloc(1, sizeof(VkImage));
-        renderStage->pTargetColorImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
-        renderStage->pTargetColorImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
-        renderStage->pTargetDepthImages = (VkImage *)calloc(1, sizeof(VkImage));
-        renderStage->pTargetDepthImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
-        renderStage->pTargetDepthImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
-
-        if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE)
-        {
-            VkuVkImageCreateInfo imageCreateInfo = {
-                .allocator = renderStage->presenter->context->memoryManager->allocator,
-                .width = renderStage->presenter->swapchainExtend.width,
-                .height = renderStage->presenter->swapchainExtend.height,
-                .mipLevels = 1,
-                .format = VK_FORMAT_B8G8R8A8_SRGB,
-                .tiling = VK_IMAGE_TILING_OPTIMAL,
-                .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .numSamples = VK_SAMPLE_COUNT_1_BIT,
-                .pImage = &(renderStage->pTargetColorImages[0]),
-                .pImageAlloc = &(renderStage->pTargetColorImgAllocs[0]),
-                .pImageAllocInfo = NULL,
-                .arrayLayers = 1
-            };
-
-            vkuCreateImage(&imageCreateInfo);
-
-            renderStage->pTargetColorImgViews[0] = vkuCreateImageView(renderStage->pTargetColorImages[0], VK_FORMAT_B8G8R8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, renderStage->presenter->context->device);
-        }
-
-        if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
-        {
-            VkuVkImageCreateInfo imageCreateInfo = {
-                .allocator = renderStage->presenter->context->memoryManager->allocator,
-                .width = renderStage->presenter->swapchainExtend.width,
-                .height = renderStage->presenter->swapchainExtend.height,
-                .mipLevels = 1,
-                .format = VK_FORMAT_D32_SFLOAT,
-                .tiling = VK_IMAGE_TILING_OPTIMAL,
-                .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .numSamples = VK_SAMPLE_COUNT_1_BIT,
-                .pImage = &(renderStage->pTargetDepthImages[0]),
-                .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
-                .pImageAllocInfo = NULL,
-                .arrayLayers = 1
-            };
-
-            vkuCreateImage(&imageCreateInfo);
-
-            renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1, renderStage->presenter->context->device);
-        }
+        info->stageCount = 1;
     }
-
-    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE || (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER))
+    else if (part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
     {
-        renderStage->colorResource = vkuRenderResourceManagerGetColorResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+        info->stageCount -= 1;
+        info->pStages = &state.shaderStages[1];
     }
-
-    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    else
     {
-        renderStage->depthResource = vkuRenderResourceManagerGetDepthResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+        info->stageCount = 0;
+        info->pStages = NULL;
     }
 
-    VkuVkRenderPassCreateInfo renderPassCreateInfo = {
-        .format = renderStage->presenter->swapchainFormat,
-        .msaaSamples = renderStage->sampleCount,
-        .physicalDevice = renderStage->presenter->context->physicalDevice,
-        .device = renderStage->presenter->context->device,
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? true : ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .presentationLayout = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER),
-    };
-
-    renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
-
-    VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
-        .imageCount = renderStage->outputCount,
-        .msaaSamples = renderStage->sampleCount,
-        .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
-        .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
-        .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
-        .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
-        .renderPass = renderStage->renderPass,
-        .extend = renderStage->presenter->swapchainExtend,
-        .device = renderStage->presenter->context->device,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? true : ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .layerCount = 1};
-
-    renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    VkPipeline library = VK_NULL_HANDLE;
+    vkuCheckPipelineResult(vkCreateGraphicsPipelines(createInfo->device, createInfo->pipelineCache, 1, info, NULL, &library), createInfo->pResult);
 
-    renderStage->pipelineManager = vkuCreateObjectManager(sizeof(VkuPipeline));
-    renderStage->outputTextureManager = vkuCreateObjectManager(sizeof(VkuTexture2D));
-    renderStage->descriptorSetManager = vkuCreateObjectManager(sizeof(VkuDescriptorSet));
+    free(state.attributeDescriptions);
 
-    vkuObjectManagerAdd(renderStage->presenter->renderStageManager, (void *)renderStage);
-    return renderStage;
+    return library;
 }
 
-VkuTexture2D vkuRenderStageGetDepthOutput(VkuRenderStage renderStage)
+VkPipeline vkuLinkGraphicsPipeline(VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkPipeline *libraries, VkBool32 optimize, VkResult *pResult)
 {
-    if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE)
-        EXIT("VkuError: Depth Texture cant be retrieved: RenderStage has no depth output!\n");
+    VkPipelineLibraryCreateInfoKHR libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    libraryInfo.libraryCount = VKU_PIPELINE_LIBRARY_PART_COUNT;
+    libraryInfo.pLibraries = libraries;
 
-    VkuTexture2D_T *tex = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
-    tex->renderStage = renderStage;
-    tex->renderStageDepthImage = VK_TRUE;
-    tex->renderStageColorImage = VK_FALSE;
-    tex->textureImage = VK_NULL_HANDLE;
-    tex->textureImageAllocation = VK_NULL_HANDLE;
-    tex->textureImageView = renderStage->pTargetDepthImgViews[0];
-    tex->imageExtend = (renderStage->staticRenderStage == VK_FALSE) ? renderStage->presenter->swapchainExtend : renderStage->extend;
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &libraryInfo,
+        .flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0,
+        .layout = pipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
 
-    vkuObjectManagerAdd(tex->renderStage->outputTextureManager, (void *)tex);
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    vkuCheckPipelineResult(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, NULL, &graphicsPipeline), pResult);
 
-    return tex;
+    return graphicsPipeline;
 }
 
-VkuTexture2D vkuRenderStageGetColorOutput(VkuRenderStage renderStage)
+// Exits on failure unless the caller asked for the result, failed creations leave the handle VK_NULL_HANDLE.
+void vkuCheckPipelineResult(VkResult result, VkResult *pResult)
 {
-    if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) != VKU_RENDER_OPTION_COLOR_IMAGE)
-        EXIT("VkuError: Color Texture cant be retrieved: RenderStage has no color output or renders directly into the swapchain!\n");
+    if (pResult != NULL)
+        *pResult = result;
+    else
+        VK_CHECK(result);
+}
 
-    VkuTexture2D_T *tex = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
-    tex->renderStage = renderStage;
-    tex->renderStageDepthImage = VK_FALSE;
-    tex->renderStageColorImage = VK_TRUE;
-    tex->textureImage = VK_NULL_HANDLE;
-    tex->textureImageAllocation = VK_NULL_HANDLE;
-    tex->textureImageView = renderStage->pTargetColorImgViews[0];
-    tex->imageExtend = (renderStage->staticRenderStage == VK_FALSE) ? renderStage->presenter->swapchainExtend : renderStage->extend;
+void vkuDestroyVkPipeline(VkDevice device, VkPipeline pipeline)
+{
+    vkDestroyPipeline(device, pipeline, NULL);
+}
 
-    vkuObjectManagerAdd(tex->renderStage->outputTextureManager, (void *)tex);
+VkPipeline vkuCreateComputeVkPipeline(VkuComputeVkPipelineCreateInfo *createInfo) {
+    VkPipelineShaderStageCreateInfo shaderStageInfo;
+    VkShaderModuleCreateInfo inlineModule;
+    vkuInitShaderStage(&shaderStageInfo, &inlineModule, VK_SHADER_STAGE_COMPUTE_BIT, createInfo->computeShaderModule, createInfo->computeShaderSpirv, createInfo->computeShaderLength);
+    shaderStageInfo.pSpecializationInfo = createInfo->specializationInfo;
 
-    return tex;
-}
+    VkComputePipelineCreateInfo pipelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = shaderStageInfo,
+        .layout = createInfo->pipelineLayout
+    };
 
-void vkuRenderStageOutputTextureUpdate(VkuTexture2D texture)
-{
-    if (texture->renderStageColorImage)
-    {
-        texture->textureImageView = texture->renderStage->pTargetColorImgViews[0];
-    }
-    else if (texture->renderStageDepthImage)
-    {
-        texture->textureImageView = texture->renderStage->pTargetDepthImgViews[0];
-    }
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    vkuCheckPipelineResult(vkCreateComputePipelines(createInfo->device, createInfo->pipelineCache, 1, &pipelineInfo, NULL, &pipeline), createInfo->pResult);
 
-    texture->imageExtend = (texture->renderStage->staticRenderStage == VK_FALSE) ? texture->renderStage->presenter->swapchainExtend : texture->renderStage->extend;
+    return pipeline;
 }
 
-void vkuPipelineUpdate(VkuPipeline pipeline);
-void vkuDescriptorSetUpdate(VkuDescriptorSet descriptorSet);
-
-void vkuRenderStageUpdate(VkuRenderStage renderStage)
+VkPipelineCache vkuCreatePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char *path)
 {
-    vkDeviceWaitIdle(renderStage->context->device);
-    vkuDestroyFramebuffer(renderStage->presenter->context->device, renderStage->framebuffers, renderStage->outputCount);
-    vkuDestroyVkRenderPass(renderStage->presenter->context->device, renderStage->renderPass);
+    void *initialData = NULL;
+    size_t initialDataSize = 0;
 
-    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER)
+    FILE *file = (path != NULL) ? fopen(path, "rb") : NULL;
+    if (file != NULL)
     {
-        if (renderStage->pTargetColorImgViews[0] != NULL)
-        {
-            vkuDestroyImage(renderStage->pTargetColorImages[0], renderStage->pTargetColorImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
-            vkuDestroyImageView(renderStage->pTargetColorImgViews[0], renderStage->presenter->context->device);
-        }
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
 
-        if (renderStage->pTargetDepthImgViews[0] != NULL)
+        if (fileSize >= (long)sizeof(VkPipelineCacheHeaderVersionOne))
         {
-            vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
-            vkuDestroyImageView(renderStage->pTargetDepthImgViews[0], renderStage->presenter->context->device);
+            initialData = malloc((size_t)fileSize);
+            if (fread(initialData, 1, (size_t)fileSize, file) == (size_t)fileSize)
+                initialDataSize = (size_t)fileSize;
         }
-    }
 
-    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
-    {
-        renderStage->pTargetColorImgViews = renderStage->presenter->swapchainImageViews;
+        fclose(file);
     }
-    else
-    {
-        if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE)
-        {
-            VkuVkImageCreateInfo imageCreateInfo = {
-                .allocator = renderStage->presenter->context->memoryManager->allocator,
-                .width = renderStage->presenter->swapchainExtend.width,
-                .height = renderStage->presenter->swapchainExtend.height,
-                .mipLevels = 1,
-                .format = VK_FORMAT_B8G8R8A8_SRGB,
-                .tiling = VK_IMAGE_TILING_OPTIMAL,
-                .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .numSamples = VK_SAMPLE_COUNT_1_BIT,
-                .pImage = &(renderStage->pTargetColorImages[0]),
-                .pImageAlloc = &(renderStage->pTargetColorImgAllocs[0]),
-                .pImageAllocInfo = NULL,
-                .arrayLayers = 1
-            };
 
-            vkuCreateImage(&imageCreateInfo);
+    if (initialDataSize > 0)
+    {
+        // Drivers are supposed to reject foreign data themselves, but not all of them do. Stale caches are dropped here.
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
 
-            renderStage->pTargetColorImgViews[0] = vkuCreateImageView(renderStage->pTargetColorImages[0], VK_FORMAT_B8G8R8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, renderStage->presenter->context->device);
-        }
+        VkPipelineCacheHeaderVersionOne header;
+        memcpy(&header, initialData, sizeof(header));
 
-        if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
+        if (header.headerSize < sizeof(header) || header.headerSize > initialDataSize || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+            memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
         {
-            VkuVkImageCreateInfo imageCreateInfo = {
-                .allocator = renderStage->presenter->context->memoryManager->allocator,
-                .width = renderStage->presenter->swapchainExtend.width,
-                .height = renderStage->presenter->swapchainExtend.height,
-                .mipLevels = 1,
-                .format = VK_FORMAT_D32_SFLOAT,
-                .tiling = VK_IMAGE_TILING_OPTIMAL,
-                .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .numSamples = VK_SAMPLE_COUNT_1_BIT,
-                .pImage = &(renderStage->pTargetDepthImages[0]),
-                .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
-                .pImageAllocInfo = NULL,
-                .arrayLayers = 1,
-            };
-
-            vkuCreateImage(&imageCreateInfo);
-
-            renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1, renderStage->presenter->context->device);
+            printf("VkuWarning: Pipeline cache %s does not match this device and is ignored!\n", path);
+            initialDataSize = 0;
         }
     }
 
-    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE || (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER))
-    {
-        renderStage->colorResource = vkuRenderResourceManagerGetColorResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
-    }
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialDataSize;
+    cacheInfo.pInitialData = (initialDataSize > 0) ? initialData : NULL;
 
-    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    VkPipelineCache pipelineCache;
+    if (vkCreatePipelineCache(device, &cacheInfo, NULL, &pipelineCache) != VK_SUCCESS)
     {
-        renderStage->depthResource = vkuRenderResourceManagerGetDepthResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = NULL;
+        VK_CHECK(vkCreatePipelineCache(device, &cacheInfo, NULL, &pipelineCache));
     }
 
-    VkuVkRenderPassCreateInfo renderPassCreateInfo = {
-        .format = renderStage->presenter->swapchainFormat,
-        .msaaSamples = renderStage->sampleCount,
-        .physicalDevice = renderStage->presenter->context->physicalDevice,
-        .device = renderStage->presenter->context->device,
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? true : ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .presentationLayout = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER),
-    };
+    free(initialData);
+    return pipelineCache;
+}
+
+bool vkuSavePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path)
+{
+    if (path == NULL || pipelineCache == VK_NULL_HANDLE)
+        return false;
 
-    renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
-
-    VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
-        .imageCount = renderStage->outputCount,
-        .msaaSamples = renderStage->sampleCount,
-        .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
-        .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
-        .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
-        .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
-        .renderPass = renderStage->renderPass,
-        .extend = renderStage->presenter->swapchainExtend,
-        .device = renderStage->presenter->context->device,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? true : ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .layerCount = 1};
-
-    renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, NULL) != VK_SUCCESS || dataSize == 0)
+        return false;
 
-    for (uint32_t i = 0; i < renderStage->outputTextureManager->elemCnt; i++)
+    void *data = malloc(dataSize);
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data) != VK_SUCCESS)
     {
-        vkuRenderStageOutputTextureUpdate((VkuTexture2D)renderStage->outputTextureManager->elements[i]);
+        free(data);
+        return false;
     }
 
-    for (uint32_t i = 0; i < renderStage->pipelineManager->elemCnt; i++)
+    size_t tmpPathLength = strlen(path) + 5;
+    char tmpPath[tmpPathLength];
+    snprintf(tmpPath, tmpPathLength, "%s.tmp", path);
+
+    FILE *file = fopen(tmpPath, "wb");
+    if (file == NULL)
     {
-        vkuPipelineUpdate((VkuPipeline)renderStage->pipelineManager->elements[i]);
+        free(data);
+        return false;
     }
 
-    for (uint32_t i = 0; i < renderStage->descriptorSetManager->elemCnt; i++)
+    bool written = fwrite(data, 1, dataSize, file) == dataSize;
+    written = (fflush(file) == 0) && written;
+    written = (fsync(fileno(file)) == 0) && written;
+    written = (fclose(file) == 0) && written;
+    free(data);
+
+    if (!written || rename(tmpPath, path) != 0)
     {
-        vkuDescriptorSetUpdate((VkuDescriptorSet)renderStage->descriptorSetManager->elements[i]);
+        remove(tmpPath);
+        return false;
     }
+
+    return true;
 }
 
-void vkuDestroyRenderStage(VkuRenderStage renderStage)
+void vkuDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache)
 {
-    if (renderStage->staticRenderStage == VK_TRUE)
-        EXIT("VkuError: Trying to destroy a VkuStaticRenderStage with vkuDestroyRenderStage()!\n"); 
+    if (pipelineCache != VK_NULL_HANDLE)
+        vkDestroyPipelineCache(device, pipelineCache, NULL);
+}
 
-    vkDeviceWaitIdle(renderStage->presenter->context->device);
+// Hash
 
-    for (uint32_t i = 0; i < renderStage->outputTextureManager->elemCnt; i++)
+#define VKU_HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define VKU_HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define VKU_HASH_PRIME_3 0x165667B19E3779F9ULL
+
+static inline uint64_t vkuHashRotl(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t vkuHash64(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t hash = seed + VKU_HASH_PRIME_3 + (uint64_t)size;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
     {
-        VkuTexture2D outTex = (VkuTexture2D)renderStage->outputTextureManager->elements[i];
-        free(outTex);
+        uint64_t lane;
+        memcpy(&lane, bytes + i, sizeof(lane));
+        hash ^= vkuHashRotl(lane * VKU_HASH_PRIME_2, 31) * VKU_HASH_PRIME_1;
+        hash = vkuHashRotl(hash, 27) * VKU_HASH_PRIME_1 + VKU_HASH_PRIME_3;
     }
 
-    vkuDestroyObjectManager(renderStage->descriptorSetManager);
-    vkuDestroyObjectManager(renderStage->outputTextureManager);
-    vkuDestroyObjectManager(renderStage->pipelineManager);
-    vkuDestroyFramebuffer(renderStage->presenter->context->device, renderStage->framebuffers, renderStage->outputCount);
-    vkuDestroyVkRenderPass(renderStage->presenter->context->device, renderStage->renderPass);
-
-    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER)
+    for (; i < size; i++)
     {
-        if (renderStage->pTargetColorImgViews[0] != NULL)
-        {
-            vkuDestroyImage(renderStage->pTargetColorImages[0], renderStage->pTargetColorImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
-            vkuDestroyImageView(renderStage->pTargetColorImgViews[0], renderStage->presenter->context->device);
-        }
+        hash ^= bytes[i] * VKU_HASH_PRIME_3;
+        hash = vkuHashRotl(hash, 11) * VKU_HASH_PRIME_1;
+    }
 
-        if (renderStage->pTargetDepthImgViews[0] != NULL)
-        {
-            vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
+    hash ^= hash >> 33;
+    hash *= VKU_HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= VKU_HASH_PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/** ######################################
+ *  #                                    #
+ *  #        VkUtils External            #
+ *  #                                    #
+ *  ######################################
+ */
+
+// External Function Predefines
+
+// VkuQueue
+
+VkuThreadSafeQueue vkuQueueCreate(size_t initial_capacity) {
+    if (initial_capacity == 0) {
+        initial_capacity = 1;
+    }
+
+    VkuThreadSafeQueue queue = (VkuThreadSafeQueue) malloc(sizeof(VkuThreadSafeQueue_T));
+    if (!queue) return NULL;
+
+    queue->data = (void **) malloc(initial_capacity * sizeof(void *));
+    if (!queue->data) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->capacity = initial_capacity;
+    queue->front = 0;
+    queue->rear = 0;
+    queue->size = 0;
+
+    pthread_mutex_init(&queue->lock, NULL);
+
+    return queue;
+}
+
+void vkuQueueDestroy(VkuThreadSafeQueue queue) {
+    if (!queue) return;
+
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->data);
+    free(queue);
+}
+
+static int vkuQueueResize(VkuThreadSafeQueue queue) {
+    size_t new_capacity = queue->capacity * 2;
+    void **new_data = (void **) malloc(new_capacity * sizeof(void *));
+    if (!new_data) return -1;
+
+    if (queue->front < queue->rear) {
+        // Elements are in a contiguous block
+        memcpy(new_data, &queue->data[queue->front], queue->size * sizeof(void *));
+    } else {
+        // Elements wrap around the end of the buffer
+        size_t first_part_size = queue->capacity - queue->front;
+        memcpy(new_data, &queue->data[queue->front], first_part_size * sizeof(void *));
+        memcpy(&new_data[first_part_size], queue->data, queue->rear * sizeof(void *));
+    }
+
+    queue->front = 0;
+    queue->rear = queue->size;
+    queue->capacity = new_capacity;
+
+    free(queue->data);
+    queue->data = new_data;
+
+    return 0;
+}
+
+int vkuQueueEnqueue(VkuThreadSafeQueue queue, void *item) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->size == queue->capacity) {
+        if (vkuQueueResize(queue) != 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return -1;
+        }
+    }
+
+    queue->data[queue->rear] = item;
+    queue->rear = (queue->rear + 1) % queue->capacity;
+    queue->size++;
+
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+void *vkuQueueDequeue(VkuThreadSafeQueue queue) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->size == 0) {
+        pthread_mutex_unlock(&queue->lock);
+        return NULL;
+    }
+
+    void *item = queue->data[queue->front];
+    queue->front = (queue->front + 1) % queue->capacity;
+    queue->size--;
+
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+// VkuWindow
+
+uint8_t *vkuLoadImage(const char *path, int *width, int *height, int *channels)
+{
+    stbi_set_flip_vertically_on_load(0);
+    uint8_t *data = stbi_load(path, width, height, channels, STBI_rgb_alpha);
+    if (data == NULL)
+    {
+        fprintf(stderr, "Failed to load image from path: %s\n", path);
+        return NULL;
+    }
+
+    return data;
+}
+
+void framebuffer_size_callback(void *userdata, SDL_Event *event) {
+    if (event->type == SDL_EVENT_WINDOW_RESIZED) {
+        VkuWindow_T *vku_window = (VkuWindow_T *)userdata;
+        if (vku_window)
+            vku_window->window_resized = true;
+    }
+}
+
+static bool SDLCALL WindowEventFilter(void* userdata, SDL_Event* event) {
+    VkuWindow vkuWindow = (VkuWindow) userdata;
+
+    if (event->type == SDL_EVENT_WINDOW_MINIMIZED) {
+        vkuWindow->minimized = true;
+    } else if (event->type == SDL_EVENT_WINDOW_RESIZED) {
+        vkuWindow->window_resized = true;
+    }
+
+    return true;
+}
+
+VkuWindow vkuCreateWindow(VkuWindowCreateInfo *createInfo) {
+    VkuWindow_T *window = (VkuWindow_T *)calloc(1, sizeof(VkuWindow_T));
+
+    window->sdlWindow = SDL_CreateWindow(createInfo->title, createInfo->width, createInfo->height, SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+
+    if (!window->sdlWindow) {
+        free(window);
+        return NULL;
+    }
+
+    SDL_GetWindowSizeInPixels(window->sdlWindow, &window->windowedWidth, &window->windowedHeight);
+    SDL_GetWindowPosition(window->sdlWindow, &window->windowedX, &window->windowedY);
+
+    if (createInfo->window_icon_path != NULL) {
+        int w, h, channels;
+        void *pixels = vkuLoadImage(createInfo->window_icon_path, &w, &h, &channels); // Your custom loader
+        if (pixels) {
+            SDL_Surface *icon = SDL_CreateSurfaceFrom(w, h, SDL_PIXELFORMAT_RGBA32, pixels, 4*w);
+            SDL_SetWindowIcon(window->sdlWindow, icon);
+            SDL_DestroySurface(icon);
+            stbi_image_free(pixels);
+        }
+    }
+
+    SDL_AddEventWatch(WindowEventFilter, window);
+
+    return window;
+}
+
+void vkuWindowToggleFullscreen(VkuWindow window) {
+    if (!window->fullscreen) {
+        SDL_GetWindowPosition(window->sdlWindow, &window->windowedX, &window->windowedY);
+        SDL_GetWindowSizeInPixels(window->sdlWindow, &window->windowedWidth, &window->windowedHeight);
+        SDL_SetWindowFullscreen(window->sdlWindow, SDL_WINDOW_FULLSCREEN);
+        window->fullscreen = true;
+    } else {
+        SDL_SetWindowFullscreen(window->sdlWindow, 0);
+        SDL_SetWindowPosition(window->sdlWindow, window->windowedX, window->windowedY);
+        SDL_SetWindowSize(window->sdlWindow, window->windowedWidth, window->windowedHeight);
+        window->fullscreen = false;
+    }
+}
+
+void vkuWindowToggleInputMode(VkuWindow window) {
+    SDL_Window *win = window->sdlWindow;
+    int isRelative = SDL_GetWindowRelativeMouseMode(window->sdlWindow);
+    SDL_SetWindowRelativeMouseMode(window->sdlWindow, !isRelative);
+}
+
+float vkuWindowGetAspect(VkuWindow window) {
+    int width, height;
+    SDL_GetWindowSize(window->sdlWindow, &width, &height);
+    return (float)width / (float)height;
+}
+
+void vkuDestroyWindow(VkuWindow window) {
+    if (window) {
+        SDL_DestroyWindow(window->sdlWindow);
+        free(window);
+    }
+}
+
+// VkuMemoryManager
+
+VkuMemoryManager vkuCreateMemoryManager(VkuMemoryManagerCreateInfo *createInfo)
+{
+    VkuMemoryManager_T *manager = (VkuMemoryManager_T *)calloc(1, sizeof(VkuMemoryManager_T));
+    manager->device = createInfo->device;
+    manager->transferQueue = createInfo->transferQueue;
+    manager->allocator = vkuCreateVmaAllocator(createInfo->instance, createInfo->physicalDevice, createInfo->device);
+    manager->transferCmdPool = vkuCreateCmdPool(createInfo->physicalDevice, createInfo->device, (createInfo->transferQueue != VK_NULL_HANDLE) ? VKU_CMD_POOL_TYPE_TRANSFER : VKU_CMD_POOL_TYPE_GRAPHICS);
+    manager->fences = NULL;
+    manager->fenceCount = 0;
+    manager->destructionQueue = vkuQueueCreate(128);
+
+    return manager;
+}
+
+void vkuDestroyMemoryManager(VkuMemoryManager memoryManager)
+{
+    vkuQueueDestroy(memoryManager->destructionQueue);
+    vkuDestroyVmaAllocator(memoryManager->allocator);
+    vkuDestroyCommandPool(memoryManager->device, memoryManager->transferCmdPool);
+    free(memoryManager);
+}
+
+VkDeviceSize vkuMemoryMamgerGetAllocatedMemorySize(VkuMemoryManager manager)
+{
+    if (!manager)
+    {
+        return 0;
+    }
+
+    VmaTotalStatistics stats;
+    vmaCalculateStatistics(manager->allocator, &stats);
+
+    return stats.total.statistics.blockBytes;
+}
+
+VkuBuffer vkuCreateBuffer(VkuMemoryManager manager, VkDeviceSize size, VkuBufferUsage usage)
+{
+    VkuBuffer_T *buffer = (VkuBuffer_T *)calloc(1, sizeof(VkuBuffer_T));
+    buffer->size = size;
+    atomic_init(&buffer->queuedForDestruction, false);
+
+    VkBufferCreateInfo bufferInfo = {};
+    VmaAllocationCreateInfo allocInfo = {};
+
+    if ((usage & VKU_BUFFER_USAGE_CPU_TO_GPU) == VKU_BUFFER_USAGE_CPU_TO_GPU)
+    {
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+    else if ((usage & VKU_BUFFER_USAGE_GPU_ONLY) == VKU_BUFFER_USAGE_GPU_ONLY)
+    {
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+        if ((usage & VKU_BUFFER_USAGE_COMPUTE) == VKU_BUFFER_USAGE_COMPUTE)
+            bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+    else if ((usage & VKU_BUFFER_USAGE_GPU_TO_CPU) == VKU_BUFFER_USAGE_GPU_TO_CPU)
+    {
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    if ((usage & VKU_BUFFER_USAGE_TEXEL) == VKU_BUFFER_USAGE_TEXEL)
+        bufferInfo.usage |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+    VK_CHECK(vmaCreateBuffer(manager->allocator, &bufferInfo, &allocInfo, &buffer->buffer, &buffer->allocation, NULL));
+    return buffer;
+};
+
+void vkuDestroyBuffer(VkuBuffer buffer, VkuMemoryManager manager, VkBool32 syncronize)
+{
+    if (buffer == NULL)
+        return;
+
+    if (syncronize)
+    {
+        if (manager->fenceCount >= 0)
+        {
+            vkWaitForFences(manager->device, manager->fenceCount, manager->fences, VK_TRUE, UINT64_MAX);
+        }
+        else
+        {
+            vkDeviceWaitIdle(manager->device);
+        }
+    }
+    
+    vmaDestroyBuffer(manager->allocator, buffer->buffer, buffer->allocation);
+    free(buffer);
+}
+
+VkBufferView vkuCreateBufferView(VkuMemoryManager manager, VkuBuffer buffer, VkFormat format)
+{
+    VkBufferViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+    viewInfo.buffer = buffer->buffer;
+    viewInfo.format = format;
+    viewInfo.offset = 0;
+    viewInfo.range = VK_WHOLE_SIZE;
+
+    VkBufferView bufferView;
+    VK_CHECK(vkCreateBufferView(manager->device, &viewInfo, NULL, &bufferView));
+    return bufferView;
+}
+
+void vkuDestroyBufferView(VkuMemoryManager manager, VkBufferView bufferView)
+{
+    vkDestroyBufferView(manager->device, bufferView, NULL);
+}
+
+void vkuEnqueueBufferDestruction(VkuMemoryManager manager, VkuBuffer buffer)
+{
+    if (!vku_atomic_load(buffer->queuedForDestruction)) {
+        vku_atomic_store(buffer->queuedForDestruction, true);
+        vkuQueueEnqueue(manager->destructionQueue, (void*) buffer);
+    }
+}
+
+void vkuDestroyBuffersInDestructionQueue(VkuMemoryManager manager, VkuPresenter syncPresenter) 
+{
+    if (syncPresenter != VK_NULL_HANDLE)
+        vkWaitForFences(manager->device, manager->fenceCount, manager->fences, VK_TRUE, UINT64_MAX);
+    else
+        vkDeviceWaitIdle(manager->device);
+
+    VkuBuffer buffer;
+    while((buffer = (VkuBuffer) vkuQueueDequeue(manager->destructionQueue)) != NULL)
+    {
+        vmaDestroyBuffer(manager->allocator, buffer->buffer, buffer->allocation);
+        free(buffer);
+    }
+}
+
+void vkuSetBufferData(VkuMemoryManager manager, VkuBuffer buffer, void *data, size_t size)
+{
+    void *mapped_data = NULL;
+    vmaMapMemory(manager->allocator, buffer->allocation, &mapped_data);
+    memcpy(mapped_data, data, size);
+    vmaUnmapMemory(manager->allocator, buffer->allocation);
+}
+
+void * vkuMapBuffer(VkuMemoryManager manager, VkuBuffer buffer)
+{
+    void *mapped_data = NULL;
+    vmaMapMemory(manager->allocator, buffer->allocation, &mapped_data);
+    return mapped_data;
+}
+
+void vkuUnmapBuffer(VkuMemoryManager manager, VkuBuffer buffer)
+{
+    vmaUnmapMemory(manager->allocator, buffer->allocation);
+}
+
+void vkuCopyBuffer(VkuMemoryManager manager, VkuBuffer *srcBuffer, VkuBuffer *dstBuffer, VkDeviceSize *size, uint32_t count)
+{
+    uint32_t greater_than_null = 0;
+    for (uint32_t i = 0; i < count; i++)
+        if (size[i] > 0)
+            greater_than_null++;
+
+    if (greater_than_null <= 0)
+        return;
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = manager->transferCmdPool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(manager->device, &allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (size[i] <= 0)
+            continue;
+
+        VkBufferCopy copyRegion = {};
+        copyRegion.size = size[i];
+
+        vkCmdCopyBuffer(commandBuffer, srcBuffer[i]->buffer, dstBuffer[i]->buffer, 1, &copyRegion);
+    }
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    vkQueueSubmit(manager->transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(manager->transferQueue);
+
+    vkFreeCommandBuffers(manager->device, manager->transferCmdPool, 1, &commandBuffer);
+}
+
+// VkuUploadBatch
+
+VkuUploadBatch vkuCreateUploadBatch(VkuContext context)
+{
+    VkuUploadBatch_T *batch = (VkuUploadBatch_T *)calloc(1, sizeof(VkuUploadBatch_T));
+    batch->stagingRing = vkuCreateBuffer(context->memoryManager, VKU_UPLOAD_BATCH_RING_SIZE, VKU_BUFFER_USAGE_CPU_TO_GPU);
+    batch->stagingMemory = (uint8_t *)vkuMapBuffer(context->memoryManager, batch->stagingRing);
+    batch->head = 0;
+    batch->tail = 0;
+    batch->images = NULL;
+    batch->regions = NULL;
+    batch->uploadCount = 0;
+    batch->uploadCapacity = 0;
+    batch->frameEnds = NULL;
+    batch->frameCount = 0;
+    batch->lastFrame = UINT32_MAX;
+
+    return batch;
+}
+
+void vkuDestroyUploadBatch(VkuContext context, VkuUploadBatch batch)
+{
+    vkuUnmapBuffer(context->memoryManager, batch->stagingRing);
+    vkuDestroyBuffer(batch->stagingRing, context->memoryManager, VK_FALSE);
+
+    free(batch->images);
+    free(batch->regions);
+    free(batch->frameEnds);
+    free(batch);
+}
+
+VkBool32 vkuUploadBatchAllocate(VkuUploadBatch batch, VkDeviceSize size, VkDeviceSize *offset)
+{
+    size = (size + VKU_UPLOAD_BATCH_ALIGNMENT - 1) & ~((VkDeviceSize)VKU_UPLOAD_BATCH_ALIGNMENT - 1);
+
+    if (batch->head == batch->tail)
+    {
+        batch->head = 0;
+        batch->tail = 0;
+    }
+
+    // head == tail means empty, so an allocation may never make head catch up with tail.
+    if (batch->head >= batch->tail)
+    {
+        if (batch->head + size <= VKU_UPLOAD_BATCH_RING_SIZE && !(batch->head + size == VKU_UPLOAD_BATCH_RING_SIZE && batch->tail == 0))
+        {
+            *offset = batch->head;
+            batch->head += size;
+            return VK_TRUE;
+        }
+
+        if (size < batch->tail)
+        {
+            *offset = 0;
+            batch->head = size;
+            return VK_TRUE;
+        }
+
+        return VK_FALSE;
+    }
+
+    if (batch->head + size < batch->tail)
+    {
+        *offset = batch->head;
+        batch->head += size;
+        return VK_TRUE;
+    }
+
+    return VK_FALSE;
+}
+
+void vkuUploadBatchRecord(VkuUploadBatch batch, VkCommandBuffer commandBuffer)
+{
+    uint32_t first = 0;
+
+    while (first < batch->uploadCount)
+    {
+        uint32_t count = 1;
+        while (first + count < batch->uploadCount && batch->images[first + count] == batch->images[first])
+            count++;
+
+        vkuCmdUploadImageRegions(commandBuffer, batch->stagingRing->buffer, batch->images[first], &batch->regions[first], count, VK_REMAINING_MIP_LEVELS, VK_REMAINING_ARRAY_LAYERS);
+        first += count;
+    }
+
+    batch->uploadCount = 0;
+}
+
+void vkuUploadBatchRetireFrame(VkuUploadBatch batch, uint32_t frameIndex)
+{
+    if (frameIndex >= batch->frameCount || batch->frameEnds[frameIndex] == VKU_UPLOAD_BATCH_NO_FRAME)
+        return;
+
+    batch->tail = batch->frameEnds[frameIndex];
+    batch->frameEnds[frameIndex] = VKU_UPLOAD_BATCH_NO_FRAME;
+}
+
+void vkuContextEnqueueImageUpload(VkuContext context, VkImage image, VkBufferImageCopy region, const uint8_t *data, VkDeviceSize size)
+{
+    if (context->uploadBatch == NULL)
+        context->uploadBatch = vkuCreateUploadBatch(context);
+
+    VkuUploadBatch batch = context->uploadBatch;
+    VkDeviceSize offset = 0;
+
+    if (!vkuUploadBatchAllocate(batch, size, &offset))
+    {
+        vkuContextFlushUploads(context);
+
+        if (!vkuUploadBatchAllocate(batch, size, &offset))
+        {
+            VkuBuffer stagingBuffer = vkuCreateBuffer(context->memoryManager, size, VKU_BUFFER_USAGE_CPU_TO_GPU);
+            vkuSetBufferData(context->memoryManager, stagingBuffer, (void *)data, size);
+
+            region.bufferOffset = 0;
+            VkCommandBuffer commandBuffer = vkuBeginSingleTimeCommands(context->device, context->graphicsCmdPool);
+            vkuCmdUploadImageRegions(commandBuffer, stagingBuffer->buffer, image, &region, 1, VK_REMAINING_MIP_LEVELS, VK_REMAINING_ARRAY_LAYERS);
+            vkuEndAndSubmitSingleTimeCommands(context->device, context->graphicsCmdPool, context->graphicsQueue, commandBuffer);
+
+            vkuDestroyBuffer(stagingBuffer, context->memoryManager, VK_FALSE);
+            return;
+        }
+    }
+
+    memcpy(batch->stagingMemory + offset, data, (size_t)size);
+    region.bufferOffset = offset;
+
+    if (batch->uploadCount == batch->uploadCapacity)
+    {
+        batch->uploadCapacity = (batch->uploadCapacity == 0) ? 16 : batch->uploadCapacity * 2;
+        batch->images = (VkImage *)realloc(batch->images, sizeof(VkImage) * batch->uploadCapacity);
+        batch->regions = (VkBufferImageCopy *)realloc(batch->regions, sizeof(VkBufferImageCopy) * batch->uploadCapacity);
+    }
+
+    batch->images[batch->uploadCount] = image;
+    batch->regions[batch->uploadCount] = region;
+    batch->uploadCount++;
+}
+
+// VkuContext
+
+VkuContext vkuCreateContext(VkuContextCreateInfo *createInfo)
+{
+
+    VkuContext_T *context = (VkuContext_T *)calloc(1, sizeof(VkuContext_T));
+    context->validation = createInfo->enableValidation;
+    context->usageFlags = createInfo->usage;
+    context->layoutCache = vkuCreateLayoutCache();
+    context->pipelineVariantCache = vkuCreatePipelineVariantCache();
+    context->descriptorAllocator = vkuCreateDescriptorAllocator();
+    context->bindlessTextureCount = createInfo->bindlessTextureCount;
+    context->pipelineCachePath = (createInfo->pipelineCachePath != NULL) ? strdup(createInfo->pipelineCachePath) : NULL;
+    pthread_rwlock_init(&context->pipelineCacheLock, NULL);
+    pthread_mutex_init(&context->pipelineBatchLock, NULL);
+    pthread_cond_init(&context->pipelineBatchCond, NULL);
+
+    VkuVkInstanceCreateInfo instanceCreateInfo = {
+        .enableValidation = createInfo->enableValidation,
+        .applicationName = createInfo->applicationName,
+        .applicationVersion = createInfo->applicationVersion,
+    };
+
+    context->instance = vkuCreateVkInstance(&instanceCreateInfo);
+
+    context->debugMessenger = vkuCreateVkDebugMessenger(context->instance, createInfo->enableValidation);
+
+    if ((createInfo->usage & VKU_CONTEXT_USAGE_PRESENTATION) != VKU_CONTEXT_USAGE_PRESENTATION)
+    {
+        context->physicalDevice = vkuGetOptimalPhysicalDevice(context->instance, VK_NULL_HANDLE);
+
+        VkuVkDeviceCreateInfo deviceCreateInfo = {
+            .instance = context->instance,
+            .surface = VK_NULL_HANDLE,
+            .physical_device = context->physicalDevice,
+            .enable_validation = createInfo->enableValidation,
+            .enable_bindless = createInfo->bindlessTextureCount > 0,
+            .pGraphicsQueue = &context->graphicsQueue,
+            .pPresentQueue = &context->presentQueue,
+            .pTransferQueue = &context->transferQueue,
+            .pComputeQueue = &context->computeQueue,
+            .pInlineShaderModules = &context->inlineShaderModules,
+            .pExtendedDynamicState = &context->extendedDynamicState,
+            .pDynamicPolygonMode = &context->dynamicPolygonMode,
+            .pDynamicRendering = &context->dynamicRendering,
+            .pGraphicsPipelineLibrary = &context->graphicsPipelineLibrary,
+        };
+
+        context->device = vkuCreateVkDevice(&deviceCreateInfo);
+        context->vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(context->device, "vkCmdPushDescriptorSetKHR");
+        context->vkCmdSetPolygonModeEXT = context->dynamicPolygonMode ? (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(context->device, "vkCmdSetPolygonModeEXT") : NULL;
+        context->pipelineCache = vkuCreatePipelineCache(context->physicalDevice, context->device, context->pipelineCachePath);
+
+        if (createInfo->enableShaderHotReload)
+            context->shaderWatcher = vkuCreateShaderWatcher(context);
+
+        VkuMemoryManagerCreateInfo memoryManagerCreateInfo = {
+            .device = context->device,
+            .transferQueue = context->transferQueue,
+            .physicalDevice = context->physicalDevice,
+            .instance = context->instance,
+        };
+
+        context->memoryManager = vkuCreateMemoryManager(&memoryManagerCreateInfo);
+
+        context->graphicsCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_GRAPHICS);
+        context->computeCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_COMPUTE);
+
+        if (context->bindlessTextureCount > 0)
+            context->bindlessTable = vkuCreateBindlessTable(context, context->bindlessTextureCount);
+    }
+    else
+    {
+        context->physicalDevice = VK_NULL_HANDLE;
+        context->device = VK_NULL_HANDLE;
+        context->memoryManager = NULL;
+    }
+
+    return context;
+}
+
+void vkuDestroyContext(VkuContext context)
+{
+    if (context->shaderWatcher != NULL)
+        vkuDestroyShaderWatcher(context->shaderWatcher);
+
+    // Batches the application never waited on still own worker threads and caches that have to be merged first.
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    while (context->pipelineBatchCount > 0)
+    {
+        VkuPipelineBatch batch = context->pipelineBatches[0];
+        pthread_mutex_unlock(&context->pipelineBatchLock);
+        vkuPipelineBatchWait(batch);
+        pthread_mutex_lock(&context->pipelineBatchLock);
+    }
+    pthread_mutex_unlock(&context->pipelineBatchLock);
+
+    vkuContextWaitPipelineBatches(context);
+
+    if (context->device != VK_NULL_HANDLE)
+    {
+        vkDeviceWaitIdle(context->device);
+        vkuDestroyCommandPool(context->device, context->computeCmdPool);
+        vkuDestroyCommandPool(context->device, context->graphicsCmdPool);
+        if (context->uploadBatch != NULL)
+            vkuDestroyUploadBatch(context, context->uploadBatch);
+        if (context->bindlessTable != NULL)
+            vkuDestroyBindlessTable(context, context->bindlessTable);
+        vkuDescriptorAllocatorClear(context->descriptorAllocator, context->device);
+        vkuPipelineVariantCacheClear(context->pipelineVariantCache, context->device);
+        vkuLayoutCacheClear(context->layoutCache, context->device);
+        vkuSavePipelineCache(context->device, context->pipelineCache, context->pipelineCachePath);
+        vkuDestroyPipelineCache(context->device, context->pipelineCache);
+        vkuDestroyMemoryManager(context->memoryManager);
+        vkuDestroyVkDevice(context->device);
+        vkuDestroyVkDebugMessenger(context->instance, context->debugMessenger);
+        vkuDestroyVkInstance(context->instance);
+    }
+
+    vkuDestroyDescriptorAllocator(context->descriptorAllocator, context->device);
+    vkuDestroyPipelineVariantCache(context->pipelineVariantCache, context->device);
+    vkuDestroyLayoutCache(context->layoutCache, context->device);
+
+    pthread_cond_destroy(&context->pipelineBatchCond);
+    pthread_mutex_destroy(&context->pipelineBatchLock);
+    pthread_rwlock_destroy(&context->pipelineCacheLock);
+    free(context->pipelineBatches);
+    free(context->pipelineCachePath);
+    free(context);
+}
+
+bool vkuContextSavePipelineCache(VkuContext context)
+{
+    if (context->device == VK_NULL_HANDLE)
+        return false;
+
+    pthread_rwlock_rdlock(&context->pipelineCacheLock);
+    bool saved = vkuSavePipelineCache(context->device, context->pipelineCache, context->pipelineCachePath);
+    pthread_rwlock_unlock(&context->pipelineCacheLock);
+
+    return saved;
+}
+
+VkSampleCountFlagBits vkuContextGetMaxSampleCount(VkuContext context)
+{
+    return vkuGetMaxUsableSampleCount(context->physicalDevice);
+}
+
+void vkuContextPhysicalDeviceWithSurfaceSupport(VkuContext context, VkSurfaceKHR surface)
+{
+    if ((context->usageFlags & VKU_CONTEXT_USAGE_PRESENTATION) != VKU_CONTEXT_USAGE_PRESENTATION)
+        EXIT("VkuError: Please set VKU_CONTEXT_USAGE_PRESENTATION flag during vkuContextCreation when using a vkuPresenter!\n");
+
+    if ((context->usageFlags & VKU_CONTEXT_USAGE_OFFSCREEN) == VKU_CONTEXT_USAGE_OFFSCREEN)
+        printf("VkuPerformanceWarning: When VKU_CONTEXT_USAGE_PRESENTATION | VKU_CONTEXT_USAGE_BASIC is set, Objects have to be recreated internally during vkuPresenter creation!\n");
+
+    VkPhysicalDevice supportedPhysicalDevice = vkuGetOptimalPhysicalDevice(context->instance, surface);
+
+    if (context->uploadBatch != NULL)
+    {
+        vkuDestroyUploadBatch(context, context->uploadBatch);
+        context->uploadBatch = NULL;
+    }
+
+    if (context->bindlessTable != NULL)
+    {
+        vkuDestroyBindlessTable(context, context->bindlessTable);
+        context->bindlessTable = NULL;
+    }
+
+    if (context->memoryManager != NULL)
+    {
+        vkuDestroyMemoryManager(context->memoryManager);
+    }
+
+    if (context->graphicsCmdPool != VK_NULL_HANDLE)
+    {
+        vkuDestroyCommandPool(context->device, context->graphicsCmdPool);
+    }
+
+    if (context->computeCmdPool != VK_NULL_HANDLE)
+    {
+        vkuDestroyCommandPool(context->device, context->computeCmdPool);
+    }
+
+    if (context->device != VK_NULL_HANDLE)
+    {
+        vkuDescriptorAllocatorClear(context->descriptorAllocator, context->device);
+        vkuPipelineVariantCacheClear(context->pipelineVariantCache, context->device);
+        vkuLayoutCacheClear(context->layoutCache, context->device);
+        pthread_rwlock_wrlock(&context->pipelineCacheLock);
+        vkuSavePipelineCache(context->device, context->pipelineCache, context->pipelineCachePath);
+        vkuDestroyPipelineCache(context->device, context->pipelineCache);
+        context->pipelineCache = VK_NULL_HANDLE;
+        pthread_rwlock_unlock(&context->pipelineCacheLock);
+        vkuDestroyVkDevice(context->device);
+    }
+
+    context->physicalDevice = supportedPhysicalDevice;
+
+    VkuVkDeviceCreateInfo deviceCreateInfo = {
+        .instance = context->instance,
+        .surface = surface,
+        .physical_device = context->physicalDevice,
+        .enable_validation = context->validation,
+        .enable_bindless = context->bindlessTextureCount > 0,
+        .pGraphicsQueue = &context->graphicsQueue,
+        .pPresentQueue = &context->presentQueue,
+        .pTransferQueue = &context->transferQueue,
+        .pComputeQueue = &context->computeQueue,
+        .pInlineShaderModules = &context->inlineShaderModules,
+        .pExtendedDynamicState = &context->extendedDynamicState,
+        .pDynamicPolygonMode = &context->dynamicPolygonMode,
+        .pDynamicRendering = &context->dynamicRendering,
+        .pGraphicsPipelineLibrary = &context->graphicsPipelineLibrary,
+    };
+
+    context->device = vkuCreateVkDevice(&deviceCreateInfo);
+    context->vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(context->device, "vkCmdPushDescriptorSetKHR");
+    context->vkCmdSetPolygonModeEXT = context->dynamicPolygonMode ? (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(context->device, "vkCmdSetPolygonModeEXT") : NULL;
+    context->pipelineCache = vkuCreatePipelineCache(context->physicalDevice, context->device, context->pipelineCachePath);
+
+    VkuMemoryManagerCreateInfo memoryManagerCreateInfo = {
+        .device = context->device,
+        .transferQueue = context->transferQueue,
+        .physicalDevice = context->physicalDevice,
+        .instance = context->instance,
+    };
+
+    context->memoryManager = vkuCreateMemoryManager(&memoryManagerCreateInfo);
+
+    context->graphicsCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_GRAPHICS);
+    context->computeCmdPool = vkuCreateCmdPool(context->physicalDevice, context->device, VKU_CMD_POOL_TYPE_COMPUTE);
+
+    if (context->bindlessTextureCount > 0)
+        context->bindlessTable = vkuCreateBindlessTable(context, context->bindlessTextureCount);
+}
+
+VkuMemoryManager vkuContextGetMemoryManager(VkuContext context)
+{
+    return context->memoryManager;
+}
+
+void vkuContextFlushUploads(VkuContext context)
+{
+    VkuUploadBatch batch = context->uploadBatch;
+
+    if (batch == NULL)
+        return;
+
+    if (batch->uploadCount > 0)
+    {
+        VkCommandBuffer commandBuffer = vkuBeginSingleTimeCommands(context->device, context->graphicsCmdPool);
+        vkuUploadBatchRecord(batch, commandBuffer);
+        vkuEndAndSubmitSingleTimeCommands(context->device, context->graphicsCmdPool, context->graphicsQueue, commandBuffer);
+    }
+
+    // The flush has completed, but ring space recorded into in-flight frames is only released once their fences have
+    // been waited on. Frames retire in order, so the flushed space is handed to the newest of them and released with it.
+    if (batch->lastFrame < batch->frameCount && batch->frameEnds[batch->lastFrame] != VKU_UPLOAD_BATCH_NO_FRAME)
+        batch->frameEnds[batch->lastFrame] = batch->head;
+    else
+        batch->tail = batch->head;
+}
+
+// VkuBindlessTable
+
+VkuBindlessTable vkuCreateBindlessTable(VkuContext context, uint32_t capacity)
+{
+    VkuBindlessTable_T *table = (VkuBindlessTable_T *)calloc(1, sizeof(VkuBindlessTable_T));
+    pthread_mutex_init(&table->lock, NULL);
+    table->capacity = capacity;
+    table->nextIndex = 0;
+    table->freeIndices = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+    table->freeIndexCount = 0;
+    table->retiredIndices = (VkuBindlessRetiredIndex *)malloc(sizeof(VkuBindlessRetiredIndex) * capacity);
+    table->retiredIndexCount = 0;
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = capacity;
+    binding.stageFlags = VK_SHADER_STAGE_ALL;
+    binding.pImmutableSamplers = NULL;
+
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    VK_CHECK(vkCreateDescriptorSetLayout(context->device, &layoutInfo, NULL, &table->setLayout));
+
+    VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity};
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+
+    VK_CHECK(vkCreateDescriptorPool(context->device, &poolInfo, NULL, &table->pool));
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = table->pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &table->setLayout;
+
+    VK_CHECK(vkAllocateDescriptorSets(context->device, &allocInfo, &table->set));
+
+    VkuSamplerCreateInfo samplerInfo = {
+        .minFilter = VK_FILTER_LINEAR,
+        .magFilter = VK_FILTER_LINEAR,
+        .repeatMode = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .mipmapLevels = VKU_BINDLESS_MAX_MIP_LEVELS,
+        .physicalDevice = context->physicalDevice,
+        .device = context->device,
+        .maxAnisotropy = 16.0f,
+        .enableCompare = VK_FALSE,
+        .compareOp = 0,
+        .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+    };
+
+    table->sampler = vkuCreateSampler(&samplerInfo);
+    // Bound with the default graphics push constant range, pipelines with other ranges rebind the table themselves.
+    VkPushConstantRange pushConstantRange;
+    uint32_t pushConstantRangeCount = vkuResolvePushConstantRanges(context, &pushConstantRange, NULL, 0, VK_SHADER_STAGE_VERTEX_BIT);
+    table->pipelineLayout = vkuContextAcquirePipelineLayout(context, &table->setLayout, 1, &pushConstantRange, pushConstantRangeCount);
+    table->pushConstantHash = vkuHash64(&pushConstantRange, sizeof(VkPushConstantRange) * pushConstantRangeCount, 0);
+
+    return table;
+}
+
+void vkuDestroyBindlessTable(VkuContext context, VkuBindlessTable table)
+{
+    vkuContextReleasePipelineLayout(context, table->pipelineLayout);
+    vkDestroySampler(context->device, table->sampler, NULL);
+    vkuDestroyDescriptorPool(context->device, table->pool);
+    vkuDestroyDescriptorSetLayout(context->device, table->setLayout);
+    pthread_mutex_destroy(&table->lock);
+    free(table->freeIndices);
+    free(table->retiredIndices);
+    free(table);
+}
+
+uint32_t vkuContextRegisterBindlessTexture(VkuContext context, VkImageView imageView)
+{
+    VkuBindlessTable table = context->bindlessTable;
+    if (table == NULL)
+        return VKU_BINDLESS_INVALID_INDEX;
+
+    pthread_mutex_lock(&table->lock);
+
+    uint32_t index;
+    if (table->freeIndexCount > 0)
+        index = table->freeIndices[--table->freeIndexCount];
+    else if (table->nextIndex < table->capacity)
+        index = table->nextIndex++;
+    else
+        EXIT("VkuError: Bindless texture table is full!\n");
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = table->sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = table->set;
+    write.dstBinding = 0;
+    write.dstArrayElement = index;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(context->device, 1, &write, 0, NULL);
+
+    pthread_mutex_unlock(&table->lock);
+    return index;
+}
+
+void vkuContextUnregisterBindlessTexture(VkuContext context, uint32_t index)
+{
+    VkuBindlessTable table = context->bindlessTable;
+    if (table == NULL || index == VKU_BINDLESS_INVALID_INDEX)
+        return;
+
+    // Frames still in flight may sample the old descriptor, so the slot is only reused once they have retired.
+    pthread_mutex_lock(&table->lock);
+    table->retiredIndices[table->retiredIndexCount++] = (VkuBindlessRetiredIndex){index, 0};
+    pthread_mutex_unlock(&table->lock);
+}
+
+void vkuBindlessTableFrameBoundary(VkuBindlessTable table, uint32_t framesInFlight)
+{
+    if (table == NULL)
+        return;
+
+    pthread_mutex_lock(&table->lock);
+
+    for (uint32_t i = 0; i < table->retiredIndexCount;)
+    {
+        VkuBindlessRetiredIndex *retired = &table->retiredIndices[i];
+        if (++retired->framesSeen < framesInFlight)
+        {
+            i++;
+            continue;
+        }
+
+        table->freeIndices[table->freeIndexCount++] = retired->index;
+        *retired = table->retiredIndices[--table->retiredIndexCount];
+    }
+
+    pthread_mutex_unlock(&table->lock);
+}
+
+// VkuRenderResourceManager
+
+VkuRenderResourceManager vkuCreateRenderResourceManager(VkuPresenter presenter)
+{
+    VkuRenderResourceManager_T *mgr = (VkuRenderResourceManager_T *)calloc(1, sizeof(VkuRenderResourceManager_T));
+    mgr->presenter = presenter;
+    mgr->maxSamplesUint32 = find_bit_position(vkuGetMaxUsableSampleCount(presenter->context->physicalDevice)) + 1;
+
+    mgr->colorResources = (VkuColorResource *)calloc(1, sizeof(VkuColorResource) * mgr->maxSamplesUint32);
+    mgr->depthResources = (VkuDepthResource *)calloc(1, sizeof(VkuDepthResource) * mgr->maxSamplesUint32);
+    mgr->sampleFlags = (VkSampleCountFlagBits *)calloc(1, sizeof(VkSampleCountFlagBits) * mgr->maxSamplesUint32);
+
+    return mgr;
+}
+
+VkuColorResource vkuRenderResourceManagerGetColorResource(VkuRenderResourceManager resourceManager, VkSampleCountFlagBits sampleCount)
+{
+    uint32_t index = find_bit_position(sampleCount);
+
+    if (resourceManager->colorResources[index] == NULL)
+    {
+        VkuColorResourcesCreateInfo colorResourcesCreateInfo = {
+            .format = resourceManager->presenter->swapchainFormat,
+            .allocator = resourceManager->presenter->context->memoryManager->allocator,
+            .extend = resourceManager->presenter->swapchainExtend,
+            .msaa_samples = sampleCount,
+            .device = resourceManager->presenter->context->device,
+        };
+
+        resourceManager->colorResources[index] = vkuCreateColorResources(&colorResourcesCreateInfo);
+        resourceManager->sampleFlags[index] = sampleCount;
+    }
+
+    return resourceManager->colorResources[index];
+}
+
+VkuDepthResource vkuRenderResourceManagerGetDepthResource(VkuRenderResourceManager resourceManager, VkSampleCountFlagBits sampleCount)
+{
+    uint32_t index = find_bit_position(sampleCount);
+
+    if (resourceManager->depthResources[index] == NULL)
+    {
+        VkuDepthResourcesCreateInfo depthResourcesCreateInfo = {
+            .physical_device = resourceManager->presenter->context->physicalDevice,
+            .device = resourceManager->presenter->context->device,
+            .allocator = resourceManager->presenter->context->memoryManager->allocator,
+            .extend = resourceManager->presenter->swapchainExtend,
+            .msaa_samples = sampleCount,
+            .layerCount = 1
+        };
+
+        resourceManager->depthResources[index] = vkuCreateDepthResources(&depthResourcesCreateInfo);
+        resourceManager->sampleFlags[index] = sampleCount;
+    }
+
+    return resourceManager->depthResources[index];
+}
+
+void vkuRenderResourceManagerUpdate(VkuRenderResourceManager resourceManager)
+{
+    for (uint32_t i = 0; i < resourceManager->maxSamplesUint32; i++)
+    {
+        if (resourceManager->colorResources[i] != NULL)
+        {
+            vkuDestroyColorResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->colorResources[i]);
+
+            VkuColorResourcesCreateInfo colorResourcesCreateInfo = {
+                .format = resourceManager->presenter->swapchainFormat,
+                .allocator = resourceManager->presenter->context->memoryManager->allocator,
+                .extend = resourceManager->presenter->swapchainExtend,
+                .msaa_samples = resourceManager->sampleFlags[i],
+                .device = resourceManager->presenter->context->device,
+            };
+
+            resourceManager->colorResources[i] = vkuCreateColorResources(&colorResourcesCreateInfo);
+        }
+
+        if (resourceManager->depthResources[i] != NULL)
+        {
+            vkuDestroyDepthResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->depthResources[i]);
+
+            VkuDepthResourcesCreateInfo depthResourcesCreateInfo = {
+                .physical_device = resourceManager->presenter->context->physicalDevice,
+                .device = resourceManager->presenter->context->device,
+                .allocator = resourceManager->presenter->context->memoryManager->allocator,
+                .extend = resourceManager->presenter->swapchainExtend,
+                .msaa_samples = resourceManager->sampleFlags[i],
+                .layerCount = 1
+            };
+
+            resourceManager->depthResources[i] = vkuCreateDepthResources(&depthResourcesCreateInfo);
+        }
+    }
+}
+
+void vkuDestroyRenderResourceManager(VkuRenderResourceManager resourceManager)
+{
+    for (uint32_t i = 0; i < resourceManager->maxSamplesUint32; i++)
+    {
+        if (resourceManager->colorResources[i] != NULL)
+            vkuDestroyColorResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->colorResources[i]);
+
+        if (resourceManager->depthResources[i] != NULL)
+            vkuDestroyDepthResources(resourceManager->presenter->context->memoryManager->allocator, resourceManager->presenter->context->device, resourceManager->depthResources[i]);
+    }
+
+    free(resourceManager->colorResources);
+    free(resourceManager->depthResources);
+    free(resourceManager->sampleFlags);
+    free(resourceManager);
+}
+
+// VkuPresenter
+
+VkuPresenter vkuCreatePresenter(VkuPresenterCreateInfo *createInfo)
+{
+    VkuPresenter_T *presenter = (VkuPresenter_T *)calloc(1, sizeof(VkuPresenter_T));
+    presenter->context = createInfo->context;
+    presenter->framesInFlight = createInfo->framesInFlight;
+
+    VkuWindowCreateInfo windowCreateInfo = {
+        .width = createInfo->width,
+        .height = createInfo->height,
+        .centered = true,
+        .title = createInfo->windowTitle,
+        .window_icon_path = createInfo->windowIconPath};
+
+    presenter->window = vkuCreateWindow(&windowCreateInfo);
+
+    presenter->surface = vkuCreateSurface(createInfo->context->instance, presenter->window->sdlWindow);
+    vkuContextPhysicalDeviceWithSurfaceSupport(createInfo->context, presenter->surface);
+
+    presenter->presentMode = createInfo->presentMode;
+
+    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
+        .physicalDevice = createInfo->context->physicalDevice,
+        .device = createInfo->context->device,
+        .surface = presenter->surface,
+        .sdlWindow = presenter->window->sdlWindow,
+        .presentMode = presenter->presentMode,
+        .pSwapchainImageCount = &presenter->swapchainImageCount,
+        .ppSwapchainImages = &presenter->swapchainImages,
+        .pSwapchainFormat = &presenter->swapchainFormat,
+        .pSwapchainExtent = &presenter->swapchainExtend,
+    };
+
+    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
+
+    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, createInfo->context->device);
+
+    presenter->cmdBuffer = vkuCreateCommandBuffer(presenter->context->device, presenter->framesInFlight, presenter->context->graphicsCmdPool);
+
+    VkuSyncObjectsCreateInfo syncCreateInfo = {
+        .ppImageAvailableSemaphores = &presenter->imageAvailableSemaphores,
+        .ppRenderFinishedSemaphores = &presenter->renderFinishedSemaphores,
+        .ppInFlightFences = &presenter->inFlightFences,
+        .framesInFlight = presenter->framesInFlight,
+        .device = presenter->context->device,
+    };
+
+    vkuCreateSyncObjects(&syncCreateInfo);
+
+    presenter->resourceManager = vkuCreateRenderResourceManager(presenter);
+    presenter->renderStageManager = vkuCreateObjectManager(sizeof(VkuRenderStage));
+
+    presenter->context->memoryManager->fences = presenter->inFlightFences;
+    presenter->context->memoryManager->fenceCount = presenter->framesInFlight;
+
+    return presenter;
+}
+
+void vkuRenderStageUpdate(VkuRenderStage renderStage);
+
+void vkuPresenterRecreate(VkuPresenter presenter)
+{
+    int width = 0, height = 0;
+    SDL_GetWindowSizeInPixels(presenter->window->sdlWindow, &width, &height);
+
+    SDL_Event event;
+    while (presenter->window->minimized || width == 0 || height == 0) {
+        if (SDL_WaitEvent(&event)) {
+            if (event.type == SDL_EVENT_WINDOW_RESTORED) {
+                presenter->window->minimized = false;
+            } else if (event.type == SDL_EVENT_WINDOW_RESIZED) {
+                SDL_GetWindowSizeInPixels(presenter->window->sdlWindow, &width, &height);
+            }
+        }
+    }
+
+    // Cleanup
+    vkDeviceWaitIdle(presenter->context->device);
+
+    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
+    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
+
+    // Creation
+    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
+        .physicalDevice = presenter->context->physicalDevice,
+        .device = presenter->context->device,
+        .surface = presenter->surface,
+        .sdlWindow = presenter->window->sdlWindow,
+        .presentMode = presenter->presentMode,
+        .pSwapchainImageCount = &presenter->swapchainImageCount,
+        .ppSwapchainImages = &presenter->swapchainImages,
+        .pSwapchainFormat = &presenter->swapchainFormat,
+        .pSwapchainExtent = &presenter->swapchainExtend,
+    };
+
+    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
+    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, presenter->context->device);
+
+    vkuRenderResourceManagerUpdate(presenter->resourceManager);
+
+    for (uint32_t i = 0; i < presenter->renderStageManager->elemCnt; i++)
+    {
+        vkuRenderStageUpdate((VkuRenderStage)presenter->renderStageManager->elements[i]);
+    }
+}
+
+void vkuPresenterSetPresentMode(VkuPresenter presenter, VkPresentModeKHR presentMode)
+{
+    vkDeviceWaitIdle(presenter->context->device);
+
+    presenter->presentMode = presentMode;
+
+    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
+    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
+
+    VkuVkSwapchainKHRCreateInfo swapchainCreateInfo = {
+        .physicalDevice = presenter->context->physicalDevice,
+        .device = presenter->context->device,
+        .surface = presenter->surface,
+        .sdlWindow = presenter->window->sdlWindow,
+        .presentMode = presenter->presentMode,
+        .pSwapchainImageCount = &presenter->swapchainImageCount,
+        .ppSwapchainImages = &presenter->swapchainImages,
+        .pSwapchainFormat = &presenter->swapchainFormat,
+        .pSwapchainExtent = &presenter->swapchainExtend,
+    };
+
+    presenter->swapchain = vkuCreateVkSwapchainKHR(&swapchainCreateInfo);
+    presenter->swapchainImageViews = vkuCreateSwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImages, presenter->swapchainFormat, presenter->context->device);
+
+    for (uint32_t i = 0; i < presenter->renderStageManager->elemCnt; i++)
+    {
+        vkuRenderStageUpdate((VkuRenderStage)presenter->renderStageManager->elements[i]);
+    }
+}
+
+VkuWindow vkuPresenterGetWindow(VkuPresenter presenter)
+{
+    return presenter->window;
+}
+
+uint32_t vkuPresenterGetFramesInFlight(VkuPresenter presenter)
+{
+    return presenter->framesInFlight;
+}
+
+void vkuDestroyPresenter(VkuPresenter presenter)
+{
+    vkDeviceWaitIdle(presenter->context->device);
+    vkuShaderWatcherRemoveOwner(presenter->context->shaderWatcher, presenter);
+
+    vkuDestroyObjectManager(presenter->renderStageManager);
+    vkuDestroyRenderResourceManager(presenter->resourceManager);
+    vkuDestroySyncObjects(presenter->context->device, presenter->framesInFlight, presenter->imageAvailableSemaphores, presenter->renderFinishedSemaphores, presenter->inFlightFences);
+    vkuDestroyCmdBuffer(presenter->cmdBuffer);
+    vkuDestroySwapchainImageViews(presenter->swapchainImageCount, presenter->swapchainImageViews, presenter->context->device);
+    vkuDestroyVkSwapchainKHR(presenter->swapchain, presenter->context->device, presenter->swapchainImages);
+    vkuDestroySurface(presenter->surface, presenter->context->instance);
+    vkuDestroyWindow(presenter->window);
+    free(presenter);
+}
+
+uint8_t *vkuPresenterRetrieveSwapchainImage(VkuPresenter presenter, uint32_t *outWidth, uint32_t *outHeight) {
+    if (presenter->swapchainExtend.width == 0 || presenter->swapchainExtend.height == 0) {
+        EXIT("vkuPresenterRetrieveSwapchainImage: Invalid swapchain extent!\n");
+        return NULL;
+    }
+
+    vkQueueWaitIdle(presenter->context->graphicsQueue);
+
+    VkImage dstImage;
+    VmaAllocation dstAlloc;
+    VmaAllocationInfo allocInfo;
+
+    VkImageCreateInfo imageInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_B8G8R8A8_SRGB,
+        .extent = {presenter->swapchainExtend.width, presenter->swapchainExtend.height, 1},
+        .mipLevels = 1, .arrayLayers = 1, .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_LINEAR,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    VmaAllocationCreateInfo allocCreateInfo = {
+        .usage = VMA_MEMORY_USAGE_AUTO,
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
+    };
+
+    if (vmaCreateImage(presenter->context->memoryManager->allocator, &imageInfo, &allocCreateInfo, &dstImage, &dstAlloc, &allocInfo) != VK_SUCCESS) {
+        EXIT("Failed to create destination image\n");
+        return NULL;
+    }
+
+    VkCommandBuffer cmdBuffer;
+    VkCommandBufferAllocateInfo cmdAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandPool = presenter->context->graphicsCmdPool,
+        .commandBufferCount = 1
+    };
+
+    if (vkAllocateCommandBuffers(presenter->context->device, &cmdAllocInfo, &cmdBuffer) != VK_SUCCESS) {
+        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
+        EXIT("Failed to allocate command buffer!\n");
+        return NULL;
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    if (vkBeginCommandBuffer(cmdBuffer, &beginInfo) != VK_SUCCESS) {
+        vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
+        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
+        EXIT("Failed to begin command buffer\n");
+        return NULL;
+    }
+
+    VkImageMemoryBarrier barriers[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .srcAccessMask = 0, .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+            .image = presenter->swapchainImages[presenter->activeFrame],
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcAccessMask = 0, .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .image = dstImage,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+        }
+    };
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2, barriers);
+
+    VkImageCopy region = {
+        .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .extent = {presenter->swapchainExtend.width, presenter->swapchainExtend.height, 1}
+    };
+
+    vkCmdCopyImage(cmdBuffer, presenter->swapchainImages[presenter->activeFrame], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    VkImageMemoryBarrier presentBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT, .dstAccessMask = 0,
+        .image = presenter->swapchainImages[presenter->activeFrame],
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    };
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &presentBarrier);
+    vkEndCommandBuffer(cmdBuffer);
+
+    VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .commandBufferCount = 1, .pCommandBuffers = &cmdBuffer};
+    if (vkQueueSubmit(presenter->context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
+        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
+        EXIT("Failed to submit command buffer\n");
+        return NULL;
+    }
+
+    vkQueueWaitIdle(presenter->context->graphicsQueue);
+    vkFreeCommandBuffers(presenter->context->device, presenter->context->graphicsCmdPool, 1, &cmdBuffer);
+
+    *outWidth = presenter->swapchainExtend.width;
+    *outHeight = presenter->swapchainExtend.height;
+
+    size_t imageSize = *outWidth * *outHeight * 4;
+    uint8_t *imageData = malloc(imageSize);
+    if (!imageData) {
+        vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
+        EXIT("Failed to allocate image data\n");
+        return NULL;
+    }
+
+    VkImageSubresource subresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .arrayLayer = 0};
+    VkSubresourceLayout layout;
+    vkGetImageSubresourceLayout(presenter->context->device, dstImage, &subresource, &layout);
+
+    uint8_t *src = allocInfo.pMappedData;
+    for (uint32_t y = 0; y < *outHeight; ++y)
+        memcpy(imageData + y * *outWidth * 4, src + y * layout.rowPitch, *outWidth * 4);
+
+    vmaDestroyImage(presenter->context->memoryManager->allocator, dstImage, dstAlloc);
+    return imageData;
+}
+
+bool vkuWriteImage(const uint8_t *pixelData, uint32_t width, uint32_t height, uint32_t channels, const char *filename, bool forceOpaque) {
+    if (!pixelData || width == 0 || height == 0 || channels != 4 || !filename) {
+        fprintf(stderr, "vkuWriteImage: Invalid parameters (requires 4 channels)\n");
+        return false;
+    }
+
+    size_t imageSize = width * height * 4;
+    uint8_t *convertedData = (uint8_t *)malloc(imageSize);
+    if (!convertedData) {
+        fprintf(stderr, "vkuWriteImage: Failed to allocate memory\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < width * height; ++i) {
+        size_t idx = i * 4;
+        convertedData[idx + 0] = pixelData[idx + 2]; // R
+        convertedData[idx + 1] = pixelData[idx + 1]; // G
+        convertedData[idx + 2] = pixelData[idx + 0]; // B
+        convertedData[idx + 3] = forceOpaque ? 255 : pixelData[idx + 3]; // A
+    }
+
+    int stride = width * 4;
+    int success = stbi_write_png(filename, width, height, 4, convertedData, stride);
+
+    free(convertedData);
+
+    if (!success) {
+        EXIT("vkuWriteImage: Failed to write image.\n");
+        return false;
+    }
+
+    return true;
+}
+
+// VkuRenderStage
+
+void vkuRenderStageInitColorOutputs(VkuRenderStage renderStage, uint32_t colorAttachmentCount, VkFormat *colorAttachmentFormats)
+{
+    // Presenter stages write the swapchain image, offscreen stages own one sampled image per color output.
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+    {
+        renderStage->colorAttachmentCount = 1;
+        renderStage->colorAttachmentFormats[0] = renderStage->presenter->swapchainFormat;
+        return;
+    }
+
+    if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) != VKU_RENDER_OPTION_COLOR_IMAGE)
+        return;
+
+    if (colorAttachmentCount > VKU_MAX_COLOR_ATTACHMENTS)
+        EXIT("VkuError: RenderStage is created with more than VKU_MAX_COLOR_ATTACHMENTS color outputs!\n");
+
+    renderStage->colorAttachmentCount = (colorAttachmentCount > 0) ? colorAttachmentCount : 1;
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+    {
+        renderStage->colorAttachmentFormats[i] = (colorAttachmentFormats != NULL) ? colorAttachmentFormats[i] : VK_FORMAT_B8G8R8A8_SRGB;
+
+        // Outputs are rendered to and sampled by later stages.
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(renderStage->context->physicalDevice, renderStage->colorAttachmentFormats[i], &formatProperties);
+        if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) == 0)
+            EXIT("VkuError: RenderStage color output format can't be used as a color attachment on this device!\n");
+        if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+            EXIT("VkuError: RenderStage color output format can't be sampled on this device!\n");
+    }
+
+    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && !vkuRenderStageSupportsMSAA(renderStage))
+        EXIT("VkuError: Multisampled RenderStages only support a single color output!\n");
+}
+
+// Presenter stages render into the resource manager's multisampled color image in the swapchain format, offscreen
+// stages own one in the format of their output. Either resolves into a single output only.
+VkBool32 vkuRenderStageSupportsMSAA(VkuRenderStage renderStage)
+{
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER || renderStage->colorAttachmentCount == 0)
+        return VK_TRUE;
+
+    return renderStage->colorAttachmentCount == 1;
+}
+
+void vkuRenderStageCreateColorOutputs(VkuRenderStage renderStage, VkExtent2D extent)
+{
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+    {
+        VkuVkImageCreateInfo imageCreateInfo = {
+            .allocator = renderStage->context->memoryManager->allocator,
+            .width = extent.width,
+            .height = extent.height,
+            .mipLevels = 1,
+            .format = renderStage->colorAttachmentFormats[i],
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .numSamples = VK_SAMPLE_COUNT_1_BIT,
+            .pImage = &(renderStage->pTargetColorImages[i]),
+            .pImageAlloc = &(renderStage->pTargetColorImgAllocs[i]),
+            .pImageAllocInfo = NULL,
+            .arrayLayers = 1
+        };
+
+        vkuCreateImage(&imageCreateInfo);
+        renderStage->pTargetColorImgViews[i] = vkuCreateImageView(renderStage->pTargetColorImages[i], renderStage->colorAttachmentFormats[i], VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, renderStage->context->device);
+    }
+
+    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && renderStage->colorAttachmentCount > 0)
+    {
+        VkuColorResourcesCreateInfo colorInfo = {
+            .format = renderStage->colorAttachmentFormats[0],
+            .allocator = renderStage->context->memoryManager->allocator,
+            .extend = extent,
+            .msaa_samples = renderStage->sampleCount,
+            .device = renderStage->context->device,
+        };
+
+        renderStage->colorResource = vkuCreateColorResources(&colorInfo);
+    }
+}
+
+void vkuRenderStageDestroyColorOutputs(VkuRenderStage renderStage)
+{
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+    {
+        if (renderStage->pTargetColorImgViews[i] != NULL)
+        {
+            vkuDestroyImage(renderStage->pTargetColorImages[i], renderStage->pTargetColorImgAllocs[i], renderStage->context->memoryManager->allocator);
+            vkuDestroyImageView(renderStage->pTargetColorImgViews[i], renderStage->context->device);
+        }
+    }
+
+    if (renderStage->colorResource != NULL)
+    {
+        vkuDestroyColorResources(renderStage->context->memoryManager->allocator, renderStage->context->device, renderStage->colorResource);
+        renderStage->colorResource = NULL;
+    }
+}
+
+VkuRenderStage vkuCreateRenderStage(VkuRenderStageCreateInfo *createInfo)
+{
+    VkuRenderStage_T *renderStage = (VkuRenderStage_T *)calloc(1, sizeof(VkuRenderStage_T));
+    renderStage->options = createInfo->options;
+    renderStage->presenter = createInfo->presenter;
+    renderStage->context = createInfo->presenter->context;
+    renderStage->sampleCount = createInfo->msaaSamples;
+    renderStage->enableDepthTesting = createInfo->enableDepthTesting;
+    renderStage->outputCount = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? renderStage->presenter->swapchainImageCount : 1;
+    renderStage->staticRenderStage = VK_FALSE;
+    renderStage->staticDepthArrayCount = 1;
+    renderStage->dynamicRendering = createInfo->dynamicRendering;
+
+    if (renderStage->dynamicRendering && !renderStage->context->dynamicRendering)
+        EXIT("VkuError: RenderStage requests dynamic rendering, but the device does not support it!\n");
+
+    vkuRenderStageInitColorOutputs(renderStage, createInfo->colorAttachmentCount, createInfo->colorAttachmentFormats);
+
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+    {
+        if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
+            EXIT("VkuError: A RenderStage cant have VKU_RENDER_OPTION_DEPTH_IMAGE and / or VKU_RENDER_OPTION_COLOR_IMAGE enabled along with VKU_RENDER_OPTION_PRESENTER!\n");
+
+        renderStage->pTargetColorImgViews = renderStage->presenter->swapchainImageViews;
+    }
+    else
+    {
+        if (!renderStage->enableDepthTesting && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
+            EXIT("VkuError: RenderStage is created with VKU_RENDER_OPTION_DEPTH_IMAGE option enabled, but enableDepthTesting is disabled!\n");
+
+        uint32_t colorOutputCount = (renderStage->colorAttachmentCount > 0) ? renderStage->colorAttachmentCount : 1;
+        renderStage->pTargetColorImages = (VkImage *)calloc(colorOutputCount, sizeof(VkImage));
+        renderStage->pTargetColorImgViews = (VkImageView *)calloc(colorOutputCount, sizeof(VkImageView));
+        renderStage->pTargetColorImgAllocs = (VmaAllocation *)calloc(colorOutputCount, sizeof(VmaAllocation));
+        renderStage->pTargetDepthImages = (VkImage *)calloc(1, sizeof(VkImage));
+        renderStage->pTargetDepthImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
+        renderStage->pTargetDepthImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
+
+        vkuRenderStageCreateColorOutputs(renderStage, renderStage->presenter->swapchainExtend);
+
+        if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
+        {
+            VkuVkImageCreateInfo imageCreateInfo = {
+                .allocator = renderStage->presenter->context->memoryManager->allocator,
+                .width = renderStage->presenter->swapchainExtend.width,
+                .height = renderStage->presenter->swapchainExtend.height,
+                .mipLevels = 1,
+                .format = VK_FORMAT_D32_SFLOAT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                .numSamples = VK_SAMPLE_COUNT_1_BIT,
+                .pImage = &(renderStage->pTargetDepthImages[0]),
+                .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
+                .pImageAllocInfo = NULL,
+                .arrayLayers = 1
+            };
+
+            vkuCreateImage(&imageCreateInfo);
+
+            renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1, renderStage->presenter->context->device);
+        }
+    }
+
+    // Offscreen stages create their multisampled color image along with their outputs.
+    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+    {
+        renderStage->colorResource = vkuRenderResourceManagerGetColorResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+    }
+
+    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    {
+        renderStage->depthResource = vkuRenderResourceManagerGetDepthResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+    }
+
+    renderStage->renderPassFormat = renderStage->presenter->swapchainFormat;
+    renderStage->renderPassSampleCount = renderStage->sampleCount;
+
+    // Dynamic rendering stages bind their attachments per frame and own no render pass / framebuffers.
+    if (!renderStage->dynamicRendering)
+    {
+        VkuVkRenderPassCreateInfo renderPassCreateInfo = {
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .colorFormats = renderStage->colorAttachmentFormats,
+            .msaaSamples = renderStage->sampleCount,
+            .physicalDevice = renderStage->presenter->context->physicalDevice,
+            .device = renderStage->presenter->context->device,
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .presentationLayout = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER),
+        };
+
+        renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
+
+        VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
+            .imageCount = renderStage->outputCount,
+            .msaaSamples = renderStage->sampleCount,
+            .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
+            .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
+            .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
+            .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
+            .renderPass = renderStage->renderPass,
+            .extend = renderStage->presenter->swapchainExtend,
+            .device = renderStage->presenter->context->device,
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .layerCount = 1};
+
+        renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    }
+
+    renderStage->pipelineManager = vkuCreateObjectManager(sizeof(VkuPipeline));
+    renderStage->outputTextureManager = vkuCreateObjectManager(sizeof(VkuTexture2D));
+    renderStage->descriptorSetManager = vkuCreateObjectManager(sizeof(VkuDescriptorSet));
+
+    vkuObjectManagerAdd(renderStage->presenter->renderStageManager, (void *)renderStage);
+    return renderStage;
+}
+
+VkuTexture2D vkuRenderStageGetDepthOutput(VkuRenderStage renderStage)
+{
+    if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE)
+        EXIT("VkuError: Depth Texture cant be retrieved: RenderStage has no depth output!\n");
+
+    VkuTexture2D_T *tex = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
+    tex->renderStage = renderStage;
+    tex->renderStageDepthImage = VK_TRUE;
+    tex->renderStageColorImage = VK_FALSE;
+    tex->textureImage = VK_NULL_HANDLE;
+    tex->textureImageAllocation = VK_NULL_HANDLE;
+    tex->textureImageView = renderStage->pTargetDepthImgViews[0];
+    tex->bindlessIndex = VKU_BINDLESS_INVALID_INDEX;
+    tex->imageExtend = (renderStage->staticRenderStage == VK_FALSE) ? renderStage->presenter->swapchainExtend : renderStage->extend;
+
+    vkuObjectManagerAdd(tex->renderStage->outputTextureManager, (void *)tex);
+
+    return tex;
+}
+
+VkuTexture2D vkuRenderStageGetColorOutput(VkuRenderStage renderStage)
+{
+    return vkuRenderStageGetColorOutputAt(renderStage, 0);
+}
+
+VkuTexture2D vkuRenderStageGetColorOutputAt(VkuRenderStage renderStage, uint32_t index)
+{
+    if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) != VKU_RENDER_OPTION_COLOR_IMAGE)
+        EXIT("VkuError: Color Texture cant be retrieved: RenderStage has no color output or renders directly into the swapchain!\n");
+
+    if (index >= renderStage->colorAttachmentCount)
+        EXIT("VkuError: Color Texture cant be retrieved: Output index is out of range!\n");
+
+    VkuTexture2D_T *tex = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
+    tex->renderStage = renderStage;
+    tex->renderStageDepthImage = VK_FALSE;
+    tex->renderStageColorImage = VK_TRUE;
+    tex->textureImage = VK_NULL_HANDLE;
+    tex->textureImageAllocation = VK_NULL_HANDLE;
+    tex->textureImageView = renderStage->pTargetColorImgViews[index];
+    tex->renderStageOutputIndex = index;
+    tex->bindlessIndex = VKU_BINDLESS_INVALID_INDEX;
+    tex->imageExtend = (renderStage->staticRenderStage == VK_FALSE) ? renderStage->presenter->swapchainExtend : renderStage->extend;
+
+    vkuObjectManagerAdd(tex->renderStage->outputTextureManager, (void *)tex);
+
+    return tex;
+}
+
+void vkuRenderStageOutputTextureUpdate(VkuTexture2D texture)
+{
+    if (texture->renderStageColorImage)
+    {
+        texture->textureImageView = texture->renderStage->pTargetColorImgViews[texture->renderStageOutputIndex];
+    }
+    else if (texture->renderStageDepthImage)
+    {
+        texture->textureImageView = texture->renderStage->pTargetDepthImgViews[0];
+    }
+
+    texture->imageExtend = (texture->renderStage->staticRenderStage == VK_FALSE) ? texture->renderStage->presenter->swapchainExtend : texture->renderStage->extend;
+}
+
+void vkuPipelineUpdate(VkuPipeline pipeline);
+void vkuDescriptorSetUpdate(VkuDescriptorSet descriptorSet);
+void vkuDescriptorSetLinkRenderStage(VkuDescriptorSet set, VkuRenderStage renderStage);
+
+void vkuRenderStageUpdate(VkuRenderStage renderStage)
+{
+    // Render pass compatibility only depends on attachment formats and sample counts, not on the extent. Viewport and
+    // scissor are dynamic, so a plain resize keeps the render pass and every pipeline built against it. With dynamic
+    // rendering a resize only reallocates the attachment images.
+    VkBool32 rebuildRenderPass = (renderStage->renderPassFormat != renderStage->presenter->swapchainFormat || renderStage->renderPassSampleCount != renderStage->sampleCount);
+
+    if (rebuildRenderPass)
+    {
+        // Background compiles still reference the render pass that is destroyed below.
+        vkuContextPauseShaderReload(renderStage->context);
+        vkuContextWaitPipelineBatches(renderStage->context);
+    }
+
+    vkDeviceWaitIdle(renderStage->context->device);
+    vkuDestroyFramebuffer(renderStage->presenter->context->device, renderStage->framebuffers, renderStage->outputCount);
+
+    if (rebuildRenderPass && !renderStage->dynamicRendering)
+        vkuDestroyVkRenderPass(renderStage->presenter->context->device, renderStage->renderPass);
+
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER)
+    {
+        vkuRenderStageDestroyColorOutputs(renderStage);
+
+        if (renderStage->pTargetDepthImgViews[0] != NULL)
+        {
+            vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
+            vkuDestroyImageView(renderStage->pTargetDepthImgViews[0], renderStage->presenter->context->device);
+        }
+    }
+
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+    {
+        renderStage->pTargetColorImgViews = renderStage->presenter->swapchainImageViews;
+        renderStage->colorAttachmentFormats[0] = renderStage->presenter->swapchainFormat;
+    }
+    else
+    {
+        vkuRenderStageCreateColorOutputs(renderStage, renderStage->presenter->swapchainExtend);
+
+        if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
+        {
+            VkuVkImageCreateInfo imageCreateInfo = {
+                .allocator = renderStage->presenter->context->memoryManager->allocator,
+                .width = renderStage->presenter->swapchainExtend.width,
+                .height = renderStage->presenter->swapchainExtend.height,
+                .mipLevels = 1,
+                .format = VK_FORMAT_D32_SFLOAT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                .numSamples = VK_SAMPLE_COUNT_1_BIT,
+                .pImage = &(renderStage->pTargetDepthImages[0]),
+                .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
+                .pImageAllocInfo = NULL,
+                .arrayLayers = 1,
+            };
+
+            vkuCreateImage(&imageCreateInfo);
+
+            renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1, renderStage->presenter->context->device);
+        }
+    }
+
+    // Offscreen stages create their multisampled color image along with their outputs.
+    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+    {
+        renderStage->colorResource = vkuRenderResourceManagerGetColorResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+    }
+
+    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    {
+        renderStage->depthResource = vkuRenderResourceManagerGetDepthResource(renderStage->presenter->resourceManager, renderStage->sampleCount);
+    }
+
+    if (rebuildRenderPass && !renderStage->dynamicRendering)
+    {
+        VkuVkRenderPassCreateInfo renderPassCreateInfo = {
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .colorFormats = renderStage->colorAttachmentFormats,
+            .msaaSamples = renderStage->sampleCount,
+            .physicalDevice = renderStage->presenter->context->physicalDevice,
+            .device = renderStage->presenter->context->device,
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .presentationLayout = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER),
+        };
+
+        renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
+    }
+
+    renderStage->renderPassFormat = renderStage->presenter->swapchainFormat;
+    renderStage->renderPassSampleCount = renderStage->sampleCount;
+
+    if (!renderStage->dynamicRendering)
+    {
+        VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
+            .imageCount = renderStage->outputCount,
+            .msaaSamples = renderStage->sampleCount,
+            .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
+            .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
+            .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
+            .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
+            .renderPass = renderStage->renderPass,
+            .extend = renderStage->presenter->swapchainExtend,
+            .device = renderStage->presenter->context->device,
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER) ? false : ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .layerCount = 1};
+
+        renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    }
+
+    for (uint32_t i = 0; i < renderStage->outputTextureManager->elemCnt; i++)
+    {
+        vkuRenderStageOutputTextureUpdate((VkuTexture2D)renderStage->outputTextureManager->elements[i]);
+    }
+
+    if (rebuildRenderPass)
+    {
+        for (uint32_t i = 0; i < renderStage->pipelineManager->elemCnt; i++)
+        {
+            vkuPipelineUpdate((VkuPipeline)renderStage->pipelineManager->elements[i]);
+        }
+
+        vkuContextResumeShaderReload(renderStage->context);
+    }
+
+    for (uint32_t i = 0; i < renderStage->descriptorSetManager->elemCnt; i++)
+    {
+        vkuDescriptorSetUpdate((VkuDescriptorSet)renderStage->descriptorSetManager->elements[i]);
+    }
+}
+
+void vkuDestroyRenderStage(VkuRenderStage renderStage)
+{
+    if (renderStage->staticRenderStage == VK_TRUE)
+        EXIT("VkuError: Trying to destroy a VkuStaticRenderStage with vkuDestroyRenderStage()!\n"); 
+
+    vkDeviceWaitIdle(renderStage->presenter->context->device);
+
+    for (uint32_t i = 0; i < renderStage->outputTextureManager->elemCnt; i++)
+    {
+        VkuTexture2D outTex = (VkuTexture2D)renderStage->outputTextureManager->elements[i];
+        free(outTex);
+    }
+
+    vkuDestroyObjectManager(renderStage->descriptorSetManager);
+    vkuDestroyObjectManager(renderStage->outputTextureManager);
+    vkuDestroyObjectManager(renderStage->pipelineManager);
+    vkuDestroyFramebuffer(renderStage->presenter->context->device, renderStage->framebuffers, renderStage->outputCount);
+    vkuDestroyVkRenderPass(renderStage->presenter->context->device, renderStage->renderPass);
+
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER)
+    {
+        vkuRenderStageDestroyColorOutputs(renderStage);
+
+        if (renderStage->pTargetDepthImgViews[0] != NULL)
+        {
+            vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->presenter->context->memoryManager->allocator);
             vkuDestroyImageView(renderStage->pTargetDepthImgViews[0], renderStage->presenter->context->device);
         }
 
-        free(renderStage->pTargetColorImages);
-        free(renderStage->pTargetColorImgAllocs);
-        free(renderStage->pTargetColorImgViews);
-        free(renderStage->pTargetDepthImages);
-        free(renderStage->pTargetDepthImgAllocs);
-        free(renderStage->pTargetDepthImgViews);
+        free(renderStage->pTargetColorImages);
+        free(renderStage->pTargetColorImgAllocs);
+        free(renderStage->pTargetColorImgViews);
+        free(renderStage->pTargetDepthImages);
+        free(renderStage->pTargetDepthImgAllocs);
+        free(renderStage->pTargetDepthImgViews);
+    }
+
+    vkuObjectManagerRemove(renderStage->presenter->renderStageManager, (void *)renderStage);
+    free(renderStage);
+}
+
+// VkuStaticRenderStage
+
+VkuRenderStage vkuCreateStaticRenderStage(VkuStaticRenderStageCreateInfo * createInfo)
+{
+    VkuRenderStage renderStage = (VkuRenderStage) calloc(1, sizeof(VkuRenderStage_T));
+    renderStage->context = createInfo->context;
+    renderStage->enableDepthTesting = createInfo->enableDepthTesting;
+    renderStage->extend.width = createInfo->width;
+    renderStage->extend.height = createInfo->height;
+    renderStage->sampleCount = createInfo->msaaSamples;
+    renderStage->options = createInfo->options;
+    renderStage->staticRenderStage = VK_TRUE;
+    renderStage->staticDepthArrayCount = createInfo->depthLayers;
+    renderStage->dynamicRendering = createInfo->dynamicRendering;
+
+    if (renderStage->dynamicRendering && !renderStage->context->dynamicRendering)
+        EXIT("VkuError: VkuStaticRenderStage requests dynamic rendering, but the device does not support it!\n");
+    
+    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
+        EXIT("VkuError: A VkuStaticRenderStage cant be created with VKU_RENDER_OPTION_PRESENTER option enabled!");
+
+    if (!renderStage->enableDepthTesting && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
+        EXIT("VkuError: RenderStage is created with VKU_RENDER_OPTION_DEPTH_IMAGE option enabled, but enableDepthTesting is disabled!\n");
+
+    vkuRenderStageInitColorOutputs(renderStage, createInfo->colorAttachmentCount, createInfo->colorAttachmentFormats);
+
+    uint32_t colorOutputCount = (renderStage->colorAttachmentCount > 0) ? renderStage->colorAttachmentCount : 1;
+    renderStage->pTargetColorImages = (VkImage *)calloc(colorOutputCount, sizeof(VkImage));
+    renderStage->pTargetColorImgViews = (VkImageView *)calloc(colorOutputCount, sizeof(VkImageView));
+    renderStage->pTargetColorImgAllocs = (VmaAllocation *)calloc(colorOutputCount, sizeof(VmaAllocation));
+    renderStage->pTargetDepthImages = (VkImage *)calloc(1, sizeof(VkImage));
+    renderStage->pTargetDepthImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
+    renderStage->pTargetDepthImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
+
+    vkuRenderStageCreateColorOutputs(renderStage, renderStage->extend);
+
+    if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
+    {
+        VkuVkImageCreateInfo imageCreateInfo = {
+            .allocator = renderStage->context->memoryManager->allocator,
+            .width = renderStage->extend.width,
+            .height = renderStage->extend.height,
+            .mipLevels = 1,
+            .format = VK_FORMAT_D32_SFLOAT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .numSamples = VK_SAMPLE_COUNT_1_BIT,
+            .pImage = &(renderStage->pTargetDepthImages[0]),
+            .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
+            .pImageAllocInfo = NULL,
+            .arrayLayers = createInfo->depthLayers
+        };
+
+        vkuCreateImage(&imageCreateInfo);
+        renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, createInfo->depthLayers, renderStage->context->device);
+    }
+
+    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    {
+        VkuDepthResourcesCreateInfo depthInfo = {
+            .physical_device = renderStage->context->physicalDevice,
+            .device = renderStage->context->device,
+            .allocator = renderStage->context->memoryManager->allocator,
+            .extend = renderStage->extend,
+            .msaa_samples = renderStage->sampleCount,
+            .layerCount = 1
+        };
+
+        renderStage->depthResource = vkuCreateDepthResources(&depthInfo);
+    }
+
+    renderStage->renderPassFormat = VK_FORMAT_B8G8R8A8_SRGB;
+    renderStage->renderPassSampleCount = renderStage->sampleCount;
+
+    if (!renderStage->dynamicRendering)
+    {
+        VkuVkRenderPassCreateInfo renderPassCreateInfo = {
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .colorFormats = renderStage->colorAttachmentFormats,
+            .msaaSamples = renderStage->sampleCount,
+            .physicalDevice = renderStage->context->physicalDevice,
+            .device = renderStage->context->device,
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .presentationLayout = VK_FALSE,
+        };
+
+        renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
+
+        VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
+            .imageCount = 1,
+            .msaaSamples = renderStage->sampleCount,
+            .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
+            .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
+            .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
+            .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
+            .renderPass = renderStage->renderPass,
+            .extend = renderStage->extend,
+            .device = renderStage->context->device,
+            .colorAttachmentCount = renderStage->colorAttachmentCount,
+            .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
+            .enableDepthTest = renderStage->enableDepthTesting,
+            .layerCount = createInfo->depthLayers};
+
+        renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    }
+
+    return renderStage;
+}
+
+void vkuDestroyStaticRenderStage(VkuRenderStage renderStage)
+{
+    if (renderStage->staticRenderStage == VK_FALSE)
+        EXIT("VkuError: Trying to destroy a VkuRenderStage with vkuDestroyStaticRenderStage()!\n"); 
+
+    vkDeviceWaitIdle(renderStage->context->device);
+
+    vkuDestroyFramebuffer(renderStage->context->device, renderStage->framebuffers, 1);
+    vkuDestroyVkRenderPass(renderStage->context->device, renderStage->renderPass);
+
+    if (renderStage->depthResource != NULL)
+    {
+        vkuDestroyDepthResources(renderStage->context->memoryManager->allocator, renderStage->context->device, renderStage->depthResource);
+    }
+
+    vkuRenderStageDestroyColorOutputs(renderStage);
+
+    if (renderStage->pTargetDepthImgViews[0] != NULL)
+    {
+        vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->context->memoryManager->allocator);
+        vkuDestroyImageView(renderStage->pTargetDepthImgViews[0], renderStage->context->device);
+    }
+
+    free(renderStage->pTargetColorImages);
+    free(renderStage->pTargetColorImgAllocs);
+    free(renderStage->pTargetColorImgViews);
+    free(renderStage->pTargetDepthImages);
+    free(renderStage->pTargetDepthImgAllocs);
+    free(renderStage->pTargetDepthImgViews);
+
+    free(renderStage);
+}
+
+void vkuRenderStageSetMSAA(VkuRenderStage renderStage, VkSampleCountFlagBits msaaFlags)
+{
+    if (renderStage->staticRenderStage == VK_FALSE)
+    {
+        if (msaaFlags != VK_SAMPLE_COUNT_1_BIT && !vkuRenderStageSupportsMSAA(renderStage))
+            EXIT("VkuError: Multisampled RenderStages only support a single color output!\n");
+
+        renderStage->sampleCount = msaaFlags;
+        vkuRenderStageUpdate(renderStage);
+
+        for (uint32_t i = 0; i < renderStage->presenter->renderStageManager->elemCnt; i++)
+        {
+            vkuRenderStageUpdate((VkuRenderStage) renderStage->presenter->renderStageManager->elements[i]);
+        }
+    } else {
+        EXIT("VkuError: vkuRenderStageSetMSAA() cant be used with a static VkuRenderStage!\n");
+    }
+}
+
+// VkuFrame
+
+void vkuFrameRecordUploads(VkuFrame frame)
+{
+    VkuUploadBatch batch = frame->presenter->context->uploadBatch;
+
+    if (batch == NULL || batch->uploadCount == 0)
+        return;
+
+    if (batch->frameCount != frame->presenter->framesInFlight)
+    {
+        batch->frameEnds = (VkDeviceSize *)realloc(batch->frameEnds, sizeof(VkDeviceSize) * frame->presenter->framesInFlight);
+        for (uint32_t i = batch->frameCount; i < frame->presenter->framesInFlight; i++)
+            batch->frameEnds[i] = VKU_UPLOAD_BATCH_NO_FRAME;
+        batch->frameCount = frame->presenter->framesInFlight;
+    }
+
+    vkuUploadBatchRecord(batch, frame->cmdBuffer);
+    batch->frameEnds[frame->presenter->currentFrame] = batch->head;
+    batch->lastFrame = frame->presenter->currentFrame;
+}
+
+VkuFrame vkuPresenterBeginFrame(VkuPresenter presenter)
+{
+    if (presenter->activeFrame)
+        EXIT("VkuError: Only One Frame can be active at a time!\n");
+    else
+        presenter->activeFrame = VK_TRUE;
+
+    VkuFrame_T *frame = (VkuFrame_T *)calloc(1, sizeof(VkuFrame_T));
+
+    frame->presenter = presenter;
+
+    int currentFrame = frame->presenter->currentFrame;
+    VkuContext context = presenter->context;
+
+    vkWaitForFences(context->device, 1, &frame->presenter->inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    uint32_t imageIndex = 0;
+
+    if (context->uploadBatch != NULL)
+        vkuUploadBatchRetireFrame(context->uploadBatch, currentFrame);
+
+    vkuDescriptorAllocatorResetFrame(context->descriptorAllocator, context->device, currentFrame);
+
+    VkResult result = vkAcquireNextImageKHR(context->device, frame->presenter->swapchain, UINT64_MAX, frame->presenter->imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        vkuPresenterRecreate(presenter);
+        presenter->window->window_resized = false;
+        return vkuPresenterBeginFrame(presenter);
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+        EXIT("failed to acquire swap chain image!");
+    }
+
+    vkuShaderWatcherFrameBoundary(context->shaderWatcher, presenter, presenter->framesInFlight, false);
+    vkuBindlessTableFrameBoundary(context->bindlessTable, presenter->framesInFlight);
+
+    vkResetFences(context->device, 1, &frame->presenter->inFlightFences[currentFrame]);
+
+    vkResetCommandBuffer(frame->presenter->cmdBuffer[currentFrame], 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(frame->presenter->cmdBuffer[currentFrame], &beginInfo));
+
+    memset(frame->boundSetLayouts, 0, sizeof(frame->boundSetLayouts));
+    memset(frame->boundSets, 0, sizeof(frame->boundSets));
+    frame->boundPushConstantHash = 0;
+
+    if (context->bindlessTable != NULL)
+    {
+        vkCmdBindDescriptorSets(frame->presenter->cmdBuffer[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, context->bindlessTable->pipelineLayout, 0, 1, &context->bindlessTable->set, 0, NULL);
+        frame->boundSetLayouts[0] = context->bindlessTable->setLayout;
+        frame->boundSets[0] = context->bindlessTable->set;
+        frame->boundPushConstantHash = context->bindlessTable->pushConstantHash;
+    }
+
+    frame->imageIndex = imageIndex;
+    frame->cmdBuffer = frame->presenter->cmdBuffer[currentFrame];
+    frame->activeRenderStage = false;
+
+    return frame;
+}
+
+void vkuPresenterSubmitFrame(VkuFrame frame, VkuComputeRun syncComputeRun)
+{
+    int currentFrame = frame->presenter->currentFrame;
+    int imageIndex = frame->imageIndex;
+
+    vkuFrameRecordUploads(frame);
+
+    VK_CHECK(vkEndCommandBuffer(frame->presenter->cmdBuffer[currentFrame]));
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+    VkSemaphore waitSemaphores[2] = {frame->presenter->imageAvailableSemaphores[currentFrame]};
+    VkPipelineStageFlags waitStages[2] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    submitInfo.waitSemaphoreCount = 1;
+
+    if (syncComputeRun != NULL) {
+        waitSemaphores[1] = syncComputeRun->executor->computeFinishedSemaphores[syncComputeRun->lastFrame];
+        waitStages[1] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        submitInfo.waitSemaphoreCount = 2;
+    }
+
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &(frame->presenter->cmdBuffer)[currentFrame];
+
+    VkSemaphore signalSemaphores[] = {frame->presenter->renderFinishedSemaphores[currentFrame]};
+    submitInfo.signalSemaphoreCount = 1;
+
+    submitInfo.pSignalSemaphores = signalSemaphores;
+
+    VK_CHECK(vkQueueSubmit(frame->presenter->context->graphicsQueue, 1, &submitInfo, frame->presenter->inFlightFences[currentFrame]));
+
+    VkPresentInfoKHR presentInfo = {};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+
+    VkSwapchainKHR swapChains[] = {frame->presenter->swapchain};
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = swapChains;
+    presentInfo.pImageIndices = (const uint32_t *)&imageIndex;
+    presentInfo.pResults = NULL;
+
+    VkResult result = vkQueuePresentKHR(frame->presenter->context->presentQueue, &presentInfo);
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || frame->presenter->window->window_resized)
+    {
+        vkuPresenterRecreate(frame->presenter);
+        frame->presenter->window->window_resized = false;
+    }
+    else if (result != VK_SUCCESS)
+        EXIT("Failed to present swap chain image!\n");
+
+    (frame->presenter->currentFrame) = (currentFrame + 1) % frame->presenter->framesInFlight;
+    frame->presenter->activeFrame = VK_FALSE;
+
+    free(frame);
+}
+
+VkBool32 vkuRenderStageHasColorTarget(VkuRenderStage renderStage)
+{
+    return renderStage->colorAttachmentCount > 0;
+}
+
+void vkuFrameBeginDynamicRendering(VkuFrame frame, VkuRenderStage renderStage)
+{
+    VkCommandBuffer cmdBuffer = frame->presenter->cmdBuffer[frame->presenter->currentFrame];
+    VkBool32 presenterStage = (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER;
+    VkBool32 depthTarget = !presenterStage && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE;
+    VkBool32 multisampled = renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+    // Attachments are cleared on load, so every image starts from UNDEFINED and previous readers only need an execution dependency.
+    VkPipelineStageFlags colorStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+    VkRenderingAttachmentInfo colorAttachments[VKU_MAX_COLOR_ATTACHMENTS] = {};
+
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+    {
+        VkRenderingAttachmentInfo *colorAttachment = &colorAttachments[i];
+        colorAttachment->sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorAttachment->imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment->loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment->storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment->clearValue.color = (VkClearColorValue){{0.0f, 0.0f, 0.0f, 0.0f}};
+
+        VkImage targetImage = presenterStage ? frame->presenter->swapchainImages[frame->imageIndex] : renderStage->pTargetColorImages[i];
+        VkImageView targetView = renderStage->pTargetColorImgViews[presenterStage ? frame->imageIndex : i];
+        vkuCmdAttachmentBarrier(cmdBuffer, targetImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorStages, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+        if (multisampled)
+        {
+            vkuCmdAttachmentBarrier(cmdBuffer, renderStage->colorResource->image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorStages, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+            colorAttachment->imageView = renderStage->colorResource->imageView;
+            colorAttachment->storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment->resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+            colorAttachment->resolveImageView = targetView;
+            colorAttachment->resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+        else
+        {
+            colorAttachment->imageView = targetView;
+        }
+    }
+
+    VkRenderingAttachmentInfo depthAttachment = {};
+    depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    depthAttachment.clearValue.depthStencil = (VkClearDepthStencilValue){1.0f, 0};
+
+    if (renderStage->enableDepthTesting)
+    {
+        VkImage depthImage = (!multisampled && depthTarget) ? renderStage->pTargetDepthImages[0] : renderStage->depthResource->image;
+        depthAttachment.imageView = (!multisampled && depthTarget) ? renderStage->pTargetDepthImgViews[0] : renderStage->depthResource->imageView;
+        vkuCmdAttachmentBarrier(cmdBuffer, depthImage, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depthStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, depthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+        if (multisampled && depthTarget)
+        {
+            vkuCmdAttachmentBarrier(cmdBuffer, renderStage->pTargetDepthImages[0], VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depthStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, depthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+            depthAttachment.resolveMode = VK_RESOLVE_MODE_MAX_BIT;
+            depthAttachment.resolveImageView = renderStage->pTargetDepthImgViews[0];
+            depthAttachment.resolveImageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        }
+    }
+
+    VkRenderingInfo renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.renderArea.extent = (renderStage->staticRenderStage == VK_FALSE) ? frame->presenter->swapchainExtend : renderStage->extend;
+    renderingInfo.layerCount = (renderStage->staticRenderStage == VK_FALSE) ? 1 : (uint32_t)renderStage->staticDepthArrayCount;
+    renderingInfo.colorAttachmentCount = renderStage->colorAttachmentCount;
+    renderingInfo.pColorAttachments = colorAttachments;
+    renderingInfo.pDepthAttachment = renderStage->enableDepthTesting ? &depthAttachment : NULL;
+
+    vkCmdBeginRendering(cmdBuffer, &renderingInfo);
+}
+
+void vkuFrameFinishDynamicRendering(VkuFrame frame, VkuRenderStage renderStage)
+{
+    VkCommandBuffer cmdBuffer = frame->presenter->cmdBuffer[frame->presenter->currentFrame];
+    VkBool32 presenterStage = (renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER;
+
+    vkCmdEndRendering(cmdBuffer);
+
+    // Same final layouts the render pass backend produces.
+    if (presenterStage)
+        vkuCmdAttachmentBarrier(cmdBuffer, frame->presenter->swapchainImages[frame->imageIndex], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    else
+    {
+        for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+            vkuCmdAttachmentBarrier(cmdBuffer, renderStage->pTargetColorImages[i], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    if (!presenterStage && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
+        vkuCmdAttachmentBarrier(cmdBuffer, renderStage->pTargetDepthImages[0], VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void vkuFrameBeginRenderStage(VkuFrame frame, VkuRenderStage renderStage)
+{
+    if (frame->activeRenderStage)
+        EXIT("VkuError: Only one VkuRenderStage can be active at a time!\n");
+    else
+        frame->activeRenderStage = true;
+
+    vkuFrameRecordUploads(frame);
+
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (renderStage->staticRenderStage == VK_FALSE) ? (float) frame->presenter->swapchainExtend.width : (float) renderStage->extend.width;
+    viewport.height = (renderStage->staticRenderStage == VK_FALSE) ? (float) frame->presenter->swapchainExtend.height : (float) renderStage->extend.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(frame->presenter->cmdBuffer[frame->presenter->currentFrame], 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent = (renderStage->staticRenderStage == VK_FALSE) ? frame->presenter->swapchainExtend : renderStage->extend;
+    vkCmdSetScissor(frame->presenter->cmdBuffer[frame->presenter->currentFrame], 0, 1, &scissor); 
+
+    if (renderStage->dynamicRendering)
+    {
+        vkuFrameBeginDynamicRendering(frame, renderStage);
+        return;
+    }
+
+    // Clear values are indexed by attachment: the color outputs, then depth. Resolve attachments aren't cleared.
+    VkClearValue clearValues[VKU_MAX_COLOR_ATTACHMENTS + 1] = {};
+    uint32_t clearValueCnt = 0;
+    for (uint32_t i = 0; i < renderStage->colorAttachmentCount; i++)
+        clearValues[clearValueCnt++].color = (VkClearColorValue){{0.0f, 0.0f, 0.0f, 0.0f}};
+    if (renderStage->enableDepthTesting)
+        clearValues[clearValueCnt++].depthStencil = (VkClearDepthStencilValue){1.0f, 0};
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderStage->renderPass;
+    renderPassInfo.framebuffer = renderStage->framebuffers[((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER) ? 0 : frame->imageIndex];
+    renderPassInfo.renderArea.offset.x = 0;
+    renderPassInfo.renderArea.offset.y = 0;
+    renderPassInfo.renderArea.extent = (renderStage->staticRenderStage == VK_FALSE) ? frame->presenter->swapchainExtend : renderStage->extend;
+    renderPassInfo.clearValueCount = clearValueCnt;
+    renderPassInfo.pClearValues = clearValues;
+
+    vkCmdBeginRenderPass(frame->presenter->cmdBuffer[frame->presenter->currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void vkuFrameFinishRenderStage(VkuFrame frame, VkuRenderStage renderStage)
+{
+    if (!frame->activeRenderStage)
+        EXIT("VkuError: No active RenderStage!\n");
+    else
+        frame->activeRenderStage = false;
+
+    if (renderStage->dynamicRendering)
+    {
+        vkuFrameFinishDynamicRendering(frame, renderStage);
+        return;
+    }
+
+    vkCmdEndRenderPass(frame->presenter->cmdBuffer[frame->presenter->currentFrame]);
+
+    if (renderStage->sampleCount == VK_SAMPLE_COUNT_1_BIT && ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE))
+    {
+        vkuTransitionDepthImageLayout(frame->presenter->context->device, frame->presenter->cmdBuffer[frame->presenter->currentFrame], renderStage->pTargetDepthImages[0], renderStage->staticDepthArrayCount);
+    }
+}
+
+void vkuFrameBindPipeline(VkuFrame frame, VkuPipeline pipeline)
+{
+    // Switches to the link-time optimized pipeline once its background link is done. The pipeline itself keeps the
+    // fast link, as other threads may read it while this frame is recorded.
+    VkPipeline boundPipeline = atomic_load(&pipeline->variant->optimizedPipeline);
+    if (boundPipeline == VK_NULL_HANDLE)
+        boundPipeline = pipeline->graphicsPipeline;
+
+    vkCmdBindPipeline(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+
+    // Variants are shared across dynamic state, so the pipeline's own create info supplies the defaults.
+    VkuContext context = frame->presenter->context;
+    VkuPipelineCreateInfo *info = &pipeline->recreateInfo;
+    if (context->extendedDynamicState)
+    {
+        vkCmdSetCullMode(frame->cmdBuffer, info->cullMode);
+        vkCmdSetPrimitiveTopology(frame->cmdBuffer, info->topology);
+        vkCmdSetDepthTestEnable(frame->cmdBuffer, info->depthTestEnable);
+        vkCmdSetDepthWriteEnable(frame->cmdBuffer, info->depthTestWrite);
+        vkCmdSetDepthCompareOp(frame->cmdBuffer, info->depthCompareMode);
+        vkCmdSetDepthBiasEnable(frame->cmdBuffer, info->enableDepthBias);
+        vkCmdSetDepthBias(frame->cmdBuffer, info->depthBiasConstantFactor, 0.0f, info->depthBiasSlopeFactor);
+    }
+
+    if (context->dynamicPolygonMode)
+        context->vkCmdSetPolygonModeEXT(frame->cmdBuffer, info->polygonMode);
+
+    // Bound sets stay valid for every set number up to which the cached (hence identical) set layouts match, as long
+    // as the push constant ranges are identical too.
+    uint32_t compatibleCount = 0;
+    while (frame->boundPushConstantHash == pipeline->pushConstantHash && compatibleCount < pipeline->setLayoutCount && frame->boundSetLayouts[compatibleCount] == pipeline->setLayouts[compatibleCount])
+        compatibleCount++;
+    frame->boundPushConstantHash = pipeline->pushConstantHash;
+
+    if (context->bindlessTable != NULL && compatibleCount == 0)
+    {
+        vkCmdBindDescriptorSets(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, 0, 1, &context->bindlessTable->set, 0, NULL);
+        frame->boundSetLayouts[0] = context->bindlessTable->setLayout;
+        frame->boundSets[0] = context->bindlessTable->set;
+        compatibleCount = 1;
+    }
+
+    uint32_t firstSet = pipeline->descriptorSetIndex;
+    uint32_t endSet = firstSet + pipeline->descriptorSetCount;
+    uint32_t firstChanged = endSet;
+    VkDescriptorSet sets[VKU_MAX_DESCRIPTOR_SETS];
+
+    for (uint32_t i = firstSet; i < endSet; i++)
+    {
+        sets[i - firstSet] = pipeline->descriptorSets[i - firstSet]->sets[frame->presenter->currentFrame];
+        if (firstChanged == endSet && (i >= compatibleCount || frame->boundSets[i] != sets[i - firstSet]))
+            firstChanged = i;
+    }
+
+    if (firstChanged < endSet)
+    {
+        uint32_t attributeCount = 0;
+        for (uint32_t i = firstChanged; i < endSet; i++)
+            attributeCount += pipeline->descriptorSets[i - firstSet]->attributeCount;
+
+        uint32_t dynamicOffsets[attributeCount > 0 ? attributeCount : 1];
+        uint32_t dynamicOffsetCount = 0;
+
+        for (uint32_t i = firstChanged; i < endSet; i++)
+        {
+            VkuDescriptorSet set = pipeline->descriptorSets[i - firstSet];
+            for (uint32_t j = 0; j < set->attributeCount; j++)
+                if (set->attributes[j].type == VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_BUFFER)
+                    dynamicOffsets[dynamicOffsetCount++] = 0;
+        }
+
+        vkCmdBindDescriptorSets(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, firstChanged, endSet - firstChanged, &sets[firstChanged - firstSet], dynamicOffsetCount, dynamicOffsets);
+
+        for (uint32_t i = firstChanged; i < endSet; i++)
+        {
+            frame->boundSetLayouts[i] = pipeline->setLayouts[i];
+            frame->boundSets[i] = sets[i - firstSet];
+        }
+
+        compatibleCount = endSet;
+    }
+
+    // Sets above the last compatible set number are disturbed by the new layout.
+    for (uint32_t i = (compatibleCount > endSet) ? compatibleCount : endSet; i < VKU_MAX_DESCRIPTOR_SETS; i++)
+    {
+        frame->boundSetLayouts[i] = VK_NULL_HANDLE;
+        frame->boundSets[i] = VK_NULL_HANDLE;
+    }
+}
+
+void vkuFramePushDescriptors(VkuFrame frame, VkuPipeline pipeline, VkuDescriptorSetAttribute *writes)
+{
+    if (pipeline->pushDescriptorAttributeCount == 0)
+        EXIT("VkuError: vkuFramePushDescriptors: Pipeline has no push-descriptor set!\n");
+
+    uint32_t count = pipeline->pushDescriptorAttributeCount;
+    VkuDescriptorTemplateData data[count];
+    VkWriteDescriptorSet descriptorWrites[count];
+    memset(descriptorWrites, 0, sizeof(descriptorWrites));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vkuFillDescriptorTemplateData(&data[i], &writes[i], frame->presenter->currentFrame);
+
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].descriptorType = vkuGetPushDescriptorType(writes[i].type);
+
+        switch (writes[i].type)
+        {
+        case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER:
+        case VKU_DESCRIPTOR_SET_ATTRIB_SAMPLED_IMAGE:
+        case VKU_DESCRIPTOR_SET_ATTRIB_SEPARATE_SAMPLER:
+        case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_IMAGE:
+            descriptorWrites[i].pImageInfo = &data[i].image;
+            break;
+        case VKU_DESCRIPTOR_SET_ATTRIB_UNIFORM_TEXEL_BUFFER:
+        case VKU_DESCRIPTOR_SET_ATTRIB_STORAGE_TEXEL_BUFFER:
+            descriptorWrites[i].pTexelBufferView = &data[i].texelBufferView;
+            break;
+        default:
+            descriptorWrites[i].pBufferInfo = &data[i].buffer;
+            break;
+        }
+    }
+
+    frame->presenter->context->vkCmdPushDescriptorSetKHR(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, pipeline->pushDescriptorSetIndex, count, descriptorWrites);
+
+    for (uint32_t i = pipeline->pushDescriptorSetIndex; i < VKU_MAX_DESCRIPTOR_SETS; i++)
+    {
+        frame->boundSetLayouts[i] = (i == pipeline->pushDescriptorSetIndex) ? pipeline->pushDescriptorSetLayout : VK_NULL_HANDLE;
+        frame->boundSets[i] = VK_NULL_HANDLE;
+    }
+}
+
+void vkuFramePipelinePushConstant(VkuFrame frame, VkuPipeline pipeline, void *data, size_t size)
+{
+    vkuFramePipelinePushConstantRange(frame, pipeline, 0, data, size);
+}
+
+void vkuFramePipelinePushConstantRange(VkuFrame frame, VkuPipeline pipeline, uint32_t offset, void *data, size_t size)
+{
+    VkShaderStageFlags stageFlags = vkuGetPushConstantStages(pipeline->pushConstantRanges, pipeline->pushConstantRangeCount, offset, size);
+    vkCmdPushConstants(frame->cmdBuffer, pipeline->pipelineLayout, stageFlags, offset, (uint32_t)size, data);
+}
+
+void vkuFrameSetCullMode(VkuFrame frame, VkCullModeFlags cullMode)
+{
+    if (!frame->presenter->context->extendedDynamicState)
+        EXIT("VkuError: vkuFrameSetCullMode: Extended dynamic state is not supported by this device!\n");
+
+    vkCmdSetCullMode(frame->cmdBuffer, cullMode);
+}
+
+void vkuFrameSetDepthState(VkuFrame frame, VkBool32 depthTestEnable, VkBool32 depthTestWrite, VkCompareOp depthCompareMode)
+{
+    if (!frame->presenter->context->extendedDynamicState)
+        EXIT("VkuError: vkuFrameSetDepthState: Extended dynamic state is not supported by this device!\n");
+
+    vkCmdSetDepthTestEnable(frame->cmdBuffer, depthTestEnable);
+    vkCmdSetDepthWriteEnable(frame->cmdBuffer, depthTestWrite);
+    vkCmdSetDepthCompareOp(frame->cmdBuffer, depthCompareMode);
+}
+
+void vkuFrameSetDepthBias(VkuFrame frame, VkBool32 enableDepthBias, float depthBiasConstantFactor, float depthBiasSlopeFactor)
+{
+    if (!frame->presenter->context->extendedDynamicState)
+        EXIT("VkuError: vkuFrameSetDepthBias: Extended dynamic state is not supported by this device!\n");
+
+    vkCmdSetDepthBiasEnable(frame->cmdBuffer, enableDepthBias);
+    vkCmdSetDepthBias(frame->cmdBuffer, depthBiasConstantFactor, 0.0f, depthBiasSlopeFactor);
+}
+
+void vkuFrameSetTopology(VkuFrame frame, VkPrimitiveTopology topology)
+{
+    if (!frame->presenter->context->extendedDynamicState)
+        EXIT("VkuError: vkuFrameSetTopology: Extended dynamic state is not supported by this device!\n");
+
+    vkCmdSetPrimitiveTopology(frame->cmdBuffer, topology);
+}
+
+void vkuFrameSetPolygonMode(VkuFrame frame, VkPolygonMode polygonMode)
+{
+    if (!frame->presenter->context->dynamicPolygonMode)
+        EXIT("VkuError: vkuFrameSetPolygonMode: Dynamic polygon mode is not supported by this device!\n");
+
+    frame->presenter->context->vkCmdSetPolygonModeEXT(frame->cmdBuffer, polygonMode);
+}
+
+void vkuFrameDrawVertexBuffer(VkuFrame frame, VkuBuffer buffer, uint64_t vertexCount, uint32_t instanceCount, uint32_t firstVertex)
+{
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(frame->cmdBuffer, 0, 1, &buffer->buffer, offsets);
+    vkCmdDraw(frame->cmdBuffer, vertexCount, instanceCount, firstVertex, 0);
+}
+
+void vkuFrameUpdateUniformBuffer(VkuFrame frame, VkuUniformBuffer uniBuffer, void *data)
+{
+    memcpy(uniBuffer->mappedMemory[frame->presenter->currentFrame], data, uniBuffer->bufferSize);
+}
+
+void vkuFrameDrawVoid(VkuFrame frame, uint64_t vertexCount)
+{
+    vkCmdDraw(frame->cmdBuffer, vertexCount, 1, 0, 0);
+}
+
+VkDescriptorSet vkuFrameAllocateDescriptorSet(VkuFrame frame, VkDescriptorSetLayout setLayout)
+{
+    VkuContext context = frame->presenter->context;
+    VkuDescriptorAllocator allocator = context->descriptorAllocator;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    // Layouts that did not come from the layout cache get the default pool sizes.
+    VkDescriptorPoolSize poolSizes[VKU_DESCRIPTOR_TYPE_COUNT];
+    uint32_t poolSizeCount = vkuLayoutCacheGetPoolSizes(context->layoutCache, setLayout, 1, poolSizes);
+
+    pthread_mutex_lock(&allocator->lock);
+
+    // Chains are only ever added. Ones beyond a smaller framesInFlight may still back sets of frames in flight, so
+    // they stay alive until the allocator is cleared after the device went idle.
+    if (allocator->frameCount < frame->presenter->framesInFlight)
+    {
+        allocator->frames = (VkuDescriptorPoolChain *)realloc(allocator->frames, sizeof(VkuDescriptorPoolChain) * frame->presenter->framesInFlight);
+        for (uint32_t i = allocator->frameCount; i < frame->presenter->framesInFlight; i++)
+            memset(&allocator->frames[i], 0, sizeof(VkuDescriptorPoolChain));
+        allocator->frameCount = frame->presenter->framesInFlight;
+    }
+
+    vkuDescriptorPoolChainAllocate(&allocator->frames[frame->presenter->currentFrame], context->device, 0, &setLayout, 1, &set, poolSizes, poolSizeCount);
+
+    pthread_mutex_unlock(&allocator->lock);
+    return set;
+}
+
+// VkuTexture2D
+
+VkuTexture2D vkuCreateTexture2D(VkuContext context, VkuTexture2DCreateInfo *createInfo)
+{
+    VkuTexture2D_T *texture = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
+    texture->renderStage = NULL;
+    texture->renderStageColorImage = VK_FALSE;
+    texture->renderStageDepthImage = VK_FALSE;
+    texture->imageExtend.height = createInfo->height;
+    texture->imageExtend.width = createInfo->width;
+    texture->mipLevels = (uint32_t)createInfo->mipLevels;
+
+    VkuTextureImageCreateInfo texInfo = {
+        .textureData = createInfo->pixelData,
+        .texWidth = createInfo->width,
+        .texHeight = createInfo->height,
+        .mipLevels = (uint32_t)createInfo->mipLevels,
+        .allocator = context->memoryManager->allocator,
+        .pTexImage = &texture->textureImage,
+        .pTexImageAlloc = &texture->textureImageAllocation,
+        .device = context->device,
+        .physicalDevice = context->physicalDevice,
+        .cmdPool = context->graphicsCmdPool,
+        .graphicsQueue = context->graphicsQueue,
+    };
+
+    vkuCreateTextureImage(&texInfo);
+    texture->textureImageView = vkuCreateTextureImageView(context->device, texture->textureImage, createInfo->mipLevels);
+    texture->bindlessIndex = vkuContextRegisterBindlessTexture(context, texture->textureImageView);
+
+    return texture;
+}
+
+void vkuTexture2DUpdateRegion(VkuContext context, VkuTexture2D texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mipLevel, uint32_t layer, const uint8_t *pixelData)
+{
+    if (texture->renderStage != NULL)
+        EXIT("VkuError: RenderStage output textures can't be updated!\n");
+
+    if (mipLevel >= texture->mipLevels || layer != 0)
+        EXIT("VkuError: Texture2D update mip level or layer out of range!\n");
+
+    uint32_t mipWidth = (texture->imageExtend.width >> mipLevel) > 0 ? (texture->imageExtend.width >> mipLevel) : 1;
+    uint32_t mipHeight = (texture->imageExtend.height >> mipLevel) > 0 ? (texture->imageExtend.height >> mipLevel) : 1;
+
+    if (width == 0 || height == 0 || x + width > mipWidth || y + height > mipHeight)
+        EXIT("VkuError: Texture2D update region exceeds the mip level extent!\n");
+
+    VkBufferImageCopy region = {};
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = mipLevel;
+    region.imageSubresource.baseArrayLayer = layer;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = (VkOffset3D){(int32_t)x, (int32_t)y, 0};
+    region.imageExtent = (VkExtent3D){width, height, 1};
+
+    vkuContextEnqueueImageUpload(context, texture->textureImage, region, pixelData, (VkDeviceSize)width * height * 4);
+}
+
+void vkuDestroyTexture2D(VkuContext context, VkuTexture2D texture)
+{
+    if (!texture->renderStage)
+    {
+        vkuContextUnregisterBindlessTexture(context, texture->bindlessIndex);
+        vkuDestroyTextureImageView(context->device, texture->textureImageView);
+        vkuDestroyTextureImage(context->memoryManager->allocator, texture->textureImage, texture->textureImageAllocation);
+    }
+
+    free(texture);
+}
+
+// VkuTexture2DArray
+
+VkuTexture2DArray vkuCreateTexture2DArray(VkuContext context, VkuTexture2DArrayCreateInfo *createInfo)
+{
+    VkuTexture2DArray_T *texArray = (VkuTexture2DArray_T *)calloc(1, sizeof(VkuTexture2DArray_T));
+    texArray->imageExtend.width = (uint32_t)createInfo->width;
+    texArray->imageExtend.height = (uint32_t)createInfo->height;
+    texArray->layerCount = (uint32_t)createInfo->layerCount;
+    texArray->mipLevels = (uint32_t)createInfo->mipLevels;
+
+    VkuTextureImageArrayCreateInfo texInfo = {
+        .width = (uint32_t)createInfo->width,
+        .height = (uint32_t)createInfo->height,
+        .layers = (uint32_t)createInfo->layerCount,
+        .tex_data = createInfo->pixelDataArray,
+        .mip_levels = (uint32_t)createInfo->mipLevels,
+        .allocator = context->memoryManager->allocator,
+        .pTexArrayImg = &texArray->textureImage,
+        .pTexArrayAlloc = &texArray->textureImageAllocation,
+        .device = context->device,
+        .cmd_pool = context->graphicsCmdPool,
+        .graphics_queue = context->graphicsQueue,
+        .physical_device = context->physicalDevice,
+    };
+
+    vkuCreateTextureImageArray(&texInfo);
+    texArray->textureImageView = vkuCreateTextureImageArrayView(context->device, texArray->textureImage, createInfo->mipLevels, createInfo->layerCount);
+    texArray->bindlessIndex = vkuContextRegisterBindlessTexture(context, texArray->textureImageView);
+
+    return texArray;
+}
+
+void vkuTexture2DArrayUpdateRegion(VkuContext context, VkuTexture2DArray texArray, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mipLevel, uint32_t layer, const uint8_t *pixelData)
+{
+    if (mipLevel >= texArray->mipLevels || layer >= texArray->layerCount)
+        EXIT("VkuError: Texture2DArray update mip level or layer out of range!\n");
+
+    uint32_t mipWidth = (texArray->imageExtend.width >> mipLevel) > 0 ? (texArray->imageExtend.width >> mipLevel) : 1;
+    uint32_t mipHeight = (texArray->imageExtend.height >> mipLevel) > 0 ? (texArray->imageExtend.height >> mipLevel) : 1;
+
+    if (width == 0 || height == 0 || x + width > mipWidth || y + height > mipHeight)
+        EXIT("VkuError: Texture2DArray update region exceeds the mip level extent!\n");
+
+    VkBufferImageCopy region = {};
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = mipLevel;
+    region.imageSubresource.baseArrayLayer = layer;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = (VkOffset3D){(int32_t)x, (int32_t)y, 0};
+    region.imageExtent = (VkExtent3D){width, height, 1};
+
+    vkuContextEnqueueImageUpload(context, texArray->textureImage, region, pixelData, (VkDeviceSize)width * height * 4);
+}
+
+void vkuDestroyTexture2DArray(VkuContext context, VkuTexture2DArray texArray)
+{
+    vkuContextUnregisterBindlessTexture(context, texArray->bindlessIndex);
+    vkuDestroyTextureImageView(context->device, texArray->textureImageView);
+    vkuDestroyTextureImage(context->memoryManager->allocator, texArray->textureImage, texArray->textureImageAllocation);
+
+    free(texArray);
+}
+
+// VkuStorageImage
+
+VkuStorageImage vkuCreateStorageImage(VkuContext context, VkuStorageImageCreateInfo *createInfo)
+{
+    // The image is also sampled, e.g. to display a compute result. Many formats (all SRGB ones among them) can't be
+    // used for storage.
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(context->physicalDevice, createInfo->format, &formatProperties);
+    if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) == 0)
+        EXIT("VkuError: Storage Image: The format doesn't support storage image usage on this device!\n");
+    if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+        EXIT("VkuError: Storage Image: The format doesn't support sampling on this device!\n");
+
+    VkuStorageImage_T *storageImage = (VkuStorageImage_T *)calloc(1, sizeof(VkuStorageImage_T));
+    storageImage->imageExtend.width = createInfo->width;
+    storageImage->imageExtend.height = createInfo->height;
+    storageImage->format = createInfo->format;
+
+    VkuVkImageCreateInfo imageCreateInfo = {
+        .allocator = context->memoryManager->allocator,
+        .width = createInfo->width,
+        .height = createInfo->height,
+        .mipLevels = 1,
+        .format = createInfo->format,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usageFlags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .numSamples = VK_SAMPLE_COUNT_1_BIT,
+        .pImage = &storageImage->image,
+        .pImageAlloc = &storageImage->imageAllocation,
+        .pImageAllocInfo = NULL,
+        .arrayLayers = 1,
+    };
+
+    vkuCreateImage(&imageCreateInfo);
+    vkuTransitionImageLayout(storageImage->image, createInfo->format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 1, 1, context->device, context->graphicsCmdPool, context->graphicsQueue);
+    storageImage->imageView = vkuCreateImageView(storageImage->image, createInfo->format, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, context->device);
+
+    return storageImage;
+}
+
+void vkuDestroyStorageImage(VkuContext context, VkuStorageImage storageImage)
+{
+    vkuDestroyImageView(storageImage->imageView, context->device);
+    vkuDestroyImage(storageImage->image, storageImage->imageAllocation, context->memoryManager->allocator);
+    free(storageImage);
+}
+
+// VkuVirtualTexture
+
+#define VKU_VIRTUAL_TEXTURE_INVALID_SLOT UINT32_MAX
+
+uint32_t vkuVirtualTextureMipPages(uint32_t pages, uint32_t mipLevel)
+{
+    return ((pages >> mipLevel) > 0) ? (pages >> mipLevel) : 1;
+}
+
+void vkuVirtualTextureGetPageCoords(VkuVirtualTexture virtualTexture, uint32_t page, uint32_t *mipLevel, uint32_t *pageX, uint32_t *pageY)
+{
+    uint32_t mip = virtualTexture->mipLevels - 1;
+    while (mip > 0 && page < virtualTexture->mipPageOffsets[mip])
+        mip--;
+
+    uint32_t mipPagesX = vkuVirtualTextureMipPages(virtualTexture->pagesX, mip);
+    uint32_t localPage = page - virtualTexture->mipPageOffsets[mip];
+
+    *mipLevel = mip;
+    *pageX = localPage % mipPagesX;
+    *pageY = localPage / mipPagesX;
+}
+
+void vkuVirtualTextureLruRemove(VkuVirtualTexture virtualTexture, uint32_t slot)
+{
+    uint32_t prev = virtualTexture->lruPrev[slot];
+    uint32_t next = virtualTexture->lruNext[slot];
+
+    if (prev != VKU_VIRTUAL_TEXTURE_INVALID_SLOT)
+        virtualTexture->lruNext[prev] = next;
+    else
+        virtualTexture->lruHead = next;
+
+    if (next != VKU_VIRTUAL_TEXTURE_INVALID_SLOT)
+        virtualTexture->lruPrev[next] = prev;
+    else
+        virtualTexture->lruTail = prev;
+
+    virtualTexture->lruPrev[slot] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+    virtualTexture->lruNext[slot] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+}
+
+void vkuVirtualTextureLruPushFront(VkuVirtualTexture virtualTexture, uint32_t slot)
+{
+    virtualTexture->lruPrev[slot] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+    virtualTexture->lruNext[slot] = virtualTexture->lruHead;
+
+    if (virtualTexture->lruHead != VKU_VIRTUAL_TEXTURE_INVALID_SLOT)
+        virtualTexture->lruPrev[virtualTexture->lruHead] = slot;
+    else
+        virtualTexture->lruTail = slot;
+
+    virtualTexture->lruHead = slot;
+}
+
+uint32_t vkuVirtualTextureAcquireSlot(VkuVirtualTexture virtualTexture)
+{
+    if (virtualTexture->freeSlotCount > 0)
+        return virtualTexture->freeSlots[--virtualTexture->freeSlotCount];
+
+    uint32_t slot = virtualTexture->lruTail;
+
+    // Every resident page was requested during this update, evicting now would only cause thrashing.
+    if (slot == VKU_VIRTUAL_TEXTURE_INVALID_SLOT || virtualTexture->slotLastUsed[slot] == virtualTexture->updateIndex)
+        return VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+
+    vkuVirtualTextureLruRemove(virtualTexture, slot);
+    virtualTexture->pageTable[virtualTexture->slotPages[slot]] = -1;
+    virtualTexture->slotPages[slot] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+    virtualTexture->indirectionDirty = VK_TRUE;
+
+    return slot;
+}
+
+void vkuVirtualTextureBuildIndirection(VkuVirtualTexture virtualTexture)
+{
+    for (int32_t mip = (int32_t)virtualTexture->mipLevels - 1; mip >= 0; mip--)
+    {
+        uint32_t mipPagesX = vkuVirtualTextureMipPages(virtualTexture->pagesX, mip);
+        uint32_t mipPagesY = vkuVirtualTextureMipPages(virtualTexture->pagesY, mip);
+        uint32_t offset = virtualTexture->mipPageOffsets[mip];
+
+        for (uint32_t y = 0; y < mipPagesY; y++)
+        {
+            for (uint32_t x = 0; x < mipPagesX; x++)
+            {
+                uint32_t page = offset + y * mipPagesX + x;
+                int32_t slot = virtualTexture->pageTable[page];
+
+                if (slot >= 0)
+                {
+                    virtualTexture->indirectionData[page] = ((uint32_t)slot & 0xFFFF) | ((uint32_t)mip << 16) | (0xFFu << 24);
+                }
+                else if ((uint32_t)mip + 1 < virtualTexture->mipLevels)
+                {
+                    uint32_t parentPagesX = vkuVirtualTextureMipPages(virtualTexture->pagesX, mip + 1);
+                    uint32_t parentPagesY = vkuVirtualTextureMipPages(virtualTexture->pagesY, mip + 1);
+                    uint32_t parentX = ((x >> 1) < parentPagesX) ? (x >> 1) : parentPagesX - 1;
+                    uint32_t parentY = ((y >> 1) < parentPagesY) ? (y >> 1) : parentPagesY - 1;
+
+                    virtualTexture->indirectionData[page] = virtualTexture->indirectionData[virtualTexture->mipPageOffsets[mip + 1] + parentY * parentPagesX + parentX];
+                }
+                else
+                {
+                    virtualTexture->indirectionData[page] = 0;
+                }
+            }
+        }
+    }
+}
+
+VkuVirtualTexture vkuCreateVirtualTexture(VkuContext context, VkuVirtualTextureCreateInfo *createInfo)
+{
+    if (createInfo->pageSize == 0 || createInfo->width == 0 || createInfo->height == 0 || (createInfo->width % createInfo->pageSize) != 0 || (createInfo->height % createInfo->pageSize) != 0)
+        EXIT("VkuError: VirtualTexture dimensions must be non-zero multiples of the page size!\n");
+
+    if (createInfo->pageLoader == NULL)
+        EXIT("VkuError: VirtualTexture requires a page loader!\n");
+
+    if (createInfo->physicalPageCount < 2 || createInfo->maxUploadsPerFrame == 0 || createInfo->framesInFlight == 0)
+        EXIT("VkuError: VirtualTexture requires at least 2 physical pages, 1 upload per frame and 1 frame in flight!\n");
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &properties);
+
+    if (createInfo->physicalPageCount > properties.limits.maxImageArrayLayers || createInfo->physicalPageCount > 0xFFFF)
+        EXIT("VkuError: VirtualTexture physicalPageCount exceeds the supported number of image array layers!\n");
+
+    VkuVirtualTexture_T *virtualTexture = (VkuVirtualTexture_T *)calloc(1, sizeof(VkuVirtualTexture_T));
+    virtualTexture->context = context;
+    virtualTexture->pageSize = createInfo->pageSize;
+    virtualTexture->pagesX = createInfo->width / createInfo->pageSize;
+    virtualTexture->pagesY = createInfo->height / createInfo->pageSize;
+    virtualTexture->physicalPageCount = createInfo->physicalPageCount;
+    virtualTexture->maxUploadsPerFrame = createInfo->maxUploadsPerFrame;
+    virtualTexture->framesInFlight = createInfo->framesInFlight;
+    virtualTexture->pageLoader = createInfo->pageLoader;
+    virtualTexture->userData = createInfo->userData;
+    virtualTexture->updateIndex = 0;
+    virtualTexture->indirectionDirty = VK_TRUE;
+
+    uint32_t maxPages = (virtualTexture->pagesX > virtualTexture->pagesY) ? virtualTexture->pagesX : virtualTexture->pagesY;
+    virtualTexture->mipLevels = 1;
+    while ((maxPages >> virtualTexture->mipLevels) > 0)
+        virtualTexture->mipLevels++;
+
+    virtualTexture->mipPageOffsets = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->mipLevels);
+    virtualTexture->pageCount = 0;
+    for (uint32_t mip = 0; mip < virtualTexture->mipLevels; mip++)
+    {
+        virtualTexture->mipPageOffsets[mip] = virtualTexture->pageCount;
+        virtualTexture->pageCount += vkuVirtualTextureMipPages(virtualTexture->pagesX, mip) * vkuVirtualTextureMipPages(virtualTexture->pagesY, mip);
+    }
+
+    virtualTexture->pageTable = (int32_t *)malloc(sizeof(int32_t) * virtualTexture->pageCount);
+    for (uint32_t i = 0; i < virtualTexture->pageCount; i++)
+        virtualTexture->pageTable[i] = -1;
+
+    virtualTexture->indirectionData = (uint32_t *)calloc(virtualTexture->pageCount, sizeof(uint32_t));
+    virtualTexture->requests = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->maxUploadsPerFrame);
+    virtualTexture->pageRegions = (VkBufferImageCopy *)malloc(sizeof(VkBufferImageCopy) * virtualTexture->maxUploadsPerFrame);
+    virtualTexture->indirectionRegions = (VkBufferImageCopy *)malloc(sizeof(VkBufferImageCopy) * virtualTexture->mipLevels);
+
+    virtualTexture->slotPages = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->physicalPageCount);
+    virtualTexture->slotLastUsed = (uint32_t *)calloc(virtualTexture->physicalPageCount, sizeof(uint32_t));
+    virtualTexture->lruPrev = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->physicalPageCount);
+    virtualTexture->lruNext = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->physicalPageCount);
+    virtualTexture->freeSlots = (uint32_t *)malloc(sizeof(uint32_t) * virtualTexture->physicalPageCount);
+    virtualTexture->freeSlotCount = virtualTexture->physicalPageCount;
+    virtualTexture->lruHead = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+    virtualTexture->lruTail = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+
+    for (uint32_t i = 0; i < virtualTexture->physicalPageCount; i++)
+    {
+        virtualTexture->slotPages[i] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+        virtualTexture->lruPrev[i] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+        virtualTexture->lruNext[i] = VKU_VIRTUAL_TEXTURE_INVALID_SLOT;
+        virtualTexture->freeSlots[i] = virtualTexture->physicalPageCount - 1 - i;
+    }
+
+    VkuTexture2DArray_T *physicalPages = (VkuTexture2DArray_T *)calloc(1, sizeof(VkuTexture2DArray_T));
+    physicalPages->imageExtend.width = virtualTexture->pageSize;
+    physicalPages->imageExtend.height = virtualTexture->pageSize;
+    physicalPages->layerCount = virtualTexture->physicalPageCount;
+    physicalPages->mipLevels = 1;
+
+    VkuVkImageCreateInfo physicalImageInfo = {
+        .allocator = context->memoryManager->allocator,
+        .width = virtualTexture->pageSize,
+        .height = virtualTexture->pageSize,
+        .mipLevels = 1,
+        .arrayLayers = virtualTexture->physicalPageCount,
+        .format = VK_FORMAT_R8G8B8A8_SRGB,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .numSamples = VK_SAMPLE_COUNT_1_BIT,
+        .pImage = &physicalPages->textureImage,
+        .pImageAlloc = &physicalPages->textureImageAllocation,
+        .pImageAllocInfo = NULL,
+    };
+
+    vkuCreateImage(&physicalImageInfo);
+    physicalPages->textureImageView = vkuCreateTextureImageArrayView(context->device, physicalPages->textureImage, 1, virtualTexture->physicalPageCount);
+    physicalPages->bindlessIndex = vkuContextRegisterBindlessTexture(context, physicalPages->textureImageView);
+    vkuTransitionImageLayout(physicalPages->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, virtualTexture->physicalPageCount, context->device, context->graphicsCmdPool, context->graphicsQueue);
+    vkuTransitionImageLayout(physicalPages->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, virtualTexture->physicalPageCount, context->device, context->graphicsCmdPool, context->graphicsQueue);
+    virtualTexture->physicalPages = physicalPages;
+
+    VkuTexture2D_T *indirectionTexture = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
+    indirectionTexture->renderStage = NULL;
+    indirectionTexture->renderStageColorImage = VK_FALSE;
+    indirectionTexture->renderStageDepthImage = VK_FALSE;
+    indirectionTexture->imageExtend.width = virtualTexture->pagesX;
+    indirectionTexture->imageExtend.height = virtualTexture->pagesY;
+    indirectionTexture->mipLevels = virtualTexture->mipLevels;
+
+    VkuVkImageCreateInfo indirectionImageInfo = {
+        .allocator = context->memoryManager->allocator,
+        .width = virtualTexture->pagesX,
+        .height = virtualTexture->pagesY,
+        .mipLevels = virtualTexture->mipLevels,
+        .arrayLayers = 1,
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .numSamples = VK_SAMPLE_COUNT_1_BIT,
+        .pImage = &indirectionTexture->textureImage,
+        .pImageAlloc = &indirectionTexture->textureImageAllocation,
+        .pImageAllocInfo = NULL,
+    };
+
+    vkuCreateImage(&indirectionImageInfo);
+    indirectionTexture->textureImageView = vkuCreateImageView(indirectionTexture->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, virtualTexture->mipLevels, 1, context->device);
+    indirectionTexture->bindlessIndex = vkuContextRegisterBindlessTexture(context, indirectionTexture->textureImageView);
+    vkuTransitionImageLayout(indirectionTexture->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, virtualTexture->mipLevels, 1, context->device, context->graphicsCmdPool, context->graphicsQueue);
+    vkuTransitionImageLayout(indirectionTexture->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, virtualTexture->mipLevels, 1, context->device, context->graphicsCmdPool, context->graphicsQueue);
+    virtualTexture->indirectionTexture = indirectionTexture;
+
+    virtualTexture->feedbackBuffer = vkuCreateBuffer(context->memoryManager, sizeof(uint32_t) * virtualTexture->pageCount, VKU_BUFFER_USAGE_GPU_TO_CPU);
+    virtualTexture->feedback = (uint32_t *)vkuMapBuffer(context->memoryManager, virtualTexture->feedbackBuffer);
+    memset(virtualTexture->feedback, 0, sizeof(uint32_t) * virtualTexture->pageCount);
+
+    VkDeviceSize pageBytes = (VkDeviceSize)virtualTexture->pageSize * virtualTexture->pageSize * 4;
+    VkDeviceSize stagingSize = pageBytes * virtualTexture->maxUploadsPerFrame + sizeof(uint32_t) * virtualTexture->pageCount;
+
+    virtualTexture->stagingBuffers = (VkuBuffer *)malloc(sizeof(VkuBuffer) * virtualTexture->framesInFlight);
+    virtualTexture->stagingMemory = (uint8_t **)malloc(sizeof(uint8_t *) * virtualTexture->framesInFlight);
+
+    for (uint32_t i = 0; i < virtualTexture->framesInFlight; i++)
+    {
+        virtualTexture->stagingBuffers[i] = vkuCreateBuffer(context->memoryManager, stagingSize, VKU_BUFFER_USAGE_CPU_TO_GPU);
+        virtualTexture->stagingMemory[i] = (uint8_t *)vkuMapBuffer(context->memoryManager, virtualTexture->stagingBuffers[i]);
+    }
+
+    return virtualTexture;
+}
+
+void vkuFrameUpdateVirtualTexture(VkuFrame frame, VkuVirtualTexture virtualTexture)
+{
+    if (frame->activeRenderStage)
+        EXIT("VkuError: vkuFrameUpdateVirtualTexture() must be called outside of a VkuRenderStage!\n");
+
+    uint32_t frameIndex = frame->presenter->currentFrame;
+    if (frameIndex >= virtualTexture->framesInFlight)
+        EXIT("VkuError: VirtualTexture was created with fewer framesInFlight than the VkuPresenter uses!\n");
+
+    virtualTexture->updateIndex++;
+
+    uint32_t topPage = virtualTexture->mipPageOffsets[virtualTexture->mipLevels - 1];
+    uint32_t requestCount = 0;
+
+    // The coarsest page is pinned so every lookup has a resident fallback.
+    if (virtualTexture->pageTable[topPage] < 0)
+        virtualTexture->requests[requestCount++] = topPage;
+
+    // Frames still in flight may write feedback concurrently. A request lost to that race is reported again next frame.
+    // Scanning coarse to fine makes the upload budget go to the pages that improve the fallback chain first.
+    for (int32_t mip = (int32_t)virtualTexture->mipLevels - 1; mip >= 0; mip--)
+    {
+        uint32_t firstPage = virtualTexture->mipPageOffsets[mip];
+        uint32_t lastPage = firstPage + vkuVirtualTextureMipPages(virtualTexture->pagesX, mip) * vkuVirtualTextureMipPages(virtualTexture->pagesY, mip);
+
+        for (uint32_t page = firstPage; page < lastPage; page++)
+        {
+            if (virtualTexture->feedback[page] == 0)
+                continue;
+
+            virtualTexture->feedback[page] = 0;
+            int32_t slot = virtualTexture->pageTable[page];
+
+            if (slot >= 0)
+            {
+                virtualTexture->slotLastUsed[slot] = virtualTexture->updateIndex;
+
+                if (page != topPage)
+                {
+                    vkuVirtualTextureLruRemove(virtualTexture, (uint32_t)slot);
+                    vkuVirtualTextureLruPushFront(virtualTexture, (uint32_t)slot);
+                }
+            }
+            else if (page != topPage && requestCount < virtualTexture->maxUploadsPerFrame)
+            {
+                virtualTexture->requests[requestCount++] = page;
+            }
+        }
+    }
+
+    VkDeviceSize pageBytes = (VkDeviceSize)virtualTexture->pageSize * virtualTexture->pageSize * 4;
+    VkBufferImageCopy *regions = virtualTexture->pageRegions;
+    uint32_t regionCount = 0;
+
+    for (uint32_t i = 0; i < requestCount; i++)
+    {
+        uint32_t page = virtualTexture->requests[i];
+        uint32_t slot = vkuVirtualTextureAcquireSlot(virtualTexture);
+        if (slot == VKU_VIRTUAL_TEXTURE_INVALID_SLOT)
+            break;
+
+        uint32_t mip, pageX, pageY;
+        vkuVirtualTextureGetPageCoords(virtualTexture, page, &mip, &pageX, &pageY);
+
+        if (!virtualTexture->pageLoader(mip, pageX, pageY, virtualTexture->stagingMemory[frameIndex] + regionCount * pageBytes, virtualTexture->userData))
+        {
+            virtualTexture->freeSlots[virtualTexture->freeSlotCount++] = slot;
+            continue;
+        }
+
+        virtualTexture->pageTable[page] = (int32_t)slot;
+        virtualTexture->slotPages[slot] = page;
+        virtualTexture->slotLastUsed[slot] = virtualTexture->updateIndex;
+        virtualTexture->indirectionDirty = VK_TRUE;
+
+        if (page != topPage)
+            vkuVirtualTextureLruPushFront(virtualTexture, slot);
+
+        memset(&regions[regionCount], 0, sizeof(VkBufferImageCopy));
+        regions[regionCount].bufferOffset = regionCount * pageBytes;
+        regions[regionCount].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[regionCount].imageSubresource.mipLevel = 0;
+        regions[regionCount].imageSubresource.baseArrayLayer = slot;
+        regions[regionCount].imageSubresource.layerCount = 1;
+        regions[regionCount].imageExtent.width = virtualTexture->pageSize;
+        regions[regionCount].imageExtent.height = virtualTexture->pageSize;
+        regions[regionCount].imageExtent.depth = 1;
+        regionCount++;
+    }
+
+    if (regionCount > 0)
+        vkuCmdUploadImageRegions(frame->cmdBuffer, virtualTexture->stagingBuffers[frameIndex]->buffer, virtualTexture->physicalPages->textureImage, regions, regionCount, 1, virtualTexture->physicalPageCount);
+
+    if (virtualTexture->indirectionDirty)
+    {
+        vkuVirtualTextureBuildIndirection(virtualTexture);
+
+        VkDeviceSize indirectionOffset = pageBytes * virtualTexture->maxUploadsPerFrame;
+        memcpy(virtualTexture->stagingMemory[frameIndex] + indirectionOffset, virtualTexture->indirectionData, sizeof(uint32_t) * virtualTexture->pageCount);
+
+        VkBufferImageCopy *mipRegions = virtualTexture->indirectionRegions;
+        memset(mipRegions, 0, sizeof(VkBufferImageCopy) * virtualTexture->mipLevels);
+
+        for (uint32_t mip = 0; mip < virtualTexture->mipLevels; mip++)
+        {
+            mipRegions[mip].bufferOffset = indirectionOffset + sizeof(uint32_t) * virtualTexture->mipPageOffsets[mip];
+            mipRegions[mip].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            mipRegions[mip].imageSubresource.mipLevel = mip;
+            mipRegions[mip].imageSubresource.baseArrayLayer = 0;
+            mipRegions[mip].imageSubresource.layerCount = 1;
+            mipRegions[mip].imageExtent.width = vkuVirtualTextureMipPages(virtualTexture->pagesX, mip);
+            mipRegions[mip].imageExtent.height = vkuVirtualTextureMipPages(virtualTexture->pagesY, mip);
+            mipRegions[mip].imageExtent.depth = 1;
+        }
+
+        vkuCmdUploadImageRegions(frame->cmdBuffer, virtualTexture->stagingBuffers[frameIndex]->buffer, virtualTexture->indirectionTexture->textureImage, mipRegions, virtualTexture->mipLevels, virtualTexture->mipLevels, 1);
+        virtualTexture->indirectionDirty = VK_FALSE;
+    }
+}
+
+void vkuDestroyVirtualTexture(VkuContext context, VkuVirtualTexture virtualTexture)
+{
+    vkDeviceWaitIdle(context->device);
+
+    for (uint32_t i = 0; i < virtualTexture->framesInFlight; i++)
+    {
+        vkuUnmapBuffer(context->memoryManager, virtualTexture->stagingBuffers[i]);
+        vkuDestroyBuffer(virtualTexture->stagingBuffers[i], context->memoryManager, VK_FALSE);
+    }
+
+    vkuUnmapBuffer(context->memoryManager, virtualTexture->feedbackBuffer);
+    vkuDestroyBuffer(virtualTexture->feedbackBuffer, context->memoryManager, VK_FALSE);
+    vkuDestroyTexture2D(context, virtualTexture->indirectionTexture);
+    vkuDestroyTexture2DArray(context, virtualTexture->physicalPages);
+
+    free(virtualTexture->stagingBuffers);
+    free(virtualTexture->stagingMemory);
+    free(virtualTexture->mipPageOffsets);
+    free(virtualTexture->pageTable);
+    free(virtualTexture->indirectionData);
+    free(virtualTexture->requests);
+    free(virtualTexture->pageRegions);
+    free(virtualTexture->indirectionRegions);
+    free(virtualTexture->slotPages);
+    free(virtualTexture->slotLastUsed);
+    free(virtualTexture->lruPrev);
+    free(virtualTexture->lruNext);
+    free(virtualTexture->freeSlots);
+    free(virtualTexture);
+}
+
+// VkuTextureCache
+
+#define VKU_TEXTURE_CACHE_MIN_BUCKETS 32
+
+VkuTextureCache vkuCreateTextureCache(VkuContext context, uint32_t framesInFlight)
+{
+    VkuTextureCache_T *cache = (VkuTextureCache_T *)calloc(1, sizeof(VkuTextureCache_T));
+    cache->context = context;
+    cache->framesInFlight = framesInFlight;
+    cache->frameIndex = 0;
+    cache->entryBucketCount = VKU_TEXTURE_CACHE_MIN_BUCKETS;
+    cache->contentBuckets = (VkuTextureCacheEntry *)calloc(cache->entryBucketCount, sizeof(VkuTextureCacheEntry));
+    cache->textureBuckets = (VkuTextureCacheEntry *)calloc(cache->entryBucketCount, sizeof(VkuTextureCacheEntry));
+    cache->pathBucketCount = VKU_TEXTURE_CACHE_MIN_BUCKETS;
+    cache->pathBuckets = (VkuTextureCachePath **)calloc(cache->pathBucketCount, sizeof(VkuTextureCachePath *));
+
+    return cache;
+}
+
+void vkuDestroyTextureCache(VkuTextureCache cache)
+{
+    vkDeviceWaitIdle(cache->context->device);
+
+    for (uint32_t i = 0; i < cache->entryCount; i++)
+    {
+        VkuTextureCacheEntry entry = cache->entries[i];
+        while (entry->paths != NULL)
+        {
+            VkuTextureCachePath *cachePath = entry->paths;
+            entry->paths = cachePath->nextOfEntry;
+            free(cachePath->path);
+            free(cachePath);
+        }
+
+        vkuDestroyTexture2D(cache->context, entry->texture);
+        free(entry);
+    }
+
+    free(cache->entries);
+    free(cache->contentBuckets);
+    free(cache->textureBuckets);
+    free(cache->pathBuckets);
+    free(cache);
+}
+
+// Bucket counts are powers of two, so the low bits of a hash select the bucket.
+uint32_t vkuTextureCacheBucket(uint64_t hash, uint32_t bucketCount)
+{
+    return (uint32_t)(hash & (bucketCount - 1));
+}
+
+uint64_t vkuTextureCacheTextureHash(VkuTexture2D texture)
+{
+    return vkuHash64(&texture, sizeof(VkuTexture2D), 0);
+}
+
+void vkuTextureCacheLinkEntry(VkuTextureCache cache, VkuTextureCacheEntry entry)
+{
+    uint32_t contentBucket = vkuTextureCacheBucket(entry->contentHash, cache->entryBucketCount);
+    entry->nextByContent = cache->contentBuckets[contentBucket];
+    cache->contentBuckets[contentBucket] = entry;
+
+    uint32_t textureBucket = vkuTextureCacheBucket(vkuTextureCacheTextureHash(entry->texture), cache->entryBucketCount);
+    entry->nextByTexture = cache->textureBuckets[textureBucket];
+    cache->textureBuckets[textureBucket] = entry;
+}
+
+void vkuTextureCacheUnlinkEntry(VkuTextureCache cache, VkuTextureCacheEntry entry)
+{
+    VkuTextureCacheEntry *link = &cache->contentBuckets[vkuTextureCacheBucket(entry->contentHash, cache->entryBucketCount)];
+    while (*link != entry)
+        link = &(*link)->nextByContent;
+    *link = entry->nextByContent;
+
+    link = &cache->textureBuckets[vkuTextureCacheBucket(vkuTextureCacheTextureHash(entry->texture), cache->entryBucketCount)];
+    while (*link != entry)
+        link = &(*link)->nextByTexture;
+    *link = entry->nextByTexture;
+}
+
+void vkuTextureCacheAddEntry(VkuTextureCache cache, VkuTextureCacheEntry entry)
+{
+    if (cache->entryCount == cache->entryCapacity)
+    {
+        cache->entryCapacity = (cache->entryCapacity == 0) ? 32 : cache->entryCapacity * 2;
+        cache->entries = (VkuTextureCacheEntry *)realloc(cache->entries, sizeof(VkuTextureCacheEntry) * cache->entryCapacity);
+    }
+
+    cache->entries[cache->entryCount++] = entry;
+
+    if (cache->entryCount > cache->entryBucketCount)
+    {
+        cache->entryBucketCount *= 2;
+        cache->contentBuckets = (VkuTextureCacheEntry *)realloc(cache->contentBuckets, sizeof(VkuTextureCacheEntry) * cache->entryBucketCount);
+        cache->textureBuckets = (VkuTextureCacheEntry *)realloc(cache->textureBuckets, sizeof(VkuTextureCacheEntry) * cache->entryBucketCount);
+        memset(cache->contentBuckets, 0, sizeof(VkuTextureCacheEntry) * cache->entryBucketCount);
+        memset(cache->textureBuckets, 0, sizeof(VkuTextureCacheEntry) * cache->entryBucketCount);
+
+        for (uint32_t i = 0; i < cache->entryCount; i++)
+            vkuTextureCacheLinkEntry(cache, cache->entries[i]);
+    }
+    else
+    {
+        vkuTextureCacheLinkEntry(cache, entry);
+    }
+}
+
+void vkuTextureCacheRetain(VkuTextureCacheEntry entry)
+{
+    entry->refCount++;
+    entry->retireFrame = 0;
+}
+
+void vkuTextureCacheAddPath(VkuTextureCache cache, uint64_t pathHash, const char *path, VkuTextureCacheEntry entry)
+{
+    VkuTextureCachePath *cachePath = (VkuTextureCachePath *)calloc(1, sizeof(VkuTextureCachePath));
+    cachePath->pathHash = pathHash;
+    cachePath->path = strdup(path);
+    cachePath->entry = entry;
+    cachePath->nextOfEntry = entry->paths;
+    entry->paths = cachePath;
+
+    if (++cache->pathCount > cache->pathBucketCount)
+    {
+        cache->pathBucketCount *= 2;
+        cache->pathBuckets = (VkuTextureCachePath **)realloc(cache->pathBuckets, sizeof(VkuTextureCachePath *) * cache->pathBucketCount);
+        memset(cache->pathBuckets, 0, sizeof(VkuTextureCachePath *) * cache->pathBucketCount);
+
+        for (uint32_t i = 0; i < cache->entryCount; i++)
+        {
+            for (VkuTextureCachePath *entryPath = cache->entries[i]->paths; entryPath != NULL; entryPath = entryPath->nextOfEntry)
+            {
+                uint32_t bucket = vkuTextureCacheBucket(entryPath->pathHash, cache->pathBucketCount);
+                entryPath->nextInBucket = cache->pathBuckets[bucket];
+                cache->pathBuckets[bucket] = entryPath;
+            }
+        }
+    }
+    else
+    {
+        uint32_t bucket = vkuTextureCacheBucket(pathHash, cache->pathBucketCount);
+        cachePath->nextInBucket = cache->pathBuckets[bucket];
+        cache->pathBuckets[bucket] = cachePath;
+    }
+}
+
+VkuTexture2D vkuTextureCacheAcquire(VkuTextureCache cache, const char *path, int mipLevels)
+{
+    uint64_t pathHash = vkuHash64(path, strlen(path), 0);
+
+    for (VkuTextureCachePath *cachePath = cache->pathBuckets[vkuTextureCacheBucket(pathHash, cache->pathBucketCount)]; cachePath != NULL; cachePath = cachePath->nextInBucket)
+    {
+        if (cachePath->pathHash == pathHash && cachePath->entry->mipLevels == (uint32_t)mipLevels && strcmp(cachePath->path, path) == 0)
+        {
+            vkuTextureCacheRetain(cachePath->entry);
+            return cachePath->entry->texture;
+        }
+    }
+
+    int width, height, channels;
+    uint8_t *pixelData = vkuLoadImage(path, &width, &height, &channels);
+    if (pixelData == NULL)
+        return NULL;
+
+    // Two differently seeded hashes form a 128-bit content key, so the decoded pixels don't have to be kept around for
+    // a byte compare. The extent is part of the seed and compared as well.
+    size_t imageSize = (size_t)width * height * 4;
+    uint64_t extentSeed = ((uint64_t)width << 32) | (uint32_t)height;
+    uint64_t contentHash = vkuHash64(pixelData, imageSize, extentSeed);
+    uint64_t contentCheck = vkuHash64(pixelData, imageSize, ~extentSeed);
+    VkuTextureCacheEntry entry = NULL;
+
+    for (VkuTextureCacheEntry candidate = cache->contentBuckets[vkuTextureCacheBucket(contentHash, cache->entryBucketCount)]; candidate != NULL; candidate = candidate->nextByContent)
+    {
+        if (candidate->contentHash == contentHash && candidate->contentCheck == contentCheck && candidate->mipLevels == (uint32_t)mipLevels && candidate->texture->imageExtend.width == (uint32_t)width && candidate->texture->imageExtend.height == (uint32_t)height)
+        {
+            entry = candidate;
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        VkuTexture2DCreateInfo texInfo = {
+            .width = width,
+            .height = height,
+            .channels = 4,
+            .pixelData = pixelData,
+            .mipLevels = mipLevels,
+        };
+
+        entry = (VkuTextureCacheEntry_T *)calloc(1, sizeof(VkuTextureCacheEntry_T));
+        entry->contentHash = contentHash;
+        entry->mipLevels = (uint32_t)mipLevels;
+        entry->refCount = 0;
+        entry->contentCheck = contentCheck;
+        entry->texture = vkuCreateTexture2D(cache->context, &texInfo);
+
+        vkuTextureCacheAddEntry(cache, entry);
+    }
+
+    // The upload has completed, the texture doesn't need the host copy anymore.
+    stbi_image_free(pixelData);
+
+    vkuTextureCacheAddPath(cache, pathHash, path, entry);
+    vkuTextureCacheRetain(entry);
+    return entry->texture;
+}
+
+void vkuTextureCacheRelease(VkuTextureCache cache, VkuTexture2D texture)
+{
+    uint32_t bucket = vkuTextureCacheBucket(vkuTextureCacheTextureHash(texture), cache->entryBucketCount);
+
+    for (VkuTextureCacheEntry entry = cache->textureBuckets[bucket]; entry != NULL; entry = entry->nextByTexture)
+    {
+        if (entry->texture != texture)
+            continue;
+
+        if (entry->refCount == 0)
+            EXIT("VkuError: VkuTextureCache texture released more often than acquired!\n");
+
+        if (--entry->refCount == 0)
+            entry->retireFrame = cache->frameIndex + cache->framesInFlight;
+
+        return;
+    }
+
+    EXIT("VkuError: Texture was not acquired from this VkuTextureCache!\n");
+}
+
+void vkuTextureCacheCollect(VkuTextureCache cache)
+{
+    cache->frameIndex++;
+
+    uint32_t i = 0;
+    while (i < cache->entryCount)
+    {
+        VkuTextureCacheEntry entry = cache->entries[i];
+
+        if (entry->refCount > 0 || entry->retireFrame > cache->frameIndex)
+        {
+            i++;
+            continue;
+        }
+
+        while (entry->paths != NULL)
+        {
+            VkuTextureCachePath *cachePath = entry->paths;
+            VkuTextureCachePath **link = &cache->pathBuckets[vkuTextureCacheBucket(cachePath->pathHash, cache->pathBucketCount)];
+            while (*link != cachePath)
+                link = &(*link)->nextInBucket;
+            *link = cachePath->nextInBucket;
+
+            entry->paths = cachePath->nextOfEntry;
+            cache->pathCount--;
+            free(cachePath->path);
+            free(cachePath);
+        }
+
+        vkuTextureCacheUnlinkEntry(cache, entry);
+        vkuDestroyTexture2D(cache->context, entry->texture);
+        free(entry);
+        cache->entries[i] = cache->entries[--cache->entryCount];
+    }
+}
+
+// VkuAssetPack
+
+uint64_t vkuAssetPackAlign(uint64_t value)
+{
+    return (value + VKU_ASSET_PACK_ALIGNMENT - 1) & ~((uint64_t)VKU_ASSET_PACK_ALIGNMENT - 1);
+}
+
+uint8_t vkuAssetPackLinearToSrgb(float value)
+{
+    value = CLAMP(value, 0.0f, 1.0f);
+    value = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+void vkuAssetPackDownsample(const uint8_t *src, uint32_t srcWidth, uint32_t srcHeight, uint8_t *dst, uint32_t dstWidth, uint32_t dstHeight, const float *srgbToLinear)
+{
+    for (uint32_t y = 0; y < dstHeight; y++)
+    {
+        uint32_t y0 = CLAMP(y * 2, 0, srcHeight - 1);
+        uint32_t y1 = CLAMP(y * 2 + 1, 0, srcHeight - 1);
+
+        for (uint32_t x = 0; x < dstWidth; x++)
+        {
+            uint32_t x0 = CLAMP(x * 2, 0, srcWidth - 1);
+            uint32_t x1 = CLAMP(x * 2 + 1, 0, srcWidth - 1);
+
+            const uint8_t *texels[4] = {
+                &src[(y0 * srcWidth + x0) * 4],
+                &src[(y0 * srcWidth + x1) * 4],
+                &src[(y1 * srcWidth + x0) * 4],
+                &src[(y1 * srcWidth + x1) * 4],
+            };
+
+            uint8_t *out = &dst[(y * dstWidth + x) * 4];
+
+            for (uint32_t c = 0; c < 3; c++)
+                out[c] = vkuAssetPackLinearToSrgb((srgbToLinear[texels[0][c]] + srgbToLinear[texels[1][c]] + srgbToLinear[texels[2][c]] + srgbToLinear[texels[3][c]]) * 0.25f);
+
+            out[3] = (uint8_t)((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+        }
+    }
+}
+
+bool vkuBuildAssetPack(const char *outputPath, const char **imagePaths, uint32_t imageCount)
+{
+    size_t tmpPathLength = strlen(outputPath) + 5;
+    char tmpPath[tmpPathLength];
+    snprintf(tmpPath, tmpPathLength, "%s.tmp", outputPath);
+
+    FILE *file = fopen(tmpPath, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "vkuBuildAssetPack: Failed to open %s\n", tmpPath);
+        return false;
+    }
+
+    float srgbToLinear[256];
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        float value = (float)i / 255.0f;
+        srgbToLinear[i] = (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    VkuAssetPackTexture *textures = (VkuAssetPackTexture *)calloc(imageCount, sizeof(VkuAssetPackTexture));
+    VkuAssetPackHeader header = {
+        .magic = VKU_ASSET_PACK_MAGIC,
+        .version = VKU_ASSET_PACK_VERSION,
+        .textureCount = imageCount,
+        .reserved = 0,
+        .tableOffset = sizeof(VkuAssetPackHeader),
+    };
+
+    uint64_t offset = vkuAssetPackAlign(sizeof(VkuAssetPackHeader) + sizeof(VkuAssetPackTexture) * imageCount);
+    bool success = true;
+
+    for (uint32_t i = 0; i < imageCount && success; i++)
+    {
+        VkuAssetPackTexture *texture = &textures[i];
+        size_t nameLength = strlen(imagePaths[i]);
+
+        if (nameLength >= VKU_ASSET_PACK_MAX_NAME_LENGTH)
+        {
+            fprintf(stderr, "vkuBuildAssetPack: Path too long: %s\n", imagePaths[i]);
+            success = false;
+            break;
+        }
+
+        int width, height, channels;
+        uint8_t *pixelData = vkuLoadImage(imagePaths[i], &width, &height, &channels);
+        if (pixelData == NULL)
+        {
+            success = false;
+            break;
+        }
+
+        memcpy(texture->name, imagePaths[i], nameLength + 1);
+        texture->nameHash = vkuHash64(imagePaths[i], nameLength, 0);
+        texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+        texture->width = (uint32_t)width;
+        texture->height = (uint32_t)height;
+        texture->mipLevels = (uint32_t)floor(log2(width > height ? width : height)) + 1;
+        if (texture->mipLevels > VKU_ASSET_PACK_MAX_MIP_LEVELS)
+            texture->mipLevels = VKU_ASSET_PACK_MAX_MIP_LEVELS;
+
+        uint8_t *level = pixelData;
+        uint32_t levelWidth = texture->width;
+        uint32_t levelHeight = texture->height;
+
+        for (uint32_t mip = 0; mip < texture->mipLevels; mip++)
+        {
+            texture->mipOffsets[mip] = offset;
+            texture->mipSizes[mip] = (uint64_t)levelWidth * levelHeight * 4;
+
+            if (fseek(file, (long)offset, SEEK_SET) != 0 || fwrite(level, 1, texture->mipSizes[mip], file) != texture->mipSizes[mip])
+            {
+                fprintf(stderr, "vkuBuildAssetPack: Failed to write %s\n", outputPath);
+                success = false;
+                break;
+            }
+
+            offset = vkuAssetPackAlign(offset + texture->mipSizes[mip]);
+
+            if (mip + 1 < texture->mipLevels)
+            {
+                uint32_t nextWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+                uint32_t nextHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+                uint8_t *next = (uint8_t *)malloc((size_t)nextWidth * nextHeight * 4);
+
+                vkuAssetPackDownsample(level, levelWidth, levelHeight, next, nextWidth, nextHeight, srgbToLinear);
+
+                if (level != pixelData)
+                    free(level);
+
+                level = next;
+                levelWidth = nextWidth;
+                levelHeight = nextHeight;
+            }
+        }
+
+        if (level != pixelData)
+            free(level);
+        stbi_image_free(pixelData);
+    }
+
+    if (success && (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(VkuAssetPackHeader), 1, file) != 1 || fwrite(textures, sizeof(VkuAssetPackTexture), imageCount, file) != imageCount))
+    {
+        fprintf(stderr, "vkuBuildAssetPack: Failed to write %s\n", outputPath);
+        success = false;
+    }
+
+    free(textures);
+
+    success = (fflush(file) == 0) && success;
+    success = (fsync(fileno(file)) == 0) && success;
+    success = (fclose(file) == 0) && success;
+
+    if (!success || rename(tmpPath, outputPath) != 0)
+    {
+        remove(tmpPath);
+        return false;
+    }
+
+    return true;
+}
+
+bool vkuAssetPackTextureValid(const VkuAssetPackTexture *texture, size_t mappingSize)
+{
+    if (texture->name[VKU_ASSET_PACK_MAX_NAME_LENGTH - 1] != '\0' || texture->format != VK_FORMAT_R8G8B8A8_SRGB || texture->width == 0 || texture->height == 0)
+        return false;
+
+    uint32_t maxDimension = texture->width > texture->height ? texture->width : texture->height;
+    uint32_t maxMipLevels = 0;
+    while (maxMipLevels < 32 && (maxDimension >> maxMipLevels) > 0)
+        maxMipLevels++;
+
+    if (texture->mipLevels == 0 || texture->mipLevels > VKU_ASSET_PACK_MAX_MIP_LEVELS || texture->mipLevels > maxMipLevels)
+        return false;
+
+    uint32_t levelWidth = texture->width;
+    uint32_t levelHeight = texture->height;
+    uint64_t previousEnd = 0;
+
+    for (uint32_t mip = 0; mip < texture->mipLevels; mip++)
+    {
+        uint64_t texelCount = (uint64_t)levelWidth * levelHeight;
+        uint64_t offset = texture->mipOffsets[mip];
+        uint64_t size = texture->mipSizes[mip];
+
+        // Mips are uploaded as one contiguous range, so they must be ascending and inside the mapping.
+        if (texelCount > mappingSize / 4 || size != texelCount * 4)
+            return false;
+        if (offset % VKU_ASSET_PACK_ALIGNMENT != 0 || offset < previousEnd || offset > mappingSize || size > mappingSize - offset)
+            return false;
+
+        previousEnd = offset + size;
+        levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+        levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+    }
+
+    return true;
+}
+
+VkuAssetPack vkuOpenAssetPack(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Failed to open asset pack: %s\n", path);
+        return NULL;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(VkuAssetPackHeader))
+    {
+        fprintf(stderr, "Invalid asset pack: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t mappingSize = (size_t)fileStat.st_size;
+    void *mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "Failed to map asset pack: %s\n", path);
+        return NULL;
+    }
+
+    const VkuAssetPackHeader *header = (const VkuAssetPackHeader *)mapping;
+    bool valid = header->magic == VKU_ASSET_PACK_MAGIC && header->version == VKU_ASSET_PACK_VERSION && header->tableOffset % sizeof(uint64_t) == 0 &&
+                 header->tableOffset <= mappingSize && header->textureCount <= (mappingSize - header->tableOffset) / sizeof(VkuAssetPackTexture);
+
+    const VkuAssetPackTexture *textures = valid ? (const VkuAssetPackTexture *)((uint8_t *)mapping + header->tableOffset) : NULL;
+    for (uint32_t i = 0; valid && i < header->textureCount; i++)
+        valid = vkuAssetPackTextureValid(&textures[i], mappingSize);
+
+    if (!valid)
+    {
+        fprintf(stderr, "Invalid asset pack: %s\n", path);
+        munmap(mapping, mappingSize);
+        return NULL;
+    }
+
+    VkuAssetPack_T *pack = (VkuAssetPack_T *)calloc(1, sizeof(VkuAssetPack_T));
+    pack->mapping = (uint8_t *)mapping;
+    pack->mappingSize = mappingSize;
+    pack->header = header;
+    pack->textures = textures;
+
+    return pack;
+}
+
+void vkuCloseAssetPack(VkuAssetPack pack)
+{
+    munmap(pack->mapping, pack->mappingSize);
+    free(pack);
+}
+
+VkuTexture2D vkuAssetPackLoadTexture2D(VkuContext context, VkuAssetPack pack, const char *name)
+{
+    uint64_t nameHash = vkuHash64(name, strlen(name), 0);
+    const VkuAssetPackTexture *entry = NULL;
+
+    for (uint32_t i = 0; i < pack->header->textureCount; i++)
+    {
+        if (pack->textures[i].nameHash == nameHash && strcmp(pack->textures[i].name, name) == 0)
+        {
+            entry = &pack->textures[i];
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        fprintf(stderr, "Asset pack has no texture named: %s\n", name);
+        return NULL;
+    }
+
+    // Mip levels are stored back to back, so the whole chain is a single copy into staging.
+    uint64_t base = entry->mipOffsets[0];
+    uint64_t size = entry->mipOffsets[entry->mipLevels - 1] + entry->mipSizes[entry->mipLevels - 1] - base;
+
+    VkuBuffer stagingBuffer = vkuCreateBuffer(context->memoryManager, size, VKU_BUFFER_USAGE_CPU_TO_GPU);
+    vkuSetBufferData(context->memoryManager, stagingBuffer, (void *)(pack->mapping + base), size);
+
+    VkBufferImageCopy regions[VKU_ASSET_PACK_MAX_MIP_LEVELS] = {};
+    for (uint32_t mip = 0; mip < entry->mipLevels; mip++)
+    {
+        regions[mip].bufferOffset = entry->mipOffsets[mip] - base;
+        regions[mip].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[mip].imageSubresource.mipLevel = mip;
+        regions[mip].imageSubresource.baseArrayLayer = 0;
+        regions[mip].imageSubresource.layerCount = 1;
+        regions[mip].imageOffset = (VkOffset3D){0, 0, 0};
+        regions[mip].imageExtent = (VkExtent3D){(entry->width >> mip) > 0 ? (entry->width >> mip) : 1, (entry->height >> mip) > 0 ? (entry->height >> mip) : 1, 1};
+    }
+
+    VkuTexture2D_T *texture = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
+    texture->renderStage = NULL;
+    texture->renderStageColorImage = VK_FALSE;
+    texture->renderStageDepthImage = VK_FALSE;
+    texture->imageExtend.width = entry->width;
+    texture->imageExtend.height = entry->height;
+    texture->mipLevels = entry->mipLevels;
+
+    VkuVkImageCreateInfo imageInfo = {
+        .allocator = context->memoryManager->allocator,
+        .width = entry->width,
+        .height = entry->height,
+        .mipLevels = entry->mipLevels,
+        .arrayLayers = 1,
+        .format = (VkFormat)entry->format,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .numSamples = VK_SAMPLE_COUNT_1_BIT,
+        .pImage = &texture->textureImage,
+        .pImageAlloc = &texture->textureImageAllocation,
+        .pImageAllocInfo = NULL,
+    };
+
+    vkuCreateImage(&imageInfo);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture->textureImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = entry->mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    VkCommandBuffer commandBuffer = vkuBeginSingleTimeCommands(context->device, context->graphicsCmdPool);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->buffer, texture->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, entry->mipLevels, regions);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+    vkuEndAndSubmitSingleTimeCommands(context->device, context->graphicsCmdPool, context->graphicsQueue, commandBuffer);
+
+    vkuDestroyBuffer(stagingBuffer, context->memoryManager, VK_FALSE);
+
+    texture->textureImageView = vkuCreateImageView(texture->textureImage, (VkFormat)entry->format, VK_IMAGE_ASPECT_COLOR_BIT, entry->mipLevels, 1, context->device);
+    texture->bindlessIndex = vkuContextRegisterBindlessTexture(context, texture->textureImageView);
+
+    return texture;
+}
+
+// VkuTextureSampler
+
+VkuTextureSampler vkuCreateTextureSampler(VkuContext context, VkuTextureSamplerCreateInfo *createInfo)
+{
+    VkuTextureSampler_T *sampler = (VkuTextureSampler_T *)calloc(1, sizeof(VkuTextureSampler_T));
+
+    VkuSamplerCreateInfo samplerInfo = {
+        .minFilter = createInfo->minFilter,
+        .magFilter = createInfo->magFilter,
+        .repeatMode = createInfo->repeatMode,
+        .mipmapLevels = createInfo->mipmapLevels,
+        .physicalDevice = context->physicalDevice,
+        .device = context->device,
+        .maxAnisotropy = 16.0f,
+        .enableCompare = createInfo->enableCompare,
+        .compareOp = createInfo->compareOp,
+        .borderColor = createInfo->borderColor};
+
+    sampler->sampler = vkuCreateSampler(&samplerInfo);
+
+    return sampler;
+}
+
+void vkuDestroyTextureSampler(VkuContext context, VkuTextureSampler sampler)
+{
+    vkuDestroySampler(sampler->sampler, context->device);
+    free(sampler);
+}
+
+// VkuUniformBuffer
+
+VkuUniformBuffer vkuCreateUniformBuffer(VkuContext context, VkDeviceSize bufferSize, uint32_t count)
+{
+    if (bufferSize <= 0)
+        EXIT("VkuError: Invalid UniformBuffer size. must not be 0");
+
+    VkuUniformBuffer_T *uniBuffer = (VkuUniformBuffer_T *)calloc(1, sizeof(VkuUniformBuffer_T));
+    uniBuffer->bufferCount = count;
+    uniBuffer->bufferSize = bufferSize;
+
+    VkuUniformBuffersCreateInfo uniInfo = {
+        .ppUniformBuffer = &uniBuffer->uniformBuffer,
+        .ppUniformAllocations = &uniBuffer->uniformAllocs,
+        .pppMappedUniformMemory = &uniBuffer->mappedMemory,
+        .allocator = context->memoryManager->allocator,
+        .bufferSize = bufferSize,
+        .bufferCount = count,
+    };
+
+    vkuCreateUniformBuffers(&uniInfo);
+
+    return uniBuffer;
+}
+
+void vkuDestroyUniformBuffer(VkuContext context, VkuUniformBuffer uniformBuffer)
+{
+    vkuDestroyUniformBuffers(context->memoryManager->allocator, uniformBuffer->uniformBuffer, uniformBuffer->uniformAllocs, uniformBuffer->mappedMemory, uniformBuffer->bufferCount);
+    free(uniformBuffer);
+}
+
+void vkuUpdateUniformBuffer(VkuFrame frame, VkuUniformBuffer uniBuffer, void *data, uint32_t bufferIndex)
+{
+    memcpy(uniBuffer->mappedMemory[bufferIndex], data, uniBuffer->bufferSize);
+}
+
+
+// VkuDescriptorSet
+
+VkuDescriptorSet vkuCreateDescriptorSet(VkuDescriptorSetCreateInfo *createInfo)
+{
+    VkuDescriptorSet_T *set = (VkuDescriptorSet_T *)calloc(1, sizeof(VkuDescriptorSet_T));
+    set->renderStage = createInfo->renderStage;
+    set->context = createInfo->context;
+    set->setCount = createInfo->descriptorCount;
+
+    set->setLayout = vkuContextAcquireDescriptorSetLayout(set->context, createInfo->attributes, createInfo->attributeCount, 0, &set->updateTemplate);
+
+    VkDescriptorPoolSize poolSizes[VKU_DESCRIPTOR_TYPE_COUNT];
+    VkuDescriptorSetsCreateInfo setsInfo = {
+        .setCount = set->setCount,
+        .setLayout = set->setLayout,
+        .allocator = set->context->descriptorAllocator,
+        .pPool = &set->pool,
+        .device = set->context->device,
+        .pPoolSizes = poolSizes,
+        .poolSizeCount = vkuLayoutCacheGetPoolSizes(set->context->layoutCache, set->setLayout, set->setCount, poolSizes),
+    };
+
+    set->sets = vkuCreateDescriptorSets(&setsInfo);
+    set->attributeCount = createInfo->attributeCount;
+    set->attributes = (VkuDescriptorSetAttribute *)malloc(sizeof(VkuDescriptorSetAttribute) * (set->attributeCount > 0 ? set->attributeCount : 1) * set->setCount);
+
+    for (uint32_t i = 0; i < set->attributeCount; i++)
+    {
+        set->attributes[i].type = createInfo->attributes[i].type;
+        set->attributes[i].sampler = createInfo->attributes[i].sampler;
+        set->attributes[i].tex2D = createInfo->attributes[i].tex2D;
+        set->attributes[i].tex2DArray = createInfo->attributes[i].tex2DArray;
+        set->attributes[i].uniformBuffer = createInfo->attributes[i].uniformBuffer;
+        set->attributes[i].shaderStage = createInfo->attributes[i].shaderStage;
+        set->attributes[i].storageBuffer = createInfo->attributes[i].storageBuffer;
+        set->attributes[i].storageBufferRange = createInfo->attributes[i].storageBufferRange;
+        set->attributes[i].storageImage = createInfo->attributes[i].storageImage;
+        set->attributes[i].texelBufferView = createInfo->attributes[i].texelBufferView;
+
+        if (set->attributes[i].tex2D != NULL)
+            vkuDescriptorSetLinkRenderStage(set, set->attributes[i].tex2D->renderStage);
+    }
+
+    for (uint32_t i = 1; i < set->setCount; i++)
+        memcpy(&set->attributes[i * set->attributeCount], set->attributes, sizeof(VkuDescriptorSetAttribute) * set->attributeCount);
+
+    set->templateData = calloc((size_t)set->setCount * (set->attributeCount > 0 ? set->attributeCount : 1), sizeof(VkuDescriptorTemplateData));
+    VkuDescriptorTemplateData *templateData = (VkuDescriptorTemplateData *)set->templateData;
+
+    for (uint32_t i = 0; i < set->setCount && set->updateTemplate != VK_NULL_HANDLE; i++)
+    {
+        for (uint32_t j = 0; j < set->attributeCount; j++)
+            vkuFillDescriptorTemplateData(&templateData[i * set->attributeCount + j], &set->attributes[i * set->attributeCount + j], i);
+
+        vkUpdateDescriptorSetWithTemplate(set->context->device, set->sets[i], set->updateTemplate, &templateData[i * set->attributeCount]);
+    }
+
+    vkuDescriptorSetLinkRenderStage(set, set->renderStage);
+
+    return set;
+}
+
+void vkuDescriptorSetLinkRenderStage(VkuDescriptorSet set, VkuRenderStage renderStage)
+{
+    if (renderStage == NULL || renderStage->staticRenderStage == VK_TRUE)
+        return;
+
+    for (uint32_t i = 0; i < set->linkedRenderStageCount; i++)
+        if (set->linkedRenderStages[i] == renderStage)
+            return;
+
+    set->linkedRenderStages = (VkuRenderStage *)realloc(set->linkedRenderStages, sizeof(VkuRenderStage) * (set->linkedRenderStageCount + 1));
+    set->linkedRenderStages[set->linkedRenderStageCount++] = renderStage;
+    vkuObjectManagerAdd(renderStage->descriptorSetManager, (void *)set);
+}
+
+void vkuDescriptorSetUpdate(VkuDescriptorSet descriptorSet)
+{
+    VkuDescriptorTemplateData *templateData = (VkuDescriptorTemplateData *)descriptorSet->templateData;
+
+    for (uint32_t i = 0; i < descriptorSet->setCount && descriptorSet->updateTemplate != VK_NULL_HANDLE; i++)
+    {
+        VkBool32 changed = VK_FALSE;
+
+        // Only render stage outputs change their image view when the swapchain is resized.
+        for (uint32_t j = 0; j < descriptorSet->attributeCount; j++)
+        {
+            VkuDescriptorSetAttribute *attribute = &descriptorSet->attributes[i * descriptorSet->attributeCount + j];
+            if ((attribute->type != VKU_DESCRIPTOR_SET_ATTRIB_SAMPLER && attribute->type != VKU_DESCRIPTOR_SET_ATTRIB_SAMPLED_IMAGE) || attribute->tex2D == NULL || attribute->tex2D->renderStage == NULL)
+                continue;
+
+            vkuFillDescriptorTemplateData(&templateData[i * descriptorSet->attributeCount + j], attribute, i);
+            changed = VK_TRUE;
+        }
+
+        if (changed)
+            vkUpdateDescriptorSetWithTemplate(descriptorSet->context->device, descriptorSet->sets[i], descriptorSet->updateTemplate, &templateData[i * descriptorSet->attributeCount]);
     }
+}
 
-    vkuObjectManagerRemove(renderStage->presenter->renderStageManager, (void *)renderStage);
-    free(renderStage);
+void vkuDescriptorSetWrite(VkuDescriptorSet set, uint32_t frameIndex, uint32_t attribIndex, VkuDescriptorSetAttribute *resource)
+{
+    if (frameIndex >= set->setCount || attribIndex >= set->attributeCount)
+        EXIT("VkuError: vkuDescriptorSetWrite: Index out of range!\n");
+
+    VkuDescriptorSetAttribute *attribute = &set->attributes[frameIndex * set->attributeCount + attribIndex];
+    if (resource->type != attribute->type)
+        EXIT("VkuError: vkuDescriptorSetWrite: Resource type does not match the set layout!\n");
+
+    attribute->sampler = resource->sampler;
+    attribute->tex2D = resource->tex2D;
+    attribute->tex2DArray = resource->tex2DArray;
+    attribute->uniformBuffer = resource->uniformBuffer;
+    attribute->storageBuffer = resource->storageBuffer;
+    attribute->storageBufferRange = resource->storageBufferRange;
+    attribute->storageImage = resource->storageImage;
+    attribute->texelBufferView = resource->texelBufferView;
+
+    if (attribute->tex2D != NULL)
+        vkuDescriptorSetLinkRenderStage(set, attribute->tex2D->renderStage);
+
+    VkuDescriptorTemplateData *templateData = &((VkuDescriptorTemplateData *)set->templateData)[frameIndex * set->attributeCount];
+    vkuFillDescriptorTemplateData(&templateData[attribIndex], attribute, frameIndex);
+    vkUpdateDescriptorSetWithTemplate(set->context->device, set->sets[frameIndex], set->updateTemplate, templateData);
 }
 
-// VkuStaticRenderStage
+void vkuDestroyDescriptorSet(VkuDescriptorSet set)
+{
+    for (uint32_t i = 0; i < set->linkedRenderStageCount; i++)
+        vkuObjectManagerRemove(set->linkedRenderStages[i]->descriptorSetManager, (void *)set);
+    free(set->linkedRenderStages);
+    vkuDescriptorAllocatorFree(set->context->descriptorAllocator, set->context->device, set->pool, set->sets, set->setCount);
+    vkuDestroyDescriptorSets(set->sets);
+    vkuContextReleaseDescriptorSetLayout(set->context, set->setLayout);
+    free(set->templateData);
+    free(set->attributes);
+    free(set);
+}
 
-VkuRenderStage vkuCreateStaticRenderStage(VkuStaticRenderStageCreateInfo * createInfo)
+// VkuPipeline
+
+VkuPipeline vkuPreparePipeline(VkuContext context, VkuPipelineCreateInfo *createInfo)
 {
-    VkuRenderStage renderStage = (VkuRenderStage) calloc(1, sizeof(VkuRenderStage_T));
-    renderStage->context = createInfo->context;
-    renderStage->enableDepthTesting = createInfo->enableDepthTesting;
-    renderStage->extend.width = createInfo->width;
-    renderStage->extend.height = createInfo->height;
-    renderStage->sampleCount = createInfo->msaaSamples;
-    renderStage->options = createInfo->options;
-    renderStage->staticRenderStage = VK_TRUE;
-    renderStage->staticDepthArrayCount = createInfo->depthLayers;
-    
-    if ((renderStage->options & VKU_RENDER_OPTION_PRESENTER) == VKU_RENDER_OPTION_PRESENTER)
-        EXIT("VkuError: A VkuStaticRenderStage cant be created with VKU_RENDER_OPTION_PRESENTER option enabled!");
+    if (!createInfo->renderStage->enableDepthTesting && createInfo->depthTestEnable)
+        EXIT("VkuError: Pipeline Creation: RenderStage does not support DepthTesting!");
 
-    if (!renderStage->enableDepthTesting && (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE)
-        EXIT("VkuError: RenderStage is created with VKU_RENDER_OPTION_DEPTH_IMAGE option enabled, but enableDepthTesting is disabled!\n");
+    VkuPipeline_T *pipeline = (VkuPipeline_T *)calloc(1, sizeof(VkuPipeline_T));
+    if (!pipeline)
+    {
+        return NULL;
+    }
 
-    renderStage->pTargetColorImages = (VkImage *)calloc(1, sizeof(VkImage));
-    renderStage->pTargetColorImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
-    renderStage->pTargetColorImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
-    renderStage->pTargetDepthImages = (VkImage *)calloc(1, sizeof(VkImage));
-    renderStage->pTargetDepthImgViews = (VkImageView *)calloc(1, sizeof(VkImageView));
-    renderStage->pTargetDepthImgAllocs = (VmaAllocation *)calloc(1, sizeof(VmaAllocation));
+    memcpy(&pipeline->recreateInfo, createInfo, sizeof(VkuPipelineCreateInfo));
+
+    pipeline->renderStage = createInfo->renderStage;
 
-    if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE)
+    vkuCopySpecializationInfo(&pipeline->specializationInfo, createInfo->specializationEntries, createInfo->specializationEntryCount, createInfo->specializationData, createInfo->specializationDataSize);
+    pipeline->recreateInfo.specializationEntries = (VkSpecializationMapEntry *)pipeline->specializationInfo.pMapEntries;
+    pipeline->recreateInfo.specializationData = (void *)pipeline->specializationInfo.pData;
+
+    if (createInfo->descriptorSetCount > 0)
     {
-        VkuVkImageCreateInfo imageCreateInfo = {
-            .allocator = renderStage->context->memoryManager->allocator,
-            .width = renderStage->extend.width,
-            .height = renderStage->extend.height,
-            .mipLevels = 1,
-            .format = VK_FORMAT_B8G8R8A8_SRGB,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            .numSamples = VK_SAMPLE_COUNT_1_BIT,
-            .pImage = &(renderStage->pTargetColorImages[0]),
-            .pImageAlloc = &(renderStage->pTargetColorImgAllocs[0]),
-            .pImageAllocInfo = NULL,
-            .arrayLayers = 1
-        };
+        pipeline->descriptorSetCount = createInfo->descriptorSetCount;
+        for (uint32_t i = 0; i < createInfo->descriptorSetCount; i++)
+            pipeline->descriptorSets[i] = createInfo->descriptorSets[i];
+    }
+    else if (createInfo->descriptorSet != NULL)
+    {
+        pipeline->descriptorSetCount = 1;
+        pipeline->descriptorSets[0] = createInfo->descriptorSet;
+    }
 
-        vkuCreateImage(&imageCreateInfo);
-        renderStage->pTargetColorImgViews[0] = vkuCreateImageView(renderStage->pTargetColorImages[0], VK_FORMAT_B8G8R8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, renderStage->context->device);
+    pipeline->descriptorSet = pipeline->descriptorSets[0];
+
+    // Pipelines built from the same shaders share one copy of the SPIR-V.
+    pipeline->internalVertexSpirv = vkuContextAcquireShaderCode(context, createInfo->vertexShaderSpirV, createInfo->vertexShaderLength);
+    pipeline->internalFragmentSpirv = vkuContextAcquireShaderCode(context, createInfo->fragmentShaderSpirV, createInfo->fragmentShaderLength);
+
+    pipeline->vertexAttributes = (VkuVertexAttribute *)malloc(sizeof(VkuVertexAttribute) * createInfo->vertexLayout.attributeCount);
+    for (uint32_t i = 0; i < createInfo->vertexLayout.attributeCount; i++)
+        memcpy(&pipeline->vertexAttributes[i], &createInfo->vertexLayout.attributes[i], sizeof(VkuVertexAttribute));
+    pipeline->vertexLayout.attributeCount = createInfo->vertexLayout.attributeCount;
+    pipeline->vertexLayout.attributes = pipeline->vertexAttributes;
+    pipeline->vertexLayout.vertexSize = createInfo->vertexLayout.vertexSize;
+
+    VkDescriptorSetLayout *setLayouts = pipeline->setLayouts;
+    uint32_t setLayoutCount = 0;
+
+    if ((context->bindlessTable != NULL) + pipeline->descriptorSetCount + (createInfo->pushDescriptorAttributeCount > 0) > VKU_MAX_DESCRIPTOR_SETS)
+        EXIT("VkuError: Pipeline Creation: Too many descriptor sets!\n");
+
+    if (context->bindlessTable != NULL)
+        setLayouts[setLayoutCount++] = context->bindlessTable->setLayout;
+
+    pipeline->descriptorSetIndex = setLayoutCount;
+    for (uint32_t i = 0; i < pipeline->descriptorSetCount; i++)
+        setLayouts[setLayoutCount++] = pipeline->descriptorSets[i]->setLayout;
+
+    pipeline->pushDescriptorAttributeCount = createInfo->pushDescriptorAttributeCount;
+    pipeline->pushDescriptorSetIndex = setLayoutCount;
+    if (createInfo->pushDescriptorAttributeCount > 0)
+    {
+        if (context->vkCmdPushDescriptorSetKHR == NULL)
+            EXIT("VkuError: Pipeline Creation: Push descriptors are not supported by this device!\n");
+
+        // Kept for checking reloaded shaders against the layout.
+        pipeline->pushDescriptorAttributes = (VkuDescriptorSetAttribute *)malloc(sizeof(VkuDescriptorSetAttribute) * createInfo->pushDescriptorAttributeCount);
+        memcpy(pipeline->pushDescriptorAttributes, createInfo->pushDescriptorAttributes, sizeof(VkuDescriptorSetAttribute) * createInfo->pushDescriptorAttributeCount);
+        pipeline->recreateInfo.pushDescriptorAttributes = pipeline->pushDescriptorAttributes;
+
+        pipeline->pushDescriptorSetLayout = vkuContextAcquireDescriptorSetLayout(context, createInfo->pushDescriptorAttributes, createInfo->pushDescriptorAttributeCount, VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR, NULL);
+        setLayouts[setLayoutCount++] = pipeline->pushDescriptorSetLayout;
     }
 
-    if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE && renderStage->enableDepthTesting)
+    pipeline->pushConstantRangeCount = vkuResolvePushConstantRanges(context, pipeline->pushConstantRanges, createInfo->pushConstantRanges, createInfo->pushConstantRangeCount, VK_SHADER_STAGE_VERTEX_BIT);
+    pipeline->pushConstantHash = vkuHash64(pipeline->pushConstantRanges, sizeof(VkPushConstantRange) * pipeline->pushConstantRangeCount, 0);
+    pipeline->recreateInfo.pushConstantRanges = pipeline->pushConstantRanges;
+    pipeline->recreateInfo.pushConstantRangeCount = pipeline->pushConstantRangeCount;
+
+    // Blend state is resolved per color output of the render stage, a single state applies to every output.
+    uint32_t colorAttachmentCount = pipeline->renderStage->colorAttachmentCount;
+    if (createInfo->blendAttachmentCount > 0 && createInfo->blendAttachments == NULL)
+        EXIT("VkuError: Pipeline Creation: blendAttachmentCount is set, but blendAttachments is NULL!\n");
+    if (createInfo->blendAttachmentCount > 1 && createInfo->blendAttachmentCount != colorAttachmentCount)
+        EXIT("VkuError: Pipeline Creation: blendAttachmentCount doesn't match the color outputs of the RenderStage!\n");
+
+    for (uint32_t i = 0; i < colorAttachmentCount; i++)
     {
-        VkuVkImageCreateInfo imageCreateInfo = {
-            .allocator = renderStage->context->memoryManager->allocator,
-            .width = renderStage->extend.width,
-            .height = renderStage->extend.height,
-            .mipLevels = 1,
-            .format = VK_FORMAT_D32_SFLOAT,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            .numSamples = VK_SAMPLE_COUNT_1_BIT,
-            .pImage = &(renderStage->pTargetDepthImages[0]),
-            .pImageAlloc = &(renderStage->pTargetDepthImgAllocs[0]),
-            .pImageAllocInfo = NULL,
-            .arrayLayers = createInfo->depthLayers
-        };
+        if (createInfo->blendAttachmentCount == 0)
+        {
+            pipeline->blendAttachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            pipeline->blendAttachments[i].blendEnable = VK_FALSE;
+        }
+        else
+        {
+            pipeline->blendAttachments[i] = createInfo->blendAttachments[(createInfo->blendAttachmentCount == 1) ? 0 : i];
+        }
 
-        vkuCreateImage(&imageCreateInfo);
-        renderStage->pTargetDepthImgViews[0] = vkuCreateImageView(renderStage->pTargetDepthImages[0], VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1, createInfo->depthLayers, renderStage->context->device);
+        // Integer outputs (e.g. an R32_UINT id buffer in a G-buffer) can't blend, a broadcast state has to leave them out.
+        if (pipeline->blendAttachments[i].blendEnable)
+        {
+            VkFormatProperties formatProperties;
+            vkGetPhysicalDeviceFormatProperties(context->physicalDevice, pipeline->renderStage->colorAttachmentFormats[i], &formatProperties);
+            if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT) == 0)
+                EXIT("VkuError: Pipeline Creation: Blending is enabled for a color output whose format doesn't support blending!\n");
+        }
     }
+    pipeline->recreateInfo.blendAttachments = pipeline->blendAttachments;
+    pipeline->recreateInfo.blendAttachmentCount = colorAttachmentCount;
 
-    if (renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT && ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE))
+    pipeline->setLayoutCount = setLayoutCount;
+    pipeline->pipelineLayout = vkuContextAcquirePipelineLayout(context, setLayouts, setLayoutCount, pipeline->pushConstantRanges, pipeline->pushConstantRangeCount);
+
+    // With validation enabled the shaders are reflected and checked against the sets, ranges and vertex layout.
+    if (context->validation)
     {
-        VkuColorResourcesCreateInfo colorInfo = {
-            .format = VK_FORMAT_B8G8R8A8_SRGB,
-            .allocator = renderStage->context->memoryManager->allocator,
-            .extend = renderStage->extend,
-            .msaa_samples = renderStage->sampleCount,
-            .device = renderStage->context->device,
-        };
+        const char *spirvs[2] = {pipeline->internalVertexSpirv, pipeline->internalFragmentSpirv};
+        uint32_t lengths[2] = {createInfo->vertexShaderLength, createInfo->fragmentShaderLength};
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            const char *error = (spirvs[i] != NULL) ? vkuCheckPipelineShader(pipeline, spirvs[i], lengths[i]) : NULL;
+            if (error != NULL)
+            {
+                fprintf(stderr, "VkuError: %s\n", error);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    vkuPipelineAcquireVariant(pipeline);
+
+    if (pipeline->renderStage->staticRenderStage == VK_FALSE)
+        vkuObjectManagerAdd(pipeline->renderStage->pipelineManager, (void *)pipeline);
+
+    if (context->shaderWatcher != NULL)
+    {
+        vkuShaderWatcherAdd(context->shaderWatcher, createInfo->vertexShaderPath, pipeline, NULL, 0);
+        vkuShaderWatcherAdd(context->shaderWatcher, createInfo->fragmentShaderPath, pipeline, NULL, 1);
+    }
+
+    return pipeline;
+}
+
+// Exits on failure unless pResult is set, then VK_NULL_HANDLE is returned and the variant keeps no library parts.
+VkPipeline vkuPipelineCompile(VkuPipeline pipeline, VkPipelineCache pipelineCache, VkResult *pResult)
+{
+    VkuGraphicsPipelineCreateInfo pipelineCreateInfo = {
+        .device = pipeline->renderStage->context->device,
+        .pipelineCache = pipelineCache,
+        .vertexShaderSpirv = pipeline->internalVertexSpirv,
+        .vertexShaderLength = pipeline->recreateInfo.vertexShaderLength,
+        .vertexShaderModule = vkuContextGetShaderModule(pipeline->renderStage->context, pipeline->internalVertexSpirv),
+        .fragmentShaderSpirv = pipeline->internalFragmentSpirv,
+        .fragmentShaderLength = pipeline->recreateInfo.fragmentShaderLength,
+        .fragmentShaderModule = vkuContextGetShaderModule(pipeline->renderStage->context, pipeline->internalFragmentSpirv),
+        .specializationInfo = (pipeline->specializationInfo.mapEntryCount > 0) ? &pipeline->specializationInfo : NULL,
+        .vertexInputLayout = pipeline->vertexLayout,
+        .extendedDynamicState = pipeline->renderStage->context->extendedDynamicState,
+        .dynamicPolygonMode = pipeline->renderStage->context->dynamicPolygonMode,
+ 
+        .swapchainExtend = (pipeline->renderStage->staticRenderStage == VK_FALSE) ? pipeline->renderStage->presenter->swapchainExtend : pipeline->renderStage->extend,
+        .polygonMode = pipeline->recreateInfo.polygonMode,
+        .pipelineLayout = pipeline->pipelineLayout,
+        .renderPass = pipeline->renderStage->renderPass,
+        .colorAttachmentCount = pipeline->renderStage->colorAttachmentCount,
+        .colorAttachmentFormats = pipeline->renderStage->colorAttachmentFormats,
+        .blendAttachments = pipeline->blendAttachments,
+        .depthAttachmentFormat = pipeline->renderStage->enableDepthTesting ? vkuFindDepthFormat(pipeline->renderStage->context->physicalDevice) : VK_FORMAT_UNDEFINED,
+        .msaaSamples = pipeline->renderStage->sampleCount,
+        .depth_test_write = pipeline->recreateInfo.depthTestWrite,
+        .depth_test_enable = pipeline->recreateInfo.depthTestEnable,
+        .depth_compare_mode = pipeline->recreateInfo.depthCompareMode,
+        .cullMode = pipeline->recreateInfo.cullMode,
+        .enableDepthBias = pipeline->recreateInfo.enableDepthBias,
+        .depthBiasConstantFactor = pipeline->recreateInfo.depthBiasConstantFactor,
+        .depthBiasSlopeFactor = pipeline->recreateInfo.depthBiasSlopeFactor,
+        .topology = pipeline->recreateInfo.topology,
+        .pResult = pResult};
+
+    VkuContext context = pipeline->renderStage->context;
+    if (!context->graphicsPipelineLibrary)
+        return vkuCreateGraphicsPipeline(&pipelineCreateInfo);
+
+    // The parts are cached on their own, so a new combination usually only needs a fast link. The optimized link
+    // follows in the background.
+    // A variant holds its parts for its whole lifetime, so a repeated compile links them again without taking new
+    // references or queueing a second optimized link.
+    VkuPipelineVariant variant = pipeline->variant;
+    VkBool32 acquireLibraries = variant->libraries[0] == NULL;
+    VkPipeline libraries[VKU_PIPELINE_LIBRARY_PART_COUNT];
+    VkPipeline linkedPipeline = VK_NULL_HANDLE;
+    uint32_t libraryCount = 0;
+    for (; libraryCount < VKU_PIPELINE_LIBRARY_PART_COUNT; libraryCount++)
+    {
+        if (acquireLibraries)
+            variant->libraries[libraryCount] = vkuPipelineAcquireLibrary(pipeline, &pipelineCreateInfo, 1u << libraryCount);
+        if (variant->libraries[libraryCount] == NULL)
+            break;
+        libraries[libraryCount] = variant->libraries[libraryCount]->pipeline;
+    }
+
+    if (libraryCount == VKU_PIPELINE_LIBRARY_PART_COUNT)
+        linkedPipeline = vkuLinkGraphicsPipeline(context->device, pipelineCache, pipeline->pipelineLayout, libraries, VK_FALSE, pResult);
+
+    if (acquireLibraries && linkedPipeline != VK_NULL_HANDLE)
+    {
+        vkuContextQueuePipelineOptimization(context, variant);
+    }
+    else if (acquireLibraries)
+    {
+        // A failed compile gives its parts back, the next attempt acquires them again and queues the optimized link.
+        VkuPipelineVariantCache cache = context->pipelineVariantCache;
+        pthread_mutex_lock(&cache->lock);
+        for (uint32_t i = 0; i < libraryCount; i++)
+        {
+            vkuPipelineVariantCacheReleaseLibrary(cache, context->device, variant->libraries[i]);
+            variant->libraries[i] = NULL;
+        }
+        pthread_mutex_unlock(&cache->lock);
+    }
+
+    return linkedPipeline;
+}
+
+VkuPipelineVariant vkuPipelineAcquireLibrary(VkuPipeline pipeline, VkuGraphicsPipelineCreateInfo *createInfo, VkGraphicsPipelineLibraryFlagsEXT part)
+{
+    VkuContext context = pipeline->renderStage->context;
+    VkuPipelineVariantCache cache = context->pipelineVariantCache;
+    VkuPipelineVariantKey *variantKey = (VkuPipelineVariantKey *)pipeline->variant->key;
+
+    // Library keys are variant keys reduced to the state of their part. Only the vertex input depends on attributes,
+    // only the shader parts on the specialization constants.
+    size_t attributesSize = sizeof(VkuVertexAttribute) * variantKey->attributeCount;
+    size_t specializationSize = pipeline->variant->keySize - sizeof(VkuPipelineVariantKey) - attributesSize;
+    VkBool32 shaderPart = part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT || part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+
+    size_t keySize = sizeof(VkuPipelineVariantKey);
+    if (part == VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+        keySize += attributesSize;
+    if (shaderPart)
+        keySize += specializationSize;
+
+    VkuPipelineVariantKey *key = (VkuPipelineVariantKey *)calloc(1, keySize);
+    key->libraryPart = part;
+
+    if (shaderPart)
+    {
+        key->specializationEntryCount = variantKey->specializationEntryCount;
+        key->specializationDataSize = variantKey->specializationDataSize;
+        memcpy(key->attributes, (uint8_t *)variantKey->attributes + attributesSize, specializationSize);
+    }
+
+    if (part == VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+    {
+        key->topology = variantKey->topology;
+        key->vertexSize = variantKey->vertexSize;
+        key->attributeCount = variantKey->attributeCount;
+        for (uint32_t i = 0; i < key->attributeCount; i++)
+            key->attributes[i] = variantKey->attributes[i];
+    }
+    else
+    {
+        key->pipelineLayout = variantKey->pipelineLayout;
+        key->renderPassFormat = variantKey->renderPassFormat;
+        key->sampleCount = variantKey->sampleCount;
+        key->options = variantKey->options;
+        key->enableDepthTesting = variantKey->enableDepthTesting;
+        key->staticRenderStage = variantKey->staticRenderStage;
+        key->dynamicRendering = variantKey->dynamicRendering;
+        key->colorAttachmentCount = variantKey->colorAttachmentCount;
+        memcpy(key->colorAttachmentFormats, variantKey->colorAttachmentFormats, sizeof(key->colorAttachmentFormats));
+    }
+
+    if (part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+    {
+        key->vertexSpirv = variantKey->vertexSpirv;
+        key->polygonMode = variantKey->polygonMode;
+        key->cullMode = variantKey->cullMode;
+        key->enableDepthBias = variantKey->enableDepthBias;
+        key->depthBiasConstantFactor = variantKey->depthBiasConstantFactor;
+        key->depthBiasSlopeFactor = variantKey->depthBiasSlopeFactor;
+    }
+    else if (part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+    {
+        key->fragmentSpirv = variantKey->fragmentSpirv;
+        key->depthTestWrite = variantKey->depthTestWrite;
+        key->depthTestEnable = variantKey->depthTestEnable;
+        key->depthCompareMode = variantKey->depthCompareMode;
+    }
+    else if (part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+    {
+        key->fragmentOutput = variantKey->fragmentSpirv != NULL;
+        memcpy(key->blendAttachments, variantKey->blendAttachments, sizeof(key->blendAttachments));
+    }
+
+    uint64_t hash = vkuHash64(key, keySize, 0);
+
+    pthread_mutex_lock(&cache->lock);
+    VkuPipelineVariant library = vkuFindPipelineVariant(cache->libraries, cache->libraryCount, hash, key, keySize);
+    if (library != NULL)
+        library->refCount++;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (library != NULL)
+    {
+        free(key);
+        return library;
+    }
 
-        renderStage->colorResource = vkuCreateColorResources(&colorInfo);
+    // Compiled outside the lock, a concurrent compile of the same part simply loses below.
+    VkPipeline libraryPipeline = vkuCreateGraphicsPipelineLibrary(createInfo, part);
+    if (libraryPipeline == VK_NULL_HANDLE)
+    {
+        free(key);
+        return NULL;
     }
 
-    if ((renderStage->sampleCount != VK_SAMPLE_COUNT_1_BIT || (renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) != VKU_RENDER_OPTION_DEPTH_IMAGE) && renderStage->enableDepthTesting)
+    pthread_mutex_lock(&cache->lock);
+
+    library = vkuFindPipelineVariant(cache->libraries, cache->libraryCount, hash, key, keySize);
+    if (library == NULL)
     {
-        VkuDepthResourcesCreateInfo depthInfo = {
-            .physical_device = renderStage->context->physicalDevice,
-            .device = renderStage->context->device,
-            .allocator = renderStage->context->memoryManager->allocator,
-            .extend = renderStage->extend,
-            .msaa_samples = renderStage->sampleCount,
-            .layerCount = 1
-        };
+        if (cache->libraryCount == cache->libraryCapacity)
+        {
+            cache->libraryCapacity = (cache->libraryCapacity == 0) ? 16 : cache->libraryCapacity * 2;
+            cache->libraries = (VkuPipelineVariant *)realloc(cache->libraries, sizeof(VkuPipelineVariant) * cache->libraryCapacity);
+        }
 
-        renderStage->depthResource = vkuCreateDepthResources(&depthInfo);
+        library = (VkuPipelineVariant_T *)calloc(1, sizeof(VkuPipelineVariant_T));
+        library->hash = hash;
+        library->key = key;
+        library->keySize = keySize;
+        library->pipeline = libraryPipeline;
+        cache->libraries[cache->libraryCount++] = library;
+        key = NULL;
+        libraryPipeline = VK_NULL_HANDLE;
     }
 
-    VkuVkRenderPassCreateInfo renderPassCreateInfo = {
-        .format = VK_FORMAT_B8G8R8A8_SRGB,
-        .msaaSamples = renderStage->sampleCount,
-        .physicalDevice = renderStage->context->physicalDevice,
-        .device = renderStage->context->device,
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .presentationLayout = VK_FALSE,
-    };
+    library->refCount++;
 
-    renderStage->renderPass = vkuCreateVkRenderPass(&renderPassCreateInfo);
-
-    VkuVkFramebufferCreateInfo frameBufferCreateInfo = {
-        .imageCount = 1,
-        .msaaSamples = renderStage->sampleCount,
-        .renderStageColorImageView = (renderStage->colorResource) ? renderStage->colorResource->imageView : VK_NULL_HANDLE,
-        .renderStageDepthImageView = (renderStage->depthResource) ? renderStage->depthResource->imageView : VK_NULL_HANDLE,
-        .renderTargetColorImageViews = renderStage->pTargetColorImgViews,
-        .renderTargetDepthImageViews = renderStage->pTargetDepthImgViews,
-        .renderPass = renderStage->renderPass,
-        .extend = renderStage->extend,
-        .device = renderStage->context->device,
-        .enableTargetColorImage = ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE) == VKU_RENDER_OPTION_COLOR_IMAGE),
-        .enableTargetDepthImage = ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE),
-        .enableDepthTest = renderStage->enableDepthTesting,
-        .layerCount = createInfo->depthLayers};
-
-    renderStage->framebuffers = vkuCreateVkFramebuffer(&frameBufferCreateInfo);
+    pthread_mutex_unlock(&cache->lock);
 
-    return renderStage;
+    if (libraryPipeline != VK_NULL_HANDLE)
+        vkuDestroyVkPipeline(context->device, libraryPipeline);
+    free(key);
+    return library;
 }
 
-void vkuDestroyStaticRenderStage(VkuRenderStage renderStage)
+// Reflects one shader stage and checks it against the pipeline's sets, ranges and vertex layout. Returns the first
+// mismatch or NULL.
+const char *vkuCheckPipelineShader(VkuPipeline pipeline, const char *spirv, uint32_t length)
 {
-    if (renderStage->staticRenderStage == VK_FALSE)
-        EXIT("VkuError: Trying to destroy a VkuRenderStage with vkuDestroyStaticRenderStage()!\n"); 
+    const char *error = NULL;
+    VkuShaderReflection reflection = vkuTryCreateShaderReflection(spirv, length, &error);
+    if (reflection == NULL)
+        return error;
 
-    vkDeviceWaitIdle(renderStage->context->device);
+    error = vkuCheckShaderReflection(reflection, pipeline->descriptorSets, pipeline->descriptorSetIndex, pipeline->descriptorSetCount, pipeline->pushDescriptorAttributes, pipeline->pushDescriptorAttributeCount, pipeline->pushConstantRanges, pipeline->pushConstantRangeCount);
 
-    vkuDestroyFramebuffer(renderStage->context->device, renderStage->framebuffers, 1);
-    vkuDestroyVkRenderPass(renderStage->context->device, renderStage->renderPass);
+    for (uint32_t i = 0; i < reflection->inputLocationCount && error == NULL; i++)
+        if (reflection->inputLocations[i] >= pipeline->vertexLayout.attributeCount)
+            error = "Shader Reflection: Vertex shader input location isn't provided by the vertex layout!";
 
-    if (renderStage->colorResource != NULL)
-    {
-        vkuDestroyColorResources(renderStage->context->memoryManager->allocator, renderStage->context->device, renderStage->colorResource);
-    }
+    vkuDestroyShaderReflection(reflection);
+    return error;
+}
 
-    if (renderStage->depthResource != NULL)
+void vkuPipelineAcquireVariant(VkuPipeline pipeline)
+{
+    VkuContext context = pipeline->renderStage->context;
+    pipeline->variant = vkuContextAcquirePipelineVariant(context, pipeline);
+
+    // A shared variant may be compiling on another thread right now. Stays VK_NULL_HANDLE until the variant is
+    // compiled by vkuPipelineCompileVariant or a batch.
+    pipeline->graphicsPipeline = vkuPipelineVariantWait(context, pipeline->variant);
+}
+
+void vkuPipelineCompileVariant(VkuPipeline pipeline)
+{
+    VkuContext context = pipeline->renderStage->context;
+
+    if (vkuPipelineVariantBeginCompile(context, pipeline->variant))
     {
-        vkuDestroyDepthResources(renderStage->context->memoryManager->allocator, renderStage->context->device, renderStage->depthResource);
+        pthread_rwlock_rdlock(&context->pipelineCacheLock);
+        VkPipeline compiled = vkuPipelineCompile(pipeline, context->pipelineCache, NULL);
+        pthread_rwlock_unlock(&context->pipelineCacheLock);
+        vkuPipelineVariantEndCompile(context, pipeline->variant, compiled);
     }
 
-    if (renderStage->pTargetColorImgViews[0] != NULL)
-    {
-        vkuDestroyImage(renderStage->pTargetColorImages[0], renderStage->pTargetColorImgAllocs[0], renderStage->context->memoryManager->allocator);
-        vkuDestroyImageView(renderStage->pTargetColorImgViews[0], renderStage->context->device);
+    pipeline->graphicsPipeline = vkuPipelineVariantWait(context, pipeline->variant);
+}
+
+VkuPipeline vkuCreatePipeline(VkuContext context, VkuPipelineCreateInfo *createInfo)
+{
+    VkuPipeline pipeline = vkuPreparePipeline(context, createInfo);
+    vkuPipelineCompileVariant(pipeline);
+    return pipeline;
+}
+
+void vkuPipelineUpdate(VkuPipeline pipeline)
+{
+    // The render pass changed, so the pipeline moves to the variant matching the new one.
+    vkuContextReleasePipelineVariant(pipeline->renderStage->context, pipeline->variant);
+    vkuPipelineAcquireVariant(pipeline);
+    vkuPipelineCompileVariant(pipeline);
+}
+
+void vkuDestroyPipeline(VkuContext context, VkuPipeline pipeline)
+{
+    vkDeviceWaitIdle(context->device);
+
+    if (context->shaderWatcher != NULL)
+        vkuShaderWatcherRemove(context->shaderWatcher, pipeline);
+
+    vkuObjectManagerRemove(pipeline->renderStage->pipelineManager, (void *)pipeline);
+
+    vkuContextReleasePipelineVariant(context, pipeline->variant);
+    vkuContextReleaseShaderCode(context, pipeline->internalVertexSpirv);
+    vkuContextReleaseShaderCode(context, pipeline->internalFragmentSpirv);
+
+    free(pipeline->vertexAttributes);
+    free(pipeline->pushDescriptorAttributes);
+    vkuFreeSpecializationInfo(&pipeline->specializationInfo);
+    vkuContextReleasePipelineLayout(context, pipeline->pipelineLayout);
+    if (pipeline->pushDescriptorSetLayout != VK_NULL_HANDLE)
+        vkuContextReleaseDescriptorSetLayout(context, pipeline->pushDescriptorSetLayout);
+    free(pipeline);
+}
+
+VkuComputeExecutor vkuCreateComputeExecutor(VkuContext context, uint32_t framesInFlight) {
+    VkuComputeExecutor executor = calloc(1, sizeof(VkuComputeExecutor_T));
+    executor->currentFrame = 0;
+    executor->context = context;
+    executor->framesInFlight = framesInFlight;
+    executor->computeFinishedSemaphores = malloc(sizeof(VkSemaphore) * framesInFlight);
+    executor->computeInFlightFences = malloc(sizeof(VkFence) *framesInFlight);
+    executor->computeCommandBuffers = malloc(sizeof(VkCommandBuffer) *framesInFlight);
+    executor->activeComputeRun = malloc(sizeof(VkuComputeRun_T));
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (size_t i = 0; i < framesInFlight; i++) {
+        VK_CHECK(vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &(executor->computeFinishedSemaphores[i])));
+        VK_CHECK(vkCreateFence(context->device, &fenceInfo, NULL, &(executor->computeInFlightFences[i])));
     }
 
-    if (renderStage->pTargetDepthImgViews[0] != NULL)
-    {
-        vkuDestroyImage(renderStage->pTargetDepthImages[0], renderStage->pTargetDepthImgAllocs[0], renderStage->context->memoryManager->allocator);
-        vkuDestroyImageView(renderStage->pTargetDepthImgViews[0], renderStage->context->device);
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = context->computeCmdPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = (uint32_t) framesInFlight;
+
+    VK_CHECK(vkAllocateCommandBuffers(context->device, &allocInfo, executor->computeCommandBuffers));
+
+    return executor;
+}
+
+void vkuDestroyComputeExecutor(VkuComputeExecutor computeExecutor) {
+    vkWaitForFences(computeExecutor->context->device, computeExecutor->framesInFlight, computeExecutor->computeInFlightFences, VK_TRUE, UINT64_MAX);
+    vkuShaderWatcherRemoveOwner(computeExecutor->context->shaderWatcher, computeExecutor);
+
+    for (size_t i = 0; i < computeExecutor->framesInFlight; i++) {
+        vkDestroySemaphore(computeExecutor->context->device, computeExecutor->computeFinishedSemaphores[i], NULL);
+        vkDestroyFence(computeExecutor->context->device, computeExecutor->computeInFlightFences[i], NULL);
     }
 
-    free(renderStage->pTargetColorImages);
-    free(renderStage->pTargetColorImgAllocs);
-    free(renderStage->pTargetColorImgViews);
-    free(renderStage->pTargetDepthImages);
-    free(renderStage->pTargetDepthImgAllocs);
-    free(renderStage->pTargetDepthImgViews);
+    free(computeExecutor->activeComputeRun);
+    free(computeExecutor->computeCommandBuffers);
+    free(computeExecutor->computeFinishedSemaphores);
+    free(computeExecutor->computeInFlightFences);
+    free(computeExecutor);
+}
 
-    free(renderStage);
+VkuComputeRun vkuComputeExecutorStartRun(VkuComputeExecutor executor) {
+    if (executor->activeRun)
+        EXIT("VkuError: Only one VkuComputeRun can be active at the same time!");
+    executor->activeRun = VK_TRUE;
+
+
+    VkuComputeRun run = executor->activeComputeRun;
+    memset(run, 0, sizeof(VkuComputeRun_T));
+    run->executor = executor;
+
+    vkWaitForFences(executor->context->device, 1, &executor->computeInFlightFences[executor->currentFrame], VK_TRUE, UINT64_MAX);
+    vkuShaderWatcherFrameBoundary(executor->context->shaderWatcher, executor, executor->framesInFlight, true);
+    vkResetFences(executor->context->device, 1, &executor->computeInFlightFences[executor->currentFrame]);
+    vkResetCommandBuffer(executor->computeCommandBuffers[executor->currentFrame], 0);
+
+    VkCommandBufferBeginInfo beginInfo= {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    VK_CHECK(vkBeginCommandBuffer(executor->computeCommandBuffers[executor->currentFrame], &beginInfo));
+
+    return run;
 }
 
-void vkuRenderStageSetMSAA(VkuRenderStage renderStage, VkSampleCountFlagBits msaaFlags)
-{
-    if (renderStage->staticRenderStage == VK_FALSE)
-    {
-        renderStage->sampleCount = msaaFlags;
-        vkuRenderStageUpdate(renderStage);
+void vkuComputeExecutorFinishRun(VkuComputeRun computeRun, VkBool32 enableFrameSyncronization) {
+    VK_CHECK(vkEndCommandBuffer(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame]));
 
-        for (uint32_t i = 0; i < renderStage->presenter->renderStageManager->elemCnt; i++)
-        {
-            vkuRenderStageUpdate((VkuRenderStage) renderStage->presenter->renderStageManager->elements[i]);
-        }
-    } else {
-        EXIT("VkuError: vkuRenderStageSetMSAA() cant be used with a static VkuRenderStage!\n");
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame];
+
+    if (enableFrameSyncronization) {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &computeRun->executor->computeFinishedSemaphores[computeRun->executor->currentFrame];
     }
+
+    VK_CHECK(vkQueueSubmit(computeRun->executor->context->computeQueue, 1, &submitInfo, computeRun->executor->computeInFlightFences[computeRun->executor->currentFrame]));
+
+    computeRun->lastFrame = computeRun->executor->currentFrame;
+    computeRun->executor->currentFrame = (computeRun->executor->currentFrame + 1) % computeRun->executor->framesInFlight;
+
+    computeRun->executor->activeRun = false;
 }
 
-// VkuFrame
+void vkuComputeRunBindComputePipeline(VkuComputeRun computeRun, VkuComputePipeline pipeline, uint32_t dynamicOffsetCount, uint32_t * dynamicOffsets) {
+    vkCmdBindPipeline(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->computePipeline);
 
-VkuFrame vkuPresenterBeginFrame(VkuPresenter presenter)
-{
-    if (presenter->activeFrame)
-        EXIT("VkuError: Only One Frame can be active at a time!\n");
-    else
-        presenter->activeFrame = VK_TRUE;
+    if (pipeline->descriptorSetCount == 0)
+        return;
 
-    VkuFrame_T *frame = (VkuFrame_T *)calloc(1, sizeof(VkuFrame_T));
+    VkDescriptorSet sets[VKU_MAX_DESCRIPTOR_SETS];
+    for (uint32_t i = 0; i < pipeline->descriptorSetCount; i++)
+        sets[i] = pipeline->descriptorSets[i]->sets[computeRun->executor->currentFrame];
 
-    frame->presenter = presenter;
+    vkCmdBindDescriptorSets(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, pipeline->descriptorSetCount, sets, dynamicOffsetCount, dynamicOffsets);
+}
 
-    int currentFrame = frame->presenter->currentFrame;
-    VkuContext context = presenter->context;
+void vkuComputeRunPushConstant(VkuComputeRun computeRun, VkuComputePipeline pipeline, void *data, size_t size) {
+    VkShaderStageFlags stageFlags = vkuGetPushConstantStages(pipeline->pushConstantRanges, pipeline->pushConstantRangeCount, 0, size);
+    vkCmdPushConstants(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], pipeline->pipelineLayout, stageFlags, 0, (uint32_t)size, data);
+}
 
-    vkWaitForFences(context->device, 1, &frame->presenter->inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-    uint32_t imageIndex = 0;
+void vkuComputeRunDispatch(VkuComputeRun computeRun, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    vkCmdDispatch(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], groupCountX, groupCountY, groupCountZ);
+}
 
-    VkResult result = vkAcquireNextImageKHR(context->device, frame->presenter->swapchain, UINT64_MAX, frame->presenter->imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+void vkuComputeRunUpdateUniformBuffer(VkuComputeRun computeRun, VkuUniformBuffer uniBuffer, void *data)
+{
+    memcpy(uniBuffer->mappedMemory[computeRun->executor->currentFrame], data, uniBuffer->bufferSize);
+}
+
+VkuComputePipeline vkuPrepareComputePipeline(VkuContext context, VkuComputePipelineCreateInfo *createInfo) {
+    VkuComputePipeline_T *pipeline = (VkuComputePipeline_T *)calloc(1, sizeof(VkuComputePipeline_T));
+
+    if (createInfo->descriptorSetCount > VKU_MAX_DESCRIPTOR_SETS)
+        EXIT("VkuError: Compute Pipeline Creation: Too many descriptor sets!\n");
+
+    if (createInfo->descriptorSetCount > 0)
     {
-        vkuPresenterRecreate(presenter);
-        presenter->window->window_resized = false;
-        return vkuPresenterBeginFrame(presenter);
+        pipeline->descriptorSetCount = createInfo->descriptorSetCount;
+        for (uint32_t i = 0; i < createInfo->descriptorSetCount; i++)
+            pipeline->descriptorSets[i] = createInfo->descriptorSets[i];
     }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    else if (createInfo->descriptorSet != NULL)
     {
-        EXIT("failed to acquire swap chain image!");
+        pipeline->descriptorSetCount = 1;
+        pipeline->descriptorSets[0] = createInfo->descriptorSet;
     }
 
-    vkResetFences(context->device, 1, &frame->presenter->inFlightFences[currentFrame]);
+    pipeline->descriptorSet = pipeline->descriptorSets[0];
+    pipeline->internalComputeSpirv = vkuContextAcquireShaderCode(context, createInfo->computeShaderSpirV, createInfo->computeShaderLength);
+    pipeline->computeShaderLength = createInfo->computeShaderLength;
+    vkuCopySpecializationInfo(&pipeline->specializationInfo, createInfo->specializationEntries, createInfo->specializationEntryCount, createInfo->specializationData, createInfo->specializationDataSize);
 
-    vkResetCommandBuffer(frame->presenter->cmdBuffer[currentFrame], 0);
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    VK_CHECK(vkBeginCommandBuffer(frame->presenter->cmdBuffer[currentFrame], &beginInfo));
+    VkDescriptorSetLayout setLayouts[VKU_MAX_DESCRIPTOR_SETS];
+    for (uint32_t i = 0; i < pipeline->descriptorSetCount; i++)
+        setLayouts[i] = pipeline->descriptorSets[i]->setLayout;
 
-    frame->imageIndex = imageIndex;
-    frame->cmdBuffer = frame->presenter->cmdBuffer[currentFrame];
-    frame->activeRenderStage = false;
+    VkuShaderReflection reflection = vkuCreateShaderReflection(pipeline->internalComputeSpirv, pipeline->computeShaderLength);
+    vkuResolveShaderLocalSize(reflection, &pipeline->specializationInfo, pipeline->localSize);
 
-    return frame;
+    // Without explicit ranges the layout gets exactly the push constant block the kernel declares.
+    VkPushConstantRange reflectedRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, (reflection->pushConstantSize + 3) & ~3u};
+    if (createInfo->pushConstantRangeCount > 0)
+        pipeline->pushConstantRangeCount = vkuResolvePushConstantRanges(context, pipeline->pushConstantRanges, createInfo->pushConstantRanges, createInfo->pushConstantRangeCount, VK_SHADER_STAGE_COMPUTE_BIT);
+    else if (reflectedRange.size > 0)
+        pipeline->pushConstantRangeCount = vkuResolvePushConstantRanges(context, pipeline->pushConstantRanges, &reflectedRange, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    if (context->validation)
+        vkuValidateShaderReflection(reflection, pipeline->descriptorSets, 0, pipeline->descriptorSetCount, NULL, 0, pipeline->pushConstantRanges, pipeline->pushConstantRangeCount);
+    vkuDestroyShaderReflection(reflection);
+
+    pipeline->pipelineLayout = vkuContextAcquirePipelineLayout(context, setLayouts, pipeline->descriptorSetCount, pipeline->pushConstantRanges, pipeline->pushConstantRangeCount);
+
+    if (context->shaderWatcher != NULL)
+        vkuShaderWatcherAdd(context->shaderWatcher, createInfo->computeShaderPath, NULL, pipeline, 0);
+
+    return pipeline;
 }
 
-void vkuPresenterSubmitFrame(VkuFrame frame, VkuComputeRun syncComputeRun)
-{
-    int currentFrame = frame->presenter->currentFrame;
-    int imageIndex = frame->imageIndex;
+VkPipeline vkuComputePipelineCompile(VkuContext context, VkuComputePipeline pipeline, VkPipelineCache pipelineCache, VkResult *pResult) {
+    VkuComputeVkPipelineCreateInfo computePipelineCreateInfo = {
+        .computeShaderLength = pipeline->computeShaderLength,
+        .computeShaderSpirv = pipeline->internalComputeSpirv,
+        .computeShaderModule = vkuContextGetShaderModule(context, pipeline->internalComputeSpirv),
+        .specializationInfo = (pipeline->specializationInfo.mapEntryCount > 0) ? &pipeline->specializationInfo : NULL,
+        .device = context->device,
+        .pipelineCache = pipelineCache,
+        .pipelineLayout = pipeline->pipelineLayout,
+        .pResult = pResult
+    };
 
-    VK_CHECK(vkEndCommandBuffer(frame->presenter->cmdBuffer[currentFrame]));
+    return vkuCreateComputeVkPipeline(&computePipelineCreateInfo);
+}
 
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+VkuComputePipeline vkuCreateComputePipeline(VkuContext context, VkuComputePipelineCreateInfo *createInfo) {
+    VkuComputePipeline pipeline = vkuPrepareComputePipeline(context, createInfo);
+    pthread_rwlock_rdlock(&context->pipelineCacheLock);
+    pipeline->computePipeline = vkuComputePipelineCompile(context, pipeline, context->pipelineCache, NULL);
+    pthread_rwlock_unlock(&context->pipelineCacheLock);
+    return pipeline;
+}
 
-    VkSemaphore waitSemaphores[2] = {frame->presenter->imageAvailableSemaphores[currentFrame]};
-    VkPipelineStageFlags waitStages[2] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+void vkuDestroyComputePipeline(VkuContext context, VkuComputePipeline computePipeline) {
+    if (context->shaderWatcher != NULL)
+        vkuShaderWatcherRemove(context->shaderWatcher, computePipeline);
 
-    if (syncComputeRun != NULL) {
-        waitSemaphores[1] = syncComputeRun->executor->computeFinishedSemaphores[syncComputeRun->lastFrame];
-        waitStages[1] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-        submitInfo.waitSemaphoreCount = 2;
-    }
+    vkuDestroyVkPipeline(context->device, computePipeline->computePipeline);
+    vkuContextReleasePipelineLayout(context, computePipeline->pipelineLayout);
+    vkuContextReleaseShaderCode(context, computePipeline->internalComputeSpirv);
+    vkuFreeSpecializationInfo(&computePipeline->specializationInfo);
+    free(computePipeline);
+}
 
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &(frame->presenter->cmdBuffer)[currentFrame];
+// VkuPipelineBatch
+
+void vkuContextWaitPipelineBatches(VkuContext context)
+{
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    while (context->pipelineBatchesInFlight > 0)
+        pthread_cond_wait(&context->pipelineBatchCond, &context->pipelineBatchLock);
+    pthread_mutex_unlock(&context->pipelineBatchLock);
+}
+
+void *vkuPipelineBatchWorkerRun(void *arg)
+{
+    VkuPipelineBatchWorker *worker = (VkuPipelineBatchWorker *)arg;
+    VkuPipelineBatch batch = worker->batch;
+    uint32_t totalCount = batch->compilePipelineCount + batch->computePipelineCount;
+
+    for (uint32_t i = atomic_fetch_add(&batch->nextIndex, 1); i < totalCount; i = atomic_fetch_add(&batch->nextIndex, 1))
+    {
+        if (i < batch->compilePipelineCount)
+        {
+            VkuPipeline pipeline = batch->compilePipelines[i];
+            if (vkuPipelineVariantBeginCompile(batch->context, pipeline->variant))
+                vkuPipelineVariantEndCompile(batch->context, pipeline->variant, vkuPipelineCompile(pipeline, worker->pipelineCache, NULL));
+        }
+        else
+        {
+            VkuComputePipeline pipeline = batch->computePipelines[i - batch->compilePipelineCount];
+            pipeline->computePipeline = vkuComputePipelineCompile(batch->context, pipeline, worker->pipelineCache, NULL);
+        }
+    }
 
-    VkSemaphore signalSemaphores[] = {frame->presenter->renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    if (atomic_fetch_sub(&batch->runningWorkers, 1) == 1)
+    {
+        VkuContext context = batch->context;
 
-    submitInfo.pSignalSemaphores = signalSemaphores;
+        // The last worker hands the compiled variants to every pipeline sharing them.
+        for (uint32_t i = 0; i < batch->pipelineCount; i++)
+            batch->pipelines[i]->graphicsPipeline = batch->pipelines[i]->variant->pipeline;
 
-    VK_CHECK(vkQueueSubmit(frame->presenter->context->graphicsQueue, 1, &submitInfo, frame->presenter->inFlightFences[currentFrame]));
+        atomic_store(&batch->complete, true);
 
-    VkPresentInfoKHR presentInfo = {};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+        pthread_mutex_lock(&context->pipelineBatchLock);
+        context->pipelineBatchesInFlight--;
+        pthread_cond_broadcast(&context->pipelineBatchCond);
+        pthread_mutex_unlock(&context->pipelineBatchLock);
+    }
 
-    VkSwapchainKHR swapChains[] = {frame->presenter->swapchain};
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = (const uint32_t *)&imageIndex;
-    presentInfo.pResults = NULL;
+    return NULL;
+}
 
-    VkResult result = vkQueuePresentKHR(frame->presenter->context->presentQueue, &presentInfo);
+VkuPipelineBatch vkuCreatePipelinesAsync(VkuContext context, VkuPipelineCreateInfo *infos, uint32_t count, VkuPipeline *outPipelines, VkuComputePipelineCreateInfo *computeInfos, uint32_t computeCount, VkuComputePipeline *outComputePipelines)
+{
+    VkuPipelineBatch_T *batch = (VkuPipelineBatch_T *)calloc(1, sizeof(VkuPipelineBatch_T));
+    batch->context = context;
+    batch->pipelineCount = count;
+    batch->computePipelineCount = computeCount;
+    batch->pipelines = (VkuPipeline *)malloc(sizeof(VkuPipeline) * (count > 0 ? count : 1));
+    batch->compilePipelines = (VkuPipeline *)malloc(sizeof(VkuPipeline) * (count > 0 ? count : 1));
+    batch->computePipelines = (VkuComputePipeline *)malloc(sizeof(VkuComputePipeline) * (computeCount > 0 ? computeCount : 1));
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || frame->presenter->window->window_resized)
+    // Layouts, render stage registration and validation stay on the calling thread, only the compiles are distributed.
+    for (uint32_t i = 0; i < count; i++)
     {
-        vkuPresenterRecreate(frame->presenter);
-        frame->presenter->window->window_resized = false;
+        batch->pipelines[i] = outPipelines[i] = vkuPreparePipeline(context, &infos[i]);
+        if (outPipelines[i]->graphicsPipeline != VK_NULL_HANDLE)
+            continue;
+
+        // Identical create infos within the batch resolve to one variant, which is compiled only once.
+        VkBool32 queued = VK_FALSE;
+        for (uint32_t j = 0; j < batch->compilePipelineCount && !queued; j++)
+            queued = (batch->compilePipelines[j]->variant == outPipelines[i]->variant);
+        if (!queued)
+            batch->compilePipelines[batch->compilePipelineCount++] = outPipelines[i];
     }
-    else if (result != VK_SUCCESS)
-        EXIT("Failed to present swap chain image!\n");
+    for (uint32_t i = 0; i < computeCount; i++)
+        batch->computePipelines[i] = outComputePipelines[i] = vkuPrepareComputePipeline(context, &computeInfos[i]);
 
-    (frame->presenter->currentFrame) = (currentFrame + 1) % frame->presenter->framesInFlight;
-    frame->presenter->activeFrame = VK_FALSE;
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t totalCount = batch->compilePipelineCount + computeCount;
+    batch->workerCount = (cpuCount > 0) ? (uint32_t)cpuCount : 1;
+    if (batch->workerCount > totalCount)
+        batch->workerCount = totalCount;
 
-    free(frame);
-}
+    atomic_init(&batch->nextIndex, 0);
+    atomic_init(&batch->runningWorkers, batch->workerCount);
+    atomic_init(&batch->complete, batch->workerCount == 0);
 
-void vkuFrameBeginRenderStage(VkuFrame frame, VkuRenderStage renderStage)
-{
-    if (frame->activeRenderStage)
-        EXIT("VkuError: Only one VkuRenderStage can be active at a time!\n");
-    else
-        frame->activeRenderStage = true;
+    if (batch->workerCount == 0)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            outPipelines[i]->graphicsPipeline = outPipelines[i]->variant->pipeline;
+        return batch;
+    }
 
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (renderStage->staticRenderStage == VK_FALSE) ? (float) frame->presenter->swapchainExtend.width : (float) renderStage->extend.width;
-    viewport.height = (renderStage->staticRenderStage == VK_FALSE) ? (float) frame->presenter->swapchainExtend.height : (float) renderStage->extend.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(frame->presenter->cmdBuffer[frame->presenter->currentFrame], 0, 1, &viewport);
+    // Every worker gets a private cache seeded from the context cache so it neither contends on it nor misses on-disk hits.
+    size_t seedSize = 0;
+    void *seedData = NULL;
+    pthread_rwlock_rdlock(&context->pipelineCacheLock);
+    if (vkGetPipelineCacheData(context->device, context->pipelineCache, &seedSize, NULL) == VK_SUCCESS && seedSize > 0)
+    {
+        seedData = malloc(seedSize);
+        if (vkGetPipelineCacheData(context->device, context->pipelineCache, &seedSize, seedData) != VK_SUCCESS)
+            seedSize = 0;
+    }
+    pthread_rwlock_unlock(&context->pipelineCacheLock);
 
-    VkRect2D scissor = {};
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent = (renderStage->staticRenderStage == VK_FALSE) ? frame->presenter->swapchainExtend : renderStage->extend;
-    vkCmdSetScissor(frame->presenter->cmdBuffer[frame->presenter->currentFrame], 0, 1, &scissor); 
+    // The context tracks the batch until it is joined, so vkuDestroyContext can merge batches nobody waited on.
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    context->pipelineBatchesInFlight++;
+    if (context->pipelineBatchCount == context->pipelineBatchCapacity)
+    {
+        context->pipelineBatchCapacity = (context->pipelineBatchCapacity == 0) ? 4 : context->pipelineBatchCapacity * 2;
+        context->pipelineBatches = (VkuPipelineBatch *)realloc(context->pipelineBatches, sizeof(VkuPipelineBatch) * context->pipelineBatchCapacity);
+    }
+    context->pipelineBatches[context->pipelineBatchCount++] = batch;
+    pthread_mutex_unlock(&context->pipelineBatchLock);
 
-    VkClearValue clearValues[2] = {{}, {}};
-    int clearValueCnt = 0;
-    if ((renderStage->options & VKU_RENDER_OPTION_COLOR_IMAGE))
-        clearValues[clearValueCnt++].color = (VkClearColorValue){{0.0f, 0.0f, 0.0f, 0.0f}};
-    if ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE))
-        clearValues[clearValueCnt++].depthStencil = (VkClearDepthStencilValue){1.0f, 0};
+    batch->workers = (VkuPipelineBatchWorker *)calloc(batch->workerCount, sizeof(VkuPipelineBatchWorker));
+    for (uint32_t i = 0; i < batch->workerCount; i++)
+    {
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = seedSize;
+        cacheInfo.pInitialData = (seedSize > 0) ? seedData : NULL;
 
-    VkRenderPassBeginInfo renderPassInfo = {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = renderStage->renderPass;
-    renderPassInfo.framebuffer = renderStage->framebuffers[((renderStage->options & VKU_RENDER_OPTION_PRESENTER) != VKU_RENDER_OPTION_PRESENTER) ? 0 : frame->imageIndex];
-    renderPassInfo.renderArea.offset.x = 0;
-    renderPassInfo.renderArea.offset.y = 0;
-    renderPassInfo.renderArea.extent = (renderStage->staticRenderStage == VK_FALSE) ? frame->presenter->swapchainExtend : renderStage->extend;
-    renderPassInfo.clearValueCount = 2;
-    renderPassInfo.pClearValues = clearValues;
+        batch->workers[i].batch = batch;
+        VK_CHECK(vkCreatePipelineCache(context->device, &cacheInfo, NULL, &batch->workers[i].pipelineCache));
 
-    vkCmdBeginRenderPass(frame->presenter->cmdBuffer[frame->presenter->currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (pthread_create(&batch->workers[i].thread, NULL, vkuPipelineBatchWorkerRun, &batch->workers[i]) != 0)
+            EXIT("VkuError: Failed to start pipeline compile thread!\n");
+    }
+
+    free(seedData);
+    return batch;
 }
 
-void vkuFrameFinishRenderStage(VkuFrame frame, VkuRenderStage renderStage)
+bool vkuPipelineBatchIsComplete(VkuPipelineBatch batch)
 {
-    if (!frame->activeRenderStage)
-        EXIT("VkuError: No active RenderStage!\n");
-    else
-        frame->activeRenderStage = false;
+    return atomic_load(&batch->complete);
+}
 
-    vkCmdEndRenderPass(frame->presenter->cmdBuffer[frame->presenter->currentFrame]);
+void vkuPipelineBatchWait(VkuPipelineBatch batch)
+{
+    if (batch->joined || batch->workerCount == 0)
+        return;
 
-    if (renderStage->sampleCount == VK_SAMPLE_COUNT_1_BIT && ((renderStage->options & VKU_RENDER_OPTION_DEPTH_IMAGE) == VKU_RENDER_OPTION_DEPTH_IMAGE))
+    VkPipelineCache workerCaches[batch->workerCount];
+    for (uint32_t i = 0; i < batch->workerCount; i++)
     {
-        vkuTransitionDepthImageLayout(frame->presenter->context->device, frame->presenter->cmdBuffer[frame->presenter->currentFrame], renderStage->pTargetDepthImages[0], renderStage->staticDepthArrayCount);
+        pthread_join(batch->workers[i].thread, NULL);
+        workerCaches[i] = batch->workers[i].pipelineCache;
     }
-}
 
-void vkuFrameBindPipeline(VkuFrame frame, VkuPipeline pipeline)
-{
-    vkCmdBindPipeline(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->graphicsPipeline);
+    VkuContext context = batch->context;
 
-    if (pipeline->descriptorSet != NULL)
-        vkCmdBindDescriptorSets(frame->cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, 0, 1, &(pipeline->descriptorSet->sets)[frame->presenter->currentFrame], 0, NULL);
-}
+    // The merge destination must not be used by any other thread meanwhile.
+    pthread_rwlock_wrlock(&context->pipelineCacheLock);
+    VK_CHECK(vkMergePipelineCaches(context->device, context->pipelineCache, batch->workerCount, workerCaches));
+    pthread_rwlock_unlock(&context->pipelineCacheLock);
 
-void vkuFramePipelinePushConstant(VkuFrame frame, VkuPipeline pipeline, void *data, size_t size)
-{
-    if (size > 128)
-        EXIT("VkuError: PushConstant size is bigger than the max allowed Value of 128 bytes!\n");
+    for (uint32_t i = 0; i < batch->workerCount; i++)
+        vkuDestroyPipelineCache(context->device, workerCaches[i]);
+
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    for (uint32_t i = 0; i < context->pipelineBatchCount; i++)
+    {
+        if (context->pipelineBatches[i] == batch)
+        {
+            context->pipelineBatches[i] = context->pipelineBatches[--context->pipelineBatchCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&context->pipelineBatchLock);
 
-    vkCmdPushConstants(frame->cmdBuffer, pipeline->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, size, data);
+    batch->joined = true;
 }
 
-void vkuFrameDrawVertexBuffer(VkuFrame frame, VkuBuffer buffer, uint64_t vertexCount, uint32_t instanceCount, uint32_t firstVertex)
+void vkuDestroyPipelineBatch(VkuPipelineBatch batch)
 {
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(frame->cmdBuffer, 0, 1, &buffer->buffer, offsets);
-    vkCmdDraw(frame->cmdBuffer, vertexCount, instanceCount, firstVertex, 0);
+    vkuPipelineBatchWait(batch);
+    free(batch->workers);
+    free(batch->pipelines);
+    free(batch->compilePipelines);
+    free(batch->computePipelines);
+    free(batch);
 }
 
-void vkuFrameUpdateUniformBuffer(VkuFrame frame, VkuUniformBuffer uniBuffer, void *data)
+void vkuCreatePipelines(VkuContext context, VkuPipelineCreateInfo *infos, uint32_t count, VkuPipeline *outPipelines)
 {
-    memcpy(uniBuffer->mappedMemory[frame->presenter->currentFrame], data, uniBuffer->bufferSize);
+    vkuDestroyPipelineBatch(vkuCreatePipelinesAsync(context, infos, count, outPipelines, NULL, 0, NULL));
 }
 
-void vkuFrameDrawVoid(VkuFrame frame, uint64_t vertexCount)
+void vkuCreateComputePipelines(VkuContext context, VkuComputePipelineCreateInfo *infos, uint32_t count, VkuComputePipeline *outPipelines)
 {
-    vkCmdDraw(frame->cmdBuffer, vertexCount, 1, 0, 0);
+    vkuDestroyPipelineBatch(vkuCreatePipelinesAsync(context, NULL, 0, NULL, infos, count, outPipelines));
 }
 
-// VkuTexture2D
+// VkuShaderWatcher
 
-VkuTexture2D vkuCreateTexture2D(VkuContext context, VkuTexture2DCreateInfo *createInfo)
+// Shader hot reload is built on inotify, elsewhere enabling it is an error rather than silently not reloading.
+#ifdef __linux__
+VkuShaderWatcher vkuCreateShaderWatcher(VkuContext context)
 {
-    VkuTexture2D_T *texture = (VkuTexture2D_T *)calloc(1, sizeof(VkuTexture2D_T));
-    texture->renderStage = NULL;
-    texture->renderStageColorImage = VK_FALSE;
-    texture->renderStageDepthImage = VK_FALSE;
-    texture->imageExtend.height = createInfo->height;
-    texture->imageExtend.width = createInfo->width;
+    VkuShaderWatcher_T *watcher = (VkuShaderWatcher_T *)calloc(1, sizeof(VkuShaderWatcher_T));
+    watcher->context = context;
+    watcher->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->inotifyFd < 0)
+        EXIT("VkuError: Shader Hot Reload: Failed to initialize inotify!\n");
 
-    VkuTextureImageCreateInfo texInfo = {
-        .textureData = createInfo->pixelData,
-        .texWidth = createInfo->width,
-        .texHeight = createInfo->height,
-        .mipLevels = (uint32_t)createInfo->mipLevels,
-        .allocator = context->memoryManager->allocator,
-        .pTexImage = &texture->textureImage,
-        .pTexImageAlloc = &texture->textureImageAllocation,
-        .device = context->device,
-        .physicalDevice = context->physicalDevice,
-        .cmdPool = context->graphicsCmdPool,
-        .graphicsQueue = context->graphicsQueue,
-    };
+    atomic_init(&watcher->stop, false);
+    pthread_mutex_init(&watcher->compileLock, NULL);
+    pthread_mutex_init(&watcher->lock, NULL);
 
-    vkuCreateTextureImage(&texInfo);
-    texture->textureImageView = vkuCreateTextureImageView(context->device, texture->textureImage, createInfo->mipLevels);
+    if (pthread_create(&watcher->thread, NULL, vkuShaderWatcherRun, watcher) != 0)
+        EXIT("VkuError: Failed to start shader watcher thread!\n");
 
-    return texture;
+    return watcher;
 }
-
-void vkuDestroyTexture2D(VkuContext context, VkuTexture2D texture)
+#else
+VkuShaderWatcher vkuCreateShaderWatcher(VkuContext context)
 {
-    if (!texture->renderStage)
-    {
-        vkuDestroyTextureImageView(context->device, texture->textureImageView);
-        vkuDestroyTextureImage(context->memoryManager->allocator, texture->textureImage, texture->textureImageAllocation);
-    }
-
-    free(texture);
+    EXIT("VkuError: Shader Hot Reload: Hot reload is unsupported on this platform!\n");
+    return NULL;
 }
+#endif
 
-// VkuTexture2DArray
-
-VkuTexture2DArray vkuCreateTexture2DArray(VkuContext context, VkuTexture2DArrayCreateInfo *createInfo)
+void vkuDestroyShaderWatcher(VkuShaderWatcher watcher)
 {
-    VkuTexture2DArray_T *texArray = (VkuTexture2DArray_T *)calloc(1, sizeof(VkuTexture2DArray_T));
+    atomic_store(&watcher->stop, true);
+    pthread_join(watcher->thread, NULL);
 
-    VkuTextureImageArrayCreateInfo texInfo = {
-        .width = (uint32_t)createInfo->width,
-        .height = (uint32_t)createInfo->height,
-        .layers = (uint32_t)createInfo->layerCount,
-        .tex_data = createInfo->pixelDataArray,
-        .mip_levels = (uint32_t)createInfo->mipLevels,
-        .allocator = context->memoryManager->allocator,
-        .pTexArrayImg = &texArray->textureImage,
-        .pTexArrayAlloc = &texArray->textureImageAllocation,
-        .device = context->device,
-        .cmd_pool = context->graphicsCmdPool,
-        .graphics_queue = context->graphicsQueue,
-        .physical_device = context->physicalDevice,
-    };
+    vkDeviceWaitIdle(watcher->context->device);
 
-    vkuCreateTextureImageArray(&texInfo);
-    texArray->textureImageView = vkuCreateTextureImageArrayView(context->device, texArray->textureImage, createInfo->mipLevels, createInfo->layerCount);
+    for (uint32_t i = 0; i < watcher->pendingCount; i++)
+        vkuShaderWatcherReleaseReload(watcher->context, &watcher->pending[i]);
+    for (uint32_t i = 0; i < watcher->retiredCount; i++)
+        vkuShaderWatcherReleaseReload(watcher->context, &watcher->retired[i]);
+    for (uint32_t i = 0; i < watcher->watchCount; i++)
+        free(watcher->watches[i].path);
 
-    return texArray;
+    close(watcher->inotifyFd);
+    pthread_mutex_destroy(&watcher->lock);
+    pthread_mutex_destroy(&watcher->compileLock);
+    free(watcher->watches);
+    free(watcher->pending);
+    free(watcher->retired);
+    free(watcher->owners);
+    free(watcher->retries);
+    free(watcher);
 }
 
-void vkuDestroyTexture2DArray(VkuContext context, VkuTexture2DArray texArray)
+void vkuShaderWatcherAdd(VkuShaderWatcher watcher, const char *path, VkuPipeline pipeline, VkuComputePipeline computePipeline, uint32_t stageIndex)
 {
-    vkuDestroyTextureImageView(context->device, texArray->textureImageView);
-    vkuDestroyTextureImage(context->memoryManager->allocator, texArray->textureImage, texArray->textureImageAllocation);
-
-    free(texArray);
-}
+    if (path == NULL)
+        return;
 
-// VkuTextureSampler
+    // inotify hands out one watch descriptor per directory, however many shaders live in it.
+    const char *slash = strrchr(path, '/');
+    char *directory = (slash == NULL) ? strdup(".") : strndup(path, (slash == path) ? 1 : (size_t)(slash - path));
+#ifdef __linux__
+    int watchDescriptor = inotify_add_watch(watcher->inotifyFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+#else
+    int watchDescriptor = -1;
+#endif
+    free(directory);
+
+    if (watchDescriptor < 0)
+    {
+        fprintf(stderr, "VkuWarning: Shader Hot Reload: Failed to watch %s\n", path);
+        return;
+    }
 
-VkuTextureSampler vkuCreateTextureSampler(VkuContext context, VkuTextureSamplerCreateInfo *createInfo)
-{
-    VkuTextureSampler_T *sampler = (VkuTextureSampler_T *)calloc(1, sizeof(VkuTextureSampler_T));
+    pthread_mutex_lock(&watcher->lock);
 
-    VkuSamplerCreateInfo samplerInfo = {
-        .minFilter = createInfo->minFilter,
-        .magFilter = createInfo->magFilter,
-        .repeatMode = createInfo->repeatMode,
-        .mipmapLevels = createInfo->mipmapLevels,
-        .physicalDevice = context->physicalDevice,
-        .device = context->device,
-        .maxAnisotropy = 16.0f,
-        .enableCompare = createInfo->enableCompare,
-        .compareOp = createInfo->compareOp,
-        .borderColor = createInfo->borderColor};
+    if (watcher->watchCount == watcher->watchCapacity)
+    {
+        watcher->watchCapacity = (watcher->watchCapacity == 0) ? 16 : watcher->watchCapacity * 2;
+        watcher->watches = (VkuShaderWatch *)realloc(watcher->watches, sizeof(VkuShaderWatch) * watcher->watchCapacity);
+    }
 
-    sampler->sampler = vkuCreateSampler(&samplerInfo);
+    VkuShaderWatch *watch = &watcher->watches[watcher->watchCount++];
+    watch->path = strdup(path);
+    watch->name = (slash == NULL) ? watch->path : watch->path + (slash - path) + 1;
+    watch->watchDescriptor = watchDescriptor;
+    watch->pipeline = pipeline;
+    watch->computePipeline = computePipeline;
+    watch->stageIndex = stageIndex;
 
-    return sampler;
+    pthread_mutex_unlock(&watcher->lock);
 }
 
-void vkuDestroyTextureSampler(VkuContext context, VkuTextureSampler sampler)
+void vkuShaderWatcherRemove(VkuShaderWatcher watcher, void *pipeline)
 {
-    vkuDestroySampler(sampler->sampler, context->device);
-    free(sampler);
-}
+    // Also waits for a reload of this pipeline that is compiling right now.
+    pthread_mutex_lock(&watcher->compileLock);
+    pthread_mutex_lock(&watcher->lock);
 
-// VkuUniformBuffer
+    for (uint32_t i = 0; i < watcher->watchCount;)
+    {
+        VkuShaderWatch *watch = &watcher->watches[i];
+        if ((void *)watch->pipeline != pipeline && (void *)watch->computePipeline != pipeline)
+        {
+            i++;
+            continue;
+        }
 
-VkuUniformBuffer vkuCreateUniformBuffer(VkuContext context, VkDeviceSize bufferSize, uint32_t count)
-{
-    if (bufferSize <= 0)
-        EXIT("VkuError: Invalid UniformBuffer size. must not be 0");
+        free(watch->path);
+        watcher->watches[i] = watcher->watches[--watcher->watchCount];
+    }
 
-    VkuUniformBuffer_T *uniBuffer = (VkuUniformBuffer_T *)calloc(1, sizeof(VkuUniformBuffer_T));
-    uniBuffer->bufferCount = count;
-    uniBuffer->bufferSize = bufferSize;
+    // A reload that was never swapped in was never used either.
+    for (uint32_t i = 0; i < watcher->pendingCount;)
+    {
+        VkuShaderReload *reload = &watcher->pending[i];
+        if ((void *)reload->pipeline != pipeline && (void *)reload->computePipeline != pipeline)
+        {
+            i++;
+            continue;
+        }
 
-    VkuUniformBuffersCreateInfo uniInfo = {
-        .ppUniformBuffer = &uniBuffer->uniformBuffer,
-        .ppUniformAllocations = &uniBuffer->uniformAllocs,
-        .pppMappedUniformMemory = &uniBuffer->mappedMemory,
-        .allocator = context->memoryManager->allocator,
-        .bufferSize = bufferSize,
-        .bufferCount = count,
-    };
+        vkuShaderWatcherReleaseReload(watcher->context, reload);
+        watcher->pending[i] = watcher->pending[--watcher->pendingCount];
+    }
 
-    vkuCreateUniformBuffers(&uniInfo);
+    for (uint32_t i = 0; i < watcher->retryCount;)
+    {
+        if ((void *)watcher->retries[i] == pipeline)
+            watcher->retries[i] = watcher->retries[--watcher->retryCount];
+        else
+            i++;
+    }
 
-    return uniBuffer;
+    pthread_mutex_unlock(&watcher->lock);
+    pthread_mutex_unlock(&watcher->compileLock);
 }
 
-void vkuDestroyUniformBuffer(VkuContext context, VkuUniformBuffer uniformBuffer)
+void vkuShaderWatcherPushReload(VkuShaderReload **reloads, uint32_t *count, uint32_t *capacity, VkuShaderReload *reload)
 {
-    vkuDestroyUniformBuffers(context->memoryManager->allocator, uniformBuffer->uniformBuffer, uniformBuffer->uniformAllocs, uniformBuffer->mappedMemory, uniformBuffer->bufferCount);
-    free(uniformBuffer);
+    if (*count == *capacity)
+    {
+        *capacity = (*capacity == 0) ? 8 : *capacity * 2;
+        *reloads = (VkuShaderReload *)realloc(*reloads, sizeof(VkuShaderReload) * *capacity);
+    }
+
+    (*reloads)[(*count)++] = *reload;
 }
 
-void vkuUpdateUniformBuffer(VkuFrame frame, VkuUniformBuffer uniBuffer, void *data, uint32_t bufferIndex)
+void vkuShaderWatcherReleaseReload(VkuContext context, VkuShaderReload *reload)
 {
-    memcpy(uniBuffer->mappedMemory[bufferIndex], data, uniBuffer->bufferSize);
+    if (reload->variant != NULL)
+        vkuContextReleasePipelineVariant(context, reload->variant);
+    if (reload->computeVkPipeline != VK_NULL_HANDLE)
+        vkuDestroyVkPipeline(context->device, reload->computeVkPipeline);
+
+    // Variant keys reference the code blobs by address, so the code is released after the variant.
+    vkuContextReleaseShaderCode(context, reload->spirv[0]);
+    vkuContextReleaseShaderCode(context, reload->spirv[1]);
+    free(reload->waitFor);
 }
 
+// Unlike vkuReadFile a missing or half-written file is not fatal, the old shader simply stays in use.
+char *vkuShaderWatcherReadSpirv(const char *path, uint32_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
 
-// VkuDescriptorSet
+    fseek(file, 0, SEEK_END);
+    long fileLength = ftell(file);
+    fseek(file, 0, SEEK_SET);
 
-VkuDescriptorSet vkuCreateDescriptorSet(VkuDescriptorSetCreateInfo *createInfo)
+    char *code = NULL;
+    if (fileLength >= 20 && fileLength % 4 == 0)
+    {
+        code = (char *)malloc(fileLength);
+        if (fread(code, 1, fileLength, file) != (size_t)fileLength || ((uint32_t *)code)[0] != VKU_SPIRV_MAGIC)
+        {
+            free(code);
+            code = NULL;
+        }
+    }
+
+    fclose(file);
+    *length = (uint32_t)fileLength;
+    return code;
+}
+
+// Builds the pipeline from the current content of its watched files, unwatched stages keep their code. Runs on the
+// watcher thread with the compile lock held.
+bool vkuShaderWatcherReloadPipeline(VkuShaderWatcher watcher, VkuPipeline pipeline, VkuShaderReload *reload)
 {
-    VkuDescriptorSet_T *set = (VkuDescriptorSet_T *)calloc(1, sizeof(VkuDescriptorSet_T));
-    set->renderStage = createInfo->renderStage;
-    set->context = createInfo->context;
-    set->setCount = createInfo->descriptorCount;
+    VkuContext context = watcher->context;
+    const char *paths[2] = {NULL, NULL};
+
+    pthread_mutex_lock(&watcher->lock);
+    for (uint32_t i = 0; i < watcher->watchCount; i++)
+        if (watcher->watches[i].pipeline == pipeline)
+            paths[watcher->watches[i].stageIndex] = watcher->watches[i].path;
+    pthread_mutex_unlock(&watcher->lock);
+
+    // Destroyed since the event was read.
+    if (paths[0] == NULL && paths[1] == NULL)
+        return false;
+
+    char *currentCode[2] = {pipeline->internalVertexSpirv, pipeline->internalFragmentSpirv};
+    uint32_t currentLength[2] = {pipeline->recreateInfo.vertexShaderLength, pipeline->recreateInfo.fragmentShaderLength};
+
+    memset(reload, 0, sizeof(VkuShaderReload));
+    reload->pipeline = pipeline;
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (paths[i] == NULL)
+        {
+            reload->spirv[i] = vkuContextAcquireShaderCode(context, currentCode[i], currentLength[i]);
+            reload->spirvLength[i] = currentLength[i];
+            continue;
+        }
 
-    set->setLayout = vkuCreateDescriptorSetLayout(set->context->device, createInfo->attributes, createInfo->attributeCount);
-    set->pool = vkuCreateDescriptorPool(set->context->device, createInfo->attributes, createInfo->attributeCount, set->setCount);
+        uint32_t length = 0;
+        char *code = vkuShaderWatcherReadSpirv(paths[i], &length);
+        if (code == NULL)
+        {
+            fprintf(stderr, "VkuWarning: Shader Hot Reload: %s is not valid SPIR-V, keeping the old shader\n", paths[i]);
+            vkuShaderWatcherReleaseReload(context, reload);
+            return false;
+        }
 
-    VkuDescriptorSetsCreateInfo setsInfo = {
-        .setCount = set->setCount,
-        .setLayout = set->setLayout,
-        .pool = set->pool,
-        .device = set->context->device,
-        .attributes = createInfo->attributes,
-        .attribCount = createInfo->attributeCount,
-    };
+        reload->spirv[i] = vkuContextAcquireShaderCode(context, code, length);
+        reload->spirvLength[i] = length;
+        free(code);
+    }
 
-    set->sets = vkuCreateDescriptorSets(&setsInfo);
-    set->attributeCount = createInfo->attributeCount;
-    set->attributes = (VkuDescriptorSetAttribute *)malloc(sizeof(VkuDescriptorSetAttribute) * createInfo->attributeCount);
+    // Shared code blobs compare by address, so an unchanged file (e.g. only touched) resolves to the current blob.
+    if (reload->spirv[0] == currentCode[0] && reload->spirv[1] == currentCode[1])
+    {
+        vkuShaderWatcherReleaseReload(context, reload);
+        return false;
+    }
 
-    for (uint32_t i = 0; i < set->attributeCount; i++)
+    // The sets and layout stay, so a shader that no longer matches them is rejected before anything is compiled.
+    for (uint32_t i = 0; i < 2; i++)
     {
-        set->attributes[i].type = createInfo->attributes[i].type;
-        set->attributes[i].sampler = createInfo->attributes[i].sampler;
-        set->attributes[i].tex2D = createInfo->attributes[i].tex2D;
-        set->attributes[i].tex2DArray = createInfo->attributes[i].tex2DArray;
-        set->attributes[i].uniformBuffer = createInfo->attributes[i].uniformBuffer;
-        set->attributes[i].shaderStage = createInfo->attributes[i].shaderStage;
+        const char *error = (paths[i] != NULL) ? vkuCheckPipelineShader(pipeline, reload->spirv[i], reload->spirvLength[i]) : NULL;
+        if (error != NULL)
+        {
+            fprintf(stderr, "VkuWarning: Shader Hot Reload: %s doesn't match the pipeline (%s), keeping the old shader\n", paths[i], error);
+            vkuShaderWatcherReleaseReload(context, reload);
+            return false;
+        }
     }
 
-    if (set->renderStage != NULL && set->renderStage->staticRenderStage == VK_FALSE)
-        vkuObjectManagerAdd(set->renderStage->descriptorSetManager, (void *)set);
+    VkuPipeline_T staged = *pipeline;
+    staged.internalVertexSpirv = reload->spirv[0];
+    staged.internalFragmentSpirv = reload->spirv[1];
+    staged.recreateInfo.vertexShaderLength = reload->spirvLength[0];
+    staged.recreateInfo.fragmentShaderLength = reload->spirvLength[1];
 
-    return set;
-}
+    // Counts as a pipeline batch from before the variant becomes visible, so callers waiting for background compiles
+    // of a shared variant wait for this one too.
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    context->pipelineBatchesInFlight++;
+    pthread_mutex_unlock(&context->pipelineBatchLock);
 
-void vkuDescriptorSetUpdate(VkuDescriptorSet descriptorSet)
-{
-    vkuDestroyDescriptorSets(descriptorSet->sets);
-    vkuDestroyDescriptorPool(descriptorSet->renderStage->context->device, descriptorSet->pool);
-    vkuDestroyDescriptorSetLayout(descriptorSet->renderStage->context->device, descriptorSet->setLayout);
+    VkResult result = VK_SUCCESS;
+    staged.variant = reload->variant = vkuContextAcquirePipelineVariant(context, &staged);
+    if (vkuPipelineVariantBeginCompile(context, reload->variant))
+    {
+        pthread_rwlock_rdlock(&context->pipelineCacheLock);
+        VkPipeline compiled = vkuPipelineCompile(&staged, context->pipelineCache, &result);
+        pthread_rwlock_unlock(&context->pipelineCacheLock);
+        vkuPipelineVariantEndCompile(context, reload->variant, compiled);
+    }
 
-    descriptorSet->setLayout = vkuCreateDescriptorSetLayout(descriptorSet->renderStage->context->device, descriptorSet->attributes, descriptorSet->attributeCount);
-    descriptorSet->pool = vkuCreateDescriptorPool(descriptorSet->renderStage->context->device, descriptorSet->attributes, descriptorSet->attributeCount, descriptorSet->setCount);
+    pthread_mutex_lock(&context->pipelineBatchLock);
+    context->pipelineBatchesInFlight--;
+    pthread_cond_broadcast(&context->pipelineBatchCond);
+    pthread_mutex_unlock(&context->pipelineBatchLock);
 
-    VkuDescriptorSetsCreateInfo setsInfo = {
-        .setCount = descriptorSet->setCount,
-        .setLayout = descriptorSet->setLayout,
-        .pool = descriptorSet->pool,
-        .device = descriptorSet->renderStage->context->device,
-        .attributes = descriptorSet->attributes,
-        .attribCount = descriptorSet->attributeCount,
-    };
+    if (vkuPipelineVariantWait(context, reload->variant) == VK_NULL_HANDLE)
+    {
+        fprintf(stderr, "VkuWarning: Shader Hot Reload: Pipeline failed to compile (VkResult %d), keeping the old shader\n", result);
+        vkuShaderWatcherReleaseReload(context, reload);
+        return false;
+    }
 
-    descriptorSet->sets = vkuCreateDescriptorSets(&setsInfo);
+    return true;
 }
 
-void vkuDestroyDescriptorSet(VkuDescriptorSet set)
+bool vkuShaderWatcherReloadComputePipeline(VkuShaderWatcher watcher, VkuComputePipeline pipeline, VkuShaderReload *reload)
 {
-    if (set->renderStage != NULL)
-        vkuObjectManagerRemove(set->renderStage->descriptorSetManager, (void *)set);
-    vkuDestroyDescriptorSets(set->sets);
-    vkuDestroyDescriptorPool(set->context->device, set->pool);
-    vkuDestroyDescriptorSetLayout(set->context->device, set->setLayout);
-    free(set->attributes);
-    free(set);
-}
+    VkuContext context = watcher->context;
+    const char *path = NULL;
 
-// VkuPipeline
+    pthread_mutex_lock(&watcher->lock);
+    for (uint32_t i = 0; i < watcher->watchCount && path == NULL; i++)
+        if (watcher->watches[i].computePipeline == pipeline)
+            path = watcher->watches[i].path;
+    pthread_mutex_unlock(&watcher->lock);
 
-VkuPipeline vkuCreatePipeline(VkuContext context, VkuPipelineCreateInfo *createInfo)
-{
-    if (!createInfo->renderStage->enableDepthTesting && createInfo->depthTestEnable)
-        EXIT("VkuError: Pipeline Creation: RenderStage does not support DepthTesting!");
+    if (path == NULL)
+        return false;
 
-    VkuPipeline_T *pipeline = (VkuPipeline_T *)calloc(1, sizeof(VkuPipeline_T));
-    if (!pipeline)
+    uint32_t length = 0;
+    char *code = vkuShaderWatcherReadSpirv(path, &length);
+    if (code == NULL)
     {
-        return NULL;
+        fprintf(stderr, "VkuWarning: Shader Hot Reload: %s is not valid SPIR-V, keeping the old shader\n", path);
+        return false;
     }
 
-    memcpy(&pipeline->recreateInfo, createInfo, sizeof(VkuPipelineCreateInfo));
-
-    pipeline->descriptorSet = createInfo->descriptorSet;
-    pipeline->renderStage = createInfo->renderStage;
-
-    size_t vertexShaderLength = createInfo->vertexShaderLength;
-    size_t fragmentShaderLength = createInfo->fragmentShaderLength;
+    memset(reload, 0, sizeof(VkuShaderReload));
+    reload->computePipeline = pipeline;
+    reload->spirv[0] = vkuContextAcquireShaderCode(context, code, length);
+    reload->spirvLength[0] = length;
+    free(code);
 
-    pipeline->internalVertexSpirv = (char *)malloc((vertexShaderLength) * sizeof(char));
-    memcpy(pipeline->internalVertexSpirv, createInfo->vertexShaderSpirV, vertexShaderLength);
-
-    if (createInfo->fragmentShaderSpirV != NULL && createInfo->fragmentShaderLength > 0) {
-        pipeline->internalFragmentSpirv = (char *)malloc((fragmentShaderLength) * sizeof(char));
-        memcpy(pipeline->internalFragmentSpirv, createInfo->fragmentShaderSpirV, fragmentShaderLength);
-    } else {
-        pipeline->internalFragmentSpirv = NULL;
+    if (reload->spirv[0] == pipeline->internalComputeSpirv)
+    {
+        vkuShaderWatcherReleaseReload(context, reload);
+        return false;
     }
 
-    pipeline->vertexAttributes = (VkuVertexAttribute *)malloc(sizeof(VkuVertexAttribute) * createInfo->vertexLayout.attributeCount);
-    for (uint32_t i = 0; i < createInfo->vertexLayout.attributeCount; i++)
-        memcpy(&pipeline->vertexAttributes[i], &createInfo->vertexLayout.attributes[i], sizeof(VkuVertexAttribute));
-    pipeline->vertexLayout.attributeCount = createInfo->vertexLayout.attributeCount;
-    pipeline->vertexLayout.attributes = pipeline->vertexAttributes;
-    pipeline->vertexLayout.vertexSize = createInfo->vertexLayout.vertexSize;
-
-    pipeline->pipelineLayout = vkuCreatePipelineLayout(context->device, &createInfo->descriptorSet->setLayout, (createInfo->descriptorSet != NULL) ? 1 : 0);
+    // The sets and layout stay, so a kernel that no longer matches them is rejected before anything is compiled.
+    const char *error = NULL;
+    VkuShaderReflection reflection = vkuTryCreateShaderReflection(reload->spirv[0], length, &error);
+    if (reflection != NULL)
+    {
+        error = vkuCheckShaderReflection(reflection, pipeline->descriptorSets, 0, pipeline->descriptorSetCount, NULL, 0, pipeline->pushConstantRanges, pipeline->pushConstantRangeCount);
+        vkuResolveShaderLocalSize(reflection, &pipeline->specializationInfo, reload->localSize);
+        vkuDestroyShaderReflection(reflection);
+    }
 
-    VkuGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .device = context->device,
-        .vertexShaderSpirv = pipeline->internalVertexSpirv,
-        .vertexShaderLength = (uint32_t)vertexShaderLength,
-        .fragmentShaderSpirv = pipeline->internalFragmentSpirv,
-        .fragmentShaderLength = (uint32_t)fragmentShaderLength,
-        .vertexInputLayout = createInfo->vertexLayout,
-        .swapchainExtend = (pipeline->renderStage->staticRenderStage == VK_FALSE) ? pipeline->renderStage->presenter->swapchainExtend : pipeline->renderStage->extend,
-        .polygonMode = createInfo->polygonMode,
-        .pipelineLayout = pipeline->pipelineLayout,
-        .renderPass = pipeline->renderStage->renderPass,
-        .msaaSamples = pipeline->renderStage->sampleCount,
-        .depth_test_write = createInfo->depthTestWrite,
-        .depth_test_enable = createInfo->depthTestEnable,
-        .depth_compare_mode = createInfo->depthCompareMode,
-        .cullMode = createInfo->cullMode,
-        .enableDepthBias = createInfo->enableDepthBias,
-        .depthBiasConstantFactor = createInfo->depthBiasConstantFactor,
-        .depthBiasSlopeFactor = createInfo->depthBiasSlopeFactor,
-        .topology = createInfo->topology
-    };
+    if (error != NULL)
+    {
+        fprintf(stderr, "VkuWarning: Shader Hot Reload: %s doesn't match the pipeline (%s), keeping the old shader\n", path, error);
+        vkuShaderWatcherReleaseReload(context, reload);
+        return false;
+    }
 
-    pipeline->graphicsPipeline = vkuCreateGraphicsPipeline(&pipelineCreateInfo);
+    VkResult result = VK_SUCCESS;
+    VkuComputePipeline_T staged = *pipeline;
+    staged.internalComputeSpirv = reload->spirv[0];
+    staged.computeShaderLength = length;
+    pthread_rwlock_rdlock(&context->pipelineCacheLock);
+    reload->computeVkPipeline = vkuComputePipelineCompile(context, &staged, context->pipelineCache, &result);
+    pthread_rwlock_unlock(&context->pipelineCacheLock);
 
-    if (pipeline->renderStage->staticRenderStage == VK_FALSE)
-        vkuObjectManagerAdd(pipeline->renderStage->pipelineManager, (void *)pipeline);
+    if (reload->computeVkPipeline == VK_NULL_HANDLE)
+    {
+        fprintf(stderr, "VkuWarning: Shader Hot Reload: %s failed to compile (VkResult %d), keeping the old shader\n", path, result);
+        vkuShaderWatcherReleaseReload(context, reload);
+        return false;
+    }
 
-    return pipeline;
+    return true;
 }
 
-void vkuPipelineUpdate(VkuPipeline pipeline)
+#ifdef __linux__
+void *vkuShaderWatcherRun(void *arg)
 {
-    vkuDestroyVkPipeline(pipeline->renderStage->context->device, pipeline->graphicsPipeline);
+    VkuShaderWatcher watcher = (VkuShaderWatcher)arg;
+    _Alignas(struct inotify_event) char events[4096];
+    struct pollfd pollFd = {watcher->inotifyFd, POLLIN, 0};
 
-    VkuGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .device = pipeline->renderStage->context->device,
-        .vertexShaderSpirv = pipeline->internalVertexSpirv,
-        .vertexShaderLength = pipeline->recreateInfo.vertexShaderLength,
-        .fragmentShaderSpirv = pipeline->internalFragmentSpirv,
-        .fragmentShaderLength = pipeline->recreateInfo.fragmentShaderLength,
-        .vertexInputLayout = pipeline->vertexLayout,
- 
-        .swapchainExtend = (pipeline->renderStage->staticRenderStage == VK_FALSE) ? pipeline->renderStage->presenter->swapchainExtend : pipeline->renderStage->extend,
-        .polygonMode = pipeline->recreateInfo.polygonMode,
-        .pipelineLayout = pipeline->pipelineLayout,
-        .renderPass = pipeline->renderStage->renderPass,
-        .msaaSamples = pipeline->renderStage->sampleCount,
-        .depth_test_write = pipeline->recreateInfo.depthTestWrite,
-        .depth_test_enable = pipeline->recreateInfo.depthTestEnable,
-        .depth_compare_mode = pipeline->recreateInfo.depthCompareMode,
-        .cullMode = pipeline->recreateInfo.cullMode,
-        .enableDepthBias = pipeline->recreateInfo.enableDepthBias,
-        .depthBiasConstantFactor = pipeline->recreateInfo.depthBiasConstantFactor,
-        .depthBiasSlopeFactor = pipeline->recreateInfo.depthBiasSlopeFactor,
-        .topology = pipeline->recreateInfo.topology};
+    VkuShaderWatch *changed = NULL;
+    uint32_t changedCapacity = 0;
 
-    pipeline->graphicsPipeline = vkuCreateGraphicsPipeline(&pipelineCreateInfo);
-}
+    while (!atomic_load(&watcher->stop))
+    {
+        // Wakes up regularly to notice vkuDestroyShaderWatcher and reloads handed back by the frame boundary.
+        int ready = poll(&pollFd, 1, 100);
 
-void vkuDestroyPipeline(VkuContext context, VkuPipeline pipeline)
-{
-    vkDeviceWaitIdle(context->device);
+        uint32_t changedCount = 0;
+        pthread_mutex_lock(&watcher->lock);
 
-    vkuObjectManagerRemove(pipeline->renderStage->pipelineManager, (void *)pipeline);
+        if (watcher->retryCount > changedCapacity)
+        {
+            changedCapacity = watcher->retryCount;
+            changed = (VkuShaderWatch *)realloc(changed, sizeof(VkuShaderWatch) * changedCapacity);
+        }
+        for (uint32_t i = 0; i < watcher->retryCount; i++)
+            changed[changedCount++] = (VkuShaderWatch){.pipeline = watcher->retries[i]};
+        watcher->retryCount = 0;
 
-    free(pipeline->internalVertexSpirv);
-    if (pipeline->internalFragmentSpirv != NULL)
-        free(pipeline->internalFragmentSpirv);
+        pthread_mutex_unlock(&watcher->lock);
 
-    free(pipeline->vertexAttributes);
-    vkuDestroyVkPipeline(context->device, pipeline->graphicsPipeline);
-    vkuDestroyPipelineLayout(context->device, pipeline->pipelineLayout);
-    free(pipeline);
-}
+        // Editors tend to produce several events per save, every pipeline is rebuilt once per wakeup.
+        ssize_t size;
+        while (ready > 0 && (size = read(watcher->inotifyFd, events, sizeof(events))) > 0)
+        {
+            pthread_mutex_lock(&watcher->lock);
 
-VkuComputeExecutor vkuCreateComputeExecutor(VkuContext context, uint32_t framesInFlight) {
-    VkuComputeExecutor executor = calloc(1, sizeof(VkuComputeExecutor_T));
-    executor->currentFrame = 0;
-    executor->context = context;
-    executor->framesInFlight = framesInFlight;
-    executor->computeFinishedSemaphores = malloc(sizeof(VkSemaphore) * framesInFlight);
-    executor->computeInFlightFences = malloc(sizeof(VkFence) *framesInFlight);
-    executor->computeCommandBuffers = malloc(sizeof(VkCommandBuffer) *framesInFlight);
-    executor->activeComputeRun = malloc(sizeof(VkuComputeRun_T));
+            const struct inotify_event *event;
+            for (char *ptr = events; ptr < events + size; ptr += sizeof(struct inotify_event) + event->len)
+            {
+                event = (const struct inotify_event *)ptr;
+                if (event->len == 0)
+                    continue;
+
+                for (uint32_t i = 0; i < watcher->watchCount; i++)
+                {
+                    VkuShaderWatch *watch = &watcher->watches[i];
+                    if (watch->watchDescriptor != event->wd || strcmp(watch->name, event->name) != 0)
+                        continue;
+
+                    bool queued = false;
+                    for (uint32_t j = 0; j < changedCount && !queued; j++)
+                        queued = changed[j].pipeline == watch->pipeline && changed[j].computePipeline == watch->computePipeline;
+                    if (queued)
+                        continue;
+
+                    if (changedCount == changedCapacity)
+                    {
+                        changedCapacity = (changedCapacity == 0) ? 16 : changedCapacity * 2;
+                        changed = (VkuShaderWatch *)realloc(changed, sizeof(VkuShaderWatch) * changedCapacity);
+                    }
+                    changed[changedCount++] = *watch;
+                }
+            }
 
-    VkSemaphoreCreateInfo semaphoreInfo = {};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            pthread_mutex_unlock(&watcher->lock);
+        }
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        for (uint32_t i = 0; i < changedCount; i++)
+        {
+            pthread_mutex_lock(&watcher->compileLock);
 
-    for (size_t i = 0; i < framesInFlight; i++) {
-        VK_CHECK(vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &(executor->computeFinishedSemaphores[i])));
-        VK_CHECK(vkCreateFence(context->device, &fenceInfo, NULL, &(executor->computeInFlightFences[i])));
-    }
+            VkuShaderReload reload;
+            bool staged = (changed[i].pipeline != NULL) ? vkuShaderWatcherReloadPipeline(watcher, changed[i].pipeline, &reload) : vkuShaderWatcherReloadComputePipeline(watcher, changed[i].computePipeline, &reload);
 
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = context->computeCmdPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t) framesInFlight;
+            if (staged)
+            {
+                pthread_mutex_lock(&watcher->lock);
+
+                // A newer reload replaces one that hasn't been swapped in yet.
+                for (uint32_t j = 0; j < watcher->pendingCount; j++)
+                {
+                    if (watcher->pending[j].pipeline == reload.pipeline && watcher->pending[j].computePipeline == reload.computePipeline)
+                    {
+                        vkuShaderWatcherReleaseReload(watcher->context, &watcher->pending[j]);
+                        watcher->pending[j] = watcher->pending[--watcher->pendingCount];
+                        break;
+                    }
+                }
+
+                vkuShaderWatcherPushReload(&watcher->pending, &watcher->pendingCount, &watcher->pendingCapacity, &reload);
+                pthread_mutex_unlock(&watcher->lock);
+            }
 
-    VK_CHECK(vkAllocateCommandBuffers(context->device, &allocInfo, executor->computeCommandBuffers));
+            pthread_mutex_unlock(&watcher->compileLock);
+        }
+    }
 
-    return executor;
+    free(changed);
+    return NULL;
 }
+#endif
 
-void vkuDestroyComputeExecutor(VkuComputeExecutor computeExecutor) {
-    for (size_t i = 0; i < computeExecutor->framesInFlight; i++) {
-        vkDestroySemaphore(computeExecutor->context->device, computeExecutor->computeFinishedSemaphores[i], NULL);
-        vkDestroyFence(computeExecutor->context->device, computeExecutor->computeInFlightFences[i], NULL);
-    }
+// Expects the watcher lock to be held. A retired reload is released once every owner that was registered when it was
+// retired has passed its boundary, or has been destroyed since.
+void vkuShaderWatcherReleaseRetired(VkuShaderWatcher watcher)
+{
+    for (uint32_t i = 0; i < watcher->retiredCount;)
+    {
+        VkuShaderReload *retired = &watcher->retired[i];
 
-    free(computeExecutor->activeComputeRun);
-    free(computeExecutor->computeCommandBuffers);
-    free(computeExecutor->computeFinishedSemaphores);
-    free(computeExecutor->computeInFlightFences);
-    free(computeExecutor);
+        bool referenced = false;
+        for (uint32_t j = 0; j < retired->waitForCount && !referenced; j++)
+            for (uint32_t k = 0; k < watcher->ownerCount && !referenced; k++)
+                referenced = watcher->owners[k].owner == retired->waitFor[j].owner && watcher->owners[k].boundary < retired->waitFor[j].boundary;
+
+        if (referenced)
+        {
+            i++;
+            continue;
+        }
+
+        vkuShaderWatcherReleaseReload(watcher->context, retired);
+        watcher->retired[i] = watcher->retired[--watcher->retiredCount];
+    }
 }
 
-VkuComputeRun vkuComputeExecutorStartRun(VkuComputeExecutor executor) {
-    if (executor->activeRun)
-        EXIT("VkuError: Only one VkuComputeRun can be active at the same time!");
-    executor->activeRun = VK_TRUE;
+// Called once the fence of the owner's (presenter or compute executor) current frame slot has been waited for. Objects
+// replaced framesInFlight boundaries of an owner ago can no longer be referenced by any of its command buffers.
+void vkuShaderWatcherFrameBoundary(VkuShaderWatcher watcher, void *owner, uint32_t framesInFlight, bool compute)
+{
+    if (watcher == NULL)
+        return;
 
+    VkuContext context = watcher->context;
+    pthread_mutex_lock(&watcher->lock);
 
-    VkuComputeRun run = executor->activeComputeRun;
-    memset(run, 0, sizeof(VkuComputeRun_T));
-    run->executor = executor;
+    VkuShaderReloadOwner *self = NULL;
+    for (uint32_t i = 0; i < watcher->ownerCount && self == NULL; i++)
+        if (watcher->owners[i].owner == owner)
+            self = &watcher->owners[i];
 
-    vkWaitForFences(executor->context->device, 1, &executor->computeInFlightFences[executor->currentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(executor->context->device, 1, &executor->computeInFlightFences[executor->currentFrame]);
-    vkResetCommandBuffer(executor->computeCommandBuffers[executor->currentFrame], 0);
+    if (self == NULL)
+    {
+        if (watcher->ownerCount == watcher->ownerCapacity)
+        {
+            watcher->ownerCapacity = (watcher->ownerCapacity == 0) ? 4 : watcher->ownerCapacity * 2;
+            watcher->owners = (VkuShaderReloadOwner *)realloc(watcher->owners, sizeof(VkuShaderReloadOwner) * watcher->ownerCapacity);
+        }
 
-    VkCommandBufferBeginInfo beginInfo= {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        self = &watcher->owners[watcher->ownerCount++];
+        *self = (VkuShaderReloadOwner){.owner = owner};
+    }
 
-    VK_CHECK(vkBeginCommandBuffer(executor->computeCommandBuffers[executor->currentFrame], &beginInfo));
+    self->boundary++;
+    self->framesInFlight = framesInFlight;
+    vkuShaderWatcherReleaseRetired(watcher);
 
-    return run;
-}
+    pthread_mutex_unlock(&watcher->lock);
 
-void vkuComputeExecutorFinishRun(VkuComputeRun computeRun, VkBool32 enableFrameSyncronization) {
-    VK_CHECK(vkEndCommandBuffer(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame]));
+    // The frame never stalls on a compile, a busy watcher thread just defers the swap.
+    if (pthread_mutex_trylock(&watcher->compileLock) != 0)
+        return;
+    pthread_mutex_lock(&watcher->lock);
 
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame];
+    for (uint32_t i = 0; i < watcher->pendingCount;)
+    {
+        VkuShaderReload reload = watcher->pending[i];
 
-    if (enableFrameSyncronization) {
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &computeRun->executor->computeFinishedSemaphores[computeRun->executor->currentFrame];
-    }
+        // A graphics pipeline is only swapped between frames of the presenter it renders for. Compute pipelines and
+        // pipelines of static render stages aren't tied to one owner, retiring waits for all of them instead.
+        bool swap = (reload.computePipeline != NULL) == compute;
+        if (swap && !compute && reload.pipeline->renderStage->presenter != NULL)
+            swap = reload.pipeline->renderStage->presenter == owner;
 
-    VK_CHECK(vkQueueSubmit(computeRun->executor->context->computeQueue, 1, &submitInfo, computeRun->executor->computeInFlightFences[computeRun->executor->currentFrame]));
+        if (!swap)
+        {
+            i++;
+            continue;
+        }
 
-    computeRun->lastFrame = computeRun->executor->currentFrame;
-    computeRun->executor->currentFrame = (computeRun->executor->currentFrame + 1) % computeRun->executor->framesInFlight;
+        watcher->pending[i] = watcher->pending[--watcher->pendingCount];
 
-    computeRun->executor->activeRun = false;
-}
+        VkuShaderReload old = {0};
+        if (compute)
+        {
+            VkuComputePipeline pipeline = reload.computePipeline;
+            old.computeVkPipeline = pipeline->computePipeline;
+            old.spirv[0] = pipeline->internalComputeSpirv;
+
+            pipeline->computePipeline = reload.computeVkPipeline;
+            pipeline->internalComputeSpirv = reload.spirv[0];
+            pipeline->computeShaderLength = reload.spirvLength[0];
+            memcpy(pipeline->localSize, reload.localSize, sizeof(pipeline->localSize));
+        }
+        else
+        {
+            VkuPipeline pipeline = reload.pipeline;
+            VkuPipeline_T staged = *pipeline;
+            staged.internalVertexSpirv = reload.spirv[0];
+            staged.internalFragmentSpirv = reload.spirv[1];
+            staged.recreateInfo.vertexShaderLength = reload.spirvLength[0];
+            staged.recreateInfo.fragmentShaderLength = reload.spirvLength[1];
+
+            // Resolved against the current render stage state. Normally this is the variant the watcher compiled, after
+            // a render pass change in between the watcher thread rebuilds it and the old shader stays until then.
+            VkuPipelineVariant variant = vkuContextAcquirePipelineVariant(context, &staged);
+            VkPipeline compiled = vkuPipelineVariantPeek(context, variant);
+            vkuContextReleasePipelineVariant(context, reload.variant);
+            reload.variant = NULL;
+
+            if (compiled == VK_NULL_HANDLE)
+            {
+                vkuContextReleasePipelineVariant(context, variant);
+                vkuShaderWatcherReleaseReload(context, &reload);
+
+                if (watcher->retryCount == watcher->retryCapacity)
+                {
+                    watcher->retryCapacity = (watcher->retryCapacity == 0) ? 8 : watcher->retryCapacity * 2;
+                    watcher->retries = (VkuPipeline *)realloc(watcher->retries, sizeof(VkuPipeline) * watcher->retryCapacity);
+                }
+                watcher->retries[watcher->retryCount++] = pipeline;
+                continue;
+            }
 
-void vkuComputeRunBindComputePipeline(VkuComputeRun computeRun, VkuComputePipeline pipeline, uint32_t dynamicOffsetCount, uint32_t * dynamicOffsets) {
-    vkCmdBindPipeline(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->computePipeline);
-    vkCmdBindDescriptorSets(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, 1, &pipeline->descriptorSet->sets[computeRun->executor->currentFrame], dynamicOffsetCount, dynamicOffsets);
-}
+            old.variant = pipeline->variant;
+            old.spirv[0] = pipeline->internalVertexSpirv;
+            old.spirv[1] = pipeline->internalFragmentSpirv;
 
-void vkuComputeRunDispatch(VkuComputeRun computeRun, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
-    vkCmdDispatch(computeRun->executor->computeCommandBuffers[computeRun->executor->currentFrame], groupCountX, groupCountY, groupCountZ);
-}
+            pipeline->internalVertexSpirv = reload.spirv[0];
+            pipeline->internalFragmentSpirv = reload.spirv[1];
+            pipeline->recreateInfo.vertexShaderLength = reload.spirvLength[0];
+            pipeline->recreateInfo.fragmentShaderLength = reload.spirvLength[1];
+            pipeline->variant = variant;
+            pipeline->graphicsPipeline = compiled;
+        }
 
-void vkuComputeRunUpdateUniformBuffer(VkuComputeRun computeRun, VkuUniformBuffer uniBuffer, void *data)
-{
-    memcpy(uniBuffer->mappedMemory[computeRun->executor->currentFrame], data, uniBuffer->bufferSize);
-}
+        // Any owner may still have frames in flight that use the replaced objects.
+        old.waitForCount = watcher->ownerCount;
+        old.waitFor = (VkuShaderReloadOwner *)malloc(sizeof(VkuShaderReloadOwner) * watcher->ownerCount);
+        for (uint32_t j = 0; j < watcher->ownerCount; j++)
+        {
+            old.waitFor[j] = watcher->owners[j];
+            old.waitFor[j].boundary += watcher->owners[j].framesInFlight;
+        }
 
-VkuComputePipeline vkuCreateComputePipeline(VkuContext context, VkuComputePipelineCreateInfo *createInfo) {
-    VkuComputePipeline_T *pipeline = (VkuComputePipeline_T *)calloc(1, sizeof(VkuComputePipeline_T));
+        vkuShaderWatcherPushReload(&watcher->retired, &watcher->retiredCount, &watcher->retiredCapacity, &old);
+    }
+
+    pthread_mutex_unlock(&watcher->lock);
+    pthread_mutex_unlock(&watcher->compileLock);
+}
 
-    pipeline->descriptorSet = createInfo->descriptorSet;
-    pipeline->internalComputeSpirv = (char *)malloc((createInfo->computeShaderLength) * sizeof(char));
-    memcpy(pipeline->internalComputeSpirv, createInfo->computeShaderSpirV, createInfo->computeShaderLength * sizeof(char));
+// Called when a presenter or compute executor is destroyed, after its frames have completed.
+void vkuShaderWatcherRemoveOwner(VkuShaderWatcher watcher, void *owner)
+{
+    if (watcher == NULL)
+        return;
 
-    pipeline->pipelineLayout = vkuCreatePipelineLayout(context->device, &createInfo->descriptorSet->setLayout, (createInfo->descriptorSet != NULL) ? 1 : 0);
+    pthread_mutex_lock(&watcher->lock);
 
-    VkuComputeVkPipelineCreateInfo computePipelineCreateInfo = {
-        .computeShaderLength = createInfo->computeShaderLength,
-        .computeShaderSpirv = createInfo->computeShaderSpirV,
-        .device = context->device,
-        .pipelineLayout = pipeline->pipelineLayout
-    };
+    for (uint32_t i = 0; i < watcher->ownerCount; i++)
+    {
+        if (watcher->owners[i].owner == owner)
+        {
+            watcher->owners[i] = watcher->owners[--watcher->ownerCount];
+            break;
+        }
+    }
 
-    pipeline->computePipeline = vkuCreateComputeVkPipeline(&computePipelineCreateInfo);
+    vkuShaderWatcherReleaseRetired(watcher);
+    pthread_mutex_unlock(&watcher->lock);
+}
 
-    return pipeline;
+void vkuContextPauseShaderReload(VkuContext context)
+{
+    if (context->shaderWatcher != NULL)
+        pthread_mutex_lock(&context->shaderWatcher->compileLock);
 }
 
-void vkuDestroyComputePipeline(VkuContext context, VkuComputePipeline computePipeline) {
-    vkuDestroyVkPipeline(context->device, computePipeline->computePipeline);
-    vkuDestroyPipelineLayout(context->device, computePipeline->pipelineLayout);
-    free(computePipeline->internalComputeSpirv);
-    free(computePipeline);
+void vkuContextResumeShaderReload(VkuContext context)
+{
+    if (context->shaderWatcher != NULL)
+        pthread_mutex_unlock(&context->shaderWatcher->compileLock);
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include <vkutils/vkutils.h>
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output.vkpack> <image> [image...]\n", argv[0]);
+        return 1;
+    }
+
+    return vkuBuildAssetPack(argv[1], (const char **)&argv[2], (uint32_t)(argc - 2)) ? 0 : 1;
+}